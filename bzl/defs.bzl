@@ -2,6 +2,8 @@
 
 Provides:
   samwise_test()                    — host unit test with automatic mock substitution.
+  samwise_host_binary()             — host tool (e.g. a simulator) with the same
+                                      mock substitution as samwise_test().
   samwise_integration_test()        — hardware integration test; creates both a
                                       firmware-linkable hw_lib and a host unit test.
   hardware_integration_test_suite() — collects integration tests and auto-generates
@@ -181,6 +183,43 @@ def samwise_test(name, srcs, deps = [], copts = [], defines = [], **kwargs):
         **kwargs
     )
 
+def samwise_host_binary(name, srcs, deps = [], copts = [], defines = [], **kwargs):
+    """Create a host-only binary that links the firmware against the mocks.
+
+    Same dependency remapping as samwise_test(), but produces a cc_binary for
+    tools that are run rather than tested, such as the mission simulator.
+    Build and run it with the tests profile:
+
+        bazel run //src/test_infrastructure:mission_sim --config=tests -- 30
+
+    Args:
+        name: Name of the binary target
+        srcs: Source files (.c files), one of which defines main()
+        deps: Dependencies (will be automatically remapped to mocks)
+        copts: Additional compiler options
+        defines: Additional preprocessor defines
+        **kwargs: Additional arguments passed to cc_binary
+    """
+
+    bin_deps = _remap_deps_to_mocks(deps)
+
+    if "//src/test_infrastructure:test_infrastructure" not in bin_deps:
+        bin_deps.append("//src/test_infrastructure:test_infrastructure")
+
+    bin_defines = list(defines)
+    if "TEST" not in bin_defines:
+        bin_defines.append("TEST")
+
+    native.cc_binary(
+        name = name,
+        srcs = srcs,
+        deps = bin_deps,
+        copts = copts,
+        local_defines = bin_defines,
+        testonly = True,
+        **kwargs
+    )
+
 def samwise_integration_test(name, int_src, srcs = [], deps = [], copts = [], defines = [], **kwargs):
     """Register a SAMWISE hardware integration test.
 
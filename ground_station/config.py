@@ -32,9 +32,59 @@ PAYLOAD_EXEC = 1  # src/tasks/command/command_parser.h:CMD_PAYLOAD_EXEC
 PAYLOAD_TURN_ON = 2  # src/tasks/command/command_parser.h:CMD_PAYLOAD_TURN_ON
 PAYLOAD_TURN_OFF = 3  # src/tasks/command/command_parser.h:CMD_PAYLOAD_TURN_OFF
 MANUAL_STATE_OVERRIDE = 4  # src/tasks/command/command_parser.h:CMD_MANUAL_STATE_OVERRIDE
-PAYLOAD_SHUTDOWN = 5  # src/tasks/command/command_parser.h:CMD_PAYLOAD_SHUTDOWN
-ADCS_EXEC = 6
-ADCS_PACKET = 7
+# No longer a flight command: the satellite parses 5 as ADCS_EXEC
+PAYLOAD_SHUTDOWN = 5
+ADCS_EXEC = 5  # src/tasks/command/command_parser.h:ADCS_EXEC
+ADCS_PACKET = 6  # src/tasks/command/command_parser.h:ADCS_PACKET
+TASK_PROFILE = 7  # src/tasks/command/command_parser.h:TASK_PROFILE
+LINK_SWITCH = 8  # src/tasks/command/command_parser.h:LINK_SWITCH
+FTP_REFORMAT = 9  # src/tasks/command/command_parser.h:FTP_REFORMAT
+FTP_START_FILE_WRITE = 10  # src/tasks/command/command_parser.h:FTP_START_FILE_WRITE
+FTP_WRITE_TO_FILE = 11  # src/tasks/command/command_parser.h:FTP_WRITE_TO_FILE
+FTP_CANCEL_FILE_WRITE = 12  # src/tasks/command/command_parser.h:FTP_CANCEL_FILE_WRITE
+FTP_START_FILE_READ = 13  # src/tasks/command/command_parser.h:FTP_START_FILE_READ
+FTP_READ_ACK = 14  # src/tasks/command/command_parser.h:FTP_READ_ACK
+FTP_CANCEL_FILE_READ = 15  # src/tasks/command/command_parser.h:FTP_CANCEL_FILE_READ
+FTP_LIST_FILES = 16  # src/tasks/command/command_parser.h:FTP_LIST_FILES
+
+# Link adaptation - Must match flight software link profiles and handshake
+# Flight Software References:
+# - Profiles: src/tasks/radio/link_adapt.c:link_profiles
+# - Flags/Timeouts: src/tasks/radio/link_adapt.h
+LINK_FLAG_PROPOSE = 0x01  # src/tasks/radio/link_adapt.h:LINK_FLAG_PROPOSE
+LINK_FLAG_ACK = 0x02  # src/tasks/radio/link_adapt.h:LINK_FLAG_ACK
+LINK_PROFILE_DEFAULT = 3  # src/tasks/radio/link_adapt.h:LINK_PROFILE_DEFAULT
+LINK_FALLBACK_S = 60  # src/tasks/radio/link_adapt.h:LINK_FALLBACK_MS
+# (spreading factor, bandwidth, coding rate), most robust first
+LINK_PROFILES = [
+    (10, 125000, 5),
+    (9, 125000, 5),
+    (8, 125000, 5),
+    (7, 125000, 5),
+    (7, 250000, 5),
+    (7, 500000, 5),
+]
+AUTO_LINK_ADAPT = True  # Accept the satellite's link proposals automatically
+
+# File uplink and downlink - Must match flight software
+# Flight Software References:
+# - Packet layouts and result codes: src/tasks/ftp/ftp_task.h
+# - Sizes: src/common/config.h
+FTP_DATA_PAYLOAD_SIZE = 205  # src/common/config.h:FTP_DATA_PAYLOAD_SIZE
+FTP_NUM_PACKETS_PER_CYCLE = 32  # src/common/config.h:FTP_NUM_PACKETS_PER_CYCLE
+FTP_STATUS_REPORT_INTERVAL_S = 5  # src/tasks/ftp/ftp_task.h:FTP_STATUS_REPORT_INTERVAL_MS
+FTP_FLAG_READ_DATA = 0x04  # src/tasks/ftp/ftp_task.h:FTP_FLAG_READ_DATA
+FTP_FLAG_READ_POLL = 0x08  # src/tasks/ftp/ftp_task.h:FTP_FLAG_READ_POLL
+FTP_READ_WINDOW = 32  # src/tasks/ftp/ftp_task.h:FTP_READ_WINDOW
+FTP_READ_FEC = 0x01  # src/tasks/ftp/ftp_task.h:FTP_READ_FEC
+FTP_READ_TIMEOUT_S = 60  # src/tasks/ftp/ftp_task.h:FTP_READ_TIMEOUT_MS
+FTP_LIST_DEEP_VERIFY = 0x01  # src/tasks/ftp/ftp_task.h:FTP_LIST_DEEP_VERIFY
+FTP_LIST_PAGE_FILES = 12  # src/tasks/ftp/ftp_task.h:FTP_LIST_PAGE_FILES
+
+# Downlink FEC - Must match flight software
+# Flight Software References: src/packet/packet_fec.h
+# Frames with a bad LoRa CRC only reach the decoder with "crc" set to False.
+PACKET_FLAG_FEC = 0x80  # src/packet/packet_fec.h:PACKET_FLAG_FEC
 
 # Packet filtering configuration
 # These filters help reject noisy packets not from the satellite
@@ -58,4 +108,6 @@ config = {
     "expected_callsign": EXPECTED_CALLSIGN,
     "enable_rssi_filter": ENABLE_RSSI_FILTER,
     "enable_callsign_filter": ENABLE_CALLSIGN_FILTER,
+    # Link adaptation
+    "auto_link_adapt": AUTO_LINK_ADAPT,
 }
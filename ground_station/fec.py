@@ -0,0 +1,178 @@
+"""Reed-Solomon FEC for downlink frames.
+
+Port of the RS(255,223) codec the flight software uses for frames flagged
+PACKET_FLAG_FEC (src/packet/packet_fec.h, payload/ssdv/rs8.c): CCSDS field and
+generator, shortened to the frame's length. The 32 parity bytes follow the
+data and cover what radio.receive() returns, [len][data], so up to 16
+corrupted bytes anywhere in it can be corrected.
+
+Pure Python so it also runs on CircuitPython.
+"""
+
+NN = 255
+NROOTS = 32
+FCR = 112
+PRIM = 11
+IPRIM = 116
+A0 = NN  # Index form of zero
+
+PARITY_SIZE = NROOTS
+MAX_FRAME = NN - NROOTS
+
+
+def _build_tables():
+    alpha_to = [0] * (NN + 1)
+    index_of = [0] * (NN + 1)
+    sr = 1
+    for i in range(NN):
+        alpha_to[i] = sr
+        index_of[sr] = i
+        sr <<= 1
+        if sr & 0x100:
+            sr ^= 0x187
+    alpha_to[NN] = 0
+    index_of[0] = A0
+
+    genpoly = [1] + [0] * NROOTS
+    root = FCR * PRIM
+    for i in range(NROOTS):
+        genpoly[i + 1] = 1
+        for j in range(i, 0, -1):
+            if genpoly[j] != 0:
+                genpoly[j] = genpoly[j - 1] ^ alpha_to[(index_of[genpoly[j]] + root) % NN]
+            else:
+                genpoly[j] = genpoly[j - 1]
+        genpoly[0] = alpha_to[(index_of[genpoly[0]] + root) % NN]
+        root += PRIM
+    genpoly = [index_of[g] for g in genpoly]
+    return alpha_to, index_of, genpoly
+
+
+ALPHA_TO, INDEX_OF, GENPOLY = _build_tables()
+
+
+def encode(frame):
+    """Return the parity for a [len][data] frame of at most MAX_FRAME bytes."""
+    if len(frame) > MAX_FRAME:
+        raise ValueError("Frame too long for FEC: %d bytes" % len(frame))
+
+    parity = [0] * NROOTS
+    for byte in frame:
+        feedback = INDEX_OF[byte ^ parity[0]]
+        if feedback != A0:
+            for j in range(1, NROOTS):
+                parity[j] ^= ALPHA_TO[(feedback + GENPOLY[NROOTS - j]) % NN]
+        parity = parity[1:]
+        if feedback != A0:
+            parity.append(ALPHA_TO[(feedback + GENPOLY[0]) % NN])
+        else:
+            parity.append(0)
+    return bytes(parity)
+
+
+def decode(codeword):
+    """Correct a [len][data] frame followed by its parity.
+
+    Returns (frame, corrected) with the parity stripped and the number of
+    bytes corrected, or (None, -1) if there are too many errors.
+    """
+    n = len(codeword)
+    if n <= NROOTS or n > NN:
+        return None, -1
+    pad = NN - n
+    data = bytearray(codeword)
+
+    # Syndromes: the codeword evaluated at the roots of the generator
+    s = [data[0]] * NROOTS
+    for j in range(1, n):
+        for i in range(NROOTS):
+            if s[i] == 0:
+                s[i] = data[j]
+            else:
+                s[i] = data[j] ^ ALPHA_TO[(INDEX_OF[s[i]] + (FCR + i) * PRIM) % NN]
+
+    if not any(s):
+        return bytes(data[:-NROOTS]), 0
+    s = [INDEX_OF[x] for x in s]
+
+    # Berlekamp-Massey for the error locator polynomial
+    lam = [1] + [0] * NROOTS
+    b = [INDEX_OF[x] for x in lam]
+    el = 0
+    for r in range(1, NROOTS + 1):
+        discr = 0
+        for i in range(r):
+            if lam[i] != 0 and s[r - i - 1] != A0:
+                discr ^= ALPHA_TO[(INDEX_OF[lam[i]] + s[r - i - 1]) % NN]
+        discr = INDEX_OF[discr]
+        if discr == A0:
+            b = [A0] + b[:NROOTS]
+            continue
+
+        t = [lam[0]] + [0] * NROOTS
+        for i in range(NROOTS):
+            if b[i] != A0:
+                t[i + 1] = lam[i + 1] ^ ALPHA_TO[(discr + b[i]) % NN]
+            else:
+                t[i + 1] = lam[i + 1]
+        if 2 * el <= r - 1:
+            el = r - el
+            b = [A0 if x == 0 else (INDEX_OF[x] - discr + NN) % NN for x in lam]
+        else:
+            b = [A0] + b[:NROOTS]
+        lam = t
+
+    lam = [INDEX_OF[x] for x in lam]
+    deg_lambda = 0
+    for i in range(NROOTS + 1):
+        if lam[i] != A0:
+            deg_lambda = i
+
+    # Chien search for its roots, which locate the errors
+    reg = list(lam)
+    roots = []
+    locs = []
+    k = IPRIM - 1
+    for i in range(1, NN + 1):
+        q = 1
+        for j in range(deg_lambda, 0, -1):
+            if reg[j] != A0:
+                reg[j] = (reg[j] + j) % NN
+                q ^= ALPHA_TO[reg[j]]
+        if q == 0:
+            roots.append(i)
+            locs.append(k)
+            if len(roots) == deg_lambda:
+                break
+        k = (k + IPRIM) % NN
+
+    # An error in the padding means the locator is wrong
+    if len(roots) != deg_lambda or any(loc < pad for loc in locs):
+        return None, -1
+
+    # Forney: error values from the evaluator polynomial
+    deg_omega = deg_lambda - 1
+    omega = []
+    for i in range(deg_omega + 1):
+        tmp = 0
+        for j in range(i, -1, -1):
+            if s[i - j] != A0 and lam[j] != A0:
+                tmp ^= ALPHA_TO[(s[i - j] + lam[j]) % NN]
+        omega.append(INDEX_OF[tmp])
+
+    for root, loc in zip(roots, locs):
+        num1 = 0
+        for i in range(deg_omega, -1, -1):
+            if omega[i] != A0:
+                num1 ^= ALPHA_TO[(omega[i] + i * root) % NN]
+        num2 = ALPHA_TO[(root * (FCR - 1) + NN) % NN]
+        den = 0
+        for i in range(min(deg_lambda, NROOTS - 1) & ~1, -1, -2):
+            if lam[i + 1] != A0:
+                den ^= ALPHA_TO[(lam[i + 1] + i * root) % NN]
+        if num1 != 0:
+            data[loc - pad] ^= ALPHA_TO[
+                (INDEX_OF[num1] + INDEX_OF[num2] + NN - INDEX_OF[den]) % NN
+            ]
+
+    return bytes(data[:-NROOTS]), len(roots)
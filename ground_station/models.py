@@ -156,6 +156,16 @@ class BeaconStats(_BaseModel):
         panel_B_voltage: int = Field(default=0, description="mV")
         panel_B_current: int = Field(default=0, description="mA")
         device_status: int = 0
+        idle_percent: int = Field(default=0, description="%")
+        # Uplink frames the satellite heard most recently
+        link_samples: int = 0
+        link_crc_errors: int = 0
+        link_rssi_avg: int = Field(default=0, description="dBm")
+        link_rssi_min: int = Field(default=0, description="dBm")
+        link_snr_avg: float = Field(default=0.0, description="dB")
+        link_snr_min: float = Field(default=0.0, description="dB")
+        link_freq_error: int = Field(default=0, description="Hz")
+        link_age_s: int = Field(default=0, description="s")
     else:
 
         def __init__(
@@ -177,6 +187,15 @@ class BeaconStats(_BaseModel):
             panel_B_voltage=0,
             panel_B_current=0,
             device_status=0,
+            idle_percent=0,
+            link_samples=0,
+            link_crc_errors=0,
+            link_rssi_avg=0,
+            link_rssi_min=0,
+            link_snr_avg=0.0,
+            link_snr_min=0.0,
+            link_freq_error=0,
+            link_age_s=0,
             **kwargs,
         ):
             self.reboot_counter = reboot_counter
@@ -196,6 +215,15 @@ class BeaconStats(_BaseModel):
             self.panel_B_voltage = panel_B_voltage  # mV
             self.panel_B_current = panel_B_current  # mA
             self.device_status = device_status
+            self.idle_percent = idle_percent  # %
+            self.link_samples = link_samples
+            self.link_crc_errors = link_crc_errors
+            self.link_rssi_avg = link_rssi_avg  # dBm
+            self.link_rssi_min = link_rssi_min  # dBm
+            self.link_snr_avg = link_snr_avg  # dB
+            self.link_snr_min = link_snr_min  # dB
+            self.link_freq_error = link_freq_error  # Hz
+            self.link_age_s = link_age_s  # s
 
     @property
     def device_status_flags(self) -> List[str]:
@@ -241,6 +269,77 @@ class BeaconData(_BaseModel):
             self.raw_hex = raw_hex
 
 
+class TaskProfile(_BaseModel):
+    """Execution time profile for one flight software task"""
+
+    if USE_PYDANTIC:
+        task_index: int = 0
+        num_tasks: int = 0
+        name: str = ""
+        num_dispatches: int = 0
+        min_us: int = 0
+        max_us: int = 0
+        mean_us: int = 0
+        mean_lateness_us: int = 0
+        max_lateness_us: int = 0
+        max_jitter_us: int = 0
+        num_skipped: int = 0
+        num_overruns: int = 0
+        num_over_budget: int = 0
+        histogram: List[int] = Field(default_factory=list)
+    else:
+
+        def __init__(
+            self,
+            task_index=0,
+            num_tasks=0,
+            name="",
+            num_dispatches=0,
+            min_us=0,
+            max_us=0,
+            mean_us=0,
+            mean_lateness_us=0,
+            max_lateness_us=0,
+            max_jitter_us=0,
+            num_skipped=0,
+            num_overruns=0,
+            num_over_budget=0,
+            histogram=None,
+            **kwargs,
+        ):
+            self.task_index = task_index
+            self.num_tasks = num_tasks
+            self.name = name
+            self.num_dispatches = num_dispatches
+            self.min_us = min_us
+            self.max_us = max_us
+            self.mean_us = mean_us
+            self.mean_lateness_us = mean_lateness_us
+            self.max_lateness_us = max_lateness_us
+            self.max_jitter_us = max_jitter_us
+            self.num_skipped = num_skipped
+            self.num_overruns = num_overruns
+            self.num_over_budget = num_over_budget
+            self.histogram = histogram if histogram else []
+
+
+class LinkReport(_BaseModel):
+    """Link adaptation proposal or acknowledgement from the satellite"""
+
+    if USE_PYDANTIC:
+        current: int = 0
+        next: int = 0
+        snr_avg_db: float = 0.0
+        rssi_dbm: int = 0
+    else:
+
+        def __init__(self, current=0, next=0, snr_avg_db=0.0, rssi_dbm=0, **kwargs):
+            self.current = current
+            self.next = next
+            self.snr_avg_db = snr_avg_db
+            self.rssi_dbm = rssi_dbm
+
+
 class Packet(_BaseModel):
     """Base class for all satellite communication packets.
 
@@ -7,7 +7,15 @@ except ImportError:
     pass
 
 import config
-from models import ADCSData, ADCSQuaternion, ADCSVector3, BeaconData, BeaconStats
+from models import (
+    ADCSData,
+    ADCSQuaternion,
+    ADCSVector3,
+    BeaconData,
+    BeaconStats,
+    LinkReport,
+    TaskProfile,
+)
 from models import Packet as ModelPacket
 from state import state_manager
 
@@ -27,6 +35,20 @@ else:
 ADCS_PACKET_FORMAT = "<18fBL"
 ADCS_PACKET_SIZE = struct.calcsize(ADCS_PACKET_FORMAT)  # 77 bytes
 
+# Must match beacon_stats in src/tasks/beacon/beacon_task.c
+# (the trailing fields are link_stats_summary_t, src/tasks/radio/link_stats.h)
+BEACON_STATS_FORMAT = "<LQ6L8HBB" "BBhhbbiH"
+BEACON_STATS_SIZE = struct.calcsize(BEACON_STATS_FORMAT)  # 68 bytes
+
+# Must match sched_profile_packet_t in src/scheduler/sched_profile.h
+TASK_PROFILE_NUM_BUCKETS = 24
+TASK_PROFILE_FORMAT = "<BB16s10L%dH" % TASK_PROFILE_NUM_BUCKETS
+TASK_PROFILE_SIZE = struct.calcsize(TASK_PROFILE_FORMAT)  # 106 bytes
+
+# Layout of link_report_t (src/tasks/radio/link_adapt.h). Keep in sync!
+LINK_REPORT_FORMAT = "<BBhh"
+LINK_REPORT_SIZE = struct.calcsize(LINK_REPORT_FORMAT)  # 6 bytes
+
 
 def create_cmd_payload(cmd_id, cmd_payload=""):
     if isinstance(cmd_payload, str):
@@ -121,10 +143,10 @@ class BeaconPacket(Packet):
 
         beacon_data = BeaconData(state_name=state_name, raw_hex=raw_hex)
 
-        # 1. Decode Stats (53 bytes)
-        if len(payload) >= stats_start + 53:
-            stats_data = payload[stats_start : stats_start + 53]
-            unpacked = struct.unpack("<LQ6L8HB", stats_data)
+        # 1. Decode Stats (68 bytes)
+        if len(payload) >= stats_start + BEACON_STATS_SIZE:
+            stats_data = payload[stats_start : stats_start + BEACON_STATS_SIZE]
+            unpacked = struct.unpack(BEACON_STATS_FORMAT, stats_data)
             beacon_data.stats = BeaconStats(
                 reboot_counter=unpacked[0],
                 time_in_state_ms=unpacked[1],
@@ -143,10 +165,19 @@ class BeaconPacket(Packet):
                 panel_B_voltage=unpacked[14],
                 panel_B_current=unpacked[15],
                 device_status=unpacked[16],
+                idle_percent=unpacked[17],
+                link_samples=unpacked[18],
+                link_crc_errors=unpacked[19],
+                link_rssi_avg=unpacked[20],
+                link_rssi_min=unpacked[21],
+                link_snr_avg=unpacked[22] / 4,
+                link_snr_min=unpacked[23] / 4,
+                link_freq_error=unpacked[24],
+                link_age_s=unpacked[25],
             )
 
             # 2. Decode ADCS if present (appended after stats)
-            adcs_start = stats_start + 53
+            adcs_start = stats_start + BEACON_STATS_SIZE
             if len(payload) >= adcs_start + ADCS_PACKET_SIZE:
                 beacon_data.adcs = AdcsTelemetryPacket.decode_payload(
                     payload[adcs_start : adcs_start + ADCS_PACKET_SIZE]
@@ -194,6 +225,50 @@ class AdcsTelemetryPacket(Packet):
             return None
 
 
+class TaskProfilePacket(Packet):
+    """Response to a TASK_PROFILE command."""
+
+    @staticmethod
+    def decode_payload(data: bytes) -> Optional[TaskProfile]:
+        if len(data) < TASK_PROFILE_SIZE:
+            return None
+        unpacked = struct.unpack(TASK_PROFILE_FORMAT, data[:TASK_PROFILE_SIZE])
+        return TaskProfile(
+            task_index=unpacked[0],
+            num_tasks=unpacked[1],
+            name=unpacked[2].split(b"\x00", 1)[0].decode("utf-8", "ignore"),
+            num_dispatches=unpacked[3],
+            min_us=unpacked[4],
+            max_us=unpacked[5],
+            mean_us=unpacked[6],
+            mean_lateness_us=unpacked[7],
+            max_lateness_us=unpacked[8],
+            max_jitter_us=unpacked[9],
+            num_skipped=unpacked[10],
+            num_overruns=unpacked[11],
+            num_over_budget=unpacked[12],
+            histogram=list(unpacked[13:]),
+        )
+
+
+class LinkReportPacket(Packet):
+    """Link adaptation frame, flagged LINK_FLAG_PROPOSE or LINK_FLAG_ACK."""
+
+    @staticmethod
+    def decode_payload(data: bytes) -> Optional[LinkReport]:
+        if len(data) < LINK_REPORT_SIZE:
+            return None
+        current, next_profile, snr_avg_q4, rssi_dbm = struct.unpack(
+            LINK_REPORT_FORMAT, data[:LINK_REPORT_SIZE]
+        )
+        return LinkReport(
+            current=current,
+            next=next_profile,
+            snr_avg_db=snr_avg_q4 / 4.0,
+            rssi_dbm=rssi_dbm,
+        )
+
+
 # Backward compatibility wrappers
 def decode_beacon_data(data):
     return BeaconPacket.decode(data)
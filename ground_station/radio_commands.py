@@ -1,4 +1,7 @@
+import time
+
 import config
+import fec
 import protocol
 import radio_initialization as hardware
 from logger import logger, telemetry_logger
@@ -13,6 +16,10 @@ class LoraRadio:
 
     def __init__(self, rfm9x_instance):
         self.radio = rfm9x_instance
+        self.link_profile = config.LINK_PROFILE_DEFAULT
+        self.last_rx = time.monotonic()
+        self.fec_corrected = 0  # Frames saved by FEC
+        self.fec_failures = 0
 
     def try_get_packet(self, timeout=0.1):
         """Check for incoming packets with short timeout.
@@ -23,8 +30,11 @@ class LoraRadio:
         if self.radio is None:
             return None
 
+        self.check_link_fallback()
+
         packet = self.radio.receive(timeout=timeout)
         if packet is not None:
+            self.last_rx = time.monotonic()
             try:
                 # Get RadioHead header fields
                 rh_destination = getattr(self.radio, "destination", None)
@@ -56,6 +66,24 @@ class LoraRadio:
                         )
                         return None
 
+                # Repair FEC frames before anything looks inside. A corrupted
+                # length byte can hide the flag's meaning, so any frame longer
+                # than its length byte says is tried too.
+                fec_flagged = isinstance(rh_identifier, int) and (
+                    rh_identifier & config.PACKET_FLAG_FEC
+                )
+                if fec_flagged or (len(packet) > fec.PARITY_SIZE and len(packet) != 1 + packet[0]):
+                    packet = self.correct_fec(packet)
+                    if packet is None:
+                        return None
+
+                # Link adaptation frames carry LINK_FLAG_* in the samwise flags
+                # byte, which arrives as the RadioHead identifier
+                link_flags = config.LINK_FLAG_PROPOSE | config.LINK_FLAG_ACK
+                if isinstance(rh_identifier, int) and rh_identifier & link_flags:
+                    self.handle_link_report(rh_identifier, packet)
+                    return None
+
                 # All received packets are from the satellite.
                 # Note: radio.node after receive() is the TO field (not FROM) of the
                 # RadioHead header — broadcast beacons (TO=0xFF) give rh_node=0xFF,
@@ -94,7 +122,7 @@ class LoraRadio:
                                 " (payload may be truncated, expected ≥%d content bytes)"
                                 " | raw: %s",
                                 beacon_data.state_name,
-                                len(beacon_data.state_name) + 1 + 53,
+                                len(beacon_data.state_name) + 1 + protocol.BEACON_STATS_SIZE,
                                 packet.hex(),
                             )
                         else:
@@ -173,6 +201,70 @@ class LoraRadio:
 
         logger.info("COMMAND SENT | ID: %d | Payload: %s", cmd_id, cmd_payload)
 
+    def correct_fec(self, packet):
+        """Apply and strip the Reed-Solomon parity of a PACKET_FLAG_FEC frame.
+
+        Returns the corrected [len][data], or None if it is beyond repair.
+        """
+        frame, corrected = fec.decode(bytes(packet))
+        if frame is None:
+            self.fec_failures += 1
+            logger.warning("PACKET DROPPED | FEC could not correct frame | raw: %s", packet.hex())
+            return None
+        if corrected:
+            self.fec_corrected += 1
+            logger.info("FEC | Corrected %d bytes", corrected)
+        return frame
+
+    # --- Link adaptation ---
+
+    def set_link_profile(self, profile):
+        """Switch the local radio to one of config.LINK_PROFILES"""
+        sf, bw, cr = config.LINK_PROFILES[profile]
+        self.link_profile = profile
+        if self.radio is None:
+            return
+        self.radio.spreading_factor = sf
+        self.radio.signal_bandwidth = bw
+        self.radio.coding_rate = cr
+        # Mandated once a symbol lasts over 16 ms, as on the satellite
+        self.radio.low_datarate_optimize = (1 << sf) * 1000 / bw > 16
+        logger.info("LINK PROFILE | %d: SF%d, %d Hz, 4/%d", profile, sf, bw, cr)
+
+    def check_link_fallback(self):
+        """Return to the default profile after LINK_FALLBACK_S of silence,
+        as the satellite does"""
+        if (
+            self.link_profile != config.LINK_PROFILE_DEFAULT
+            and time.monotonic() - self.last_rx > config.LINK_FALLBACK_S
+        ):
+            logger.warning("LINK FALLBACK | No packets for %d s", config.LINK_FALLBACK_S)
+            self.set_link_profile(config.LINK_PROFILE_DEFAULT)
+
+    def handle_link_report(self, flags, packet):
+        """Handle a link proposal or acknowledgement from the satellite"""
+        if len(packet) < 1:
+            return
+        report = protocol.LinkReportPacket.decode_payload(bytes(packet[1 : 1 + packet[0]]))
+        if report is None or report.next >= len(config.LINK_PROFILES):
+            logger.error("LINK DECODE ERROR | raw: %s", bytes(packet).hex())
+            return
+
+        logger.info(
+            "LINK %s | %d -> %d | SNR %.2f dB | RSSI %d dBm",
+            "ACK" if flags & config.LINK_FLAG_ACK else "PROPOSE",
+            report.current,
+            report.next,
+            report.snr_avg_db,
+            report.rssi_dbm,
+        )
+
+        if flags & config.LINK_FLAG_ACK:
+            # The satellite switches right after sending this
+            self.set_link_profile(report.next)
+        elif config.config.get("auto_link_adapt", False):
+            self.send_link_switch(report.next)
+
     # --- High-level command abstractions ---
 
     def send_no_op(self):
@@ -203,6 +295,15 @@ class LoraRadio:
         """Send single command byte to adcs"""
         self.send_command(config.ADCS_EXEC, command_byte)
 
+    def send_task_profile(self, task_index, reset=False):
+        """Request the execution time profile of one task (optionally clearing it)"""
+        self.send_command(config.TASK_PROFILE, bytes([task_index, 1 if reset else 0]))
+
+    def send_link_switch(self, profile):
+        """Ask the satellite to switch link profile. Both ends switch once it
+        acknowledges"""
+        self.send_command(config.LINK_SWITCH, bytes([profile]))
+
 
 # Singleton management handled during initialization
 radio = None
@@ -129,6 +129,8 @@ def test_beacon_decode():
     # uint16_t panel_B_voltage_mv;
     # uint16_t panel_B_current_ma;
     # uint8_t device_status;
+    # uint8_t idle_percent;
+    # link_stats_summary_t link;
 
     # Load beacon packet hex from test data generated by //src/tasks/beacon:beacon_test
     # To regenerate: ./scripts/update_beacon_test_data.sh
@@ -144,6 +146,12 @@ def test_beacon_decode():
     assert result.state_name == "mock_state beat cal!"
     assert result.stats.reboot_counter == 42
     assert result.stats.battery_voltage == 4000
+    assert result.stats.idle_percent == 87
+    assert result.stats.link_samples == 1
+    assert result.stats.link_crc_errors == 0
+    assert result.stats.link_rssi_avg == -105
+    assert result.stats.link_snr_min == -1.5
+    assert result.stats.link_freq_error == -1500
     assert result.callsign == "KC3WNY"
 
 
@@ -273,17 +281,17 @@ def test_command_packet_payload_exec_structure(test_state):
 # Wire format (after adafruit_rfm9x strips the 4-byte RadioHead header):
 #
 #   [byte 0]        data_len  — number of bytes that follow (= len of beacon content)
-#   [bytes 1..]     beacon content: state_name\0 | stats (53 B) | ADCS (25 B) | callsign (7 B)
+#   [bytes 1..]     beacon content: state_name\0 | stats (68 B) | ADCS (25 B) | callsign (7 B)
 #
 # The RadioHead fields (to/from/id/flags) are NOT in these bytes — the library
 # exposes them as radio.destination / radio.node / radio.identifier / radio.flags.
 #
 # decode_beacon_data() expects exactly this layout: [data_len][content].
 
-# 148 bytes of beacon content (state_name + stats + ADCS + callsign, no length prefix).
+# 163 bytes of beacon content (state_name + stats + ADCS + callsign, no length prefix).
 _EXAMPLE_BEACON_CONTENT = bytes.fromhex(
     "6d6f636b5f737461746500"  # state_name = "mock_state\0"
-    # ---- beacon stats (53 bytes, struct <LQ6L8HB) ----
+    # ---- beacon stats (68 bytes, struct <LQ6L8HBBBBhhbbiH) ----
     "00000000"  # reboot_counter    = 0
     "3930000000000000"  # time_in_state_ms  = 12345
     "00000000"  # rx_bytes          = 0
@@ -301,6 +309,15 @@ _EXAMPLE_BEACON_CONTENT = bytes.fromhex(
     "0000"  # panel_B_voltage   = 0 mV
     "0000"  # panel_B_current   = 0 mA
     "00"  # device_status     = 0x00
+    "00"  # idle_percent      = 0
+    "00"  # link_samples      = 0
+    "00"  # link_crc_errors   = 0
+    "0000"  # link_rssi_avg     = 0 dBm
+    "0000"  # link_rssi_min     = 0 dBm
+    "00"  # link_snr_avg      = 0
+    "00"  # link_snr_min      = 0
+    "00000000"  # link_freq_error   = 0 Hz
+    "0000"  # link_age_s        = 0 s
     # ---- ADCS telemetry (77 bytes, struct <18fBL) ----
     "0000803f"  # angular_velocity  = 1.0 rad/s
     "cdcccc3d"  # q0               ≈ 0.1
@@ -430,5 +447,108 @@ def test_decode_example_incoming_packet():
     assert beacon.callsign == "KC3WNY"
 
 
+@pytest.mark.unit
+@pytest.mark.protocol
+def test_decode_task_profile():
+    """Task profile responses decode per sched_profile_packet_t"""
+    histogram = [0] * protocol.TASK_PROFILE_NUM_BUCKETS
+    histogram[5] = 3
+    histogram[17] = 1
+    data = struct.pack(
+        protocol.TASK_PROFILE_FORMAT,
+        2,
+        9,
+        b"telemetry",
+        4,
+        20,
+        70000,
+        17515,
+        12,
+        300,
+        290,
+        1,
+        2,
+        3,
+        *histogram,
+    )
+    assert len(data) == 106
+
+    profile = protocol.TaskProfilePacket.decode_payload(data)
+
+    assert profile.task_index == 2
+    assert profile.num_tasks == 9
+    assert profile.name == "telemetry"
+    assert profile.num_dispatches == 4
+    assert profile.min_us == 20
+    assert profile.max_us == 70000
+    assert profile.mean_us == 17515
+    assert profile.mean_lateness_us == 12
+    assert profile.max_lateness_us == 300
+    assert profile.max_jitter_us == 290
+    assert profile.num_skipped == 1
+    assert profile.num_overruns == 2
+    assert profile.num_over_budget == 3
+    assert profile.histogram == histogram
+    assert protocol.TaskProfilePacket.decode_payload(data[:-1]) is None
+
+
+@pytest.mark.unit
+@pytest.mark.protocol
+def test_decode_link_report():
+    """Link frames decode per link_report_t"""
+    data = struct.pack(protocol.LINK_REPORT_FORMAT, 3, 4, -22, -97)
+    assert len(data) == 6
+
+    report = protocol.LinkReportPacket.decode_payload(data)
+
+    assert report.current == 3
+    assert report.next == 4
+    assert report.snr_avg_db == -5.5
+    assert report.rssi_dbm == -97
+    assert protocol.LinkReportPacket.decode_payload(data[:-1]) is None
+
+
+# Parity from the flight software's encoder (src/packet/test/packet_fec_test.c)
+# for the frame [len=7]["samwise"]
+_FEC_EXAMPLE_FRAME = b"\x07samwise"
+_FEC_EXAMPLE_PARITY = bytes.fromhex(
+    "62d1a4d985810e2665e87c63cae18e5f6e625c25b2b0b49d29fa3b44b3bfeaa5"
+)
+
+
+@pytest.mark.unit
+@pytest.mark.protocol
+def test_fec_matches_flight_encoder():
+    """Parity is bit-for-bit what the satellite computes"""
+    from ground_station import fec
+
+    assert fec.encode(_FEC_EXAMPLE_FRAME) == _FEC_EXAMPLE_PARITY
+    assert fec.decode(_FEC_EXAMPLE_FRAME + _FEC_EXAMPLE_PARITY) == (_FEC_EXAMPLE_FRAME, 0)
+
+
+@pytest.mark.unit
+@pytest.mark.protocol
+def test_fec_corrects_up_to_16_bytes():
+    """Up to 16 corrupted bytes anywhere are corrected; more are reported"""
+    from ground_station import fec
+
+    frame = bytes([_EXAMPLE_RAW_BEACON[0]]) + _EXAMPLE_BEACON_CONTENT
+    codeword = frame + fec.encode(frame)
+
+    for errors in (1, 8, 16):
+        corrupted = bytearray(codeword)
+        for i in range(errors):
+            corrupted[(i * 11) % len(codeword)] ^= 0xA5
+        assert fec.decode(bytes(corrupted)) == (frame, errors)
+
+    corrupted = bytearray(codeword)
+    for i in range(17):
+        corrupted[i * 2] ^= 0xFF
+    assert fec.decode(bytes(corrupted)) == (None, -1)
+
+    with pytest.raises(ValueError):
+        fec.encode(bytes(fec.MAX_FRAME + 1))
+
+
 if __name__ == "__main__":
     pytest.main([__file__, "-v", "-s"])
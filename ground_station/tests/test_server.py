@@ -348,3 +348,107 @@ def test_try_get_packet_returns_beacon_data_on_success():
     assert result.state_name == "nominal"
     assert result.stats is not None
     assert result.stats.reboot_counter == 5
+
+
+@pytest.mark.unit
+@pytest.mark.server
+def test_try_get_packet_corrects_fec_beacon():
+    """A beacon with FEC parity decodes despite corrupted bytes."""
+    import struct
+
+    import config as cfg
+    import fec
+
+    state = b"nominal\x00"
+    stats = struct.pack(
+        "<LQ6L8HB", 7, 9000, 0, 0, 0, 0, 0, 0, 3800, 60, 5100, 110, 3300, 25, 3300, 25, 0
+    )
+    payload = state + stats + b"KC3WNY"
+    frame = bytes([len(payload)]) + payload
+    corrupted = bytearray(frame + fec.encode(frame))
+    # The length byte too, so only the flag marks it
+    for i in range(0, 40, 4):
+        corrupted[i] ^= 0x3C
+
+    mock_rfm = MagicMock()
+    mock_rfm.receive.return_value = bytes(corrupted)
+    mock_rfm.identifier = cfg.PACKET_FLAG_FEC
+    mock_rfm.last_rssi = -118
+    mock_rfm.last_snr = -9
+
+    radio = LoraRadio(mock_rfm)
+    original = dict(cfg.config)
+    cfg.config["enable_rssi_filter"] = False
+    cfg.config["enable_callsign_filter"] = False
+    try:
+        result = radio.try_get_packet(timeout=0.0)
+    finally:
+        cfg.config.update(original)
+
+    assert isinstance(result, BeaconData)
+    assert result.stats.reboot_counter == 7
+    assert radio.fec_corrected == 1
+
+    # Beyond repair: dropped, not misread
+    for i in range(1, 40, 2):
+        corrupted[i] ^= 0x55
+    mock_rfm.receive.return_value = bytes(corrupted)
+    assert radio.try_get_packet(timeout=0.0) is None
+    assert radio.fec_failures == 1
+
+
+# ---------------------------------------------------------------------------
+# radio_commands link adaptation handshake
+# ---------------------------------------------------------------------------
+
+
+def _link_frame(flags, current, next_profile):
+    import struct
+
+    import config as cfg
+
+    mock_rfm = MagicMock()
+    report = struct.pack("<BBhh", current, next_profile, 40, -90)
+    mock_rfm.receive.return_value = bytes([len(report)]) + report
+    mock_rfm.identifier = flags
+    mock_rfm.last_rssi = -90
+    mock_rfm.last_snr = 10
+    return mock_rfm, cfg
+
+
+@pytest.mark.unit
+@pytest.mark.server
+def test_link_proposal_is_accepted():
+    """A proposal is answered with LINK_SWITCH; the profile changes only on ACK."""
+    mock_rfm, cfg = _link_frame(0x01, 3, 4)
+    radio = LoraRadio(mock_rfm)
+    radio.send_link_switch = MagicMock()
+
+    assert radio.try_get_packet(timeout=0.0) is None
+    radio.send_link_switch.assert_called_once_with(4)
+    assert radio.link_profile == cfg.LINK_PROFILE_DEFAULT
+
+    mock_rfm.identifier = 0x02
+    assert radio.try_get_packet(timeout=0.0) is None
+    assert radio.link_profile == 4
+    assert mock_rfm.spreading_factor == 7
+    assert mock_rfm.signal_bandwidth == 250000
+    assert mock_rfm.low_datarate_optimize is False
+
+
+@pytest.mark.unit
+@pytest.mark.server
+def test_link_falls_back_after_silence():
+    """With nothing heard for LINK_FALLBACK_S both ends return to the default."""
+    mock_rfm, cfg = _link_frame(0x02, 3, 0)
+    radio = LoraRadio(mock_rfm)
+    radio.try_get_packet(timeout=0.0)
+    assert radio.link_profile == 0
+    assert mock_rfm.spreading_factor == 10
+
+    mock_rfm.receive.return_value = None
+    radio.last_rx -= cfg.LINK_FALLBACK_S + 1
+    radio.try_get_packet(timeout=0.0)
+    assert radio.link_profile == cfg.LINK_PROFILE_DEFAULT
+    assert mock_rfm.spreading_factor == 7
+    assert mock_rfm.signal_bandwidth == 125000
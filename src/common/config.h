@@ -6,6 +6,63 @@
 #define I2C_TIMEOUT_MS 100
 #define MIN_WATCHDOG_INTERVAL_MS 200
 
+// A gap this long between watchdog_task dispatches is logged as a loop stall,
+// naming the slowest task, well before the hardware watchdog would bite
+#define WATCHDOG_STALL_MS 1000
+
+/**
+ * CRC32 (src/utils/crc32.c)
+ */
+// Bitwise needs no table. The table is 1 KiB and slicing-by-4/8 take 4/8 KiB,
+// and go faster in that order; see crc32_bench for the throughput of each.
+// Either can be given per profile in .bazelrc, e.g. --copt=-DCRC32_IMPL=1.
+#define CRC32_IMPL_BITWISE 0
+#define CRC32_IMPL_TABLE 1
+#define CRC32_IMPL_SLICE4 4
+#define CRC32_IMPL_SLICE8 8
+
+// Keep the table, and the loop that reads it, in SRAM rather than reading them
+// through the XIP cache, where they compete with the rest of the code
+#ifdef FLIGHT
+// A 4 KiB table in SRAM, so file CRCs neither wait on flash nor evict code
+#ifndef CRC32_IMPL
+#define CRC32_IMPL CRC32_IMPL_SLICE4
+#endif
+#ifndef CRC32_TABLE_IN_RAM
+#define CRC32_TABLE_IN_RAM 1
+#endif
+#else
+#ifndef CRC32_IMPL
+#define CRC32_IMPL CRC32_IMPL_SLICE8
+#endif
+#ifndef CRC32_TABLE_IN_RAM
+#define CRC32_TABLE_IN_RAM 0
+#endif
+#endif
+
+/**
+ * Scheduler configuration
+ */
+// Window over which the scheduler's idle percentage is computed
+#define SCHED_IDLE_WINDOW_MS 10000
+
+// Order in which sched_dispatch runs tasks that are ready at the same time.
+// Fixed priority compares sched_task_t.priority first and breaks ties by
+// deadline; EDF compares absolute deadlines first and breaks ties by priority.
+#define SCHED_POLICY_FIXED_PRIORITY 0
+#define SCHED_POLICY_EDF 1
+#ifndef SCHED_POLICY
+#define SCHED_POLICY SCHED_POLICY_FIXED_PRIORITY
+#endif
+
+// Execution budgets (sched_task_t.budget_ms). A task over budget this many
+// dispatches in a row is suspended for SCHED_BUDGET_SUSPEND_MS and the FSM
+// enters the safe state, returning to where it was after
+// SCHED_SAFE_STATE_DWELL_MS.
+#define SCHED_BUDGET_MAX_STRIKES 3
+#define SCHED_BUDGET_SUSPEND_MS (10 * 60 * 1000)
+#define SCHED_SAFE_STATE_DWELL_MS (5 * 60 * 1000)
+
 /**
  * MPPT (LT8491) configuration
  *
@@ -24,8 +81,13 @@
 /**
  * FTP Configuration
  */
-// The number of packets to require before moving on to the next n packets
-#define FTP_NUM_PACKETS_PER_CYCLE 5
+// The number of packets to require before moving on to the next n packets.
+// Each cycle ends with a round trip to the ground, so this also sets how much
+// of an upload's airtime goes to waiting (see src/tasks/ftp/README.md).
+#define FTP_NUM_PACKETS_PER_CYCLE 32
+
+// Bytes needed for one bit per packet of a cycle
+#define FTP_BITFIELD_SIZE ((FTP_NUM_PACKETS_PER_CYCLE + 7) / 8)
 
 // Automatically calculated size of maximum data payload in bytes per packet
 #define FTP_DATA_PAYLOAD_SIZE                                                  \
@@ -35,6 +97,11 @@
 // Type used to represent packet sequence IDs
 typedef uint16_t FTP_PACKET_SEQUENCE_T;
 
+// Largest file that packet sequence IDs can address
+#define FTP_MAX_FILE_LEN                                                       \
+    ((1UL << (sizeof(FTP_PACKET_SEQUENCE_T) * CHAR_BIT)) *                     \
+     FTP_DATA_PAYLOAD_SIZE)
+
 /**
  * Filesystem configuration
  */
@@ -73,6 +140,11 @@ _Static_assert(FILESYS_READ_BUFFER_SIZE <=
                "FILESYS_READ_BUFFER_SIZE_T must be able to hold "
                "FILESYS_READ_BUFFER_SIZE");
 
+// Whether completing a file write reads the whole file back from MRAM to check
+// its CRC, instead of trusting the CRC kept up as each buffer is committed.
+// Copied to slate filesys_verify_on_complete when the filesystem is mounted.
+#define FILESYS_VERIFY_ON_COMPLETE 0
+
 // Note: Only one file can be buffered at a time, so there is no configuration
 // for FILESYS_MAX_BUFFERED_FILES.
 
@@ -107,6 +179,11 @@ typedef uint32_t FILESYS_BUFFERED_FILE_CRC_T;
 // attribute IDs in the range [0, 255].
 #define FILESYS_CRC_ATTR 0
 
+// Attribute ID of the CRC a file was last computed to have, stamped with the
+// file's size and last block so that it is dropped once the file changes.
+// Listing files takes the CRC from it rather than reading each file through.
+#define FILESYS_VERIFIED_CRC_ATTR 1
+
 // MRAM: 256-byte blocks are fine (erase is a no-op).
 // Flash (hardware): block_size MUST be >= 4096 to match flash_range_erase
 //                   sector alignment on RP2350.
@@ -37,5 +37,8 @@ typedef struct
 
     // The current number of elements in the queue.
     unsigned int level;
+
+    // The highest level reached since queue_init (host builds only).
+    unsigned int max_level;
 } queue_t;
 #endif
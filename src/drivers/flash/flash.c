@@ -7,6 +7,8 @@
  */
 
 #include "flash.h"
+#include "logger.h"
+#include "xip_safe.h"
 
 /* See the partition file in: /ota_mvp/pt.json
  *   0x00079000 is the projected location of the shared DATA partition
@@ -15,6 +17,17 @@
  */
 #define FLASH_TARGET_OFFSET (0x00079000)
 #define INIT_MARKER 0xABCDABCD // Distinct marker to indicate initialized data
+#define REPLAY_MARKER 0x5A5A1234 // Mixed into replay_check
+
+// How long to wait for the other core to park before giving up on a write
+#define FLASH_SAFE_EXECUTE_TIMEOUT_MS 10
+
+// The replay fields were added after the first flights; data from before
+// then holds whatever followed the old struct
+static uint32_t replay_check(uint32_t boot_count, uint32_t reserved)
+{
+    return boot_count ^ reserved ^ REPLAY_MARKER;
+}
 
 // Read the persistent data from flash
 const persistent_data_t *read_persistent_data()
@@ -24,16 +37,27 @@ const persistent_data_t *read_persistent_data()
     return (const persistent_data_t *)flash_data_ptr;
 }
 
-// Write the persistent data to flash
-void write_persistent_data(persistent_data_t *data)
+static void write_persistent_data_cb(void *param)
 {
-    uint32_t ints = save_and_disable_interrupts();
-
     flash_range_erase(FLASH_TARGET_OFFSET, FLASH_SECTOR_SIZE);
 
-    flash_range_program(FLASH_TARGET_OFFSET, (uint8_t *)data, FLASH_PAGE_SIZE);
+    flash_range_program(FLASH_TARGET_OFFSET, (uint8_t *)param, FLASH_PAGE_SIZE);
+}
 
-    restore_interrupts(ints);
+// Write the persistent data to flash. xip_safe_execute disables interrupts
+// and, once the core1 executor is running, parks the other core in SRAM while
+// XIP is offline. The sector erase keeps interrupts (radio DIO0 and DMA
+// completion included) off for tens of ms.
+bool write_persistent_data(persistent_data_t *data)
+{
+    int rc = xip_safe_execute(write_persistent_data_cb, data,
+                              FLASH_SAFE_EXECUTE_TIMEOUT_MS);
+    if (rc != PICO_OK)
+    {
+        LOG_ERROR("[flash] Write failed: could not park other core (%d)", rc);
+        return false;
+    }
+    return true;
 }
 
 // Initialize the persistent data structure or load existing data
@@ -49,6 +73,9 @@ persistent_data_t *init_persistent_data()
         data.marker = INIT_MARKER;
         data.reboot_counter = 0;
         data.burn_wire_attempts = 0;
+        data.replay_boot_count = 0;
+        data.replay_reserved = 0;
+        data.replay_check = 0;
     }
     else
     {
@@ -56,17 +83,18 @@ persistent_data_t *init_persistent_data()
         data = *flash_data;
     }
 
-    write_persistent_data(&data);
+    if (!write_persistent_data(&data))
+        return NULL;
     return &data;
 }
 
-void increment_reboot_counter()
+bool increment_reboot_counter()
 {
     static persistent_data_t data;
     const persistent_data_t *flash_data = read_persistent_data();
     data = *flash_data;
     data.reboot_counter++;
-    write_persistent_data(&data);
+    return write_persistent_data(&data);
 }
 
 uint32_t get_reboot_counter()
@@ -98,3 +126,26 @@ void reset_burn_wire_attempts()
     data.burn_wire_attempts = 0;
     write_persistent_data(&data);
 }
+
+bool save_replay_reservation(uint32_t boot_count, uint32_t reserved)
+{
+    static persistent_data_t data;
+    const persistent_data_t *flash_data = read_persistent_data();
+    data = *flash_data;
+    data.replay_boot_count = boot_count;
+    data.replay_reserved = reserved;
+    data.replay_check = replay_check(boot_count, reserved);
+    return write_persistent_data(&data);
+}
+
+bool get_replay_reservation(uint32_t *boot_count, uint32_t *reserved)
+{
+    const persistent_data_t *flash_data = read_persistent_data();
+    if (flash_data->replay_check != replay_check(flash_data->replay_boot_count,
+                                                 flash_data->replay_reserved))
+        return false;
+
+    *boot_count = flash_data->replay_boot_count;
+    *reserved = flash_data->replay_reserved;
+    return true;
+}
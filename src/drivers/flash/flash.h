@@ -22,17 +22,42 @@ typedef struct
     uint32_t marker;             // Marker to verify initialization
     uint32_t reboot_counter;     // Actual counter
     uint32_t burn_wire_attempts; // Number of burn wire attempts
+
+    // Uplink msg_ids reserved by the replay window, see packet.h. Valid when
+    // replay_check matches.
+    uint32_t replay_boot_count;
+    uint32_t replay_reserved;
+    uint32_t replay_check;
 } persistent_data_t;
 
 /**
  * @brief Initialize persistent data structure, setting reboot counter to 1 if
  * uninitialized.
- * @return Pointer to the persistent data.
+ * @return Pointer to the persistent data, or NULL if it could not be written.
  */
 persistent_data_t *init_persistent_data(void);
 
-void increment_reboot_counter();
+/**
+ * @brief Count this boot in the persistent data.
+ * @return false if the flash could not be written.
+ */
+bool increment_reboot_counter();
 uint32_t get_reboot_counter();
 void increment_burn_wire_attempts();
 uint32_t get_burn_wire_attempts();
 void reset_burn_wire_attempts();
+
+/**
+ * @brief Persist the replay window reservation for boot_count.
+ *
+ * Erases and rewrites the persistent data sector, which stalls both cores and
+ * masks interrupts for tens of ms.
+ * @return false if the flash could not be written.
+ */
+bool save_replay_reservation(uint32_t boot_count, uint32_t reserved);
+
+/**
+ * @brief Read back the replay window reservation.
+ * @return false if none was ever saved.
+ */
+bool get_replay_reservation(uint32_t *boot_count, uint32_t *reserved);
@@ -16,9 +16,10 @@ persistent_data_t *init_persistent_data(void)
     return &mock_data;
 }
 
-void increment_reboot_counter()
+bool increment_reboot_counter()
 {
     mock_data.reboot_counter++;
+    return true;
 }
 
 uint32_t get_reboot_counter()
@@ -40,3 +41,23 @@ void reset_burn_wire_attempts()
 {
     mock_data.burn_wire_attempts = 0;
 }
+
+static bool mock_replay_saved = false;
+
+bool save_replay_reservation(uint32_t boot_count, uint32_t reserved)
+{
+    mock_data.replay_boot_count = boot_count;
+    mock_data.replay_reserved = reserved;
+    mock_replay_saved = true;
+    return true;
+}
+
+bool get_replay_reservation(uint32_t *boot_count, uint32_t *reserved)
+{
+    if (!mock_replay_saved)
+        return false;
+
+    *boot_count = mock_data.replay_boot_count;
+    *reserved = mock_data.replay_reserved;
+    return true;
+}
@@ -0,0 +1,25 @@
+/**
+ * @file xip_safe.c
+ * @brief See xip_safe.h.
+ */
+
+#include "xip_safe.h"
+#include "hardware/sync.h"
+#include "pico/flash.h"
+#include "pico/multicore.h"
+#include "pico/stdlib.h"
+
+int xip_safe_execute(void (*func)(void *), void *param, uint32_t timeout_ms)
+{
+    // sched_core1_init does not return until core1 is a lockout victim, so
+    // until then core1 has not been launched and cannot be running from XIP
+    if (!multicore_lockout_victim_is_initialized(get_core_num() ^ 1))
+    {
+        uint32_t irq_state = save_and_disable_interrupts();
+        func(param);
+        restore_interrupts(irq_state);
+        return PICO_OK;
+    }
+
+    return flash_safe_execute(func, param, timeout_ms);
+}
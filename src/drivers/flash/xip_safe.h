@@ -0,0 +1,24 @@
+/**
+ * @file xip_safe.h
+ * @brief Run code that takes XIP offline (flash erase/program, MRAM over QMI
+ * direct mode) without the other core fetching from flash meanwhile.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Run func(param) with interrupts disabled on this core and the other
+ * core kept off XIP.
+ *
+ * Once the core1 executor is up (see sched_core1_init) this is
+ * flash_safe_execute, which parks the other core in SRAM. Before core1 is
+ * launched there is nothing to park, and flash_safe_execute would refuse with
+ * PICO_ERROR_NOT_PERMITTED, so func runs with only this core's interrupts
+ * masked.
+ *
+ * @param timeout_ms How long to wait for the other core to park.
+ * @return PICO_OK, or the flash_safe_execute error if func was not run.
+ */
+int xip_safe_execute(void (*func)(void *), void *param, uint32_t timeout_ms);
@@ -1,5 +1,11 @@
 #include "logger.h"
 
+// log_message runs on both cores (and in IRQs). Each message goes out in a
+// single printf, which the SDK's stdout mutex keeps whole.
+#if !defined(TEST) && !PICO_STDOUT_MUTEX
+#error "The logger relies on PICO_STDOUT_MUTEX to serialise the two cores"
+#endif
+
 // Track enabled sinks using bitwise OR
 static uint8_t enabled_sinks =
     LOG_SINK_TEST | LOG_SINK_FLASH | LOG_SINK_DISK | LOG_SINK_USB;
@@ -9,6 +9,9 @@ const char *current_executing_task = NULL;
 // Visualization log file handle
 FILE *viz_log = NULL;
 
+// Set false to drop DEBUG/INFO output, e.g. for long simulations
+bool logger_mock_echo = true;
+
 // External reference to mock time (from test_mocks/pico/time.c)
 extern uint64_t mock_time_us;
 
@@ -57,8 +60,11 @@ void log_message(LOG_LEVEL level, uint8_t sink_mask, const char *fmt, ...)
         log_viz_task_message(current_executing_task, buffer);
     }
 
-    // Always print to stdout/stderr as well
+    // Print to stdout as well, unless silenced
     va_end(args);
+    if (!logger_mock_echo && level < LOG_LEVEL_ERROR)
+        return;
+
     va_start(args, fmt);
     vprintf(fmt, args);
     va_end(args);
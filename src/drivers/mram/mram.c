@@ -23,6 +23,7 @@
 
 #include "logger.h"
 #include "macros.h"
+#include "xip_safe.h"
 
 // MRAM COMMANDS
 #define WREN_CMD 0x06 // Write Enable
@@ -46,6 +47,9 @@
 // QMI CS1 pin for the MRAM (GPIO47 on RP2350B)
 #define MRAM_CS_PIN 47
 
+// How long to wait for the other core to park before giving up on a transfer
+#define MRAM_SAFE_EXECUTE_TIMEOUT_MS 10
+
 // SPI clock divider for QMI direct mode.
 // Even N → N/2 system-clock cycles per SCK half-period → SPI_CLK = sys_clk / N.
 // At 150 MHz sys_clk, CLKDIV=6 gives 25 MHz, well within the MRAM's 40 MHz max.
@@ -59,7 +63,7 @@
  * Pass rxbuf = NULL to ignore received data.
  *
  * Placed in SRAM via __no_inline_not_in_flash_func because QMI direct
- * mode stalls XIP. Callers MUST disable interrupts before calling.
+ * mode stalls XIP. Call through mram_qmi_transfer, never directly.
  */
 static void __no_inline_not_in_flash_func(mram_qmi_cmd)(const uint8_t *txbuf,
                                                         uint8_t *rxbuf,
@@ -115,10 +119,45 @@ static void __no_inline_not_in_flash_func(mram_qmi_cmd)(const uint8_t *txbuf,
     hw_clear_bits(&qmi_hw->direct_csr, QMI_DIRECT_CSR_EN_BITS);
 }
 
+typedef struct
+{
+    const uint8_t *txbuf;
+    uint8_t *rxbuf;
+    size_t count;
+} mram_qmi_args_t;
+
+static void mram_qmi_cmd_cb(void *param)
+{
+    mram_qmi_args_t *args = (mram_qmi_args_t *)param;
+    mram_qmi_cmd(args->txbuf, args->rxbuf, args->count);
+}
+
+/**
+ * Run mram_qmi_cmd with interrupts disabled and, once the core1 executor is
+ * running, with the other core parked in SRAM: XIP is stalled for both cores
+ * while QMI is in direct mode.
+ * @return false if the other core could not be parked and nothing was sent
+ */
+static bool mram_qmi_transfer(const uint8_t *txbuf, uint8_t *rxbuf,
+                              size_t count)
+{
+    mram_qmi_args_t args = {.txbuf = txbuf, .rxbuf = rxbuf, .count = count};
+    int rc = xip_safe_execute(mram_qmi_cmd_cb, &args,
+                              MRAM_SAFE_EXECUTE_TIMEOUT_MS);
+    if (rc != PICO_OK)
+    {
+        LOG_ERROR("[mram] Transfer failed: could not park other core (%d)",
+                  rc);
+        return false;
+    }
+    return true;
+}
+
 /**
  * Initialize MRAM and wake from sleep mode
+ * @return true if the wake command was sent
  */
-void mram_init(void)
+bool mram_init(void)
 {
     LOG_INFO("[mram] Init start");
 
@@ -126,41 +165,41 @@ void mram_init(void)
 
     uint8_t wake_cmd = WAKE_CMD;
 
-    uint32_t interrupts = save_and_disable_interrupts();
-    mram_qmi_cmd(&wake_cmd, NULL, 1);
-    restore_interrupts(interrupts);
+    if (!mram_qmi_transfer(&wake_cmd, NULL, 1))
+        return false;
 
     sleep_us(WAKE_TIME_US);
 
     LOG_INFO("[mram] Init complete");
+    return true;
 }
 
 /**
  * Read status register from MRAM
- * @return Status register value
+ * @param status Set to the status register value
+ * @return true if the status register was read
  */
-uint8_t mram_read_status(void)
+bool mram_read_status(uint8_t *status)
 {
     uint8_t tx_buf[2] = {RDSR_CMD, 0x00};
     uint8_t rx_buf[2] = {0x00, 0x00};
 
-    uint32_t interrupts = save_and_disable_interrupts();
-    mram_qmi_cmd(tx_buf, rx_buf, 2);
-    restore_interrupts(interrupts);
+    if (!mram_qmi_transfer(tx_buf, rx_buf, 2))
+        return false;
 
-    return rx_buf[1];
+    *status = rx_buf[1];
+    return true;
 }
 
 /**
  * Enable write operations on MRAM
+ * @return true if the command was sent
  */
-void mram_write_enable(void)
+bool mram_write_enable(void)
 {
     uint8_t cmd = WREN_CMD;
 
-    uint32_t interrupts = save_and_disable_interrupts();
-    mram_qmi_cmd(&cmd, NULL, 1);
-    restore_interrupts(interrupts);
+    return mram_qmi_transfer(&cmd, NULL, 1);
 }
 
 /**
@@ -168,12 +207,14 @@ void mram_write_enable(void)
  * @param address 24-bit address to read from
  * @param data Buffer to store read data
  * @param length Number of bytes to read (max 256)
+ * @return true if read succeeded, false if length exceeds maximum or the
+ * transfer failed
  */
-void mram_read(uint32_t address, uint8_t *data, size_t length)
+bool mram_read(uint32_t address, uint8_t *data, size_t length)
 {
     if (length > 256)
     {
-        return;
+        return false;
     }
 
     static uint8_t cmd_buf[256 + 4];
@@ -189,27 +230,30 @@ void mram_read(uint32_t address, uint8_t *data, size_t length)
         cmd_buf[4 + i] = 0x00;
     }
 
-    uint32_t interrupts = save_and_disable_interrupts();
-    mram_qmi_cmd(cmd_buf, rx_buf, 4 + length);
-    restore_interrupts(interrupts);
+    if (!mram_qmi_transfer(cmd_buf, rx_buf, 4 + length))
+        return false;
 
     memcpy(data, &rx_buf[4], length);
+    return true;
 }
 
 /**
  * Clear/erase a region of MRAM by writing zeros
  * @param address 24-bit address to clear
  * @param length Number of bytes to clear (max 256)
+ * @return true if clear succeeded, false if length exceeds maximum or the
+ * transfer failed
  */
-void mram_clear(uint32_t address, size_t length)
+bool mram_clear(uint32_t address, size_t length)
 {
     if (length > 256)
     {
         LOG_INFO("[mram] Clear failed: length %zu exceeds maximum", length);
-        return;
+        return false;
     }
 
-    mram_write_enable();
+    if (!mram_write_enable())
+        return false;
 
     static uint8_t clear_buf[256 + 4];
 
@@ -220,9 +264,7 @@ void mram_clear(uint32_t address, size_t length)
 
     memset(&clear_buf[4], 0x00, length);
 
-    uint32_t interrupts = save_and_disable_interrupts();
-    mram_qmi_cmd(clear_buf, NULL, 4 + length);
-    restore_interrupts(interrupts);
+    return mram_qmi_transfer(clear_buf, NULL, 4 + length);
 }
 
 /**
@@ -230,7 +272,8 @@ void mram_clear(uint32_t address, size_t length)
  * @param address 24-bit address to write to
  * @param data Buffer containing data to write
  * @param length Number of bytes to write (max 256)
- * @return true if write succeeded, false if length exceeds maximum
+ * @return true if write succeeded, false if length exceeds maximum or the
+ * transfer failed
  */
 bool mram_write(uint32_t address, const uint8_t *data, size_t length)
 {
@@ -240,7 +283,8 @@ bool mram_write(uint32_t address, const uint8_t *data, size_t length)
         return false;
     }
 
-    mram_write_enable();
+    if (!mram_write_enable())
+        return false;
 
     static uint8_t cmd_buf[256 + 4];
 
@@ -251,47 +295,42 @@ bool mram_write(uint32_t address, const uint8_t *data, size_t length)
 
     memcpy(&cmd_buf[4], data, length);
 
-    uint32_t interrupts = save_and_disable_interrupts();
-    mram_qmi_cmd(cmd_buf, NULL, 4 + length);
-    restore_interrupts(interrupts);
-
-    return true;
+    return mram_qmi_transfer(cmd_buf, NULL, 4 + length);
 }
 
 /**
  * Disable write operations on MRAM
+ * @return true if the command was sent
  */
-void mram_write_disable(void)
+bool mram_write_disable(void)
 {
     uint8_t cmd = WRDI_CMD;
 
-    uint32_t interrupts = save_and_disable_interrupts();
-    mram_qmi_cmd(&cmd, NULL, 1);
-    restore_interrupts(interrupts);
+    return mram_qmi_transfer(&cmd, NULL, 1);
 }
 
 /**
  * Put MRAM into low power sleep mode
+ * @return true if the command was sent
  */
-void mram_sleep(void)
+bool mram_sleep(void)
 {
     uint8_t cmd = SLEEP_CMD;
 
-    uint32_t interrupts = save_and_disable_interrupts();
-    mram_qmi_cmd(&cmd, NULL, 1);
-    restore_interrupts(interrupts);
+    return mram_qmi_transfer(&cmd, NULL, 1);
 }
 
 /**
  * Wake MRAM from sleep mode
+ * @return true if the command was sent
  */
-void mram_wake(void)
+bool mram_wake(void)
 {
     uint8_t cmd = WAKE_CMD;
 
-    uint32_t interrupts = save_and_disable_interrupts();
-    mram_qmi_cmd(&cmd, NULL, 1);
-    restore_interrupts(interrupts);
+    if (!mram_qmi_transfer(&cmd, NULL, 1))
+        return false;
 
     sleep_us(WAKE_TIME_US);
+    return true;
 }
@@ -14,55 +14,66 @@
 
 /**
  * Initialize MRAM and wake from sleep mode
+ * @return true if the wake command was sent
  */
-void mram_init(void);
+bool mram_init(void);
 
 /**
  * Read status register from MRAM
- * @return Status register value
+ * @param status Set to the status register value
+ * @return true if the status register was read
  */
-uint8_t mram_read_status(void);
+bool mram_read_status(uint8_t *status);
 
 /**
  * Enable write operations on MRAM
+ * @return true if the command was sent
  */
-void mram_write_enable(void);
+bool mram_write_enable(void);
 
 /**
  * Disable write operations on MRAM
+ * @return true if the command was sent
  */
-void mram_write_disable(void);
+bool mram_write_disable(void);
 
 /**
  * Put MRAM into low power sleep mode
+ * @return true if the command was sent
  */
-void mram_sleep(void);
+bool mram_sleep(void);
 
 /**
  * Wake MRAM from sleep mode
+ * @return true if the command was sent
  */
-void mram_wake(void);
+bool mram_wake(void);
 
 /**
  * Read data from MRAM at specified address
  * @param address 24-bit address to read from
  * @param data Buffer to store read data
  * @param length Number of bytes to read (max 256)
+ * @return true if read succeeded, false if length exceeds maximum or the
+ * transfer failed
  */
-void mram_read(uint32_t address, uint8_t *data, size_t length);
+bool mram_read(uint32_t address, uint8_t *data, size_t length);
 
 /**
  * Clear/erase a region of MRAM by writing zeros
  * @param address 24-bit address to clear
  * @param length Number of bytes to clear (max 256)
+ * @return true if clear succeeded, false if length exceeds maximum or the
+ * transfer failed
  */
-void mram_clear(uint32_t address, size_t length);
+bool mram_clear(uint32_t address, size_t length);
 
 /**
  * Write data to MRAM at specified address
  * @param address 24-bit address to write to
  * @param data Buffer containing data to write
  * @param length Number of bytes to write (max 256)
- * @return true if write succeeded, false if length exceeds maximum
+ * @return true if write succeeded, false if length exceeds maximum or the
+ * transfer failed
  */
 bool mram_write(uint32_t address, const uint8_t *data, size_t length);
@@ -9,73 +9,81 @@
 static uint8_t mock_mram[MOCK_MRAM_SIZE];
 static bool write_enabled = false;
 
-void mram_init(void)
+bool mram_init(void)
 {
     write_enabled = false;
     printf("[Mock MRAM] Initialized\n");
+    return true;
 }
 
 // NOTE: This function only works on read/write permissions on the
 // entire chip, rather than interacting with BP0, BP1, etc.
-uint8_t mram_read_status(void)
+bool mram_read_status(uint8_t *status)
 {
-    return write_enabled ? 0x02 : 0x00;
+    *status = write_enabled ? 0x02 : 0x00;
+    return true;
 }
 
-void mram_write_enable(void)
+bool mram_write_enable(void)
 {
     write_enabled = true;
     printf("[Mock MRAM] Write enabled\n");
+    return true;
 }
 
-void mram_write_disable(void)
+bool mram_write_disable(void)
 {
     write_enabled = false;
     printf("[Mock MRAM] Write disabled\n");
+    return true;
 }
 
-void mram_sleep(void)
+bool mram_sleep(void)
 {
     printf("[Mock MRAM] Entering sleep mode\n");
+    return true;
 }
 
-void mram_wake(void)
+bool mram_wake(void)
 {
     write_enabled = false;
     printf("[Mock MRAM] Waking up\n");
+    return true;
 }
 
-void mram_read(uint32_t address, uint8_t *data, size_t length)
+bool mram_read(uint32_t address, uint8_t *data, size_t length)
 {
     if (length > 256)
     {
-        return;
+        return false;
     }
 
     if (address + length > MOCK_MRAM_SIZE)
     {
         printf("[Mock MRAM] Read out of bounds\n");
-        return;
+        return false;
     }
 
     memcpy(data, &mock_mram[address], length);
+    return true;
 }
 
-void mram_clear(uint32_t address, size_t length)
+bool mram_clear(uint32_t address, size_t length)
 {
     if (length > 256)
     {
-        return;
+        return false;
     }
 
     if (address + length > MOCK_MRAM_SIZE)
     {
         printf("[Mock MRAM] Clear out of bounds\n");
-        return;
+        return false;
     }
 
     write_enabled = true;
     memset(&mock_mram[address], 0, length);
+    return true;
 }
 
 bool mram_write(uint32_t address, const uint8_t *data, size_t length)
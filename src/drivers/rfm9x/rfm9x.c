@@ -1,4 +1,7 @@
 #include "rfm9x.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "safe_sleep.h"
 #include <string.h>
 
@@ -13,6 +16,9 @@ rfm9x_t rfm9x_mk()
                  .tx_irq = NULL,
                  .rx_irq = NULL,
                  .spi = SPI_INSTANCE(SAMWISE_RF_SPI),
+                 .spi_baudrate = RFM9X_SPI_BAUDRATE,
+                 .dma_tx_chan = -1,
+                 .dma_rx_chan = -1,
 #ifndef PICO
                  .rf_reg_pin = SAMWISE_RF_REGULATOR_PIN,
 #endif
@@ -49,12 +55,15 @@ static inline void cs_deselect(rfm9x_t *r)
     busy_wait_us(5);
 }
 
+static void rfm9x_dma_wait(rfm9x_t *r);
+
 /*
  * Read a buffer from a register address.
  */
 static inline void rfm9x_get_buf(rfm9x_t *r, rfm9x_reg_t reg, uint8_t *buf,
                                  uint32_t n)
 {
+    rfm9x_dma_wait(r);
     cs_select(r);
 
     // First, configure that we will be GETTING from the Radio Module.
@@ -78,6 +87,7 @@ static inline void rfm9x_get_buf(rfm9x_t *r, rfm9x_reg_t reg, uint8_t *buf,
 static inline void rfm9x_put_buf(rfm9x_t *r, rfm9x_reg_t reg, uint8_t *buf,
                                  uint32_t n)
 {
+    rfm9x_dma_wait(r);
     cs_select(r);
 
     // this value will be passed in to tell the radio that we will be writing
@@ -480,12 +490,16 @@ void rfm9x_set_bandwidth(rfm9x_t *r, uint32_t bandwidth)
 
     if (bandwidth >= 500000)
     {
-        /* see Semtech SX1276 errata note 2.1 */
+        /* see Semtech SX1276 errata note 2.1, values for the 410-525 MHz
+         * band */
         rfm9x_put8(r, 0x36, 0x02);
-        rfm9x_put8(r, 0x3a, 0x64);
+        rfm9x_put8(r, 0x3a, 0x7F);
     }
     else
     {
+        /* Undo the above when switching down from 500 kHz at runtime */
+        rfm9x_put8(r, 0x36, 0x03);
+
         if (bandwidth == 7800)
         {
             rfm9x_put8(r, 0x2F, 0x48);
@@ -640,6 +654,56 @@ uint8_t rfm9x_is_ldro_on(rfm9x_t *r)
     return bit_is_on(rfm9x_get8(r, _RH_RF95_REG_26_MODEM_CONFIG3), 3);
 }
 
+void rfm9x_set_modem(rfm9x_t *r, const rfm9x_modem_t *m)
+{
+    uint8_t old_mode = rfm9x_get_mode(r);
+    rfm9x_set_mode(r, STANDBY_MODE);
+
+    rfm9x_set_bandwidth(r, m->bw);
+    rfm9x_set_coding_rate(r, m->cr);
+    rfm9x_set_spreading_factor(r, m->sf);
+    rfm9x_set_ldro(r, rfm9x_modem_needs_ldro(m));
+    r->modem = *m;
+
+    rfm9x_set_mode(r, old_mode);
+}
+
+/*
+ * Carrier offset of the packet just received (SX1276 datasheet 4.1.5): a
+ * 20-bit two's complement count, scaled by the bandwidth.
+ */
+static int32_t rfm9x_packet_freq_error(rfm9x_t *r)
+{
+    int32_t fei = (rfm9x_get8(r, _RH_RF95_REG_28_FEI_MSB) & 0x0F) << 16;
+    fei |= rfm9x_get8(r, _RH_RF95_REG_29_FEI_MID) << 8;
+    fei |= rfm9x_get8(r, _RH_RF95_REG_2A_FEI_LSB);
+    if (fei & 0x80000)
+        fei -= 0x100000;
+
+    // fei * 2^24 / F_xosc * (BW / 500 kHz)
+    return (int32_t)((int64_t)fei * (1 << 24) * (r->modem.bw / 1000) /
+                     (32000000LL * 500));
+}
+
+/*
+ * Signal quality of the packet just received (RFM9X.pdf 6.4 p109).
+ */
+static void rfm9x_read_rx_info(rfm9x_t *r, rfm9x_rx_info_t *info)
+{
+    int8_t snr = (int8_t)rfm9x_get8(r, _RH_RF95_REG_19_PKT_SNR_VALUE);
+
+    // Low frequency (RFM98) port offset; below the noise floor the SNR
+    // corrects the reading (RFM9X.pdf 5.5.5 p87)
+    int16_t rssi = -164 + rfm9x_get8(r, _RH_RF95_REG_1A_PKT_RSSI_VALUE);
+    if (snr < 0)
+        rssi += snr / 4;
+
+    info->snr_q4 = snr;
+    info->rssi_dbm = rssi;
+    info->freq_error_hz = rfm9x_packet_freq_error(r);
+    info->crc_error = rfm9x_is_crc_enabled(r) && rfm9x_crc_error(r);
+}
+
 static rfm9x_t *radio_with_interrupts;
 
 static void rfm9x_interrupt_received(uint gpio, uint32_t events)
@@ -663,6 +727,132 @@ static void rfm9x_interrupt_received(uint gpio, uint32_t events)
     }
 }
 
+/*
+ * DMA FIFO transfers.
+ *
+ * At RFM9X_SPI_BAUDRATE, clocking a full packet through the FIFO with
+ * blocking SPI keeps the CPU busy for about 2 ms, inside the radio interrupt.
+ * Instead, the register address is sent blocking and the data is handed to
+ * two DMA channels: one feeds the SPI TX FIFO (from buf, or a constant 0x00
+ * when reading), the other drains the RX FIFO (into buf, or a dummy byte when
+ * writing). The RX channel finishes last, once every byte has been clocked,
+ * so its interrupt ends the transaction.
+ */
+
+#define RFM9X_DMA_IRQ DMA_IRQ_1
+
+static uint8_t dma_zero = 0;
+static uint8_t dma_sink;
+
+/*
+ * Finish the pending DMA transfer, if any: release CS, put the radio back in
+ * its previous mode and call the completion callback. Called from both the DMA
+ * interrupt and rfm9x_dma_wait; only the first caller does the work.
+ */
+static void rfm9x_dma_complete(rfm9x_t *r)
+{
+    uint32_t irq_state = save_and_disable_interrupts();
+    bool pending = r->dma_pending;
+    r->dma_pending = false;
+    restore_interrupts(irq_state);
+
+    if (!pending)
+        return;
+
+    cs_deselect(r);
+    if (r->dma_is_write)
+        rfm9x_put8(r, _RH_RF95_REG_22_PAYLOAD_LENGTH, r->dma_len);
+    rfm9x_set_mode(r, r->dma_old_mode);
+
+    if (r->dma_done != NULL)
+        r->dma_done(r->dma_len);
+}
+
+/*
+ * Wait out a pending DMA transfer before touching the radio again. Polls the
+ * channel rather than waiting for its interrupt, so this also works from an
+ * interrupt handler the DMA interrupt cannot preempt.
+ */
+static void rfm9x_dma_wait(rfm9x_t *r)
+{
+    if (!r->dma_pending)
+        return;
+
+    dma_channel_wait_for_finish_blocking(r->dma_rx_chan);
+    rfm9x_dma_complete(r);
+}
+
+static void rfm9x_dma_irq_handler(void)
+{
+    rfm9x_t *r = radio_with_interrupts;
+    if (r == NULL || r->dma_rx_chan < 0 ||
+        !dma_channel_get_irq1_status(r->dma_rx_chan))
+        return;
+
+    dma_channel_acknowledge_irq1(r->dma_rx_chan);
+    rfm9x_dma_complete(r);
+}
+
+/*
+ * Start moving n > 0 bytes between buf and the FIFO. The caller has already
+ * set the FIFO address pointer and the dma_* bookkeeping fields.
+ */
+static void rfm9x_dma_start(rfm9x_t *r, uint8_t *buf, uint8_t n, bool write)
+{
+    cs_select(r);
+
+    uint8_t value = write ? (_RH_RF95_REG_00_FIFO | 0x80)
+                          : (_RH_RF95_REG_00_FIFO & 0x7F);
+    spi_write_blocking(r->spi, &value, 1);
+
+    dma_channel_config tx = dma_channel_get_default_config(r->dma_tx_chan);
+    channel_config_set_transfer_data_size(&tx, DMA_SIZE_8);
+    channel_config_set_dreq(&tx, spi_get_dreq(r->spi, true));
+    channel_config_set_read_increment(&tx, write);
+    channel_config_set_write_increment(&tx, false);
+    dma_channel_configure(r->dma_tx_chan, &tx, &spi_get_hw(r->spi)->dr,
+                          write ? buf : &dma_zero, n, false);
+
+    dma_channel_config rx = dma_channel_get_default_config(r->dma_rx_chan);
+    channel_config_set_transfer_data_size(&rx, DMA_SIZE_8);
+    channel_config_set_dreq(&rx, spi_get_dreq(r->spi, false));
+    channel_config_set_read_increment(&rx, false);
+    channel_config_set_write_increment(&rx, !write);
+    dma_channel_configure(r->dma_rx_chan, &rx, write ? &dma_sink : buf,
+                          &spi_get_hw(r->spi)->dr, n, false);
+
+    r->dma_pending = true;
+    dma_start_channel_mask((1u << r->dma_tx_chan) | (1u << r->dma_rx_chan));
+}
+
+/*
+ * Claim the DMA channels. Without them, FIFO transfers fall back to blocking
+ * SPI.
+ */
+static void rfm9x_dma_init(rfm9x_t *r)
+{
+    r->dma_pending = false;
+    r->dma_tx_chan = dma_claim_unused_channel(false);
+    r->dma_rx_chan = dma_claim_unused_channel(false);
+
+    if (r->dma_tx_chan < 0 || r->dma_rx_chan < 0)
+    {
+        LOG_ERROR("RFM9X: No free DMA channels, FIFO transfers will block");
+        if (r->dma_tx_chan >= 0)
+            dma_channel_unclaim(r->dma_tx_chan);
+        if (r->dma_rx_chan >= 0)
+            dma_channel_unclaim(r->dma_rx_chan);
+        r->dma_tx_chan = -1;
+        r->dma_rx_chan = -1;
+        return;
+    }
+
+    dma_channel_set_irq1_enabled(r->dma_rx_chan, true);
+    irq_add_shared_handler(RFM9X_DMA_IRQ, &rfm9x_dma_irq_handler,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(RFM9X_DMA_IRQ, true);
+}
+
 void rfm9x_format_packet(packet_t *pkt, uint8_t dst, uint8_t src, uint8_t flags,
                          uint8_t seq, uint8_t len, uint8_t *data)
 {
@@ -722,8 +912,9 @@ void rfm9x_init(rfm9x_t *r)
     // RFM9X.pdf 4.3 p75:
     // CPOL = 0, CPHA = 0 (mode 0)
     // MSB first
-    spi_init(r->spi, RFM9X_SPI_BAUDRATE);
+    r->spi_baudrate = spi_init(r->spi, r->spi_baudrate);
     spi_set_format(r->spi, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    rfm9x_dma_init(r);
 
     // TODO: Reset the chip
     rfm9x_reset(r);
@@ -762,19 +953,16 @@ void rfm9x_init(rfm9x_t *r)
      */
     rfm9x_set_frequency(r, RFM9X_FREQUENCY); /* Always */
 
-    rfm9x_set_preamble_length(r, 8); /* 8 bytes matches Radiohead library */
-    ASSERT(rfm9x_get_preamble_length(r) == 8);
+    /* 8 bytes matches Radiohead library */
+    rfm9x_set_preamble_length(r, RFM9X_PREAMBLE_LENGTH);
+    ASSERT(rfm9x_get_preamble_length(r) == RFM9X_PREAMBLE_LENGTH);
 
-    rfm9x_set_bandwidth(r, RFM9X_BANDWIDTH); /* Configure 125000 to match
-                                       Radiohead, see SX1276 errata note 2.3 */
+    /* 125000 Hz, 4/5 and SF7 match the Radiohead library, see SX1276 errata
+     * note 2.3. The link adaptation may change these later. */
+    rfm9x_set_modem(r, &RFM9X_MODEM_DEFAULT);
     ASSERT(rfm9x_get_bandwidth(r) == RFM9X_BANDWIDTH);
-
-    rfm9x_set_coding_rate(r, 5); /* Configure 4/5 to match Radiohead library */
-    ASSERT(rfm9x_get_coding_rate(r) == 5);
-
-    rfm9x_set_spreading_factor(
-        r, 7); /* Configure to 7 to match Radiohead library */
-    ASSERT(rfm9x_get_spreading_factor(r) == 7);
+    ASSERT(rfm9x_get_coding_rate(r) == RFM9X_CODING_RATE);
+    ASSERT(rfm9x_get_spreading_factor(r) == RFM9X_SPREADING_FACTOR);
 
     rfm9x_set_crc(r, 1); /* ENABLE CRC checking */
     ASSERT(rfm9x_is_crc_enabled(r) == 1);
@@ -800,12 +988,8 @@ void rfm9x_init(rfm9x_t *r)
     rfm9x_set_agc(r, 1);
     ASSERT(rfm9x_is_agc_on(r) == 1);
 
-    // LDRO does not work with our current settings
-    //   Coding Rate 5/5
-    //   Spreading Factor 7
-    //   Bandwidth 125kHz)
-    // rfm9x_set_ldro(r, 1);
-    // ASSERT(rfm9x_is_ldro_on(r) == 1);
+    // LDRO is set by rfm9x_set_modem; SF7 at 125kHz does not need it
+    ASSERT(rfm9x_is_ldro_on(r) == 0);
 
     // Setup interrupt
     gpio_set_irq_enabled_with_callback(r->d0_pin, GPIO_IRQ_EDGE_RISE, true,
@@ -828,6 +1012,8 @@ void rfm9x_print_parameters(rfm9x_t *r)
 {
     printf("RFM9X Radio Parameters:\n");
     printf("  Frequency: %lu Hz\n", rfm9x_get_frequency(r));
+    printf("  SPI: %lu Hz, FIFO transfers %s\n", r->spi_baudrate,
+           r->dma_rx_chan >= 0 ? "by DMA" : "blocking");
     printf("  Spreading Factor: %d\n", rfm9x_get_spreading_factor(r));
     printf("  Bandwidth: %lu Hz\n", rfm9x_get_bandwidth(r));
     printf("  Coding Rate: %d\n", rfm9x_get_coding_rate(r));
@@ -927,35 +1113,115 @@ uint8_t rfm9x_packet_to_fifo(rfm9x_t *r, uint8_t *buf, uint8_t n)
     return 0;
 }
 
+/*
+ * Point the FIFO at the packet just received and record its signal quality
+ * in r->last_rx. Returns its length, or 0 if there is none or it failed its
+ * CRC. Expects the radio in standby.
+ */
+static uint8_t rfm9x_fifo_rx_prepare(rfm9x_t *r)
+{
+    rfm9x_read_rx_info(r, &r->last_rx);
+    if (r->last_rx.crc_error)
+        return 0;
+
+    uint8_t fifo_length = rfm9x_get8(r, _RH_RF95_REG_13_RX_NB_BYTES);
+    if (fifo_length > 0)
+    {
+        uint8_t current_addr =
+            rfm9x_get8(r, _RH_RF95_REG_10_FIFO_RX_CURRENT_ADDR);
+        rfm9x_put8(r, _RH_RF95_REG_0D_FIFO_ADDR_PTR, current_addr);
+    }
+    return fifo_length;
+}
+
 uint8_t rfm9x_packet_from_fifo(rfm9x_t *r, uint8_t *buf)
 {
-    uint8_t n_read = 0;
     uint8_t old_mode = rfm9x_get_mode(r);
     rfm9x_set_mode(r, STANDBY_MODE);
 
-    // Check for CRC error
-    if (rfm9x_is_crc_enabled(r) && rfm9x_crc_error(r))
+    uint8_t n_read = rfm9x_fifo_rx_prepare(r);
+    if (n_read > 0)
     {
-        // TODO report somehow
+        // read the packet
+        rfm9x_get_buf(r, _RH_RF95_REG_00_FIFO, buf, n_read);
     }
-    else
-    {
-        uint8_t fifo_length = rfm9x_get8(r, _RH_RF95_REG_13_RX_NB_BYTES);
-        if (fifo_length > 0)
-        {
-            uint8_t current_addr =
-                rfm9x_get8(r, _RH_RF95_REG_10_FIFO_RX_CURRENT_ADDR);
-            rfm9x_put8(r, _RH_RF95_REG_0D_FIFO_ADDR_PTR, current_addr);
 
-            // read the packet
-            rfm9x_get_buf(r, _RH_RF95_REG_00_FIFO, buf, fifo_length);
-        }
-        n_read = fifo_length;
-    }
     rfm9x_set_mode(r, old_mode);
     return n_read;
 }
 
+void rfm9x_packet_to_fifo_async(rfm9x_t *r, uint8_t *buf, uint8_t n,
+                                rfm9x_fifo_done done)
+{
+    if (r->dma_rx_chan < 0 || n == 0)
+    {
+        rfm9x_packet_to_fifo(r, buf, n);
+        if (done != NULL)
+            done(n);
+        return;
+    }
+
+    uint8_t old_mode = rfm9x_get_mode(r);
+    rfm9x_set_mode(r, STANDBY_MODE);
+
+    rfm9x_put8(r, _RH_RF95_REG_0D_FIFO_ADDR_PTR, 0x00);
+
+    // The payload length and mode are set once the data is in
+    r->dma_old_mode = old_mode;
+    r->dma_len = n;
+    r->dma_is_write = true;
+    r->dma_done = done;
+    rfm9x_dma_start(r, buf, n, true);
+}
+
+void rfm9x_packet_from_fifo_async(rfm9x_t *r, uint8_t *buf,
+                                  rfm9x_fifo_done done)
+{
+    if (r->dma_rx_chan < 0)
+    {
+        uint8_t n = rfm9x_packet_from_fifo(r, buf);
+        if (done != NULL)
+            done(n);
+        return;
+    }
+
+    uint8_t old_mode = rfm9x_get_mode(r);
+    rfm9x_set_mode(r, STANDBY_MODE);
+
+    uint8_t n = rfm9x_fifo_rx_prepare(r);
+    if (n == 0)
+    {
+        rfm9x_set_mode(r, old_mode);
+        if (done != NULL)
+            done(0);
+        return;
+    }
+
+    r->dma_old_mode = old_mode;
+    r->dma_len = n;
+    r->dma_is_write = false;
+    r->dma_done = done;
+    rfm9x_dma_start(r, buf, n, false);
+}
+
+uint32_t rfm9x_set_spi_baudrate(rfm9x_t *r, uint32_t baudrate)
+{
+    if (baudrate == 0)
+        return r->spi_baudrate;
+    if (baudrate > RFM9X_SPI_BAUDRATE_MAX)
+        baudrate = RFM9X_SPI_BAUDRATE_MAX;
+
+    // Never change the clock under a transfer
+    rfm9x_dma_wait(r);
+    r->spi_baudrate = spi_set_baudrate(r->spi, baudrate);
+    return r->spi_baudrate;
+}
+
+uint32_t rfm9x_get_spi_baudrate(rfm9x_t *r)
+{
+    return r->spi_baudrate;
+}
+
 void rfm9x_clear_interrupts(rfm9x_t *r)
 {
     rfm9x_put8(r, _RH_RF95_REG_12_IRQ_FLAGS, 0xFF);
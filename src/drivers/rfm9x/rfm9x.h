@@ -22,8 +22,12 @@
     PACKET_SIZE - 4 // 4 bytes for header (destination, node, identifier, flags)
 
 #define RFM9X_SPI_BAUDRATE (1000 * 1000)
+#define RFM9X_SPI_BAUDRATE_MAX (10 * 1000 * 1000) // RFM9X.pdf 2.5.5 p12
 #define RFM9X_FREQUENCY 4381 // In .1 MHz, so 438.1 MHz
 #define RFM9X_BANDWIDTH 125000
+#define RFM9X_SPREADING_FACTOR 7
+#define RFM9X_CODING_RATE 5 // 4/5
+#define RFM9X_PREAMBLE_LENGTH 8
 
 typedef enum
 {
@@ -35,9 +39,41 @@ typedef enum
     RX_MODE = 5,
 } rfm9x_mode_t;
 
+/*
+ * LoRa modem settings. Both ends of the link must use the same ones.
+ */
+typedef struct
+{
+    uint8_t sf;  // Spreading factor, [7,12]
+    uint8_t cr;  // Coding rate denominator under 4, [5,8]
+    uint32_t bw; // Bandwidth in Hz
+} rfm9x_modem_t;
+
+#define RFM9X_MODEM_DEFAULT                                                    \
+    ((rfm9x_modem_t){.sf = RFM9X_SPREADING_FACTOR,                             \
+                     .cr = RFM9X_CODING_RATE,                                  \
+                     .bw = RFM9X_BANDWIDTH})
+
+/*
+ * Signal quality of a received packet, read from the radio along with it.
+ */
+typedef struct
+{
+    int32_t freq_error_hz; // Offset of the sender's carrier from ours
+    int16_t rssi_dbm;
+    int8_t snr_q4; // Quarter dB
+    bool crc_error;
+} rfm9x_rx_info_t;
+
 typedef void (*rfm9x_tx_irq)(void);
 typedef void (*rfm9x_rx_irq)(void);
 
+/*
+ * Called when a DMA FIFO transfer has finished, with the number of bytes
+ * moved. Runs in interrupt context, or inline if DMA is unavailable.
+ */
+typedef void (*rfm9x_fifo_done)(uint8_t n);
+
 typedef struct _rfm9x
 {
     uint reset_pin;
@@ -55,6 +91,24 @@ typedef struct _rfm9x
 #endif
 
     spi_inst_t *spi;
+    uint32_t spi_baudrate;
+    rfm9x_modem_t modem; // As last set by rfm9x_init or rfm9x_set_modem
+
+    /*
+     * DMA channels for FIFO transfers, or -1 to use blocking SPI. The
+     * pending transfer is finished by the DMA interrupt, or by the next
+     * register access, whichever comes first.
+     */
+    int dma_tx_chan;
+    int dma_rx_chan;
+    volatile bool dma_pending;
+    uint8_t dma_old_mode;
+    uint8_t dma_len;
+    bool dma_is_write;
+    rfm9x_fifo_done dma_done;
+
+    rfm9x_rx_info_t last_rx; // Of the last packet read from the FIFO
+
     uint8_t seq; /* current sequence number */
     uint32_t high_power : 1, max_power : 1, debug : 1;
 } rfm9x_t;
@@ -84,11 +138,71 @@ uint8_t rfm9x_rx_done(rfm9x_t *r);
 
 uint8_t rfm9x_packet_to_fifo(rfm9x_t *r, uint8_t *buf, uint8_t n);
 uint8_t rfm9x_packet_from_fifo(rfm9x_t *r, uint8_t *buf);
+
+/*
+ * Non-blocking versions of the above. The FIFO data is moved by DMA, so buf
+ * must stay valid until done is called (done may be NULL). The radio is back
+ * in its previous mode by the time done runs.
+ */
+void rfm9x_packet_to_fifo_async(rfm9x_t *r, uint8_t *buf, uint8_t n,
+                                rfm9x_fifo_done done);
+void rfm9x_packet_from_fifo_async(rfm9x_t *r, uint8_t *buf,
+                                  rfm9x_fifo_done done);
+
+/*
+ * Change the SPI clock, up to RFM9X_SPI_BAUDRATE_MAX. Returns the rate
+ * actually set.
+ */
+uint32_t rfm9x_set_spi_baudrate(rfm9x_t *r, uint32_t baudrate);
+uint32_t rfm9x_get_spi_baudrate(rfm9x_t *r);
 void rfm9x_clear_interrupts(rfm9x_t *r);
 
 void rfm9x_set_rx_irq(rfm9x_t *r, rfm9x_rx_irq irq);
 void rfm9x_set_tx_irq(rfm9x_t *r, rfm9x_rx_irq irq);
 
+/*
+ * Switch the modem settings. The radio goes back to its previous mode after.
+ */
+void rfm9x_set_modem(rfm9x_t *r, const rfm9x_modem_t *m);
+
+#ifdef TEST
+/*
+ * Hand the mock a packet as if it had just been received and raise the RX
+ * interrupt. The packet is read back from the FIFO with the given quality;
+ * with info->crc_error set the read returns nothing, as on the radio.
+ */
+void rfm9x_mock_receive(rfm9x_t *r, const uint8_t *buf, uint8_t n,
+                        const rfm9x_rx_info_t *info);
+#endif
+
+/*
+ * Low data rate optimization is mandated once a symbol lasts over 16 ms
+ * (RFM9X.pdf 6.4 p107).
+ */
+static inline bool rfm9x_modem_needs_ldro(const rfm9x_modem_t *m)
+{
+    return ((1000000u << m->sf) / m->bw) > 16000;
+}
+
+/*
+ * Time on air of an n byte packet with explicit header and CRC on (SX1276
+ * datasheet 4.1.1.7).
+ */
+static inline uint32_t rfm9x_airtime_us(const rfm9x_modem_t *m, uint32_t n)
+{
+    const int32_t sf = m->sf;
+    const uint32_t symbol_us = (1000000u << sf) / m->bw;
+
+    int32_t num = 8 * (int32_t)n - 4 * sf + 28 + 16;
+    int32_t den = 4 * (sf - (rfm9x_modem_needs_ldro(m) ? 2 : 0));
+    int32_t blocks = num > 0 ? (num + den - 1) / den : 0;
+    uint32_t payload_symbols = 8 + blocks * m->cr;
+
+    // The preamble adds 4.25 symbols on top of its programmed length
+    return (RFM9X_PREAMBLE_LENGTH * 4 + 17 + payload_symbols * 4) * symbol_us /
+           4;
+}
+
 void rfm9x_print_parameters(rfm9x_t *r);
 void rfm9x_print_packet(char *msg, uint8_t *packet, uint8_t l);
 void rfm9x_format_packet(packet_t *pkt, uint8_t dst, uint8_t src, uint8_t flags,
@@ -131,6 +245,9 @@ typedef enum
     _RH_RF95_REG_24_HOP_PERIOD = 0x24,
     _RH_RF95_REG_25_FIFO_RX_BYTE_ADDR = 0x25,
     _RH_RF95_REG_26_MODEM_CONFIG3 = 0x26,
+    _RH_RF95_REG_28_FEI_MSB = 0x28,
+    _RH_RF95_REG_29_FEI_MID = 0x29,
+    _RH_RF95_REG_2A_FEI_LSB = 0x2A,
 
     /**
      * In this register:
@@ -0,0 +1,292 @@
+/**
+ * @file rfm9x_channel.c
+ *
+ * Host LoRa channel emulator.
+ */
+
+#include "rfm9x_channel.h"
+#include "error.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include <string.h>
+
+// Frames remembered, on air or recently, to find collisions
+#define MAX_FRAMES 8
+
+#define FIFO_SIZE 256
+
+typedef enum
+{
+    MODE_STANDBY,
+    MODE_RX,
+    MODE_TX,
+} node_mode_t;
+
+typedef struct
+{
+    rfm9x_t *radio;
+    bool crc;
+    node_mode_t mode;
+    uint64_t rx_since_us; // In MODE_RX: hears frames arriving from here on
+    uint64_t tx_end_us;   // In MODE_TX
+
+    uint8_t tx_buf[FIFO_SIZE];
+    uint8_t tx_len;
+    bool tx_loaded;
+
+    // Last frame received, until read
+    uint8_t rx_buf[FIFO_SIZE];
+    uint8_t rx_len;
+    rfm9x_rx_info_t rx_info;
+
+    rfm9x_channel_stats_t stats;
+} node_t;
+
+typedef struct
+{
+    int src;
+    uint8_t buf[FIFO_SIZE];
+    uint8_t len;
+    rfm9x_modem_t modem;
+    uint64_t start_us; // On air at the sender
+    uint64_t end_us;
+    bool pending; // Not yet delivered
+} frame_t;
+
+static rfm9x_channel_config_t config;
+static node_t nodes[RFM9X_CHANNEL_MAX_RADIOS];
+static int num_nodes;
+static frame_t frames[MAX_FRAMES];
+static int next_frame;
+static uint64_t rng_state;
+
+// xorshift64*
+static uint64_t rng_next(void)
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static bool rng_chance(double p)
+{
+    return (rng_next() >> 11) * 0x1.0p-53 < p;
+}
+
+static node_t *find(const rfm9x_t *r)
+{
+    for (int i = 0; i < num_nodes; i++)
+        if (nodes[i].radio == r)
+            return &nodes[i];
+    return NULL;
+}
+
+void rfm9x_channel_init(const rfm9x_channel_config_t *c)
+{
+    config = *c;
+    memset(nodes, 0, sizeof(nodes));
+    memset(frames, 0, sizeof(frames));
+    num_nodes = 0;
+    next_frame = 0;
+    // xorshift must not start at zero
+    rng_state = c->seed ? c->seed : 1;
+}
+
+void rfm9x_channel_attach(rfm9x_t *r, bool crc)
+{
+    ASSERT(find(r) == NULL);
+    ASSERT(num_nodes < RFM9X_CHANNEL_MAX_RADIOS);
+    nodes[num_nodes++] = (node_t){.radio = r, .crc = crc};
+}
+
+const rfm9x_channel_stats_t *rfm9x_channel_stats(const rfm9x_t *r)
+{
+    node_t *n = find(r);
+    ASSERT(n != NULL);
+    return &n->stats;
+}
+
+static bool same_modem(const rfm9x_modem_t *a, const rfm9x_modem_t *b)
+{
+    return a->sf == b->sf && a->cr == b->cr && a->bw == b->bw;
+}
+
+static bool collides(const frame_t *f, int dst)
+{
+    for (int i = 0; i < MAX_FRAMES; i++)
+    {
+        const frame_t *g = &frames[i];
+        if (g == f || g->len == 0 || g->src == dst)
+            continue;
+        if (g->start_us < f->end_us && f->start_us < g->end_us)
+            return true;
+    }
+    return false;
+}
+
+static void deliver(frame_t *f, int dst)
+{
+    node_t *n = &nodes[dst];
+    uint64_t arrival_us = f->start_us + config.latency_us;
+
+    if (n->mode != MODE_RX || n->rx_since_us > arrival_us ||
+        !same_modem(&n->radio->modem, &f->modem))
+    {
+        n->stats.missed++;
+        return;
+    }
+    if (collides(f, dst))
+    {
+        n->stats.collisions++;
+        return;
+    }
+    if (rng_chance(config.loss))
+    {
+        n->stats.lost++;
+        return;
+    }
+
+    memcpy(n->rx_buf, f->buf, f->len);
+    n->rx_len = f->len;
+    bool flipped = false;
+    for (unsigned int bit = 0; bit < f->len * 8u; bit++)
+    {
+        if (rng_chance(config.ber))
+        {
+            n->rx_buf[bit / 8] ^= 1 << (bit % 8);
+            flipped = true;
+        }
+    }
+    if (flipped)
+        n->stats.corrupted++;
+
+    n->rx_info = (rfm9x_rx_info_t){.rssi_dbm = config.rssi_dbm,
+                                   .snr_q4 = config.snr_q4,
+                                   .crc_error = flipped && n->crc};
+    n->stats.rx_frames++;
+    if (n->radio->rx_irq != NULL)
+        n->radio->rx_irq();
+}
+
+uint64_t rfm9x_channel_next_event_us(void)
+{
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < num_nodes; i++)
+        if (nodes[i].mode == MODE_TX && nodes[i].tx_end_us < next)
+            next = nodes[i].tx_end_us;
+    for (int i = 0; i < MAX_FRAMES; i++)
+        if (frames[i].pending && frames[i].end_us + config.latency_us < next)
+            next = frames[i].end_us + config.latency_us;
+    return next;
+}
+
+void rfm9x_channel_run_until(uint64_t t)
+{
+    uint64_t next;
+    while ((next = rfm9x_channel_next_event_us()) <= t)
+    {
+        if (next > mock_time_us)
+            mock_time_us = next;
+
+        // Transmissions end before the frames reach anyone
+        node_t *sender = NULL;
+        for (int i = 0; i < num_nodes && sender == NULL; i++)
+            if (nodes[i].mode == MODE_TX && nodes[i].tx_end_us == next)
+                sender = &nodes[i];
+        if (sender != NULL)
+        {
+            // The radio goes to standby once a frame is sent
+            sender->mode = MODE_STANDBY;
+            sender->stats.tx_frames++;
+            if (sender->radio->tx_irq != NULL)
+                sender->radio->tx_irq();
+            continue;
+        }
+
+        for (int i = 0; i < MAX_FRAMES; i++)
+        {
+            frame_t *f = &frames[i];
+            if (!f->pending || f->end_us + config.latency_us != next)
+                continue;
+            f->pending = false;
+            for (int dst = 0; dst < num_nodes; dst++)
+                if (dst != f->src)
+                    deliver(f, dst);
+            break;
+        }
+    }
+    if (t > mock_time_us)
+        mock_time_us = t;
+}
+
+bool rfm9x_channel_transmit(rfm9x_t *r)
+{
+    node_t *n = find(r);
+    if (n == NULL)
+        return false;
+    // The plain mock ignores keying with nothing loaded too
+    if (!n->tx_loaded || n->mode == MODE_TX)
+        return true;
+
+    frame_t *f = &frames[next_frame];
+    ASSERT(!f->pending);
+    next_frame = (next_frame + 1) % MAX_FRAMES;
+
+    f->src = n - nodes;
+    memcpy(f->buf, n->tx_buf, n->tx_len);
+    f->len = n->tx_len;
+    f->modem = r->modem;
+    f->start_us = mock_time_us + config.turnaround_us;
+    f->end_us = f->start_us + rfm9x_airtime_us(&r->modem, f->len);
+    f->pending = true;
+
+    n->tx_loaded = false;
+    n->mode = MODE_TX;
+    n->tx_end_us = f->end_us;
+    return true;
+}
+
+bool rfm9x_channel_listen(rfm9x_t *r)
+{
+    node_t *n = find(r);
+    if (n == NULL)
+        return false;
+    if (n->mode == MODE_RX)
+        return true;
+
+    if (n->mode == MODE_TX)
+    {
+        // Cut off: the frame never completes and no TxDone comes
+        for (int i = 0; i < MAX_FRAMES; i++)
+            if (frames[i].pending && frames[i].src == n - nodes)
+                frames[i] = (frame_t){0};
+    }
+    n->mode = MODE_RX;
+    n->rx_since_us = mock_time_us + config.turnaround_us;
+    return true;
+}
+
+bool rfm9x_channel_to_fifo(rfm9x_t *r, const uint8_t *buf, uint8_t n_bytes)
+{
+    node_t *n = find(r);
+    if (n == NULL)
+        return false;
+    memcpy(n->tx_buf, buf, n_bytes);
+    n->tx_len = n_bytes;
+    n->tx_loaded = n_bytes > 0;
+    return true;
+}
+
+bool rfm9x_channel_from_fifo(rfm9x_t *r, uint8_t *buf, uint8_t *n_bytes)
+{
+    node_t *n = find(r);
+    if (n == NULL)
+        return false;
+    *n_bytes = n->rx_info.crc_error ? 0 : n->rx_len;
+    memcpy(buf, n->rx_buf, *n_bytes);
+    r->last_rx = n->rx_info;
+    n->rx_len = 0;
+    n->rx_info = (rfm9x_rx_info_t){0};
+    return true;
+}
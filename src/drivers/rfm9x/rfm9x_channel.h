@@ -0,0 +1,92 @@
+/**
+ * @file rfm9x_channel.h
+ *
+ * Host LoRa channel emulator behind the rfm9x_* API.
+ *
+ * Radios attached to the channel stop behaving like the plain mock: a frame
+ * keyed with rfm9x_transmit goes on air for its real time on air under the
+ * sender's modem settings, TxDone fires when it ends, and it reaches every
+ * other attached radio latency_us later. A receiver only gets it if it has
+ * been listening since before the frame arrived, is on the same settings and
+ * heard nothing else meanwhile. Surviving frames are then lost or have bits
+ * flipped at random; with CRC checking on, a corrupted frame is reported as a
+ * CRC error and reads back empty, as on the radio.
+ *
+ * Radios are half duplex: switching to transmit or to receive takes
+ * turnaround_us, and a transmitting radio hears nothing. Going back to
+ * listening while a frame is on air cuts it off.
+ *
+ * Nothing happens on its own. The test advances time with
+ * rfm9x_channel_run_until, which moves mock_time_us from event to event and
+ * raises the radios' interrupts on the way. Runs are repeatable for a given
+ * seed.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rfm9x.h"
+
+#define RFM9X_CHANNEL_MAX_RADIOS 4
+
+typedef struct
+{
+    double loss; // Probability that a frame is lost outright
+    double ber;  // Probability that each bit of a frame is flipped
+    uint32_t latency_us;
+    uint32_t turnaround_us;
+
+    // Signal quality reported with every frame received
+    int16_t rssi_dbm;
+    int8_t snr_q4;
+
+    uint64_t seed;
+} rfm9x_channel_config_t;
+
+/*
+ * What happened to the frames sent to one radio.
+ */
+typedef struct
+{
+    uint32_t tx_frames;
+    uint32_t rx_frames;  // Handed to the radio, including CRC failures
+    uint32_t lost;       // Dropped by the channel
+    uint32_t corrupted;  // With at least one bit flipped
+    uint32_t collisions; // Overlapped another frame
+    uint32_t missed;     // Not listening, or on other modem settings
+} rfm9x_channel_stats_t;
+
+/*
+ * Start an empty channel at the current mock time. Any radios attached
+ * before go back to the plain mock.
+ */
+void rfm9x_channel_init(const rfm9x_channel_config_t *config);
+
+/*
+ * Put a radio on the channel, in standby. crc sets whether it checks the
+ * CRC of frames it receives.
+ */
+void rfm9x_channel_attach(rfm9x_t *r, bool crc);
+
+/*
+ * Time of the next event, or UINT64_MAX if nothing is on air.
+ */
+uint64_t rfm9x_channel_next_event_us(void);
+
+/*
+ * Run every event up to time t, then leave mock_time_us at t (or later, if
+ * it already was).
+ */
+void rfm9x_channel_run_until(uint64_t t);
+
+const rfm9x_channel_stats_t *rfm9x_channel_stats(const rfm9x_t *r);
+
+/*
+ * Hooks for rfm9x_mock.c: each returns false if r is not on the channel.
+ */
+bool rfm9x_channel_transmit(rfm9x_t *r);
+bool rfm9x_channel_listen(rfm9x_t *r);
+bool rfm9x_channel_to_fifo(rfm9x_t *r, const uint8_t *buf, uint8_t n);
+bool rfm9x_channel_from_fifo(rfm9x_t *r, uint8_t *buf, uint8_t *n);
@@ -1,4 +1,6 @@
 #include "rfm9x.h"
+#include "rfm9x_channel.h"
+#include <string.h>
 
 void rfm9x_print_parameters(rfm9x_t *r)
 {
@@ -13,13 +15,24 @@ uint8_t rfm9x_tx_done(rfm9x_t *r)
     // TODO: Allow tests to simulate TX completion state
     return 1;
 }
+// Set when a frame is loaded, so keying the transmitter sends it
+static bool frame_loaded;
+
 void rfm9x_transmit(rfm9x_t *r)
 {
-    // TODO: Capture transmitted data for test assertions
+    if (rfm9x_channel_transmit(r))
+        return;
+
+    // The mock sends instantly: TxDone fires as soon as a frame is keyed
+    if (frame_loaded && r->tx_irq != NULL)
+    {
+        frame_loaded = false;
+        r->tx_irq();
+    }
 }
 void rfm9x_listen(rfm9x_t *r)
 {
-    // TODO: Track listen state for test assertions
+    rfm9x_channel_listen(r);
 }
 void rfm9x_clear_interrupts(rfm9x_t *r)
 {
@@ -27,24 +40,89 @@ void rfm9x_clear_interrupts(rfm9x_t *r)
 }
 uint8_t rfm9x_packet_to_fifo(rfm9x_t *r, uint8_t *buf, uint8_t n)
 {
-    // TODO: Capture FIFO writes for test verification
+    if (rfm9x_channel_to_fifo(r, buf, n))
+        return n;
+
+    frame_loaded = true;
     return n;
 }
+// Set by rfm9x_mock_receive until the packet is read
+static uint8_t rx_buf[PACKET_SIZE];
+static uint8_t rx_len;
+static rfm9x_rx_info_t rx_info;
+
 uint8_t rfm9x_packet_from_fifo(rfm9x_t *r, uint8_t *buf)
 {
-    // TODO: Allow tests to inject mock received packets
-    return 0;
+    uint8_t n;
+    if (rfm9x_channel_from_fifo(r, buf, &n))
+        return n;
+
+    n = rx_info.crc_error ? 0 : rx_len;
+    r->last_rx = rx_info;
+    memcpy(buf, rx_buf, n);
+    rx_len = 0;
+    rx_info = (rfm9x_rx_info_t){0};
+    return n;
+}
+void rfm9x_mock_receive(rfm9x_t *r, const uint8_t *buf, uint8_t n,
+                        const rfm9x_rx_info_t *info)
+{
+    memcpy(rx_buf, buf, n);
+    rx_len = n;
+    rx_info = *info;
+    if (r->rx_irq != NULL)
+        r->rx_irq();
+}
+/*
+ * No DMA on the host: the async FIFO calls run the blocking path and
+ * complete inline.
+ */
+void rfm9x_packet_to_fifo_async(rfm9x_t *r, uint8_t *buf, uint8_t n,
+                                rfm9x_fifo_done done)
+{
+    n = rfm9x_packet_to_fifo(r, buf, n);
+    if (done != NULL)
+        done(n);
+}
+void rfm9x_packet_from_fifo_async(rfm9x_t *r, uint8_t *buf,
+                                  rfm9x_fifo_done done)
+{
+    uint8_t n = rfm9x_packet_from_fifo(r, buf);
+    if (done != NULL)
+        done(n);
+}
+uint32_t rfm9x_set_spi_baudrate(rfm9x_t *r, uint32_t baudrate)
+{
+    if (baudrate == 0)
+        return r->spi_baudrate;
+    if (baudrate > RFM9X_SPI_BAUDRATE_MAX)
+        baudrate = RFM9X_SPI_BAUDRATE_MAX;
+    r->spi_baudrate = baudrate;
+    return baudrate;
+}
+uint32_t rfm9x_get_spi_baudrate(rfm9x_t *r)
+{
+    return r->spi_baudrate;
+}
+void rfm9x_set_modem(rfm9x_t *r, const rfm9x_modem_t *m)
+{
+    r->modem = *m;
 }
 void rfm9x_set_tx_irq(rfm9x_t *r, void (*callback)(void))
 {
-    // TODO: Store callback so tests can trigger TX interrupts
+    r->tx_irq = callback;
 }
 void rfm9x_set_rx_irq(rfm9x_t *r, void (*callback)(void))
 {
-    // TODO: Store callback so tests can trigger RX interrupts
+    r->rx_irq = callback;
 }
 void rfm9x_format_packet(packet_t *pkt, uint8_t dst, uint8_t src, uint8_t flags,
                          uint8_t seq, uint8_t len, uint8_t *data)
 {
-    // TODO: Implement packet formatting for test verification
+    pkt->dst = dst;
+    pkt->src = src;
+    pkt->flags = flags;
+    pkt->seq = seq;
+    pkt->len = len;
+    memcpy(pkt->data, data, len);
 }
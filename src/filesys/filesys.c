@@ -44,11 +44,12 @@ const struct lfs_file_config filesys_lfs_file_cfg = {
     .buffer = cache_buffer,
 };
 
-static void filesys_file_open(lfs_file_t *file, const char *fname, int flags,
-                              lfs_ssize_t *lfs_error_code)
+static void filesys_file_open_cfg(lfs_file_t *file, const char *fname,
+                                  int flags, const struct lfs_file_config *cfg,
+                                  lfs_ssize_t *lfs_error_code)
 {
     *lfs_error_code = LFS_ERR_OK;
-    int err = lfs_file_opencfg(&lfs, file, fname, flags, &filesys_lfs_file_cfg);
+    int err = lfs_file_opencfg(&lfs, file, fname, flags, cfg);
     if (err < 0)
     {
         *lfs_error_code = err;
@@ -56,6 +57,13 @@ static void filesys_file_open(lfs_file_t *file, const char *fname, int flags,
     }
 }
 
+static void filesys_file_open(lfs_file_t *file, const char *fname, int flags,
+                              lfs_ssize_t *lfs_error_code)
+{
+    filesys_file_open_cfg(file, fname, flags, &filesys_lfs_file_cfg,
+                          lfs_error_code);
+}
+
 static void filesys_file_close(lfs_file_t *file, lfs_ssize_t *lfs_error_code)
 {
     *lfs_error_code = LFS_ERR_OK;
@@ -68,13 +76,53 @@ static void filesys_file_close(lfs_file_t *file, lfs_ssize_t *lfs_error_code)
     }
 }
 
+// The CRC of a file's contents, kept as FILESYS_VERIFIED_CRC_ATTR so that
+// listing need not read the file through. It is stamped with the file's size
+// and last block: littlefs writes copy on write, so any change to the file
+// gives it a new last block and the stamp no longer matches.
+typedef struct __attribute__((packed))
+{
+    FILESYS_BUFFERED_FILE_CRC_T crc;
+    FILESYS_BUFFERED_FILE_LEN_T file_size;
+    lfs_block_t head;
+} filesys_verified_crc_t;
+
+// Inline files live in their directory's metadata, with no block of their
+// own, so they are never stamped. They are at most FILESYS_CFG_CACHE_SIZE
+// bytes and cheap to read through.
+static bool filesys_file_stampable(const lfs_file_t *file)
+{
+    return !(file->flags & LFS_F_INLINE);
+}
+
+static void filesys_set_verified_crc(const char *fname,
+                                     FILESYS_BUFFERED_FILE_CRC_T crc,
+                                     FILESYS_BUFFERED_FILE_LEN_T file_size,
+                                     lfs_block_t head)
+{
+    filesys_verified_crc_t verified = {
+        .crc = crc, .file_size = file_size, .head = head};
+    int err = lfs_setattr(&lfs, fname, FILESYS_VERIFIED_CRC_ATTR, &verified,
+                          sizeof(verified));
+
+    // Only a cache, which listing fills in again when it reads the file
+    if (err < 0)
+        LOG_ERROR("[filesys] Failed to set verified CRC of file %s: %d", fname,
+                  err);
+}
+
 filesys_error_t filesys_initialize(slate_t *slate, lfs_ssize_t *lfs_error_code)
 {
     *lfs_error_code = LFS_ERR_OK;
 
     // mount the filesystem
 #ifdef MRAM
-    mram_init();
+    if (!mram_init())
+    {
+        *lfs_error_code = LFS_ERR_IO;
+        LOG_ERROR("[filesys] Failed to wake MRAM");
+        return FILESYS_ERR_MOUNT;
+    }
 #endif
     int err = lfs_mount(&lfs, &filesys_lfs_cfg);
 
@@ -92,6 +140,7 @@ filesys_error_t filesys_initialize(slate_t *slate, lfs_ssize_t *lfs_error_code)
     }
 
     slate->filesys_is_writing_file = false;
+    slate->filesys_verify_on_complete = FILESYS_VERIFY_ON_COMPLETE;
     filesys_clear_buffer(slate);
 
     lfs_mounted = true;
@@ -105,7 +154,12 @@ filesys_error_t filesys_reformat_initialize(slate_t *slate,
     *lfs_error_code = LFS_ERR_OK;
 
 #ifdef MRAM
-    mram_init();
+    if (!mram_init())
+    {
+        *lfs_error_code = LFS_ERR_IO;
+        LOG_ERROR("[filesys] Failed to wake MRAM");
+        return FILESYS_ERR_REFORMAT;
+    }
 #endif
     if (lfs_mounted)
     {
@@ -218,6 +272,22 @@ filesys_error_t filesys_start_file_write(slate_t *slate,
         return FILESYS_ERR_SET_CRC_ATTR;
     }
 
+    // The stamp of the file it replaces would only be ignored, but a block
+    // freed here could come round again as the new file's last block
+    err = lfs_removeattr(&lfs, slate->filesys_buffered_fname_str,
+                         FILESYS_VERIFIED_CRC_ATTR);
+    if (err < 0)
+    {
+        *lfs_error_code = err;
+        LOG_ERROR("[filesys] Failed to clear verified CRC of file %s: %d",
+                  slate->filesys_buffered_fname_str, err);
+
+        lfs_ssize_t close_lfs_err;
+        filesys_file_close(&lfs_open_file, &close_lfs_err);
+
+        return FILESYS_ERR_SET_CRC_ATTR;
+    }
+
     // Close file for now - reopen it every time we write
     lfs_ssize_t close_lfs_err;
     filesys_file_close(&lfs_open_file, &close_lfs_err);
@@ -234,6 +304,9 @@ filesys_error_t filesys_start_file_write(slate_t *slate,
     slate->filesys_buffered_file_len = file_size;
     slate->filesys_buffered_file_crc = file_crc;
     slate->filesys_buffer_is_dirty = false;
+    slate->filesys_bytes_written = 0;
+    slate->filesys_crc_state = 0xFFFFFFFF;
+    slate->filesys_crc_state_valid = true;
 
     LOG_INFO("[filesys] Started file write for file: %s",
              slate->filesys_buffered_fname_str);
@@ -326,16 +399,40 @@ filesys_error_t filesys_write_buffer_to_mram(slate_t *slate,
         return FILESYS_ERR_WRITE_MRAM;
     }
 
+    // Flushed, the file has the last block that stamps its CRC
+    int sync_err = lfs_file_sync(&lfs, &lfs_open_file);
+    lfs_block_t head = lfs_open_file.ctz.head;
+    bool stampable = filesys_file_stampable(&lfs_open_file);
+
     lfs_ssize_t close_lfs_err;
     filesys_file_close(&lfs_open_file, &close_lfs_err);
-    if (close_lfs_err < 0)
+    if (sync_err < 0 || close_lfs_err < 0)
     {
-        *lfs_error_code = close_lfs_err;
+        *lfs_error_code = sync_err < 0 ? sync_err : close_lfs_err;
         LOG_ERROR("[filesys] Failed to close file %s after writing: %d",
-                  slate->filesys_buffered_fname_str, close_lfs_err);
+                  slate->filesys_buffered_fname_str, *lfs_error_code);
+
+        // Some of the buffer may have reached MRAM, so only reading the file
+        // back can tell its CRC now
+        slate->filesys_crc_state_valid = false;
         return FILESYS_ERR_CLOSE_FILE;
     }
 
+    // Keep the CRC up while the buffer is still at hand, so that completing
+    // the file does not have to read it back from MRAM
+    slate->filesys_crc_state = crc32_continue(slate->filesys_buffer, n_bytes,
+                                              slate->filesys_crc_state);
+    slate->filesys_bytes_written += n_bytes;
+
+    // With the whole file on MRAM its CRC is known, so listing it need not
+    // read it. A file to be read back on completion is left to the first
+    // listing to stamp, from what it reads.
+    if (stampable && !slate->filesys_verify_on_complete &&
+        slate->filesys_bytes_written == slate->filesys_buffered_file_len)
+        filesys_set_verified_crc(slate->filesys_buffered_fname_str,
+                                 ~slate->filesys_crc_state,
+                                 slate->filesys_bytes_written, head);
+
     filesys_clear_buffer(slate);
 
     return FILESYS_OK;
@@ -445,22 +542,25 @@ unsigned int filesys_compute_crc(slate_t *slate, filesys_error_t *error_code,
                                     error_code, lfs_error_code);
 }
 
-filesys_error_t filesys_is_crc_correct(slate_t *slate,
-                                       lfs_ssize_t *lfs_error_code)
+unsigned int filesys_written_crc(slate_t *slate, filesys_error_t *error_code,
+                                 lfs_ssize_t *lfs_error_code)
 {
-    *lfs_error_code = LFS_ERR_OK;
-
-    if (!slate->filesys_is_writing_file)
+    if (slate->filesys_is_writing_file && !slate->filesys_verify_on_complete &&
+        slate->filesys_crc_state_valid &&
+        slate->filesys_bytes_written == slate->filesys_buffered_file_len)
     {
-        LOG_ERROR(
-            "[filesys] Cannot check CRC; no file is currently being written.");
-        return FILESYS_ERR_NO_FILE_WRITING;
+        *error_code = FILESYS_OK;
+        *lfs_error_code = LFS_ERR_OK;
+        return ~slate->filesys_crc_state;
     }
 
-    filesys_error_t error_code = 0;
-    unsigned int computed_crc =
-        filesys_compute_crc(slate, &error_code, lfs_error_code);
+    return filesys_compute_crc(slate, error_code, lfs_error_code);
+}
 
+static filesys_error_t filesys_check_crc(slate_t *slate,
+                                         unsigned int computed_crc,
+                                         filesys_error_t error_code)
+{
     if (error_code != FILESYS_OK)
     {
         LOG_ERROR("[filesys] Failed to compute CRC for file %s",
@@ -482,6 +582,24 @@ filesys_error_t filesys_is_crc_correct(slate_t *slate,
     return FILESYS_OK;
 }
 
+filesys_error_t filesys_is_crc_correct(slate_t *slate,
+                                       lfs_ssize_t *lfs_error_code)
+{
+    *lfs_error_code = LFS_ERR_OK;
+
+    if (!slate->filesys_is_writing_file)
+    {
+        LOG_ERROR(
+            "[filesys] Cannot check CRC; no file is currently being written.");
+        return FILESYS_ERR_NO_FILE_WRITING;
+    }
+
+    filesys_error_t error_code = FILESYS_OK;
+    unsigned int computed_crc =
+        filesys_compute_crc(slate, &error_code, lfs_error_code);
+    return filesys_check_crc(slate, computed_crc, error_code);
+}
+
 filesys_error_t filesys_complete_file_write(slate_t *slate,
                                             lfs_ssize_t *lfs_error_code)
 {
@@ -495,8 +613,12 @@ filesys_error_t filesys_complete_file_write(slate_t *slate,
         return FILESYS_ERR_BUFFER_DIRTY;
     }
 
-    // Check CRC here
-    filesys_error_t crc_check = filesys_is_crc_correct(slate, lfs_error_code);
+    // Check CRC here, read back from MRAM only if the running one will not do
+    filesys_error_t error_code = FILESYS_OK;
+    unsigned int computed_crc =
+        filesys_written_crc(slate, &error_code, lfs_error_code);
+    filesys_error_t crc_check =
+        filesys_check_crc(slate, computed_crc, error_code);
     if (crc_check != FILESYS_OK)
     {
         LOG_INFO("[filesys] CRC check failed during file write completion for "
@@ -556,14 +678,30 @@ filesys_error_t filesys_cancel_file_write(slate_t *slate,
 
 filesys_error_t filesys_list_files(slate_t *slate,
                                    filesys_file_info_t *file_list,
-                                   uint16_t max_files,
+                                   uint16_t max_files, bool deep_verify,
                                    uint16_t *num_files_found,
                                    lfs_ssize_t *lfs_error_code)
+{
+    bool more;
+    filesys_error_t err =
+        filesys_list_files_page(slate, "", file_list, max_files, deep_verify,
+                                num_files_found, &more, lfs_error_code);
+    if (err == FILESYS_OK && more)
+        LOG_INFO("[filesys] file_list full (%u); stopping early", max_files);
+    return err;
+}
+
+filesys_error_t filesys_list_files_page(slate_t *slate, const char *after,
+                                        filesys_file_info_t *file_list,
+                                        uint16_t max_files, bool deep_verify,
+                                        uint16_t *num_files_found, bool *more,
+                                        lfs_ssize_t *lfs_error_code)
 {
     // Note that this current implementation only works with files in the root
     // directory and does not support subdirectories.
     *lfs_error_code = LFS_ERR_OK;
     *num_files_found = 0;
+    *more = false;
 
     lfs_dir_t dir;
     int err = lfs_dir_open(&lfs, &dir, FILESYS_ROOT_DIR);
@@ -592,17 +730,22 @@ filesys_error_t filesys_list_files(slate_t *slate,
         if (entry_info.type != LFS_TYPE_REG)
             continue;
 
+        // littlefs keeps directory entries sorted by name, so the pages
+        // before this one are all behind us
+        if (strcmp(entry_info.name, after) <= 0)
+            continue;
+
         // Stop if the caller's list is full
         if (*num_files_found >= max_files)
         {
-            LOG_INFO("[filesys] file_list full (%u); stopping early",
-                     max_files);
+            *more = true;
             break;
         }
 
         filesys_file_info_t *info = &file_list[*num_files_found];
         lfs_ssize_t info_lfs_err;
-        filesys_get_file_info(slate, entry_info.name, info, &info_lfs_err);
+        filesys_get_file_info(slate, entry_info.name, info, deep_verify,
+                              &info_lfs_err);
         // Note: filesys_get_file_info populates flags to indicate which
         // fields are valid, so we don't need to check its return value
         // here — listing continues regardless.
@@ -627,6 +770,7 @@ filesys_error_t filesys_list_files(slate_t *slate,
 filesys_error_t filesys_get_file_info(slate_t *slate,
                                       FILESYS_BUFFERED_FNAME_STR_T fname,
                                       filesys_file_info_t *info,
+                                      bool deep_verify,
                                       lfs_ssize_t *lfs_error_code)
 {
     *lfs_error_code = LFS_ERR_OK;
@@ -636,10 +780,20 @@ filesys_error_t filesys_get_file_info(slate_t *slate,
     strncpy(info->fname, fname, sizeof(info->fname) - 1);
     info->fname[sizeof(info->fname) - 1] = '\0';
 
-    // Get the file size by temporarily opening the file.
+    // Get the file size and last block by temporarily opening the file. Its
+    // verified CRC is read as it opens, with no lookup of its own; left zero
+    // if there is none, it matches no file with a block.
+    filesys_verified_crc_t verified = {0};
+    struct lfs_attr verified_attr = {.type = FILESYS_VERIFIED_CRC_ATTR,
+                                     .buffer = &verified,
+                                     .size = sizeof(verified)};
+    const struct lfs_file_config info_file_cfg = {
+        .buffer = cache_buffer, .attrs = &verified_attr, .attr_count = 1};
+
     lfs_file_t tmp_file;
     lfs_ssize_t open_err;
-    filesys_file_open(&tmp_file, fname, LFS_O_RDONLY, &open_err);
+    filesys_file_open_cfg(&tmp_file, fname, LFS_O_RDONLY, &info_file_cfg,
+                          &open_err);
     if (open_err < 0)
     {
         *lfs_error_code = open_err;
@@ -657,6 +811,11 @@ filesys_error_t filesys_get_file_info(slate_t *slate,
         return FILESYS_ERR_FILE_SIZE;
     }
 
+    lfs_block_t head = tmp_file.ctz.head;
+    bool stampable = filesys_file_stampable(&tmp_file);
+    bool stamped = stampable && verified.file_size == (lfs_size_t)file_size &&
+                   verified.head == head;
+
     lfs_ssize_t close_err;
     filesys_file_close(&tmp_file, &close_err);
     if (close_err < 0)
@@ -682,20 +841,36 @@ filesys_error_t filesys_get_file_info(slate_t *slate,
         info->flags |= FILESYS_FILE_INFO_EXPECTED_CRC_VALID;
     }
 
-    // Compute the on-disk CRC.
-    filesys_error_t crc_err;
-    lfs_ssize_t crc_lfs_err;
-    unsigned int computed = filesys_compute_file_crc(fname, info->file_size,
-                                                     &crc_err, &crc_lfs_err);
-
-    if (crc_err == FILESYS_OK)
+    // The verified CRC stands in for reading the file, unless asked not to
+    if (stamped && !deep_verify)
     {
-        info->computed_crc = computed;
-        info->flags |= FILESYS_FILE_INFO_COMPUTED_CRC_VALID;
+        info->computed_crc = verified.crc;
+        info->flags |= FILESYS_FILE_INFO_COMPUTED_CRC_VALID |
+                       FILESYS_FILE_INFO_CRC_CACHED;
     }
     else
     {
-        info->computed_crc = 0;
+        // Compute the on-disk CRC.
+        filesys_error_t crc_err;
+        lfs_ssize_t crc_lfs_err;
+        unsigned int computed = filesys_compute_file_crc(
+            fname, info->file_size, &crc_err, &crc_lfs_err);
+
+        if (crc_err == FILESYS_OK)
+        {
+            info->computed_crc = computed;
+            info->flags |= FILESYS_FILE_INFO_COMPUTED_CRC_VALID;
+
+            // Stamp what was read, so the next listing need not read it,
+            // and so it remembers damage a deep verify found
+            if (stampable && !(stamped && verified.crc == computed))
+                filesys_set_verified_crc(fname, computed, info->file_size,
+                                         head);
+        }
+        else
+        {
+            info->computed_crc = 0;
+        }
     }
 
     // Determine CRC match only when both values are valid.
@@ -717,8 +892,9 @@ filesys_error_t filesys_open_file_read(slate_t *slate, lfs_file_t *file,
     *lfs_error_code = LFS_ERR_OK;
 
     // Populate file info (size, CRCs, flags).
+    // Read through, since the file is about to be sent as it is on MRAM
     filesys_error_t info_err =
-        filesys_get_file_info(slate, fname, info, lfs_error_code);
+        filesys_get_file_info(slate, fname, info, true, lfs_error_code);
     if (info_err != FILESYS_OK)
     {
         return info_err;
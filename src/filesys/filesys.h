@@ -171,7 +171,9 @@ filesys_error_t filesys_write_data_to_buffer(slate_t *slate,
 
 /**
  * Writes the current buffered state to MRAM as a block, and mark the buffer
- * as clean. Note this ALWAYS appends to the end of the file.
+ * as clean. Note this ALWAYS appends to the end of the file. The running CRC
+ * of the file (slate filesys_crc_state) is kept up from the buffer, so that
+ * completing the file does not have to read it back.
  *
  * @param slate Pointer to the slate structure.
  * @param n_bytes The number of bytes to write for this buffer. Use
@@ -205,9 +207,27 @@ lfs_t *filesys_get_lfs(void);
 unsigned int filesys_compute_crc(slate_t *slate, filesys_error_t *error_code,
                                  lfs_ssize_t *lfs_error_code);
 
+/**
+ * Returns the CRC of the file currently being written, as far as it has been
+ * committed with filesys_write_buffer_to_mram, without touching MRAM. The file
+ * is read back with filesys_compute_crc instead if slate
+ * filesys_verify_on_complete is set, if a failed write may have left MRAM out
+ * of step with the running CRC, or if fewer or more bytes than the file length
+ * were committed.
+ *
+ * @param slate Pointer to the slate structure.
+ * @param error_code Pointer to store error code in case of failure, or
+ * FILESYS_OK on success.
+ * @param lfs_error_code Pointer to store error code in case of failure.
+ * LFS_ERR_OK if there is no relevant LFS error.
+ * @return The CRC value.
+ */
+unsigned int filesys_written_crc(slate_t *slate, filesys_error_t *error_code,
+                                 lfs_ssize_t *lfs_error_code);
+
 /**
  * Validates the CRC of the file currently being written against the stored CRC
- * (on _CRC attribute).
+ * (on _CRC attribute). This always reads the whole file back from MRAM.
  *
  * @param slate Pointer to the slate structure.
  * @param lfs_error_code Pointer to store error code in case of failure.
@@ -223,7 +243,8 @@ filesys_error_t filesys_is_crc_correct(slate_t *slate,
 /**
  * Marks the filesystem as no longer writing a file. If the buffer is currently
  * dirty, it returns false, and you must either clear the current buffer or
- * write it to MRAM before completing.
+ * write it to MRAM before completing. The CRC is checked with
+ * filesys_written_crc, so the file is only read back when it has to be.
  *
  * @param slate Pointer to the slate structure.
  * @param lfs_error_code Pointer to store error code in case of failure.
@@ -276,6 +297,7 @@ filesys_error_t filesys_cancel_file_write(slate_t *slate,
 #define FILESYS_FILE_INFO_CRC_MATCH 0x01          // computed == expected CRC
 #define FILESYS_FILE_INFO_COMPUTED_CRC_VALID 0x02 // computed CRC is valid
 #define FILESYS_FILE_INFO_EXPECTED_CRC_VALID 0x04 // expected CRC attr was read
+#define FILESYS_FILE_INFO_CRC_CACHED 0x08 // computed CRC is the verified one
 
 typedef struct __attribute__((packed))
 {
@@ -293,12 +315,21 @@ typedef struct __attribute__((packed))
  * caller-provided filesys_file_info_t whose flags indicate which fields are
  * valid.
  *
+ * The computed CRC is taken from the file's verified CRC attribute
+ * (FILESYS_VERIFIED_CRC_ATTR) when its stamp shows the file unchanged since,
+ * and FILESYS_FILE_INFO_CRC_CACHED is set. The attribute is written when the
+ * last of a file is written to MRAM, and whenever this reads a file through,
+ * so a file is read at most once. Note the cached CRC cannot see MRAM going
+ * bad under the file; a deep verify reads it regardless.
+ *
  * This is the shared helper used by both filesys_list_files and
  * filesys_open_file_read.
  *
  * @param slate Pointer to the slate structure.
  * @param fname Null-terminated filename to query.
  * @param info Pointer to a caller-allocated filesys_file_info_t to populate.
+ * @param deep_verify Read the whole file to compute its CRC, even if it has a
+ *        verified one.
  * @param lfs_error_code Pointer to store the first LFS error code encountered.
  *        LFS_ERR_OK if no LFS error occurred.
  * @return FILESYS_OK on success (info is fully populated),
@@ -313,12 +344,15 @@ typedef struct __attribute__((packed))
 filesys_error_t filesys_get_file_info(slate_t *slate,
                                       FILESYS_BUFFERED_FNAME_STR_T fname,
                                       filesys_file_info_t *info,
+                                      bool deep_verify,
                                       lfs_ssize_t *lfs_error_code);
 
 /**
  * Lists all files on the filesystem, computing each file's on-disk CRC32
  * and retrieving its stored (expected) CRC32 attribute. Results are written
- * into the caller-provided array.
+ * into the caller-provided array. The CRCs come as from filesys_get_file_info,
+ * so that a listing costs a few metadata reads per file unless deep_verify is
+ * set.
  *
  * If CRC computation or attribute retrieval fails for a particular file, the
  * corresponding _valid flag in filesys_file_info_t is set to 0 and listing
@@ -330,6 +364,7 @@ filesys_error_t filesys_get_file_info(slate_t *slate,
  * @param max_files Maximum number of entries that file_list can hold (array
  *        capacity). If there are more files on disk than max_files, only
  *        max_files entries are written.
+ * @param deep_verify Read every file through to compute its CRC.
  * @param num_files_found Pointer to a variable that will receive the total
  *        number of files written to file_list.
  * @param lfs_error_code Pointer to store the first LFS error code encountered.
@@ -341,10 +376,36 @@ filesys_error_t filesys_get_file_info(slate_t *slate,
  */
 filesys_error_t filesys_list_files(slate_t *slate,
                                    filesys_file_info_t *file_list,
-                                   uint16_t max_files,
+                                   uint16_t max_files, bool deep_verify,
                                    uint16_t *num_files_found,
                                    lfs_ssize_t *lfs_error_code);
 
+/**
+ * Lists the files whose names come after a given one, a page at a time, as
+ * filesys_list_files does for the first page. littlefs keeps a directory
+ * sorted by name, so passing the name of the last file of a page as after
+ * gives the next one, without reading the files already listed.
+ *
+ * @param slate Pointer to the slate structure.
+ * @param after Null-terminated name the listing starts after, "" for the
+ *        first page.
+ * @param file_list Pointer to a caller-allocated array of filesys_file_info_t
+ *        that will be populated with file information.
+ * @param max_files Maximum number of entries that file_list can hold.
+ * @param deep_verify Read every file through to compute its CRC.
+ * @param num_files_found Pointer to a variable that will receive the number
+ *        of files written to file_list.
+ * @param more Pointer to a variable set if files remain after this page.
+ * @param lfs_error_code Pointer to store the first LFS error code encountered.
+ *        LFS_ERR_OK if no LFS error occurred.
+ * @return As filesys_list_files.
+ */
+filesys_error_t filesys_list_files_page(slate_t *slate, const char *after,
+                                        filesys_file_info_t *file_list,
+                                        uint16_t max_files, bool deep_verify,
+                                        uint16_t *num_files_found, bool *more,
+                                        lfs_ssize_t *lfs_error_code);
+
 /* ===== Read Operations ===== */
 /* These functions provide a standardized interface for reading files from MRAM.
  * CRC integrity is verified when a file is opened for reading, so every read
@@ -356,9 +417,10 @@ filesys_error_t filesys_list_files(slate_t *slate,
  * Opens a file for reading and verifies its CRC32 integrity.
  *
  * The file's on-disk data is read to compute a CRC32 which is compared against
- * the stored CRC attribute. If the CRC does not match, the file is not opened
- * and an error is returned. The caller must provide an lfs_file_t object that
- * will be used for all subsequent read operations on this file.
+ * the stored CRC attribute, whether or not it has a verified CRC. If the CRC
+ * does not match, the file is not opened and an error is returned. The caller
+ * must provide an lfs_file_t object that will be used for all subsequent read
+ * operations on this file.
  *
  * File metadata (size, computed CRC, expected CRC, validity flags) is written
  * to the caller-provided filesys_file_info_t, even on CRC mismatch, so the
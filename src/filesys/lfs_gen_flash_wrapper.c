@@ -2,6 +2,7 @@
 #include "lfs_gen_flash_wrapper.h"
 #include "hardware/flash.h"
 #include "hardware/sync.h"
+#include "xip_safe.h"
 #include <string.h>
 
 // PLEASE FOR THE LOVE OF GOD, BUDDHA, OR WHATEVER YOU BELIEVE IN
@@ -24,25 +25,57 @@ int lfs_gen_flash_wrap_read(const struct lfs_config *c, lfs_block_t block,
     return 0;
 }
 
+// How long to wait for the other core to park before failing the operation
+#define LFS_FLASH_SAFE_EXECUTE_TIMEOUT_MS 10
+
+typedef struct
+{
+    unsigned int flash_offset;
+    const void *buffer;
+    lfs_size_t size;
+} flash_op_args_t;
+
+static void flash_prog_cb(void *param)
+{
+    flash_op_args_t *args = (flash_op_args_t *)param;
+    flash_range_program(args->flash_offset, (const uint8_t *)args->buffer,
+                        args->size);
+}
+
+static void flash_erase_cb(void *param)
+{
+    flash_op_args_t *args = (flash_op_args_t *)param;
+    flash_range_erase(args->flash_offset, args->size);
+}
+
+// xip_safe_execute disables interrupts and, once the core1 executor is
+// running, parks the other core in SRAM while XIP is offline.
 int lfs_gen_flash_wrap_prog(const struct lfs_config *c, lfs_block_t block,
                             lfs_off_t off, const void *buffer, lfs_size_t size)
 {
-    unsigned int flash_offset = LFS_FLASH_BASE + (block * c->block_size) + off;
+    flash_op_args_t args = {
+        .flash_offset = LFS_FLASH_BASE + (block * c->block_size) + off,
+        .buffer = buffer,
+        .size = size,
+    };
 
-    unsigned int ints = save_and_disable_interrupts();
-    flash_range_program(flash_offset, (const uint8_t *)buffer, size);
-    restore_interrupts(ints);
+    if (xip_safe_execute(flash_prog_cb, &args,
+                         LFS_FLASH_SAFE_EXECUTE_TIMEOUT_MS) != PICO_OK)
+        return LFS_ERR_IO;
 
     return 0;
 }
 
 int lfs_gen_flash_wrap_erase(const struct lfs_config *c, lfs_block_t block)
 {
-    unsigned int flash_offset = LFS_FLASH_BASE + (block * c->block_size);
+    flash_op_args_t args = {
+        .flash_offset = LFS_FLASH_BASE + (block * c->block_size),
+        .size = c->block_size,
+    };
 
-    unsigned int ints = save_and_disable_interrupts();
-    flash_range_erase(flash_offset, c->block_size);
-    restore_interrupts(ints);
+    if (xip_safe_execute(flash_erase_cb, &args,
+                         LFS_FLASH_SAFE_EXECUTE_TIMEOUT_MS) != PICO_OK)
+        return LFS_ERR_IO;
 
     return 0;
 }
@@ -58,11 +91,15 @@ int lfs_gen_flash_wrap_sync(const struct lfs_config *c)
 #define MOCK_FLASH_SIZE (1024 * 1024)
 static uint8_t mock_flash[MOCK_FLASH_SIZE];
 
+uint64_t lfs_gen_flash_wrap_mock_bytes_read;
+uint64_t lfs_gen_flash_wrap_mock_bytes_prog;
+
 int lfs_gen_flash_wrap_read(const struct lfs_config *c, lfs_block_t block,
                             lfs_off_t off, void *buffer, lfs_size_t size)
 {
     uint32_t addr = block * c->block_size + off;
     memcpy(buffer, &mock_flash[addr], size);
+    lfs_gen_flash_wrap_mock_bytes_read += size;
     return 0;
 }
 
@@ -71,6 +108,7 @@ int lfs_gen_flash_wrap_prog(const struct lfs_config *c, lfs_block_t block,
 {
     uint32_t addr = block * c->block_size + off;
     memcpy(&mock_flash[addr], buffer, size);
+    lfs_gen_flash_wrap_mock_bytes_prog += size;
     return 0;
 }
 
@@ -40,4 +40,9 @@ int lfs_gen_flash_wrap_sync(const struct lfs_config *c);
 #ifdef TEST
 // Reset the mock flash backing store to all 0xFF (erased state).
 void lfs_gen_flash_wrap_mock_reset(void);
+
+// Bytes littlefs has read from and programmed to the mock, for measuring I/O.
+// Free running; take the difference over what is being measured.
+extern uint64_t lfs_gen_flash_wrap_mock_bytes_read;
+extern uint64_t lfs_gen_flash_wrap_mock_bytes_prog;
 #endif
@@ -3,7 +3,8 @@
 int lfs_mram_wrap_read(const struct lfs_config *c, lfs_block_t block,
                        lfs_off_t off, void *buffer, lfs_size_t size)
 {
-    mram_read(block * c->block_size + off, buffer, size);
+    if (!mram_read(block * c->block_size + off, buffer, size))
+        return LFS_ERR_IO;
 
     return LFS_ERR_OK;
 }
@@ -0,0 +1,185 @@
+/**
+ * @file filesys_crc_bench.c
+ *
+ * Host benchmark of the MRAM traffic of a file upload through filesys.
+ *
+ * Each file is written the way FTP writes it: one FILESYS_BUFFER_SIZE cycle at
+ * a time, then completed. Bytes read from and programmed to the block device
+ * are counted in the mock, so they include littlefs' own metadata. Completing
+ * with the running CRC is compared to reading the file back to check it
+ * (FILESYS_VERIFY_ON_COMPLETE). Then a directory of such files is listed,
+ * from the verified CRCs and with a deep verify.
+ *
+ * Usage: filesys_crc_bench [file_kib...]
+ */
+
+#include "crc32.h"
+#include "filesys.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Files of the listing, which fill about three quarters of the filesystem
+#define LIST_MAX_FILES 24
+#define LIST_FILE_KIB 16
+
+typedef struct
+{
+    uint64_t read;
+    uint64_t prog;
+} traffic_t;
+
+static traffic_t traffic_now(void)
+{
+    return (traffic_t){lfs_gen_flash_wrap_mock_bytes_read,
+                       lfs_gen_flash_wrap_mock_bytes_prog};
+}
+
+// Starts a file and commits it a cycle at a time, short of completing it
+static int write_file(slate_t *slate, const char *fname, const uint8_t *file,
+                      uint32_t len)
+{
+    lfs_ssize_t lfs_error;
+    lfs_ssize_t blocks_left;
+    FILESYS_BUFFERED_FNAME_STR_T fname_str;
+    snprintf(fname_str, sizeof(fname_str), "%s", fname);
+    if (filesys_start_file_write(slate, fname_str, len, crc32(file, len),
+                                 &lfs_error, &blocks_left) != FILESYS_OK)
+        return -1;
+
+    for (uint32_t i = 0; i < len; i += FILESYS_BUFFER_SIZE)
+    {
+        FILESYS_BUFFER_SIZE_T n = len - i < FILESYS_BUFFER_SIZE
+                                      ? len - i
+                                      : FILESYS_BUFFER_SIZE;
+        if (filesys_write_data_to_buffer(slate, file + i, n, 0, &lfs_error) !=
+                FILESYS_OK ||
+            filesys_write_buffer_to_mram(slate, n, &lfs_error) != FILESYS_OK)
+            return -1;
+    }
+    return 0;
+}
+
+// Traffic of the upload and, within it, of completing the file
+static int upload(slate_t *slate, const uint8_t *file, uint32_t len,
+                  bool verify, traffic_t *total, traffic_t *complete)
+{
+    lfs_ssize_t lfs_error;
+    if (filesys_reformat_initialize(slate, &lfs_error) != FILESYS_OK)
+        return -1;
+    slate->filesys_verify_on_complete = verify;
+
+    traffic_t start = traffic_now();
+    if (write_file(slate, "BN", file, len) < 0)
+        return -1;
+
+    traffic_t before_complete = traffic_now();
+    if (filesys_complete_file_write(slate, &lfs_error) != FILESYS_OK)
+        return -1;
+    traffic_t end = traffic_now();
+
+    total->read = end.read - start.read;
+    total->prog = end.prog - start.prog;
+    complete->read = end.read - before_complete.read;
+    complete->prog = end.prog - before_complete.prog;
+    return 0;
+}
+
+// Bytes read listing n_files uploaded files, from their verified CRCs and
+// with a deep verify
+static int list(slate_t *slate, const uint8_t *file, uint32_t len,
+                int n_files, uint64_t *cached, uint64_t *deep)
+{
+    lfs_ssize_t lfs_error;
+    if (filesys_reformat_initialize(slate, &lfs_error) != FILESYS_OK)
+        return -1;
+
+    for (int i = 0; i < n_files; i++)
+    {
+        char fname[3] = {'A' + i / 26, 'A' + i % 26, '\0'};
+        if (write_file(slate, fname, file, len) < 0 ||
+            filesys_complete_file_write(slate, &lfs_error) != FILESYS_OK)
+            return -1;
+    }
+
+    static filesys_file_info_t file_list[LIST_MAX_FILES];
+    uint16_t num_files_found;
+    for (int deep_verify = 0; deep_verify <= 1; deep_verify++)
+    {
+        traffic_t start = traffic_now();
+        if (filesys_list_files(slate, file_list, LIST_MAX_FILES, deep_verify,
+                               &num_files_found,
+                               &lfs_error) != FILESYS_OK ||
+            num_files_found != n_files)
+            return -1;
+        *(deep_verify ? deep : cached) = traffic_now().read - start.read;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t default_kib[] = {16, 64, 256};
+    int n_sizes = argc > 1 ? argc - 1 : 3;
+
+    slate_t slate;
+    if (clear_and_init_slate(&slate) != 0)
+        return 1;
+
+    // Gathered first, as filesys logs as it goes
+    char lines[16][128];
+    int n_lines = 0;
+    for (int i = 0; i < n_sizes && n_lines + 2 <= 16; i++)
+    {
+        uint32_t len = (argc > 1 ? (uint32_t)atoi(argv[i + 1])
+                                 : default_kib[i]) * 1024;
+        uint8_t *file = malloc(len);
+        if (file == NULL)
+            return 1;
+        for (uint32_t j = 0; j < len; j++)
+            file[j] = (uint8_t)rand();
+
+        for (int verify = 0; verify <= 1; verify++)
+        {
+            traffic_t total, complete;
+            if (upload(&slate, file, len, verify, &total, &complete) < 0)
+            {
+                fprintf(stderr, "Upload of %u KiB failed\n", len / 1024);
+                return 1;
+            }
+            snprintf(lines[n_lines++], sizeof(lines[0]),
+                     "%6u KiB  %-7s %6.2f %6.2f %6.2f   %8.2f\n", len / 1024,
+                     verify ? "verify" : "running",
+                     (double)total.read / len, (double)total.prog / len,
+                     (double)(total.read + total.prog) / len,
+                     (double)complete.read / len);
+        }
+        free(file);
+    }
+
+    uint32_t len = LIST_FILE_KIB * 1024;
+    uint8_t *file = malloc(len);
+    if (file == NULL)
+        return 1;
+    for (uint32_t j = 0; j < len; j++)
+        file[j] = (uint8_t)rand();
+    uint64_t cached, deep;
+    if (list(&slate, file, len, LIST_MAX_FILES, &cached, &deep) < 0)
+    {
+        fprintf(stderr, "Listing failed\n");
+        return 1;
+    }
+    free(file);
+
+    printf("\nMRAM traffic per uploaded byte\n");
+    printf("    file  check     read   prog  total   complete\n");
+    for (int i = 0; i < n_lines; i++)
+        fputs(lines[i], stdout);
+
+    printf("\nBytes read listing %d files of %d KiB\n", LIST_MAX_FILES,
+           LIST_FILE_KIB);
+    printf("  cached %8llu (%llu per file)\n", (unsigned long long)cached,
+           (unsigned long long)(cached / LIST_MAX_FILES));
+    printf("  deep   %8llu (%llu per file)\n", (unsigned long long)deep,
+           (unsigned long long)(deep / LIST_MAX_FILES));
+    return 0;
+}
@@ -1301,7 +1301,7 @@ int filesys_test_list_files_empty_filesystem_success(slate_t *slate)
     uint16_t num_files_found = 0xFFFF; // Set to garbage to verify it's updated
 
     filesys_error_t code = filesys_list_files(
-        slate, file_list, 8, &num_files_found, &lfs_error_code);
+        slate, file_list, 8, false, &num_files_found, &lfs_error_code);
     TEST_ASSERT(code == FILESYS_OK,
                 "list_files should succeed on empty filesystem");
     TEST_ASSERT(lfs_error_code == LFS_ERR_OK,
@@ -1387,7 +1387,7 @@ int filesys_test_list_files_multiple_files_success(slate_t *slate)
     filesys_file_info_t file_list[8];
     uint16_t num_files_found = 0;
 
-    code = filesys_list_files(slate, file_list, 8, &num_files_found,
+    code = filesys_list_files(slate, file_list, 8, false, &num_files_found,
                               &lfs_error_code);
     TEST_ASSERT(code == FILESYS_OK, "list_files should succeed");
     TEST_ASSERT(lfs_error_code == LFS_ERR_OK,
@@ -1485,7 +1485,7 @@ int filesys_test_list_files_max_files_limit_success(slate_t *slate)
     filesys_file_info_t file_list[1];
     uint16_t num_files_found = 0;
 
-    code = filesys_list_files(slate, file_list, 1, &num_files_found,
+    code = filesys_list_files(slate, file_list, 1, false, &num_files_found,
                               &lfs_error_code);
     TEST_ASSERT(code == FILESYS_OK, "list_files should succeed with limit");
     TEST_ASSERT(lfs_error_code == LFS_ERR_OK,
@@ -1537,7 +1537,7 @@ int filesys_test_list_files_after_cancel_success(slate_t *slate)
     filesys_file_info_t file_list[8];
     uint16_t num_files_found = 0xFFFF;
 
-    code = filesys_list_files(slate, file_list, 8, &num_files_found,
+    code = filesys_list_files(slate, file_list, 8, false, &num_files_found,
                               &lfs_error_code);
     TEST_ASSERT(code == FILESYS_OK, "list_files should succeed after cancel");
     TEST_ASSERT(lfs_error_code == LFS_ERR_OK,
@@ -1601,7 +1601,7 @@ int filesys_test_list_files_crc_mismatch_success(slate_t *slate)
     filesys_file_info_t file_list[8];
     uint16_t num_files_found = 0;
 
-    code = filesys_list_files(slate, file_list, 8, &num_files_found,
+    code = filesys_list_files(slate, file_list, 8, false, &num_files_found,
                               &lfs_error_code);
     TEST_ASSERT(code == FILESYS_OK, "list_files should succeed");
     TEST_ASSERT(num_files_found == 1, "Should find 1 file");
@@ -2389,7 +2389,360 @@ int filesys_test_read_multi_chunk_file_success(slate_t *slate)
 }
 
 // ============================================================================
-// Test 41: Probe maximum writable file capacity
+// Test 41: Running CRC - completing does not read the file back
+// ============================================================================
+int filesys_test_running_crc_success(slate_t *slate)
+{
+    LOG_DEBUG("=== Test: Running CRC ===\n");
+
+    lfs_ssize_t lfs_error_code;
+    lfs_ssize_t blocks_left;
+    FILESYS_BUFFERED_FNAME_STR_T fname = "RC";
+    const FILESYS_BUFFERED_FILE_LEN_T half =
+        sizeof(filesys_test_example_file_1_buf) / 2;
+
+    filesys_error_t code = filesys_start_file_write(
+        slate, fname, sizeof(filesys_test_example_file_1_buf),
+        filesys_test_example_file_1_crc, &lfs_error_code, &blocks_left);
+    TEST_ASSERT(code == FILESYS_OK, "start_file_write should succeed");
+    TEST_ASSERT(slate->filesys_bytes_written == 0,
+                "No bytes should be committed yet");
+
+    // Commit the file in two buffers, as FTP does by cycle
+    for (FILESYS_BUFFERED_FILE_LEN_T i = 0; i < 2; i++)
+    {
+        code = filesys_write_data_to_buffer(
+            slate, filesys_test_example_file_1_buf + i * half, half, 0,
+            &lfs_error_code);
+        TEST_ASSERT(code == FILESYS_OK, "write_data_to_buffer should succeed");
+
+        code = filesys_write_buffer_to_mram(slate, half, &lfs_error_code);
+        TEST_ASSERT(code == FILESYS_OK, "write_buffer_to_mram should succeed");
+        TEST_ASSERT(slate->filesys_bytes_written == (i + 1) * half,
+                    "Committed bytes should grow by each buffer");
+    }
+
+    TEST_ASSERT(slate->filesys_crc_state_valid, "Running CRC should be valid");
+    TEST_ASSERT(~slate->filesys_crc_state == filesys_test_example_file_1_crc,
+                "Running CRC should match the whole file");
+
+    filesys_error_t crc_error;
+    unsigned int crc = filesys_written_crc(slate, &crc_error, &lfs_error_code);
+    TEST_ASSERT(crc_error == FILESYS_OK, "written_crc should succeed");
+    TEST_ASSERT(crc == filesys_test_example_file_1_crc,
+                "written_crc should return the running CRC");
+
+#ifdef TEST // MRAM traffic is only counted by the mock
+    uint64_t bytes_read = lfs_gen_flash_wrap_mock_bytes_read;
+#endif
+    code = filesys_complete_file_write(slate, &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "complete_file_write should succeed");
+#ifdef TEST
+    TEST_ASSERT(lfs_gen_flash_wrap_mock_bytes_read == bytes_read,
+                "Completing should not read anything from MRAM");
+#endif
+
+    LOG_DEBUG("=== Test PASSED: Running CRC ===\n");
+    return 0;
+}
+
+// ============================================================================
+// Test 42: Verify on complete - the file is read back and checked
+// ============================================================================
+int filesys_test_verify_on_complete_should_fail(slate_t *slate)
+{
+    LOG_DEBUG("=== Test: Verify on Complete ===\n");
+
+    lfs_ssize_t lfs_error_code;
+    lfs_ssize_t blocks_left;
+    FILESYS_BUFFERED_FNAME_STR_T fname = "VC";
+
+    filesys_error_t code = filesys_start_file_write(
+        slate, fname, sizeof(filesys_test_example_file_1_buf),
+        filesys_test_example_file_1_crc, &lfs_error_code, &blocks_left);
+    TEST_ASSERT(code == FILESYS_OK, "start_file_write should succeed");
+
+    int8_t code_8 = filesys_test_write_whole_buffer(
+        slate, (uint8_t *)filesys_test_example_file_1_buf,
+        sizeof(filesys_test_example_file_1_buf));
+    TEST_ASSERT(code_8 == FILESYS_OK,
+                "write_whole_buffer should succeed, exited with %d", code_8);
+
+    // Change the file on MRAM behind filesys' back, keeping its length
+    lfs_file_t lfs_file;
+    int err =
+        lfs_file_opencfg(filesys_get_lfs(), &lfs_file, fname,
+                         LFS_O_WRONLY | LFS_O_TRUNC, &filesys_lfs_file_cfg);
+    TEST_ASSERT(err == 0, "Raw LFS file open for corruption should succeed");
+
+    lfs_ssize_t written = lfs_file_write(
+        filesys_get_lfs(), &lfs_file, filesys_test_example_file_6_buf,
+        sizeof(filesys_test_example_file_6_buf));
+    TEST_ASSERT(written == sizeof(filesys_test_example_file_6_buf),
+                "Raw LFS write should succeed");
+
+    err = lfs_file_close(filesys_get_lfs(), &lfs_file);
+    TEST_ASSERT(err == 0, "Raw LFS file close should succeed");
+
+    // The running CRC cannot see it, reading the file back does
+    slate->filesys_verify_on_complete = true;
+#ifdef TEST // MRAM traffic is only counted by the mock
+    uint64_t bytes_read = lfs_gen_flash_wrap_mock_bytes_read;
+#endif
+    code = filesys_complete_file_write(slate, &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_ERR_CRC_MISMATCH,
+                "complete_file_write should fail with CRC mismatch");
+#ifdef TEST
+    TEST_ASSERT(lfs_gen_flash_wrap_mock_bytes_read >=
+                    bytes_read + sizeof(filesys_test_example_file_6_buf),
+                "Completing should read the file back from MRAM");
+#endif
+    TEST_ASSERT(slate->filesys_is_writing_file,
+                "File should still be open after a CRC mismatch");
+
+    code = filesys_cancel_file_write(slate, &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "cancel_file_write should succeed");
+
+    LOG_DEBUG("=== Test PASSED: Verify on Complete ===\n");
+    return 0;
+}
+
+// ============================================================================
+// Test 43: List files - the CRC verified on write is listed without reading
+// the file, and a deep verify reads it
+// ============================================================================
+int filesys_test_list_files_cached_crc_success(slate_t *slate)
+{
+    LOG_DEBUG("=== Test: List Files - Cached CRC ===\n");
+
+    lfs_ssize_t lfs_error_code;
+    lfs_ssize_t blocks_left;
+    FILESYS_BUFFERED_FNAME_STR_T fname = "CC";
+
+    static uint8_t buffer[2 * FILESYS_BUFFER_SIZE];
+    for (size_t i = 0; i < sizeof(buffer); i++)
+        buffer[i] = (uint8_t)(i * 7 + 1);
+    const unsigned int file_crc = crc32(buffer, sizeof(buffer));
+
+    filesys_error_t code = filesys_start_file_write(
+        slate, fname, sizeof(buffer), file_crc, &lfs_error_code, &blocks_left);
+    TEST_ASSERT(code == FILESYS_OK, "start_file_write should succeed");
+
+    int8_t code_8 =
+        filesys_test_write_whole_buffer(slate, buffer, sizeof(buffer));
+    TEST_ASSERT(code_8 == FILESYS_OK,
+                "write_whole_buffer should succeed, exited with %d", code_8);
+
+    code = filesys_complete_file_write(slate, &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "complete_file_write should succeed");
+
+    filesys_file_info_t file_list[1];
+    uint16_t num_files_found = 0;
+
+#ifdef TEST // MRAM traffic is only counted by the mock
+    uint64_t bytes_read = lfs_gen_flash_wrap_mock_bytes_read;
+#endif
+    code = filesys_list_files(slate, file_list, 1, false, &num_files_found,
+                              &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "list_files should succeed");
+    TEST_ASSERT(num_files_found == 1, "Should find 1 file");
+#ifdef TEST
+    TEST_ASSERT(lfs_gen_flash_wrap_mock_bytes_read - bytes_read <
+                    sizeof(buffer) / 4,
+                "Listing should not read the file through");
+#endif
+    TEST_ASSERT(file_list[0].flags & FILESYS_FILE_INFO_CRC_CACHED,
+                "Computed CRC should be the cached one");
+    TEST_ASSERT(file_list[0].flags & FILESYS_FILE_INFO_CRC_MATCH,
+                "CRC match flag should be set");
+    TEST_ASSERT(file_list[0].computed_crc == file_crc,
+                "Cached CRC should be the file's CRC");
+
+#ifdef TEST
+    bytes_read = lfs_gen_flash_wrap_mock_bytes_read;
+#endif
+    code = filesys_list_files(slate, file_list, 1, true, &num_files_found,
+                              &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "Deep list_files should succeed");
+#ifdef TEST
+    TEST_ASSERT(lfs_gen_flash_wrap_mock_bytes_read - bytes_read >=
+                    sizeof(buffer),
+                "A deep verify should read the file through");
+#endif
+    TEST_ASSERT(!(file_list[0].flags & FILESYS_FILE_INFO_CRC_CACHED),
+                "Deep verify should not use the cached CRC");
+    TEST_ASSERT(file_list[0].flags & FILESYS_FILE_INFO_CRC_MATCH,
+                "CRC match flag should be set");
+    TEST_ASSERT(file_list[0].computed_crc == file_crc,
+                "Computed CRC should be the file's CRC");
+
+    LOG_DEBUG("=== Test PASSED: List Files - Cached CRC ===\n");
+    return 0;
+}
+
+// ============================================================================
+// Test 44: List files - MRAM going bad under a file is only seen by a deep
+// verify, which then leaves it on record
+// ============================================================================
+int filesys_test_list_files_deep_verify_success(slate_t *slate)
+{
+    LOG_DEBUG("=== Test: List Files - Deep Verify ===\n");
+
+    lfs_ssize_t lfs_error_code;
+    lfs_ssize_t blocks_left;
+    FILESYS_BUFFERED_FNAME_STR_T fname = "DV";
+
+    filesys_error_t code = filesys_start_file_write(
+        slate, fname, sizeof(filesys_test_example_file_1_buf),
+        filesys_test_example_file_1_crc, &lfs_error_code, &blocks_left);
+    TEST_ASSERT(code == FILESYS_OK, "start_file_write should succeed");
+
+    int8_t code_8 = filesys_test_write_whole_buffer(
+        slate, (uint8_t *)filesys_test_example_file_1_buf,
+        sizeof(filesys_test_example_file_1_buf));
+    TEST_ASSERT(code_8 == FILESYS_OK,
+                "write_whole_buffer should succeed, exited with %d", code_8);
+
+    code = filesys_complete_file_write(slate, &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "complete_file_write should succeed");
+
+    // The file fits in its one block, data first. Clear bits of its first
+    // bytes on the block device, under littlefs, which leaves the file's
+    // size and blocks as they were.
+    lfs_file_t lfs_file;
+    int err = lfs_file_opencfg(filesys_get_lfs(), &lfs_file, fname,
+                               LFS_O_RDONLY, &filesys_lfs_file_cfg);
+    TEST_ASSERT(err == 0, "Raw LFS file open should succeed");
+    lfs_block_t head = lfs_file.ctz.head;
+    err = lfs_file_close(filesys_get_lfs(), &lfs_file);
+    TEST_ASSERT(err == 0, "Raw LFS file close should succeed");
+
+    const uint8_t zeros[16] = {0};
+    err = filesys_lfs_cfg.prog(&filesys_lfs_cfg, head, 0, zeros,
+                               sizeof(zeros));
+    TEST_ASSERT(err == 0, "Raw block device write should succeed");
+
+    // Remount, as after a reboot, so nothing is served from littlefs' caches
+    err = lfs_unmount(filesys_get_lfs());
+    TEST_ASSERT(err == 0, "Unmount should succeed");
+    code = filesys_initialize(slate, &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "Remount should succeed");
+
+    filesys_file_info_t file_list[1];
+    uint16_t num_files_found = 0;
+
+    code = filesys_list_files(slate, file_list, 1, false, &num_files_found,
+                              &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "list_files should succeed");
+    TEST_ASSERT(file_list[0].flags & FILESYS_FILE_INFO_CRC_CACHED,
+                "Computed CRC should be the cached one");
+    TEST_ASSERT(file_list[0].flags & FILESYS_FILE_INFO_CRC_MATCH,
+                "The cached CRC cannot see the damage");
+
+    code = filesys_list_files(slate, file_list, 1, true, &num_files_found,
+                              &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "Deep list_files should succeed");
+    TEST_ASSERT(!(file_list[0].flags & FILESYS_FILE_INFO_CRC_CACHED),
+                "Deep verify should not use the cached CRC");
+    TEST_ASSERT(file_list[0].flags & FILESYS_FILE_INFO_COMPUTED_CRC_VALID,
+                "Computed CRC should be valid");
+    TEST_ASSERT(!(file_list[0].flags & FILESYS_FILE_INFO_CRC_MATCH),
+                "Deep verify should find the damage");
+    const FILESYS_BUFFERED_FILE_CRC_T damaged_crc = file_list[0].computed_crc;
+
+    code = filesys_list_files(slate, file_list, 1, false, &num_files_found,
+                              &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "list_files should succeed");
+    TEST_ASSERT(file_list[0].flags & FILESYS_FILE_INFO_CRC_CACHED,
+                "Computed CRC should be the cached one");
+    TEST_ASSERT(!(file_list[0].flags & FILESYS_FILE_INFO_CRC_MATCH),
+                "The cache should now hold the damaged CRC");
+    TEST_ASSERT(file_list[0].computed_crc == damaged_crc,
+                "Cached CRC should be the one deep verify found");
+
+    LOG_DEBUG("=== Test PASSED: List Files - Deep Verify ===\n");
+    return 0;
+}
+
+// ============================================================================
+// Test 45: List files a page at a time, in name order
+// ============================================================================
+int filesys_test_list_files_page_success(slate_t *slate)
+{
+    LOG_DEBUG("=== Test: List Files - Pages ===\n");
+
+    lfs_ssize_t lfs_error_code;
+    lfs_ssize_t blocks_left;
+
+    // Written out of order, listed in order
+    static const char *const written[] = {"P3", "P1", "P5", "P2", "P4"};
+    static const char *const listed[] = {"P1", "P2", "P3", "P4", "P5"};
+    for (size_t i = 0; i < 5; i++)
+    {
+        FILESYS_BUFFERED_FNAME_STR_T fname;
+        memcpy(fname, written[i], sizeof(fname));
+
+        filesys_error_t code = filesys_start_file_write(
+            slate, fname, sizeof(filesys_test_example_file_3_buf),
+            filesys_test_example_file_3_crc, &lfs_error_code, &blocks_left);
+        TEST_ASSERT(code == FILESYS_OK, "start_file_write should succeed");
+
+        int8_t code_8 = filesys_test_write_whole_buffer(
+            slate, (uint8_t *)filesys_test_example_file_3_buf,
+            sizeof(filesys_test_example_file_3_buf));
+        TEST_ASSERT(code_8 == FILESYS_OK,
+                    "write_whole_buffer should succeed, exited with %d",
+                    code_8);
+
+        code = filesys_complete_file_write(slate, &lfs_error_code);
+        TEST_ASSERT(code == FILESYS_OK, "complete_file_write should succeed");
+    }
+
+    // Pages of two, each starting after the last name of the one before
+    filesys_file_info_t page[2];
+    FILESYS_BUFFERED_FNAME_STR_T after = "";
+    size_t total = 0;
+    for (int n = 0; n < 3; n++)
+    {
+        uint16_t num_files_found = 0xFFFF;
+        bool more;
+        filesys_error_t code =
+            filesys_list_files_page(slate, after, page, 2, false,
+                                    &num_files_found, &more, &lfs_error_code);
+        TEST_ASSERT(code == FILESYS_OK, "list_files_page should succeed");
+        TEST_ASSERT(num_files_found == (n < 2 ? 2 : 1),
+                    "Page %d should hold %d files, not %u", n, n < 2 ? 2 : 1,
+                    num_files_found);
+        TEST_ASSERT(more == (n < 2), "Only the last page should have no more");
+
+        for (uint16_t i = 0; i < num_files_found; i++, total++)
+        {
+            TEST_ASSERT(strcmp(page[i].fname, listed[total]) == 0,
+                        "File %zu should be %s, not %s", total, listed[total],
+                        page[i].fname);
+            TEST_ASSERT(page[i].flags & FILESYS_FILE_INFO_CRC_MATCH,
+                        "CRC match flag should be set");
+        }
+        memcpy(after, page[num_files_found - 1].fname, sizeof(after));
+    }
+    TEST_ASSERT(total == 5, "Every file should be listed once");
+
+    // Nothing after the last file
+    uint16_t num_files_found = 0xFFFF;
+    bool more = true;
+    filesys_error_t code =
+        filesys_list_files_page(slate, "P5", page, 2, false, &num_files_found,
+                                &more, &lfs_error_code);
+    TEST_ASSERT(code == FILESYS_OK, "list_files_page should succeed");
+    TEST_ASSERT(num_files_found == 0 && !more,
+                "A page past the last file should be empty");
+
+    LOG_DEBUG("=== Test PASSED: List Files - Pages ===\n");
+    return 0;
+}
+
+// ============================================================================
+// Test 46: Probe maximum writable file capacity
 //
 // Writes FILESYS_BUFFER_SIZE-byte chunks to a single file until LFS reports
 // LFS_ERR_NOSPC. Reports the total bytes successfully committed so callers
@@ -2512,6 +2865,13 @@ const test_harness_case_t filesys_tests[] = {
     {37, filesys_test_close_file_read_success, "Close File Read"},
     {38, filesys_test_read_full_workflow_success, "Read Full Workflow"},
     {39, filesys_test_read_multi_chunk_file_success, "Read Multi-Chunk File"},
+    {40, filesys_test_running_crc_success, "Running CRC"},
+    {41, filesys_test_verify_on_complete_should_fail, "Verify on Complete"},
+    {42, filesys_test_list_files_cached_crc_success,
+     "List Files - Cached CRC"},
+    {43, filesys_test_list_files_deep_verify_success,
+     "List Files - Deep Verify"},
+    {44, filesys_test_list_files_page_success, "List Files - Pages"},
 };
 
 const size_t filesys_tests_len =
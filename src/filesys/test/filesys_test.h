@@ -48,6 +48,11 @@ int filesys_test_read_file_size_success(slate_t *slate);
 int filesys_test_close_file_read_success(slate_t *slate);
 int filesys_test_read_full_workflow_success(slate_t *slate);
 int filesys_test_read_multi_chunk_file_success(slate_t *slate);
+int filesys_test_running_crc_success(slate_t *slate);
+int filesys_test_verify_on_complete_should_fail(slate_t *slate);
+int filesys_test_list_files_cached_crc_success(slate_t *slate);
+int filesys_test_list_files_deep_verify_success(slate_t *slate);
+int filesys_test_list_files_page_success(slate_t *slate);
 int filesys_test_probe_max_file_capacity(void);
 
 extern const test_harness_case_t filesys_tests[];
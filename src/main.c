@@ -88,10 +88,19 @@ int main()
      */
     LOG_DEBUG("main: Initializing persistent data...");
     persistent_data_t *data = init_persistent_data();
-    LOG_DEBUG("main: Persistent data initialized, reboot count = %d",
-              data->reboot_counter);
-    increment_reboot_counter();
-    LOG_DEBUG("      rebot_counter++ -> %d", data->reboot_counter);
+    if (data == NULL)
+    {
+        // Keep booting: only the reboot count is lost
+        LOG_ERROR("main: Could not write persistent data to flash!");
+    }
+    else
+    {
+        LOG_DEBUG("main: Persistent data initialized, reboot count = %d",
+                  data->reboot_counter);
+        if (!increment_reboot_counter())
+            LOG_ERROR("main: Could not save the reboot counter!");
+        LOG_DEBUG("      rebot_counter++ -> %d", data->reboot_counter);
+    }
 
     /*
      * Initialize everything.
@@ -100,10 +109,10 @@ int main()
     LOG_INFO("main: Initializing...");
     LOG_DEBUG("main: Calling init()...");
     ASSERT(init(&slate));
-    slate.reboot_counter = data->reboot_counter;
+    slate.reboot_counter = data != NULL ? data->reboot_counter : 0;
 
     LOG_INFO("main: Starting SAMWISE flight software...");
-    LOG_INFO("Current reboot count: %d\n", data->reboot_counter);
+    LOG_INFO("Current reboot count: %d\n", slate.reboot_counter);
 
 #ifdef PACKET_HMAC_PSK
     LOG_INFO("main: HMAC_PSK <ENABLED>");
@@ -8,6 +8,8 @@
 #include "packet.h"
 #include "logger.h"
 
+#include "hardware/sync.h"
+
 #include <tinycrypt/hmac.h>
 #include <tinycrypt/sha256.h>
 #include <tinycrypt/utils.h>
@@ -17,8 +19,6 @@
     "PACKET_HMAC_PSK must be defined for flight builds. See .bazelrc for instructions."
 #endif
 
-#define PACKET_HMAC_PSK_LEN 32
-
 _Static_assert(offsetof(packet_t, hmac) ==
                    sizeof(packet_t) - TC_SHA256_DIGEST_SIZE,
                "hmac must be the last field and no padding before hmac");
@@ -29,8 +29,11 @@ static const size_t PACKET_OFFSET_DATA = offsetof(packet_t, data);
 static const size_t PACKET_OFFSET_AFTER_DATA = offsetof(packet_t, boot_count);
 static const size_t PACKET_OFFSET_HMAC = offsetof(packet_t, hmac);
 
-// Track last seen message ID for replay protection
-static uint32_t last_seen_msg_id = 0;
+#ifdef PACKET_HMAC_PSK
+// Replay protection. Checked from the RX interrupt, so updated with
+// interrupts off.
+static packet_replay_window_t replay_window = {.seen = 1};
+#endif
 
 /*
  * Packet Authentication Requirements & Expectations
@@ -48,8 +51,12 @@ static uint32_t last_seen_msg_id = 0;
  * 2. Replay Protection:
  *    - Each packet includes a boot_count and msg_id.
  *    - The boot_count must match the current system boot count.
- *    - The msg_id must be strictly greater than the last seen msg_id for the
- * current boot_count.
+ *    - The msg_id must not have been accepted before for the current
+ * boot_count. A window of the last PACKET_REPLAY_WINDOW msg_ids tracks which
+ * were accepted, so reordered packets are still fresh; anything below the
+ * window is rejected.
+ *    - The window is reserved ahead in flash, so a reboot that keeps the
+ * boot_count cannot make old msg_ids fresh again.
  *    - If either check fails, the packet is considered a replay and is
  * rejected.
  *
@@ -57,61 +64,226 @@ static uint32_t last_seen_msg_id = 0;
  *    - If PACKET_HMAC_PSK is defined, authentication is enforced as above.
  *    - If PACKET_HMAC_PSK is not defined, authentication is bypassed (all
  * packets are accepted).
- *    - On successful authentication, last_seen_msg_id is updated.
+ *    - The HMAC key schedule (inner/outer SHA-256 midstates) is derived once
+ * from the PSK, and each packet starts from a copy of it.
+ *    - Replays are rejected before any hashing; the receive path uses
+ * packet_check_replay to drop them before they are queued.
+ *    - On successful authentication, the msg_id is marked in the window.
  *    - On failure, an error is logged and the packet is rejected.
  */
 
-bool is_packet_authenticated(packet_t *packet, uint32_t current_boot_count)
+#ifdef PACKET_HMAC_PSK
+static packet_hmac_key_t packet_hmac_key;
+static bool packet_hmac_key_ready = false;
+#endif
+
+void packet_hmac_key_init(packet_hmac_key_t *key, const uint8_t *psk,
+                          size_t psk_len)
+{
+    struct tc_hmac_state_struct hmac;
+    tc_hmac_set_key(&hmac, psk, psk_len);
+
+    // tc_hmac_init absorbs the ipad block; the opad block is absorbed by
+    // tc_hmac_final, so do that part by hand
+    tc_hmac_init(&hmac);
+    key->inner = hmac.hash_state;
+
+    tc_sha256_init(&key->outer);
+    tc_sha256_update(&key->outer, &hmac.key[TC_SHA256_BLOCK_SIZE],
+                     TC_SHA256_BLOCK_SIZE);
+
+    _set(&hmac, 0, sizeof(hmac));
+}
+
+void packet_compute_hmac(const packet_hmac_key_t *key, const packet_t *packet,
+                         uint8_t out[PACKET_HMAC_SIZE])
+{
+    struct tc_sha256_state_struct sha = key->inner;
+    tc_sha256_update(&sha, (const uint8_t *)packet, PACKET_OFFSET_DATA);
+    tc_sha256_update(&sha, packet->data, packet->len);
+    tc_sha256_update(&sha, (const uint8_t *)packet + PACKET_OFFSET_AFTER_DATA,
+                     PACKET_OFFSET_HMAC - PACKET_OFFSET_AFTER_DATA);
+    tc_sha256_final(out, &sha);
+
+    sha = key->outer;
+    tc_sha256_update(&sha, out, TC_SHA256_DIGEST_SIZE);
+    tc_sha256_final(out, &sha);
+}
+
+void packet_auth_init(void)
 {
 #ifdef PACKET_HMAC_PSK
-    if (packet == NULL)
+    packet_hmac_key_init(&packet_hmac_key, (const uint8_t *)PACKET_HMAC_PSK,
+                         PACKET_HMAC_PSK_LEN);
+    packet_hmac_key_ready = true;
+#endif
+}
+
+void packet_replay_window_init(packet_replay_window_t *w, uint32_t boot_count,
+                               uint32_t reserved)
+{
+    w->boot_count = boot_count;
+    w->top = reserved;
+    // Bit 0 is msg_id 0 in a fresh window, which is never valid
+    w->seen = reserved ? ~0ULL : 1;
+    w->reserved = reserved;
+}
+
+packet_auth_result_t packet_replay_window_check(const packet_replay_window_t *w,
+                                                const packet_t *packet,
+                                                uint32_t current_boot_count)
+{
+    if (packet->boot_count != current_boot_count)
+        return PACKET_AUTH_WRONG_BOOT;
+
+    packet_replay_window_t empty;
+    if (w->boot_count != current_boot_count)
     {
-        LOG_ERROR("is_packet_authenticated: NULL packet pointer");
-        return false;
+        packet_replay_window_init(&empty, current_boot_count, 0);
+        w = &empty;
     }
 
-    // Replay protection: check boot_count and msg_id
-    if (packet->boot_count != current_boot_count)
+    uint32_t msg_id = packet->msg_id;
+    if (msg_id > w->top)
+        return PACKET_AUTH_OK;
+
+    uint32_t age = w->top - msg_id;
+    if (age >= PACKET_REPLAY_WINDOW)
+        return PACKET_AUTH_TOO_OLD;
+    if (w->seen & (1ULL << age))
+        return PACKET_AUTH_DUPLICATE;
+    return PACKET_AUTH_OK;
+}
+
+void packet_replay_window_accept(packet_replay_window_t *w, uint32_t msg_id,
+                                 uint32_t current_boot_count)
+{
+    if (w->boot_count != current_boot_count)
+        packet_replay_window_init(w, current_boot_count, 0);
+
+    if (msg_id > w->top)
     {
-        LOG_ERROR("Replay detected: packet boot_count %u != current %u",
-                  packet->boot_count, current_boot_count);
-        return false;
+        uint32_t shift = msg_id - w->top;
+        w->seen = shift < PACKET_REPLAY_WINDOW ? w->seen << shift : 0;
+        w->seen |= 1;
+        w->top = msg_id;
     }
-    if (packet->msg_id <= last_seen_msg_id)
+    else
     {
-        LOG_ERROR("Replay detected: packet msg_id %u <= last seen %u for "
-                  "boot_count %u",
-                  packet->msg_id, last_seen_msg_id, packet->boot_count);
+        w->seen |= 1ULL << (w->top - msg_id);
+    }
+}
+
+bool packet_replay_window_reserve(packet_replay_window_t *w)
+{
+    if (w->top < w->reserved)
         return false;
+
+    w->reserved = w->top + PACKET_REPLAY_RESERVE;
+    return true;
+}
+
+packet_auth_result_t packet_check_replay(const packet_t *packet,
+                                         uint32_t current_boot_count)
+{
+#ifdef PACKET_HMAC_PSK
+    return packet_replay_window_check(&replay_window, packet,
+                                      current_boot_count);
+#else
+    return PACKET_AUTH_OK;
+#endif
+}
+
+void packet_replay_restore(uint32_t boot_count, uint32_t reserved)
+{
+#ifdef PACKET_HMAC_PSK
+    uint32_t ints = save_and_disable_interrupts();
+    packet_replay_window_init(&replay_window, boot_count, reserved);
+    restore_interrupts(ints);
+#endif
+}
+
+bool packet_replay_reserve(uint32_t *boot_count, uint32_t *reserved)
+{
+#ifdef PACKET_HMAC_PSK
+    uint32_t ints = save_and_disable_interrupts();
+    packet_replay_window_t w = replay_window;
+    restore_interrupts(ints);
+
+    // Taken on a copy: the window only counts it once it is persisted
+    bool changed = packet_replay_window_reserve(&w);
+    *boot_count = w.boot_count;
+    *reserved = w.reserved;
+    return changed;
+#else
+    return false;
+#endif
+}
+
+void packet_replay_reserved(uint32_t boot_count, uint32_t reserved)
+{
+#ifdef PACKET_HMAC_PSK
+    uint32_t ints = save_and_disable_interrupts();
+    if (replay_window.boot_count == boot_count &&
+        reserved > replay_window.reserved)
+        replay_window.reserved = reserved;
+    restore_interrupts(ints);
+#endif
+}
+
+packet_auth_result_t packet_authenticate(packet_t *packet,
+                                         uint32_t current_boot_count)
+{
+#ifdef PACKET_HMAC_PSK
+    if (packet == NULL)
+    {
+        LOG_ERROR("packet_authenticate: NULL packet pointer");
+        return PACKET_AUTH_BAD_LENGTH;
     }
 
-    struct tc_hmac_state_struct hmac;
-    tc_hmac_set_key(&hmac, (const uint8_t *)PACKET_HMAC_PSK,
-                    PACKET_HMAC_PSK_LEN);
-    tc_hmac_init(&hmac);
+    // Replay protection comes first: it is cheap, and a replay never needs
+    // hashing
+    packet_auth_result_t result =
+        packet_check_replay(packet, current_boot_count);
+    if (result != PACKET_AUTH_OK)
+    {
+        LOG_ERROR("Replay detected (%d): packet boot_count %u msg_id %u, "
+                  "current boot_count %u",
+                  result, packet->boot_count, packet->msg_id,
+                  current_boot_count);
+        return result;
+    }
+    if (packet->len > PACKET_DATA_SIZE)
+    {
+        LOG_ERROR("packet_authenticate: bad data length %u", packet->len);
+        return PACKET_AUTH_BAD_LENGTH;
+    }
 
-    tc_hmac_update(&hmac, (const void *)packet, PACKET_OFFSET_DATA);
-    tc_hmac_update(&hmac, (const void *)(packet->data), packet->len);
-    size_t after_data_len = PACKET_OFFSET_HMAC - PACKET_OFFSET_AFTER_DATA;
-    tc_hmac_update(
-        &hmac,
-        (const void *)((const uint8_t *)packet + PACKET_OFFSET_AFTER_DATA),
-        after_data_len);
+    if (!packet_hmac_key_ready)
+        packet_auth_init();
 
     uint8_t out_hmac[TC_SHA256_DIGEST_SIZE];
-    tc_hmac_final(out_hmac, TC_SHA256_DIGEST_SIZE, &hmac);
+    packet_compute_hmac(&packet_hmac_key, packet, out_hmac);
 
     if (_compare(out_hmac, packet->hmac, TC_SHA256_DIGEST_SIZE) != 0)
     {
         LOG_ERROR("HMAC mismatch: computed and provided HMACs do not match");
-        return false;
+        return PACKET_AUTH_BAD_HMAC;
     }
 
-    // Update last seen msg_id since this packet is authenticated
-    last_seen_msg_id = packet->msg_id;
+    // Mark the msg_id as seen since this packet is authenticated
+    uint32_t ints = save_and_disable_interrupts();
+    packet_replay_window_accept(&replay_window, packet->msg_id,
+                                current_boot_count);
+    restore_interrupts(ints);
 
-    return true;
+    return PACKET_AUTH_OK;
 #else  // If PACKET_HMAC_PSK is not defined, skip authentication
-    return true;
+    return PACKET_AUTH_OK;
 #endif // PACKET_HMAC_PSK
 }
+
+bool is_packet_authenticated(packet_t *packet, uint32_t current_boot_count)
+{
+    return packet_authenticate(packet, current_boot_count) == PACKET_AUTH_OK;
+}
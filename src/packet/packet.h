@@ -33,8 +33,136 @@ typedef struct __attribute__((packed))
 #define PACKET_DATA_SIZE (sizeof(((packet_t *)0)->data))
 #define PACKET_FOOTER_SIZE (PACKET_SIZE - PACKET_HEADER_SIZE - PACKET_DATA_SIZE)
 #define PACKET_HMAC_SIZE (TC_SHA256_DIGEST_SIZE)
+#define PACKET_HMAC_PSK_LEN 32 // Bytes of PACKET_HMAC_PSK used as the key
 #define PACKET_MIN_SIZE (PACKET_HEADER_SIZE + PACKET_FOOTER_SIZE)
 
+/**
+ * HMAC-SHA256 key schedule: the SHA-256 states after absorbing the key XORed
+ * with ipad and with opad. They depend only on the key, so computing them once
+ * saves two compressions (and TinyCrypt's dummy key hash) per packet.
+ */
+typedef struct
+{
+    struct tc_sha256_state_struct inner;
+    struct tc_sha256_state_struct outer;
+} packet_hmac_key_t;
+
+/**
+ * Derive the key schedule for a pre-shared key.
+ */
+void packet_hmac_key_init(packet_hmac_key_t *key, const uint8_t *psk,
+                          size_t psk_len);
+
+/**
+ * Compute the HMAC of a packet (every field but the HMAC itself).
+ * packet->len must be at most PACKET_DATA_SIZE.
+ */
+void packet_compute_hmac(const packet_hmac_key_t *key, const packet_t *packet,
+                         uint8_t out[PACKET_HMAC_SIZE]);
+
+/**
+ * Outcome of authenticating an uplink packet. Rejections are counted by cause.
+ */
+typedef enum
+{
+    PACKET_AUTH_OK,
+    PACKET_AUTH_WRONG_BOOT, // boot_count is not the current one
+    PACKET_AUTH_TOO_OLD,    // msg_id below the replay window
+    PACKET_AUTH_DUPLICATE,  // msg_id in the window and already accepted
+    PACKET_AUTH_BAD_LENGTH,
+    PACKET_AUTH_BAD_HMAC,
+    PACKET_AUTH_RESULT_COUNT
+} packet_auth_result_t;
+
+/*
+ * Anti-replay window (as in IPsec, RFC 4303 3.4.3). Any msg_id above the
+ * highest accepted one is fresh, and so is one up to PACKET_REPLAY_WINDOW - 1
+ * below it that has not been accepted yet, so packets reordered or
+ * retransmitted within a burst still get through.
+ *
+ * The window belongs to one boot_count. To survive a reboot without the
+ * counter changing, msg_ids are reserved PACKET_REPLAY_RESERVE at a time in
+ * flash; after such a reboot everything up to the reservation counts as seen.
+ * Each reservation erases a flash sector, so one uplink in every
+ * PACKET_REPLAY_RESERVE stalls the radio for tens of ms, FTP bursts included.
+ */
+#define PACKET_REPLAY_WINDOW 64
+#define PACKET_REPLAY_RESERVE 256
+
+typedef struct
+{
+    uint32_t boot_count;
+    uint32_t top;      // Highest msg_id accepted
+    uint64_t seen;     // Bit i set: msg_id top - i accepted
+    uint32_t reserved; // Persisted: every msg_id up to here counts as seen
+} packet_replay_window_t;
+
+/**
+ * Start a window for boot_count in which every msg_id up to reserved (0 for
+ * none) has been seen. msg_id 0 is never fresh.
+ */
+void packet_replay_window_init(packet_replay_window_t *w, uint32_t boot_count,
+                               uint32_t reserved);
+
+/**
+ * Check a packet against the window without changing it. A window for another
+ * boot_count counts as empty.
+ */
+packet_auth_result_t packet_replay_window_check(const packet_replay_window_t *w,
+                                                const packet_t *packet,
+                                                uint32_t current_boot_count);
+
+/**
+ * Mark msg_id as accepted, sliding the window up if it is the new highest.
+ */
+void packet_replay_window_accept(packet_replay_window_t *w, uint32_t msg_id,
+                                 uint32_t current_boot_count);
+
+/**
+ * Once the window reaches its reservation, extend the reservation and return
+ * true: the caller must persist w->boot_count and w->reserved.
+ */
+bool packet_replay_window_reserve(packet_replay_window_t *w);
+
+/**
+ * Derive the key schedule for PACKET_HMAC_PSK. Called once at startup;
+ * is_packet_authenticated also does it on first use.
+ */
+void packet_auth_init(void);
+
+/**
+ * Cheap check, without any hashing, against the replay window. Lets the
+ * receive path drop replays before they take a queue slot. Always OK without
+ * PACKET_HMAC_PSK.
+ */
+packet_auth_result_t packet_check_replay(const packet_t *packet,
+                                         uint32_t current_boot_count);
+
+/**
+ * Restore the replay window from a reservation persisted by an earlier boot.
+ */
+void packet_replay_restore(uint32_t boot_count, uint32_t reserved);
+
+/**
+ * If msg_ids need reserving ahead, return true with what must be written to
+ * flash before the packet just authenticated is acted on. The reservation
+ * takes effect once packet_replay_reserved is called, so until then every
+ * packet asks for it again.
+ */
+bool packet_replay_reserve(uint32_t *boot_count, uint32_t *reserved);
+
+/**
+ * Record that the reservation from packet_replay_reserve is in flash.
+ */
+void packet_replay_reserved(uint32_t boot_count, uint32_t reserved);
+
+/**
+ * Authenticate a packet: replay window, then length, then HMAC. On success
+ * its msg_id is marked as seen.
+ */
+packet_auth_result_t packet_authenticate(packet_t *packet,
+                                         uint32_t current_boot_count);
+
 /**
  * Verifies the authenticity of a packet by computing its HMAC and comparing it
  * to the provided HMAC field. Also checks for replay attacks using boot_count
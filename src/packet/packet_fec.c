@@ -0,0 +1,41 @@
+/**
+ * @file packet_fec.c
+ *
+ * Reed-Solomon forward error correction for downlink frames.
+ */
+
+#include "packet_fec.h"
+#include "rs8.h"
+
+#define RS_NN 255
+#define RS_KK (RS_NN - PACKET_FEC_PARITY_SIZE)
+
+size_t packet_fec_encode(uint8_t *buf, size_t n)
+{
+    if (n < PACKET_HEADER_SIZE || n > PACKET_FEC_MAX_FRAME)
+        return 0;
+
+    // A shortened codeword: the missing leading symbols are zero padding
+    size_t k = n - PACKET_FEC_OFFSET;
+    encode_rs_8(buf + PACKET_FEC_OFFSET, buf + n, RS_KK - k);
+    return n + PACKET_FEC_PARITY_SIZE;
+}
+
+int packet_fec_decode(uint8_t *buf, size_t n)
+{
+    if (n < PACKET_HEADER_SIZE + PACKET_FEC_PARITY_SIZE ||
+        n > PACKET_FEC_MAX_FRAME + PACKET_FEC_PARITY_SIZE)
+        return -1;
+
+    int pad = RS_NN - (n - PACKET_FEC_OFFSET);
+    int loc[PACKET_FEC_PARITY_SIZE];
+    int count = decode_rs_8(buf + PACKET_FEC_OFFSET, loc, 0, pad);
+
+    // An error "found" in the padding means too many errors to locate
+    for (int i = 0; i < count; i++)
+    {
+        if (loc[i] < pad)
+            return -1;
+    }
+    return count;
+}
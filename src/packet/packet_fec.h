@@ -0,0 +1,66 @@
+/**
+ * @file packet_fec.h
+ *
+ * Reed-Solomon forward error correction for downlink frames.
+ *
+ * A frame with PACKET_FLAG_FEC set carries PACKET_FEC_PARITY_SIZE parity bytes
+ * after its data, computed with the CCSDS RS(255,223) code SSDV also uses,
+ * shortened to the frame's length. The ground can then correct up to 16
+ * corrupted bytes anywhere in the codeword.
+ *
+ * The codeword starts at the len byte. dst, src, flags and seq double as the
+ * RadioHead header, which LoRa receivers strip before the payload reaches the
+ * application, so parity over them could not be checked there.
+ *
+ * The code is systematic and len still only counts the data, so receivers
+ * that know nothing of FEC just ignore the parity.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "packet.h"
+
+// Set in the packet flags of frames that carry parity
+#define PACKET_FLAG_FEC 0x80
+
+#define PACKET_FEC_PARITY_SIZE 32
+
+// Where in the frame the codeword starts
+#define PACKET_FEC_OFFSET (offsetof(packet_t, len))
+
+// Longest frame (before parity) one codeword can protect
+#define PACKET_FEC_MAX_FRAME (PACKET_FEC_OFFSET + 255 - PACKET_FEC_PARITY_SIZE)
+
+// Downlink frames have no footer, so the parity goes where it would be
+_Static_assert(PACKET_HEADER_SIZE + PACKET_DATA_SIZE <= PACKET_FEC_MAX_FRAME,
+               "Full packet does not fit in one FEC codeword");
+_Static_assert(PACKET_HEADER_SIZE + PACKET_DATA_SIZE + PACKET_FEC_PARITY_SIZE <=
+                   PACKET_SIZE,
+               "FEC parity does not fit in packet_t");
+
+/**
+ * Append parity to the n-byte frame in buf, header included, which must have
+ * room for PACKET_FEC_PARITY_SIZE more bytes. Returns the new frame length,
+ * or 0 if the frame is shorter than its header or longer than
+ * PACKET_FEC_MAX_FRAME.
+ */
+size_t packet_fec_encode(uint8_t *buf, size_t n);
+
+/**
+ * Correct the n-byte frame in buf (header and parity included) in place.
+ * Returns the number of bytes corrected, or -1 if the frame is beyond repair.
+ */
+int packet_fec_decode(uint8_t *buf, size_t n);
+
+/**
+ * Length of a downlink frame for p on the wire, parity included.
+ */
+static inline size_t packet_fec_frame_size(const packet_t *p)
+{
+    return PACKET_HEADER_SIZE + p->len +
+           ((p->flags & PACKET_FLAG_FEC) ? PACKET_FEC_PARITY_SIZE : 0);
+}
@@ -0,0 +1,56 @@
+/**
+ * @file packet_pool.c
+ *
+ * Fixed pool of packet_t slots shared by the radio RX/TX queues.
+ */
+
+#include "packet_pool.h"
+#include "error.h"
+#include "logger.h"
+
+void packet_pool_init(packet_pool_t *pool)
+{
+    queue_init(&pool->free_list, sizeof(packet_handle_t), PACKET_POOL_SIZE);
+    for (packet_handle_t h = 0; h < PACKET_POOL_SIZE; h++)
+    {
+        bool added = queue_try_add(&pool->free_list, &h);
+        ASSERT(added);
+    }
+}
+
+void packet_pool_deinit(packet_pool_t *pool)
+{
+    queue_free(&pool->free_list);
+}
+
+packet_handle_t packet_pool_alloc(packet_pool_t *pool)
+{
+    packet_handle_t h;
+    if (!queue_try_remove(&pool->free_list, &h))
+        return PACKET_HANDLE_NONE;
+    return h;
+}
+
+void packet_pool_free(packet_pool_t *pool, packet_handle_t h)
+{
+    ASSERT(h < PACKET_POOL_SIZE);
+
+    // The free list has room for every slot, so this only fails on a double
+    // free
+    bool added = queue_try_add(&pool->free_list, &h);
+    ASSERT(added);
+}
+
+bool packet_pool_enqueue(packet_pool_t *pool, queue_t *q, packet_handle_t h)
+{
+    if (queue_try_add(q, &h))
+        return true;
+
+    packet_pool_free(pool, h);
+    return false;
+}
+
+unsigned int packet_pool_available(packet_pool_t *pool)
+{
+    return queue_get_level(&pool->free_list);
+}
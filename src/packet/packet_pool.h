@@ -0,0 +1,73 @@
+/**
+ * @file packet_pool.h
+ *
+ * Fixed pool of packet_t slots shared by the radio RX/TX queues.
+ *
+ * Rather than copying whole 255-byte packets in and out of queue_t, the
+ * queues carry one-byte handles into this pool. Whoever holds a handle owns
+ * the slot: the radio ISR fills an RX slot and hands it to the command task
+ * through rx_queue; a task fills a TX slot and hands it to the radio through
+ * the tx_sched queues. The last owner frees the slot.
+ *
+ * The free list is itself a queue_t, so allocating and freeing are safe from
+ * interrupts and across cores.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "packet.h"
+#include "pico/util/queue.h"
+
+#define PACKET_POOL_SIZE 32
+
+typedef uint8_t packet_handle_t;
+#define PACKET_HANDLE_NONE ((packet_handle_t)0xFF)
+
+_Static_assert(PACKET_POOL_SIZE < PACKET_HANDLE_NONE,
+               "packet_handle_t cannot address the whole pool");
+
+typedef struct
+{
+    packet_t slots[PACKET_POOL_SIZE];
+    queue_t free_list;
+} packet_pool_t;
+
+/**
+ * Allocate the free list and mark every slot free.
+ */
+void packet_pool_init(packet_pool_t *pool);
+
+/**
+ * Release the free list. Slots still held become invalid.
+ */
+void packet_pool_deinit(packet_pool_t *pool);
+
+/**
+ * Take a free slot. Returns PACKET_HANDLE_NONE if the pool is exhausted.
+ * The slot's contents are whatever its last owner left there.
+ */
+packet_handle_t packet_pool_alloc(packet_pool_t *pool);
+
+/**
+ * Return a slot to the pool. The handle must not be used afterwards.
+ */
+void packet_pool_free(packet_pool_t *pool, packet_handle_t h);
+
+/**
+ * Hand a slot to whoever consumes q. If q is full the slot is freed instead,
+ * so either way the caller no longer owns it. Returns true if queued.
+ */
+bool packet_pool_enqueue(packet_pool_t *pool, queue_t *q, packet_handle_t h);
+
+/**
+ * Number of free slots.
+ */
+unsigned int packet_pool_available(packet_pool_t *pool);
+
+static inline packet_t *packet_pool_get(packet_pool_t *pool, packet_handle_t h)
+{
+    return &pool->slots[h];
+}
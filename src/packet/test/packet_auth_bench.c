@@ -0,0 +1,115 @@
+/**
+ * @file packet_auth_bench.c
+ *
+ * Host micro-benchmark of uplink packet authentication cost.
+ *
+ * Compares keying TinyCrypt's HMAC for every packet (what
+ * is_packet_authenticated used to do) against starting from the cached
+ * inner/outer SHA-256 midstates, and packet_check_replay, which rejects stale
+ * packets without hashing. Built with its own PACKET_HMAC_PSK so the replay
+ * check is live. Cycles are read from the TSC on x86 and are only
+ * meaningful relative to each other; on the RP2350 the ratio is what carries
+ * over.
+ *
+ * Usage: packet_auth_bench [iterations]
+ */
+
+#include "packet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <tinycrypt/hmac.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+static const uint8_t *psk = (const uint8_t *)PACKET_HMAC_PSK;
+#define PSK_LEN 32
+
+// Keep the compiler from discarding the results
+static volatile uint8_t sink;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void)
+{
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void per_packet_key(const packet_t *p, uint8_t out[PACKET_HMAC_SIZE])
+{
+    struct tc_hmac_state_struct hmac;
+    tc_hmac_set_key(&hmac, psk, PSK_LEN);
+    tc_hmac_init(&hmac);
+    tc_hmac_update(&hmac, p, PACKET_HEADER_SIZE);
+    tc_hmac_update(&hmac, p->data, p->len);
+    tc_hmac_update(&hmac, &p->boot_count,
+                   sizeof(p->boot_count) + sizeof(p->msg_id));
+    tc_hmac_final(out, PACKET_HMAC_SIZE, &hmac);
+}
+
+static packet_hmac_key_t key;
+
+static void cached_key(const packet_t *p, uint8_t out[PACKET_HMAC_SIZE])
+{
+    packet_compute_hmac(&key, p, out);
+}
+
+static void replay_check(const packet_t *p, uint8_t out[PACKET_HMAC_SIZE])
+{
+    out[0] = packet_check_replay(p, 474) != PACKET_AUTH_OK;
+}
+
+static void run(const char *name, void (*fn)(const packet_t *, uint8_t *),
+                const packet_t *p, int iterations)
+{
+    uint8_t out[PACKET_HMAC_SIZE];
+    uint64_t start_ns = now_ns();
+    uint64_t start_cycles = now_cycles();
+    for (int i = 0; i < iterations; i++)
+    {
+        fn(p, out);
+        sink ^= out[0];
+    }
+    uint64_t cycles = now_cycles() - start_cycles;
+    uint64_t ns = now_ns() - start_ns;
+
+    printf("%-16s %4u B %10.0f cycles %10.1f ns\n", name, p->len,
+           (double)cycles / iterations, (double)ns / iterations);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+    if (iterations <= 0)
+    {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    packet_hmac_key_init(&key, psk, PSK_LEN);
+
+    // A short command, and a full packet
+    const uint8_t lens[] = {8, PACKET_DATA_SIZE};
+    printf("%-16s %6s %24s\n", "method", "data", "per packet");
+    for (size_t i = 0; i < sizeof(lens); i++)
+    {
+        // msg_id 0 is never fresh, so packet_check_replay rejects it
+        packet_t p = {.len = lens[i], .boot_count = 474, .msg_id = 0};
+        run("per-packet key", per_packet_key, &p, iterations);
+        run("cached midstate", cached_key, &p, iterations);
+        run("replay reject", replay_check, &p, iterations);
+    }
+    return 0;
+}
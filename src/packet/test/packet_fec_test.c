@@ -0,0 +1,105 @@
+/**
+ * @file packet_fec_test.c
+ * @brief Reed-Solomon parity on downlink frames corrects up to 16 corrupted
+ * bytes after the RadioHead header and rejects frames with more
+ */
+
+#include "error.h"
+#include "logger.h"
+#include "packet_fec.h"
+#include <string.h>
+
+#define FEC_MAX_CORRECTABLE (PACKET_FEC_PARITY_SIZE / 2)
+
+static uint8_t frame[PACKET_FEC_MAX_FRAME + PACKET_FEC_PARITY_SIZE];
+static uint8_t clean[sizeof(frame)];
+
+static size_t make_frame(size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        frame[i] = (uint8_t)(i * 37 + 11);
+    size_t total = packet_fec_encode(frame, n);
+    ASSERT(total == n + PACKET_FEC_PARITY_SIZE);
+    memcpy(clean, frame, total);
+    return total;
+}
+
+/**
+ * Test 1: A clean frame decodes unchanged, at every length
+ */
+void test_clean(void)
+{
+    LOG_DEBUG("=== Test 1: Clean frames ===");
+
+    for (size_t n = PACKET_HEADER_SIZE; n <= PACKET_FEC_MAX_FRAME; n++)
+    {
+        size_t total = make_frame(n);
+        ASSERT(packet_fec_decode(frame, total) == 0);
+        ASSERT(memcmp(frame, clean, total) == 0);
+    }
+
+    // Same parity as the ground station's encoder computes
+    memcpy(frame, "\xff\x00\x80\x00\x07samwise", 12);
+    packet_fec_encode(frame, 12);
+    const uint8_t expected[4] = {0x62, 0xd1, 0xa4, 0xd9};
+    ASSERT(memcmp(frame + 12, expected, sizeof(expected)) == 0);
+
+    LOG_DEBUG("  Test 1 passed");
+}
+
+/**
+ * Test 2: Up to 16 corrupted bytes anywhere in the codeword, parity included,
+ * are corrected
+ */
+void test_correct(void)
+{
+    LOG_DEBUG("=== Test 2: Correctable errors ===");
+
+    const size_t lens[] = {PACKET_HEADER_SIZE + 8,
+                           PACKET_HEADER_SIZE + PACKET_DATA_SIZE};
+    for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++)
+    {
+        for (int errors = 1; errors <= FEC_MAX_CORRECTABLE; errors++)
+        {
+            size_t total = make_frame(lens[l]);
+            size_t codeword = total - PACKET_FEC_OFFSET;
+            for (int e = 0; e < errors; e++)
+                frame[PACKET_FEC_OFFSET + (e * 7 + l) % codeword] ^= 0x5A + e;
+
+            ASSERT(packet_fec_decode(frame, total) == errors);
+            ASSERT(memcmp(frame, clean, total) == 0);
+        }
+    }
+
+    LOG_DEBUG("  Test 2 passed");
+}
+
+/**
+ * Test 3: More errors than the parity can locate are reported, and frames
+ * too long for one codeword are refused
+ */
+void test_uncorrectable(void)
+{
+    LOG_DEBUG("=== Test 3: Uncorrectable frames ===");
+
+    size_t total = make_frame(PACKET_HEADER_SIZE + 8);
+    for (int e = 0; e < FEC_MAX_CORRECTABLE + 1; e++)
+        frame[PACKET_FEC_OFFSET + e * 2] ^= 0xFF;
+    ASSERT(packet_fec_decode(frame, total) == -1);
+
+    ASSERT(packet_fec_encode(frame, PACKET_FEC_MAX_FRAME + 1) == 0);
+
+    LOG_DEBUG("  Test 3 passed");
+}
+
+int main(void)
+{
+    LOG_DEBUG("=== Packet FEC Test ===");
+
+    test_clean();
+    test_correct();
+    test_uncorrectable();
+
+    LOG_DEBUG("=== All Packet FEC Tests Passed ===");
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file packet_pool_test.c
+ * @brief Packet pool allocation, exhaustion and handoff through a queue
+ */
+
+#include "error.h"
+#include "logger.h"
+#include "packet_pool.h"
+
+static packet_pool_t pool;
+
+/**
+ * Test 1: Every slot can be allocated exactly once, then the pool is empty
+ */
+void test_alloc_all(void)
+{
+    LOG_DEBUG("=== Test 1: Allocate every slot ===");
+
+    packet_pool_init(&pool);
+    ASSERT(packet_pool_available(&pool) == PACKET_POOL_SIZE);
+
+    bool seen[PACKET_POOL_SIZE] = {0};
+    for (int i = 0; i < PACKET_POOL_SIZE; i++)
+    {
+        packet_handle_t h = packet_pool_alloc(&pool);
+        ASSERT(h < PACKET_POOL_SIZE);
+        ASSERT(!seen[h]);
+        seen[h] = true;
+    }
+    ASSERT(packet_pool_available(&pool) == 0);
+    ASSERT(packet_pool_alloc(&pool) == PACKET_HANDLE_NONE);
+
+    for (packet_handle_t h = 0; h < PACKET_POOL_SIZE; h++)
+        packet_pool_free(&pool, h);
+    ASSERT(packet_pool_available(&pool) == PACKET_POOL_SIZE);
+
+    packet_pool_deinit(&pool);
+    LOG_DEBUG("  Test 1 passed");
+}
+
+/**
+ * Test 2: A packet passed through a queue by handle arrives intact, and a
+ * handle that does not fit in the queue goes back to the pool
+ */
+void test_enqueue(void)
+{
+    LOG_DEBUG("=== Test 2: Hand off through a queue ===");
+
+    packet_pool_init(&pool);
+    queue_t q;
+    queue_init(&q, sizeof(packet_handle_t), 1);
+
+    packet_handle_t h = packet_pool_alloc(&pool);
+    packet_t *p = packet_pool_get(&pool, h);
+    p->len = 3;
+    p->data[0] = 0xAB;
+    ASSERT(packet_pool_enqueue(&pool, &q, h));
+
+    // The queue is full: the second slot is freed, not leaked
+    packet_handle_t h2 = packet_pool_alloc(&pool);
+    ASSERT(!packet_pool_enqueue(&pool, &q, h2));
+    ASSERT(packet_pool_available(&pool) == PACKET_POOL_SIZE - 1);
+
+    packet_handle_t out;
+    ASSERT(queue_try_remove(&q, &out));
+    ASSERT(out == h);
+    p = packet_pool_get(&pool, out);
+    ASSERT(p->len == 3 && p->data[0] == 0xAB);
+    packet_pool_free(&pool, out);
+    ASSERT(packet_pool_available(&pool) == PACKET_POOL_SIZE);
+
+    queue_free(&q);
+    packet_pool_deinit(&pool);
+    LOG_DEBUG("  Test 2 passed");
+}
+
+int main(void)
+{
+    LOG_DEBUG("=== Packet Pool Test ===");
+
+    test_alloc_all();
+    test_enqueue();
+
+    LOG_DEBUG("=== All Packet Pool Tests Passed ===");
+    return 0;
+}
@@ -0,0 +1,181 @@
+/**
+ * @file tx_sched_test.c
+ * @brief Downlink scheduling by class: priority, weighted airtime sharing and
+ * the bulk pool reserve
+ */
+
+#include "error.h"
+#include "logger.h"
+#include "tx_sched.h"
+
+#define FRAME_US 100000
+
+static packet_pool_t pool;
+static tx_sched_t tx;
+
+static void setup(void)
+{
+    packet_pool_init(&pool);
+    tx_sched_init(&tx);
+}
+
+static void teardown(void)
+{
+    tx_sched_deinit(&tx);
+    packet_pool_deinit(&pool);
+}
+
+static void queue_n(tx_class_t cls, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        packet_handle_t h = tx_sched_alloc(&tx, &pool, cls);
+        ASSERT(h != PACKET_HANDLE_NONE);
+        ASSERT(tx_sched_enqueue(&tx, &pool, cls, h));
+    }
+}
+
+// Send the next frame as the radio would
+static tx_class_t send_next(void)
+{
+    packet_handle_t h;
+    tx_class_t cls;
+    ASSERT(tx_sched_peek(&tx, &h, &cls));
+    tx_sched_commit(&tx, cls, FRAME_US);
+    packet_pool_free(&pool, h);
+    return cls;
+}
+
+/**
+ * Test 1: With nothing sent yet, classes go in priority order
+ */
+void test_priority(void)
+{
+    LOG_DEBUG("=== Test 1: Priority ===");
+    setup();
+
+    packet_handle_t h;
+    tx_class_t cls;
+    ASSERT(!tx_sched_peek(&tx, &h, &cls));
+
+    queue_n(TX_CLASS_BULK, 1);
+    queue_n(TX_CLASS_BEACON, 1);
+    queue_n(TX_CLASS_COMMAND, 1);
+    ASSERT(tx_sched_level(&tx) == 3);
+
+    ASSERT(send_next() == TX_CLASS_COMMAND);
+    ASSERT(send_next() == TX_CLASS_BEACON);
+    ASSERT(send_next() == TX_CLASS_BULK);
+    ASSERT(tx_sched_is_empty(&tx));
+    ASSERT(tx.airtime_us[TX_CLASS_BULK] == FRAME_US);
+
+    teardown();
+    LOG_DEBUG("  Test 1 passed");
+}
+
+/**
+ * Test 2: Backlogged classes share the airtime by weight
+ */
+void test_weighted_share(void)
+{
+    LOG_DEBUG("=== Test 2: Weighted sharing ===");
+    setup();
+
+    const int rounds = 3;
+    const int total = rounds * (TX_SCHED_WEIGHT_BEACON + TX_SCHED_WEIGHT_BULK);
+    queue_n(TX_CLASS_BEACON, total);
+    queue_n(TX_CLASS_BULK, total);
+
+    int sent[TX_CLASS_COUNT] = {0};
+    for (int i = 0; i < total; i++)
+        sent[send_next()]++;
+    ASSERT(sent[TX_CLASS_BEACON] == rounds * TX_SCHED_WEIGHT_BEACON);
+    ASSERT(sent[TX_CLASS_BULK] == rounds * TX_SCHED_WEIGHT_BULK);
+
+    while (!tx_sched_is_empty(&tx))
+        send_next();
+    teardown();
+    LOG_DEBUG("  Test 2 passed");
+}
+
+/**
+ * Test 3: However much bulk data is queued, command responses go next, and a
+ * class that was idle gets no credit for it
+ */
+void test_no_starvation(void)
+{
+    LOG_DEBUG("=== Test 3: No starvation ===");
+    setup();
+
+    queue_n(TX_CLASS_BULK, 20);
+    for (int i = 0; i < 10; i++)
+        ASSERT(send_next() == TX_CLASS_BULK);
+
+    queue_n(TX_CLASS_COMMAND, 1);
+    ASSERT(send_next() == TX_CLASS_COMMAND);
+
+    // Nor does a command that has just been sent hold back the next
+    queue_n(TX_CLASS_COMMAND, 3);
+    for (int i = 0; i < 3; i++)
+        ASSERT(send_next() == TX_CLASS_COMMAND);
+    ASSERT(tx.sent[TX_CLASS_COMMAND] == 4);
+
+    // The beacon class was idle through ten bulk frames, but rejoins at
+    // its share rather than taking the next ten. Bulk is one frame ahead of
+    // the virtual clock, so the beacon class may get one extra.
+    const int rounds = 3;
+    const int n = rounds * (TX_SCHED_WEIGHT_BEACON + TX_SCHED_WEIGHT_BULK);
+    queue_n(TX_CLASS_BEACON, n);
+    int beacons = 0;
+    for (int i = 0; i < n; i++)
+        beacons += send_next() == TX_CLASS_BEACON;
+    ASSERT(beacons >= rounds * TX_SCHED_WEIGHT_BEACON);
+    ASSERT(beacons <= rounds * TX_SCHED_WEIGHT_BEACON + 1);
+
+    while (!tx_sched_is_empty(&tx))
+        send_next();
+    teardown();
+    LOG_DEBUG("  Test 3 passed");
+}
+
+/**
+ * Test 4: Bulk data leaves pool slots to the other classes, and every frame
+ * lost for want of a slot is counted against its class
+ */
+void test_pool_reserve(void)
+{
+    LOG_DEBUG("=== Test 4: Pool reserve ===");
+    setup();
+
+    const int bulk = PACKET_POOL_SIZE - TX_SCHED_BULK_POOL_RESERVE;
+    queue_n(TX_CLASS_BULK, bulk);
+    ASSERT(!tx_sched_has_room(&pool, TX_CLASS_BULK));
+    ASSERT(tx_sched_alloc(&tx, &pool, TX_CLASS_BULK) == PACKET_HANDLE_NONE);
+    ASSERT(tx.drops[TX_CLASS_BULK] == 1);
+
+    ASSERT(tx_sched_has_room(&pool, TX_CLASS_BEACON));
+    queue_n(TX_CLASS_BEACON, TX_SCHED_BULK_POOL_RESERVE);
+    ASSERT(tx_sched_alloc(&tx, &pool, TX_CLASS_COMMAND) ==
+           PACKET_HANDLE_NONE);
+    ASSERT(tx.drops[TX_CLASS_COMMAND] == 1);
+    ASSERT(tx.drops[TX_CLASS_BEACON] == 0);
+
+    while (!tx_sched_is_empty(&tx))
+        send_next();
+    ASSERT(packet_pool_available(&pool) == PACKET_POOL_SIZE);
+    teardown();
+    LOG_DEBUG("  Test 4 passed");
+}
+
+int main(void)
+{
+    LOG_DEBUG("=== TX Scheduler Test ===");
+
+    test_priority();
+    test_weighted_share();
+    test_no_starvation();
+    test_pool_reserve();
+
+    LOG_DEBUG("=== All TX Scheduler Tests Passed ===");
+    return 0;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file tx_sched.c
+ *
+ * Downlink scheduler: one queue of pool handles per traffic class.
+ */
+
+#include "tx_sched.h"
+#include "error.h"
+#include <string.h>
+
+static const uint8_t weights[TX_CLASS_COUNT] = {
+    [TX_CLASS_BEACON] = TX_SCHED_WEIGHT_BEACON,
+    [TX_CLASS_BULK] = TX_SCHED_WEIGHT_BULK,
+};
+
+void tx_sched_init(tx_sched_t *tx)
+{
+    memset(tx, 0, sizeof(*tx));
+
+    // Each queue can hold the whole pool, so only allocation can fail
+    for (int c = 0; c < TX_CLASS_COUNT; c++)
+        queue_init(&tx->queues[c], sizeof(packet_handle_t), PACKET_POOL_SIZE);
+}
+
+void tx_sched_deinit(tx_sched_t *tx)
+{
+    for (int c = 0; c < TX_CLASS_COUNT; c++)
+        queue_free(&tx->queues[c]);
+}
+
+bool tx_sched_has_room(packet_pool_t *pool, tx_class_t cls)
+{
+    unsigned int reserve = cls == TX_CLASS_BULK ? TX_SCHED_BULK_POOL_RESERVE
+                                                : 0;
+    return packet_pool_available(pool) > reserve;
+}
+
+packet_handle_t tx_sched_alloc(tx_sched_t *tx, packet_pool_t *pool,
+                               tx_class_t cls)
+{
+    ASSERT(cls < TX_CLASS_COUNT);
+
+    packet_handle_t h = PACKET_HANDLE_NONE;
+    if (tx_sched_has_room(pool, cls))
+        h = packet_pool_alloc(pool);
+    if (h == PACKET_HANDLE_NONE)
+        tx->drops[cls]++;
+    return h;
+}
+
+bool tx_sched_enqueue(tx_sched_t *tx, packet_pool_t *pool, tx_class_t cls,
+                      packet_handle_t h)
+{
+    ASSERT(cls < TX_CLASS_COUNT);
+
+    if (packet_pool_enqueue(pool, &tx->queues[cls], h))
+        return true;
+
+    tx->drops[cls]++;
+    return false;
+}
+
+static uint64_t start_tag(const tx_sched_t *tx, tx_class_t cls)
+{
+    return tx->finish[cls] > tx->vtime ? tx->finish[cls] : tx->vtime;
+}
+
+bool tx_sched_peek(tx_sched_t *tx, packet_handle_t *h, tx_class_t *cls)
+{
+    if (queue_try_peek(&tx->queues[TX_CLASS_COMMAND], h))
+    {
+        *cls = TX_CLASS_COMMAND;
+        return true;
+    }
+
+    tx_class_t best = TX_CLASS_COUNT;
+    for (tx_class_t c = TX_CLASS_COMMAND + 1; c < TX_CLASS_COUNT; c++)
+    {
+        packet_handle_t head;
+        if (!queue_try_peek(&tx->queues[c], &head))
+            continue;
+
+        // Strictly earlier only, so ties go to the higher priority
+        if (best == TX_CLASS_COUNT || start_tag(tx, c) < start_tag(tx, best))
+        {
+            best = c;
+            *h = head;
+        }
+    }
+
+    if (best == TX_CLASS_COUNT)
+        return false;
+    *cls = best;
+    return true;
+}
+
+void tx_sched_commit(tx_sched_t *tx, tx_class_t cls, uint32_t airtime_us)
+{
+    packet_handle_t h;
+    bool removed = queue_try_remove(&tx->queues[cls], &h);
+    ASSERT(removed);
+
+    tx->sent[cls]++;
+    tx->airtime_us[cls] += airtime_us;
+    if (cls == TX_CLASS_COMMAND)
+        return;
+
+    uint64_t start = start_tag(tx, cls);
+    tx->vtime = start;
+    tx->finish[cls] = start + airtime_us / weights[cls];
+}
+
+unsigned int tx_sched_level(tx_sched_t *tx)
+{
+    unsigned int level = 0;
+    for (int c = 0; c < TX_CLASS_COUNT; c++)
+        level += queue_get_level(&tx->queues[c]);
+    return level;
+}
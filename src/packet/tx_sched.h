@@ -0,0 +1,112 @@
+/**
+ * @file tx_sched.h
+ *
+ * Downlink scheduler: one queue of pool handles per traffic class.
+ *
+ * Producers allocate a slot for their class, fill it and enqueue it; the
+ * radio picks what to send next.
+ *
+ * Command responses go first whenever any are queued. They only ever answer
+ * the uplink, so they cannot take much airtime, and the link handshake relies
+ * on an acknowledgement leaving before whatever was queued behind it.
+ *
+ * The other classes share the remaining airtime by weight using start-time
+ * fair queueing: each class has a virtual finish time, advanced by a frame's
+ * airtime divided by the class weight, and the backlogged class whose next
+ * frame would start earliest goes first. A class that has been idle starts
+ * again at the current virtual time rather than with credit for the airtime
+ * it did not use. Ties go to the higher priority class.
+ *
+ * Bulk data also cannot take the last TX_SCHED_BULK_POOL_RESERVE pool slots,
+ * so it never leaves the other classes without room.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "packet_pool.h"
+#include "pico/util/queue.h"
+
+// In priority order
+typedef enum
+{
+    TX_CLASS_COMMAND, // Command responses and link handshake frames
+    TX_CLASS_BEACON,
+    TX_CLASS_BULK, // File downlink and other data that can wait
+    TX_CLASS_COUNT
+} tx_class_t;
+
+// Airtime shares when both are backlogged. Commands are not weighted.
+#define TX_SCHED_WEIGHT_BEACON 2
+#define TX_SCHED_WEIGHT_BULK 1
+
+// Free pool slots bulk data leaves to the other classes
+#define TX_SCHED_BULK_POOL_RESERVE 8
+
+typedef struct
+{
+    queue_t queues[TX_CLASS_COUNT]; // packet_handle_t
+
+    // Start-time fair queueing state, in weighted airtime us
+    uint64_t vtime;                  // Virtual start of the last frame sent
+    uint64_t finish[TX_CLASS_COUNT]; // Virtual finish of each class's last
+
+    uint32_t drops[TX_CLASS_COUNT]; // Frames lost for want of a pool slot
+    uint32_t sent[TX_CLASS_COUNT];
+    uint64_t airtime_us[TX_CLASS_COUNT];
+} tx_sched_t;
+
+/**
+ * Allocate the queues and clear the counters.
+ */
+void tx_sched_init(tx_sched_t *tx);
+
+/**
+ * Release the queues. Handles still queued are not freed.
+ */
+void tx_sched_deinit(tx_sched_t *tx);
+
+/**
+ * Whether tx_sched_alloc would succeed for cls right now. Bulk producers
+ * should hold back while this is false rather than lose frames.
+ */
+bool tx_sched_has_room(packet_pool_t *pool, tx_class_t cls);
+
+/**
+ * Take a pool slot for a frame of class cls. Returns PACKET_HANDLE_NONE, and
+ * counts a drop, if the pool has no slot for it.
+ */
+packet_handle_t tx_sched_alloc(tx_sched_t *tx, packet_pool_t *pool,
+                               tx_class_t cls);
+
+/**
+ * Queue a filled slot for the radio. If the queue is full the slot is freed
+ * and a drop counted, so either way the caller no longer owns it. Returns
+ * true if queued.
+ */
+bool tx_sched_enqueue(tx_sched_t *tx, packet_pool_t *pool, tx_class_t cls,
+                      packet_handle_t h);
+
+/**
+ * The frame that should go out next, without removing it. Returns false if
+ * every queue is empty.
+ */
+bool tx_sched_peek(tx_sched_t *tx, packet_handle_t *h, tx_class_t *cls);
+
+/**
+ * Remove the frame tx_sched_peek returned for cls, charging the class for
+ * its airtime. Only the radio may call this.
+ */
+void tx_sched_commit(tx_sched_t *tx, tx_class_t cls, uint32_t airtime_us);
+
+/**
+ * Frames queued across all classes.
+ */
+unsigned int tx_sched_level(tx_sched_t *tx);
+
+static inline bool tx_sched_is_empty(tx_sched_t *tx)
+{
+    return tx_sched_level(tx) == 0;
+}
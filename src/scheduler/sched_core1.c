@@ -0,0 +1,90 @@
+/**
+ * @file sched_core1.c
+ *
+ * Core1 executor for the RP2350.
+ */
+
+#include "sched_core1.h"
+#include "error.h"
+#include "hardware/sync.h"
+#include "logger.h"
+#include "pico/flash.h"
+#include "pico/multicore.h"
+#include "pico/mutex.h"
+#include "pico/stdlib.h"
+#include "pico/util/queue.h"
+#include "sched_profile.h"
+
+static slate_t *core1_slate;
+
+// Tasks waiting to run on core1. queue_t is protected by a hardware spinlock,
+// so core0 can add while core1 removes.
+static queue_t work_queue;
+
+static uint32_t core1_stack[SCHED_CORE1_STACK_BYTES / sizeof(uint32_t)];
+
+auto_init_mutex(slate_mutex);
+
+static void sched_core1_entry(void)
+{
+    // Let core0 park us in RAM while it takes XIP offline (flash/MRAM). Once
+    // this returns, sched_core1_init lets core0 carry on.
+    ASSERT(flash_safe_execute_core_init());
+
+    while (true)
+    {
+        sched_task_t *task;
+        queue_remove_blocking(&work_queue, &task);
+
+        uint64_t start_us = time_us_64();
+        task->task_dispatch(core1_slate);
+        sched_profile_record(task, time_us_64() - start_us);
+
+        // Publish the profile update before core0 can resubmit the task
+        __dmb();
+        task->in_flight = false;
+    }
+}
+
+void sched_core1_init(slate_t *slate)
+{
+    core1_slate = slate;
+    queue_init(&work_queue, sizeof(sched_task_t *), SCHED_CORE1_QUEUE_DEPTH);
+
+    // Core1 may also touch flash/MRAM, so core0 must be able to park too
+    ASSERT(flash_safe_execute_core_init());
+
+    multicore_launch_core1_with_stack(sched_core1_entry, core1_stack,
+                                      sizeof(core1_stack));
+
+    // Until core1 can be parked, xip_safe_execute only masks interrupts on
+    // core0, which is not safe once core1 runs from XIP
+    while (!multicore_lockout_victim_is_initialized(1))
+        tight_loop_contents();
+
+    LOG_DEBUG("sched: Core1 executor started");
+}
+
+bool sched_core1_submit(sched_task_t *task)
+{
+    if (task->in_flight)
+        return false;
+
+    task->in_flight = true;
+    if (!queue_try_add(&work_queue, &task))
+    {
+        task->in_flight = false;
+        return false;
+    }
+    return true;
+}
+
+void sched_slate_lock(void)
+{
+    mutex_enter_blocking(&slate_mutex);
+}
+
+void sched_slate_unlock(void)
+{
+    mutex_exit(&slate_mutex);
+}
@@ -0,0 +1,60 @@
+/**
+ * @file sched_core1.h
+ *
+ * Core1 executor. Tasks with core = SCHED_CORE_1 are still scheduled by
+ * sched_dispatch on core0, but instead of running inline they are handed to
+ * core1 through a multicore-safe queue, so a slow ADCS exchange or a long
+ * filesystem operation never delays beaconing or command handling.
+ *
+ * Tasks on different cores must not share slate fields without care:
+ *  - pico queue_t (rx_queue, TX queues, ...) is already safe across cores.
+ *  - Single byte/word fields (flags, counters) are written atomically.
+ *  - Anything larger that one core writes and the other reads (e.g. a
+ *    telemetry struct) must be copied under sched_slate_lock().
+ *
+ * Logging is safe from core1 (see log_message). The neopixel shows which task
+ * core0 is running, so core1 tasks leave it alone.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "slate.h"
+#include "state_machine.h"
+
+// Depth of the core0 -> core1 work queue. Each task can only be queued once
+// at a time, so this bounds the number of SCHED_CORE_1 tasks.
+#define SCHED_CORE1_QUEUE_DEPTH MAX_TASKS_PER_STATE
+
+// Core1 stack. The SDK default is 2 KiB, less than one log_message (1000 byte
+// buffer plus vsnprintf) with float formatting on top.
+#define SCHED_CORE1_STACK_BYTES (8 * 1024)
+
+/**
+ * Start the core1 executor. Must be called on core0 after all tasks have
+ * been initialized.
+ */
+void sched_core1_init(slate_t *slate);
+
+/**
+ * Queue a task for dispatch on core1. Returns false (and queues nothing) if
+ * the task is still queued or running from a previous submission.
+ */
+bool sched_core1_submit(sched_task_t *task);
+
+/**
+ * Take/release the lock guarding multi-word slate fields shared between
+ * cores. Hold it only for the copy itself, never across blocking I/O.
+ */
+void sched_slate_lock(void);
+void sched_slate_unlock(void);
+
+#ifdef TEST
+/**
+ * Host builds have no second core. Run every task currently queued for core1
+ * on the calling thread, as core1 would, and return how many ran.
+ */
+size_t sched_core1_run_pending(void);
+#endif
@@ -0,0 +1,71 @@
+/**
+ * @file sched_core1_mock.c
+ *
+ * Host mock of the core1 executor. There is no second core, so submitted
+ * tasks stay queued until the test calls sched_core1_run_pending(). This
+ * keeps the affinity logic (what gets offloaded, and when a resubmission is
+ * refused) observable under TEST.
+ */
+
+#include "sched_core1.h"
+#include "pico/stdlib.h"
+#include "pico/util/queue.h"
+#include "sched_profile.h"
+
+static slate_t *core1_slate;
+static queue_t work_queue;
+static bool initialized = false;
+
+void sched_core1_init(slate_t *slate)
+{
+    core1_slate = slate;
+
+    // sched_init can run more than once per test binary
+    if (initialized)
+    {
+        sched_task_t *task;
+        while (queue_try_remove(&work_queue, &task))
+            task->in_flight = false;
+        return;
+    }
+
+    queue_init(&work_queue, sizeof(sched_task_t *), SCHED_CORE1_QUEUE_DEPTH);
+    initialized = true;
+}
+
+bool sched_core1_submit(sched_task_t *task)
+{
+    if (task->in_flight)
+        return false;
+
+    task->in_flight = true;
+    if (!queue_try_add(&work_queue, &task))
+    {
+        task->in_flight = false;
+        return false;
+    }
+    return true;
+}
+
+size_t sched_core1_run_pending(void)
+{
+    size_t ran = 0;
+    sched_task_t *task;
+    while (queue_try_remove(&work_queue, &task))
+    {
+        uint64_t start_us = time_us_64();
+        task->task_dispatch(core1_slate);
+        sched_profile_record(task, time_us_64() - start_us);
+        task->in_flight = false;
+        ran++;
+    }
+    return ran;
+}
+
+void sched_slate_lock(void)
+{
+}
+
+void sched_slate_unlock(void)
+{
+}
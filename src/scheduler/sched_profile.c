@@ -0,0 +1,94 @@
+/**
+ * @file sched_profile.c
+ *
+ * Per-task execution time profiling.
+ */
+
+#include "sched_profile.h"
+#include <string.h>
+
+uint8_t sched_profile_bucket(uint64_t elapsed_us)
+{
+    if (elapsed_us == 0)
+        return 0;
+
+    // Bucket k holds [2^(k-1), 2^k), i.e. floor(log2(elapsed_us)) + 1
+    uint8_t bucket = 64 - __builtin_clzll(elapsed_us);
+    if (bucket >= SCHED_PROFILE_NUM_BUCKETS)
+        bucket = SCHED_PROFILE_NUM_BUCKETS - 1;
+    return bucket;
+}
+
+void sched_profile_record(sched_task_t *task, uint64_t elapsed_us)
+{
+    sched_task_profile_t *p = &task->profile;
+    uint32_t elapsed =
+        elapsed_us > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed_us;
+
+    if (p->num_dispatches == 0 || elapsed < p->min_us)
+        p->min_us = elapsed;
+    if (elapsed > p->max_us)
+        p->max_us = elapsed;
+
+    p->num_dispatches++;
+    p->total_us += elapsed;
+
+    uint16_t *count = &p->histogram[sched_profile_bucket(elapsed_us)];
+    if (*count < UINT16_MAX)
+        (*count)++;
+}
+
+void sched_profile_record_lateness(sched_task_t *task, uint64_t lateness_us)
+{
+    sched_task_profile_t *p = &task->profile;
+    uint32_t lateness =
+        lateness_us > UINT32_MAX ? UINT32_MAX : (uint32_t)lateness_us;
+
+    if (p->num_dispatches > 0)
+    {
+        uint32_t jitter = lateness > p->last_lateness_us
+                              ? lateness - p->last_lateness_us
+                              : p->last_lateness_us - lateness;
+        if (jitter > p->max_jitter_us)
+            p->max_jitter_us = jitter;
+    }
+
+    if (lateness > p->max_lateness_us)
+        p->max_lateness_us = lateness;
+
+    p->last_lateness_us = lateness;
+    p->total_lateness_us += lateness;
+}
+
+void sched_profile_reset(sched_task_t *task)
+{
+    memset(&task->profile, 0, sizeof(task->profile));
+}
+
+void sched_profile_serialize(const sched_task_t *task, uint8_t task_index,
+                             uint8_t num_tasks, sched_profile_packet_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->task_index = task_index;
+    out->num_tasks = num_tasks;
+
+    if (task == NULL)
+        return;
+
+    const sched_task_profile_t *p = &task->profile;
+    strncpy(out->name, task->name, SCHED_PROFILE_NAME_LEN);
+    out->num_dispatches = p->num_dispatches;
+    out->min_us = p->min_us;
+    out->max_us = p->max_us;
+    out->mean_us =
+        p->num_dispatches ? (uint32_t)(p->total_us / p->num_dispatches) : 0;
+    out->mean_lateness_us =
+        p->num_dispatches ? (uint32_t)(p->total_lateness_us / p->num_dispatches)
+                          : 0;
+    out->max_lateness_us = p->max_lateness_us;
+    out->max_jitter_us = p->max_jitter_us;
+    out->num_skipped = p->num_skipped;
+    out->num_overruns = p->num_overruns;
+    out->num_over_budget = p->num_over_budget;
+    memcpy(out->histogram, p->histogram, sizeof(out->histogram));
+}
@@ -0,0 +1,71 @@
+/**
+ * @file sched_profile.h
+ *
+ * Per-task execution time profiling. sched_dispatch brackets every
+ * task_dispatch call with time_us_64() and feeds the elapsed time in here, so
+ * we can see which task eats the loop budget (I2C timeouts, UART retries...).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "state_machine.h"
+
+// Length of the (null-padded, possibly unterminated) task name in the packet
+#define SCHED_PROFILE_NAME_LEN 16
+
+/**
+ * Compact binary downlink format for a single task's profile. All fields are
+ * little endian. Must match TaskProfilePacket in ground_station/protocol.py.
+ */
+typedef struct
+{
+    uint8_t task_index; // Index into state_registry_get_task_by_index
+    uint8_t num_tasks;  // Total number of tasks that can be queried
+    char name[SCHED_PROFILE_NAME_LEN];
+    uint32_t num_dispatches;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t mean_us;
+    uint32_t mean_lateness_us;
+    uint32_t max_lateness_us;
+    uint32_t max_jitter_us;
+    uint32_t num_skipped;
+    uint32_t num_overruns;
+    uint32_t num_over_budget;
+    uint16_t histogram[SCHED_PROFILE_NUM_BUCKETS];
+} __attribute__((__packed__)) sched_profile_packet_t;
+
+/**
+ * Get the histogram bucket for an execution time.
+ */
+uint8_t sched_profile_bucket(uint64_t elapsed_us);
+
+/**
+ * Record one dispatch of a task which took elapsed_us.
+ */
+void sched_profile_record(sched_task_t *task, uint64_t elapsed_us);
+
+/**
+ * Record how late a task started relative to its deadline. Call this before
+ * sched_profile_record for the same dispatch.
+ */
+void sched_profile_record_lateness(sched_task_t *task, uint64_t lateness_us);
+
+/**
+ * Clear all statistics for a task.
+ */
+void sched_profile_reset(sched_task_t *task);
+
+/**
+ * Fill in the downlink packet for a task.
+ *
+ * @param task          Task to report, or NULL to only report num_tasks
+ * @param task_index    Index of the task, echoed back to the ground
+ * @param num_tasks     Number of tasks that can be queried
+ * @param out           Packet to fill in
+ */
+void sched_profile_serialize(const sched_task_t *task, uint8_t task_index,
+                             uint8_t num_tasks, sched_profile_packet_t *out);
@@ -0,0 +1,38 @@
+/**
+ * @file sched_tables.c
+ *
+ * Static state and task tables for the state registry.
+ *
+ * The task table is expanded from SCHED_TASKS in task_ids.h. States list
+ * their tasks with SCHED_TASK_LIST, which only compiles for tasks in
+ * SCHED_TASKS, so a task cannot be left out of the table.
+ */
+
+#include "state_registry.h"
+
+#include "burn_wire_reset_state.h"
+#include "burn_wire_state.h"
+#include "init_state.h"
+#include "running_state.h"
+#include "safe_state.h"
+#ifdef BRINGUP
+#include "bringup_state.h"
+#endif
+
+sched_state_t *const sched_state_table[STATE_COUNT] = {
+    [STATE_INIT] = &init_state,
+    [STATE_RUNNING] = &running_state,
+    [STATE_BURN_WIRE] = &burn_wire_state,
+    [STATE_BURN_WIRE_RESET] = &burn_wire_reset_state,
+    [STATE_SAFE] = &safe_state,
+#ifdef BRINGUP
+    [STATE_BRINGUP] = &bringup_state,
+#endif
+};
+
+#define SCHED_TASK_TABLE_ENTRY(task) &task,
+
+sched_task_t *const sched_task_table[] = {SCHED_TASKS(SCHED_TASK_TABLE_ENTRY)};
+
+const size_t sched_task_table_len =
+    sizeof(sched_task_table) / sizeof(sched_task_table[0]);
@@ -0,0 +1,38 @@
+/**
+ * @file sched_wakeup.c
+ *
+ * Event-driven task wakeups.
+ */
+
+#include "sched_wakeup.h"
+#include "hardware/sync.h"
+
+// Written from IRQ context, read and cleared from the main loop. Single byte
+// accesses are atomic, so no locking is needed.
+static volatile bool pending[SCHED_WAKEUP_COUNT];
+
+void sched_wakeup_signal(sched_wakeup_t source)
+{
+    if (source <= SCHED_WAKEUP_NONE || source >= SCHED_WAKEUP_COUNT)
+        return;
+
+    pending[source] = true;
+    __sev();
+}
+
+bool sched_wakeup_is_pending(sched_wakeup_t source)
+{
+    if (source <= SCHED_WAKEUP_NONE || source >= SCHED_WAKEUP_COUNT)
+        return false;
+
+    return pending[source];
+}
+
+bool sched_wakeup_consume(sched_wakeup_t source)
+{
+    if (!sched_wakeup_is_pending(source))
+        return false;
+
+    pending[source] = false;
+    return true;
+}
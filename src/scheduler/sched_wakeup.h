@@ -0,0 +1,40 @@
+/**
+ * @file sched_wakeup.h
+ *
+ * Event-driven task wakeups. An ISR signals a wakeup source, and any task
+ * bound to that source (sched_task_t.wakeup) becomes eligible for dispatch on
+ * the next sched_dispatch instead of waiting out its period.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * Sources of asynchronous events. GPIO edge handlers and queue producers all
+ * signal through here. Each source should be bound to at most one task, since
+ * dispatching a task consumes its pending wakeup.
+ */
+typedef enum
+{
+    SCHED_WAKEUP_NONE = 0,
+    SCHED_WAKEUP_RADIO_RX,    // Packet queued on rx_queue (radio DIO0)
+    SCHED_WAKEUP_FTP_COMMAND, // Command queued on ftp_command_data
+    SCHED_WAKEUP_COUNT,
+} sched_wakeup_t;
+
+/**
+ * Mark a wakeup source as pending. Safe to call from IRQ context. Also issues
+ * a SEV so a core about to idle in WFE notices the event.
+ */
+void sched_wakeup_signal(sched_wakeup_t source);
+
+/**
+ * Return whether a wakeup source is pending, without clearing it.
+ */
+bool sched_wakeup_is_pending(sched_wakeup_t source);
+
+/**
+ * Return whether a wakeup source is pending, and clear it.
+ */
+bool sched_wakeup_consume(sched_wakeup_t source);
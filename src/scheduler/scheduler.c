@@ -9,59 +9,382 @@
 #include "scheduler.h"
 #include "error.h"
 #include "logger.h"
+#include "sched_core1.h"
+#include "sched_profile.h"
+#include "sched_wakeup.h"
 #include "state_registry.h"
 
-#include "burn_wire_reset_state.h"
-#include "burn_wire_state.h"
-#include "init_state.h"
-#include "running_state.h"
-#ifdef BRINGUP
-#include "bringup_state.h"
-#endif
+/**
+ * Find the earliest next_dispatch among a state's tasks. Returns false if the
+ * state has no tasks to wait on.
+ */
+static bool sched_get_earliest_dispatch(sched_state_t *state,
+                                        absolute_time_t *earliest)
+{
+    if (state->num_tasks == 0)
+        return false;
 
-static size_t n_tasks = 0;
-static sched_task_t *all_tasks[STATE_COUNT * MAX_TASKS_PER_STATE];
+    *earliest = state->task_list[0]->next_dispatch;
+    for (size_t i = 1; i < state->num_tasks; i++)
+    {
+        absolute_time_t t = state->task_list[i]->next_dispatch;
+        if (absolute_time_diff_us(t, *earliest) > 0)
+            *earliest = t;
+    }
+    return true;
+}
 
 /**
- * Initialize the state machine.
+ * Return whether any of a state's tasks has a pending wakeup.
  */
-void sched_init(slate_t *slate)
+static bool sched_has_pending_wakeup(sched_state_t *state)
+{
+    for (size_t i = 0; i < state->num_tasks; i++)
+    {
+        if (sched_wakeup_is_pending(state->task_list[i]->wakeup))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Sleep until the next task in the current state is due, and account for the
+ * time spent idle.
+ *
+ * best_effort_wfe_or_timeout wakes early on any interrupt (e.g. the radio DIO0
+ * or the payload UART RX), so an early return is harmless: the next call to
+ * sched_dispatch dispatches any task woken by the event, or goes straight back
+ * to sleep. sched_wakeup_signal also issues a SEV, so an event that lands
+ * between the pending check and the WFE is not lost.
+ */
+static void sched_idle(slate_t *slate, sched_state_t *state)
+{
+    absolute_time_t idle_start = get_absolute_time();
+    absolute_time_t wake_time = idle_start;
+
+    // With a wakeup pending, wake_time stays at idle_start and we don't sleep
+    if (!sched_has_pending_wakeup(state) &&
+        sched_get_earliest_dispatch(state, &wake_time))
+    {
+        // Tasks are due strictly after next_dispatch (see sched_dispatch)
+        wake_time = delayed_by_us(wake_time, 1);
+    }
+
+    if (absolute_time_diff_us(idle_start, wake_time) > 0)
+    {
+        best_effort_wfe_or_timeout(wake_time);
+    }
+
+    absolute_time_t idle_end = get_absolute_time();
+    slate->sched_idle_us += absolute_time_diff_us(idle_start, idle_end);
+
+    uint64_t window_us =
+        absolute_time_diff_us(slate->sched_idle_window_start, idle_end);
+    if (window_us >= SCHED_IDLE_WINDOW_MS * 1000ULL)
+    {
+        slate->sched_idle_percent =
+            (uint8_t)((slate->sched_idle_us * 100) / window_us);
+        slate->sched_idle_us = 0;
+        slate->sched_idle_window_start = idle_end;
+    }
+}
+
+/**
+ * Advance a task's next_dispatch after it has become due at time now,
+ * according to its period_mode.
+ */
+static void sched_advance_deadline(sched_task_t *task, absolute_time_t now)
+{
+    switch (task->period_mode)
+    {
+        case SCHED_PERIOD_FIXED_RATE_CATCH_UP:
+            task->next_dispatch =
+                delayed_by_ms(task->next_dispatch, task->period_ms);
+            break;
+
+        case SCHED_PERIOD_FIXED_RATE_SKIP:
+        {
+            task->next_dispatch =
+                delayed_by_ms(task->next_dispatch, task->period_ms);
+
+            // Drop any whole periods we have already missed
+            if (absolute_time_diff_us(task->next_dispatch, now) > 0)
+            {
+                uint64_t behind_us =
+                    absolute_time_diff_us(task->next_dispatch, now);
+                uint64_t period_us = task->period_ms * 1000ULL;
+                uint64_t missed = behind_us / period_us + 1;
+                task->next_dispatch =
+                    delayed_by_us(task->next_dispatch, missed * period_us);
+                task->profile.num_skipped += missed;
+            }
+            break;
+        }
+
+        case SCHED_PERIOD_DELAY:
+        default:
+            task->next_dispatch = make_timeout_time_ms(task->period_ms);
+            break;
+    }
+}
+
+/**
+ * Return a task's relative deadline in milliseconds (0 if it has none).
+ */
+static uint32_t sched_relative_deadline_ms(const sched_task_t *task)
+{
+    return task->deadline_ms != 0 ? task->deadline_ms : task->period_ms;
+}
+
+/**
+ * Return whether ready task a (absolute deadline a_deadline) should run
+ * before ready task b under SCHED_POLICY. Full ties return false, so tasks
+ * keep their task_list order.
+ */
+static bool sched_runs_before(const sched_task_t *a,
+                              absolute_time_t a_deadline,
+                              const sched_task_t *b,
+                              absolute_time_t b_deadline)
 {
-    // Register all states
-    state_registry_register(STATE_INIT, &init_state);
-    state_registry_register(STATE_RUNNING, &running_state);
-    state_registry_register(STATE_BURN_WIRE, &burn_wire_state);
-    state_registry_register(STATE_BURN_WIRE_RESET, &burn_wire_reset_state);
-#ifdef BRINGUP
-    state_registry_register(STATE_BRINGUP, &bringup_state);
+    bool a_earlier = absolute_time_diff_us(a_deadline, b_deadline) > 0;
+
+#if SCHED_POLICY == SCHED_POLICY_EDF
+    if (a_earlier || absolute_time_diff_us(b_deadline, a_deadline) > 0)
+        return a_earlier;
+    return a->priority > b->priority;
+#else
+    if (a->priority != b->priority)
+        return a->priority > b->priority;
+    return a_earlier;
 #endif
+}
 
-    size_t num_states = state_registry_count();
+/**
+ * Check a core0 task's execution time against its budget once it has
+ * returned. Over budget, the task skips budget_skip_periods periods. After
+ * SCHED_BUDGET_MAX_STRIKES dispatches over budget in a row it is suspended
+ * for SCHED_BUDGET_SUSPEND_MS and the FSM is sent to the safe state, so a
+ * driver stuck in timeouts degrades us in a controlled way instead of
+ * starving the watchdog task until the hardware watchdog bites.
+ */
+static void sched_enforce_budget(slate_t *slate, sched_task_t *task,
+                                 uint64_t elapsed_us)
+{
+    if (task->budget_ms == 0)
+        return;
+
+    if (elapsed_us <= task->budget_ms * 1000ULL)
+    {
+        task->budget_strikes = 0;
+        return;
+    }
+
+    task->profile.num_over_budget++;
+    if (task->budget_strikes < UINT8_MAX)
+        task->budget_strikes++;
+    LOG_ERROR("sched: Task %s ran %u us, over its %u ms budget (%u/%u)",
+              task->name, (uint32_t)elapsed_us, task->budget_ms,
+              task->budget_strikes, SCHED_BUDGET_MAX_STRIKES);
+
+    if (task->budget_strikes >= SCHED_BUDGET_MAX_STRIKES)
+    {
+        LOG_ERROR("sched: Suspending %s for %u ms", task->name,
+                  SCHED_BUDGET_SUSPEND_MS);
+        task->next_dispatch = make_timeout_time_ms(SCHED_BUDGET_SUSPEND_MS);
+        if (task->period_ms > 0)
+            task->profile.num_skipped +=
+                SCHED_BUDGET_SUSPEND_MS / task->period_ms;
+        slate->sched_budget_faults++;
+
+        if (slate->current_state_id != STATE_SAFE)
+        {
+            // An override already pending (e.g. from a command run earlier
+            // in this dispatch) is kept for when the safe state ends
+            if (slate->manual_override_state_id != STATE_SAFE)
+                slate->sched_fault_saved_override_state_id =
+                    slate->manual_override_state_id;
+            slate->sched_fault_resume_state_id = slate->current_state_id;
+            slate->manual_override_state_id = STATE_SAFE;
+        }
+        return;
+    }
+
+    // Skipping whole periods keeps the task's phase
+    if (task->budget_skip_periods > 0)
+    {
+        task->next_dispatch = delayed_by_ms(
+            task->next_dispatch,
+            task->budget_skip_periods * task->period_ms);
+        task->profile.num_skipped += task->budget_skip_periods;
+    }
+}
+
+/**
+ * Dispatch a single ready task, consuming its wakeup and advancing its
+ * deadline if it was due. Core0 tasks count an overrun if they finish after
+ * their absolute deadline, and are held to their execution budget.
+ */
+static void sched_run_task(slate_t *slate, sched_task_t *task, bool is_due,
+                           absolute_time_t deadline, absolute_time_t now)
+{
+    sched_wakeup_consume(task->wakeup);
+
+    // A task suspended for its budget ignores wakeups until it is due again
+    if (!is_due && task->budget_strikes >= SCHED_BUDGET_MAX_STRIKES)
+        return;
 
     /*
-     * Check that each state has a valid number of tasks, and enumerate all
-     * tasks.
+     * A core1 task still running from an earlier dispatch drops this period
+     * rather than queueing behind itself, which also means it overran. Its
+     * execution stats belong to core1 until in_flight clears, so leave them
+     * alone.
      */
-    for (size_t i = 0; i < num_states; i++)
+    if (task->core == SCHED_CORE_1 && task->in_flight)
     {
-        sched_state_t *state = state_registry_get_by_index(i);
-        ASSERT(state->num_tasks <= MAX_TASKS_PER_STATE);
-        for (size_t j = 0; j < state->num_tasks; j++)
+        if (is_due)
         {
-            bool is_duplicate = 0;
-            for (size_t k = 0; k < n_tasks; k++)
-            {
-                if (all_tasks[k] == state->task_list[j])
-                    is_duplicate = 1;
-            }
-            if (!is_duplicate)
-            {
-                all_tasks[n_tasks] = state->task_list[j];
-                n_tasks++;
-            }
+            sched_advance_deadline(task, now);
+            task->profile.num_skipped++;
+            task->profile.num_overruns++;
         }
+        return;
+    }
+
+    if (is_due)
+    {
+        sched_profile_record_lateness(
+            task, absolute_time_diff_us(task->next_dispatch, now));
+        sched_advance_deadline(task, now);
+    }
+
+    if (task->core == SCHED_CORE_1)
+    {
+        // Execution time is profiled by the executor on core1
+        sched_core1_submit(task);
+        return;
+    }
+
+    uint64_t start_us = time_us_64();
+    task->task_dispatch(slate);
+    uint64_t elapsed_us = time_us_64() - start_us;
+    sched_profile_record(task, elapsed_us);
+
+    if (sched_relative_deadline_ms(task) != 0 &&
+        absolute_time_diff_us(deadline, get_absolute_time()) > 0)
+        task->profile.num_overruns++;
+
+    // Reported (and reset) by watchdog_task
+    if (elapsed_us > slate->sched_slowest_us)
+    {
+        slate->sched_slowest_us = (uint32_t)elapsed_us;
+        slate->sched_slowest_task = task->name;
+    }
+
+    sched_enforce_budget(slate, task, elapsed_us);
+}
+
+/**
+ * Return the period a task runs at in a state: the closest override walking
+ * up from the state through its parents, or the task's own period.
+ */
+static uint32_t sched_state_period_ms(const sched_state_t *state,
+                                      const sched_task_t *task)
+{
+    for (; state != NULL; state = state->parent)
+    {
+        for (size_t i = 0; i < MAX_TASKS_PER_STATE; i++)
+        {
+            const sched_period_override_t *o = &state->period_overrides[i];
+            if (o->task == NULL)
+                break;
+            if (o->task == task)
+                return o->period_ms;
+        }
+    }
+    return task->dispatch_period_ms;
+}
+
+/**
+ * Apply a state's task periods on entry. A task whose period got shorter is
+ * pulled in so it does not sit out the rest of its old, longer period, unless
+ * its budget suspension is still pending: that must run its full length.
+ */
+static void sched_apply_periods(const sched_state_t *state)
+{
+    for (size_t i = 0; i < state->num_tasks; i++)
+    {
+        sched_task_t *task = state->task_list[i];
+        uint32_t period_ms = sched_state_period_ms(state, task);
+        if (period_ms == task->period_ms)
+            continue;
+
+        task->period_ms = period_ms;
+        if (task->budget_strikes >= SCHED_BUDGET_MAX_STRIKES)
+            continue;
+
+        absolute_time_t latest = make_timeout_time_ms(period_ms);
+        if (absolute_time_diff_us(latest, task->next_dispatch) > 0)
+            task->next_dispatch = latest;
+    }
+}
+
+/**
+ * Return whether ancestor is state or one of its parents.
+ */
+static bool sched_state_contains(const sched_state_t *ancestor,
+                                 const sched_state_t *state)
+{
+    for (; state != NULL; state = state->parent)
+    {
+        if (state == ancestor)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Run on_enter hooks from just below stop down to state, outermost first.
+ */
+static void sched_enter_states(slate_t *slate, const sched_state_t *state,
+                               const sched_state_t *stop)
+{
+    if (state == NULL || state == stop)
+        return;
+    sched_enter_states(slate, state->parent, stop);
+    if (state->on_enter != NULL)
+        state->on_enter(slate);
+}
+
+/**
+ * Make next the current state: exit from up to the closest common ancestor,
+ * then enter down to next and apply its task periods.
+ */
+static void sched_transition(slate_t *slate, const sched_state_t *from,
+                             const sched_state_t *next)
+{
+    const sched_state_t *common = from;
+    while (common != NULL && !sched_state_contains(common, next))
+    {
+        if (common->on_exit != NULL)
+            common->on_exit(slate);
+        common = common->parent;
     }
 
+    slate->current_state_id = next->id;
+    slate->entered_current_state_time = get_absolute_time();
+    slate->time_in_current_state_ms = 0;
+
+    sched_enter_states(slate, next, common);
+    sched_apply_periods(next);
+}
+
+/**
+ * Initialize the state machine.
+ */
+void sched_init(slate_t *slate)
+{
+    // States and tasks come from the static tables in sched_tables.c
+    size_t n_tasks = state_registry_task_count();
     LOG_DEBUG("sched: Enumerated %d tasks", n_tasks);
 
     /*
@@ -69,30 +392,45 @@ void sched_init(slate_t *slate)
      */
     for (size_t i = 0; i < n_tasks; i++)
     {
-        LOG_DEBUG("sched: Initializing task %s", all_tasks[i]->name);
-        all_tasks[i]->task_init(slate);
+        sched_task_t *task = state_registry_get_task_by_index(i);
+        LOG_DEBUG("sched: Initializing task %s", task->name);
+        task->task_init(slate);
     }
 
     for (size_t i = 0; i < n_tasks; i++)
     {
-        all_tasks[i]->next_dispatch =
-            make_timeout_time_ms(all_tasks[i]->dispatch_period_ms);
+        sched_task_t *task = state_registry_get_task_by_index(i);
+        task->period_ms = task->dispatch_period_ms;
+        task->next_dispatch = make_timeout_time_ms(task->period_ms);
+        task->budget_strikes = 0;
+        sched_profile_reset(task);
     }
 
+    sched_core1_init(slate);
+
     /*
      * Enter the init state by default
      */
-    slate->current_state_id = STATE_INIT;
     slate->manual_override_state_id = STATE_NONE;
-    slate->entered_current_state_time = get_absolute_time();
-    slate->time_in_current_state_ms = 0;
+    sched_transition(slate, NULL, state_registry_get(STATE_INIT));
+
+    slate->sched_idle_window_start = get_absolute_time();
+    slate->sched_idle_us = 0;
+    slate->sched_idle_percent = 0;
+
+    slate->sched_budget_faults = 0;
+    slate->sched_fault_resume_state_id = STATE_NONE;
+    slate->sched_fault_saved_override_state_id = STATE_NONE;
+    slate->sched_slowest_task = NULL;
+    slate->sched_slowest_us = 0;
 
     LOG_DEBUG("sched: Done initializing!");
 }
 
 /**
  * Dispatch the state machine. Runs any of the current state's tasks which are
- * due, and transitions into the next state.
+ * due (highest priority or earliest deadline first, see SCHED_POLICY),
+ * transitions into the next state, and then idles until the next task is due.
  */
 void sched_dispatch(slate_t *slate)
 {
@@ -100,22 +438,49 @@ void sched_dispatch(slate_t *slate)
         state_registry_get(slate->current_state_id);
 
     /*
-     * Loop through all of this state's tasks
+     * Run every task of this state that is due or has been woken, in the
+     * order given by SCHED_POLICY. Readiness is re-evaluated after each
+     * dispatch, so a task woken while another ran can still go next. Each
+     * task runs at most once per sched_dispatch.
      */
-    for (size_t i = 0; i < current_state_info->num_tasks; i++)
+    bool dispatched[MAX_TASKS_PER_STATE] = {false};
+    while (true)
     {
-        sched_task_t *task = current_state_info->task_list[i];
+        absolute_time_t now = get_absolute_time();
+        sched_task_t *next = NULL;
+        size_t next_index = 0;
+        bool next_is_due = false;
+        absolute_time_t next_deadline = now;
 
-        /*
-         * Check if this task is due and if so, dispatch it
-         */
-        if (absolute_time_diff_us(task->next_dispatch, get_absolute_time()) > 0)
+        for (size_t i = 0; i < current_state_info->num_tasks; i++)
         {
-            task->next_dispatch =
-                make_timeout_time_ms(task->dispatch_period_ms);
+            sched_task_t *task = current_state_info->task_list[i];
+            bool is_due = absolute_time_diff_us(task->next_dispatch, now) > 0;
+            if (dispatched[i] ||
+                (!is_due && !sched_wakeup_is_pending(task->wakeup)))
+                continue;
+
+            // A wakeup releases the task now; otherwise it was released at
+            // next_dispatch
+            absolute_time_t release = is_due ? task->next_dispatch : now;
+            absolute_time_t deadline =
+                delayed_by_ms(release, sched_relative_deadline_ms(task));
 
-            task->task_dispatch(slate);
+            if (next == NULL ||
+                sched_runs_before(task, deadline, next, next_deadline))
+            {
+                next = task;
+                next_index = i;
+                next_is_due = is_due;
+                next_deadline = deadline;
+            }
         }
+
+        if (next == NULL)
+            break;
+
+        dispatched[next_index] = true;
+        sched_run_task(slate, next, next_is_due, next_deadline, now);
     }
 
     slate->time_in_current_state_ms =
@@ -134,6 +499,10 @@ void sched_dispatch(slate_t *slate)
         LOG_INFO("sched: Manual state override to %s", override->name);
         next_state_id = slate->manual_override_state_id;
         slate->manual_override_state_id = STATE_NONE;
+
+        // A newer override out of the safe state supersedes the saved one
+        if (slate->current_state_id == STATE_SAFE)
+            slate->sched_fault_saved_override_state_id = STATE_NONE;
     }
     else
     {
@@ -144,9 +513,11 @@ void sched_dispatch(slate_t *slate)
     {
         sched_state_t *next = state_registry_get(next_state_id);
         LOG_DEBUG("sched: Transitioning to state %s", next->name);
-
-        slate->current_state_id = next_state_id;
-        slate->entered_current_state_time = get_absolute_time();
-        slate->time_in_current_state_ms = 0;
+        sched_transition(slate, current_state_info, next);
     }
+
+    /*
+     * Sleep until the earliest task of the (possibly new) state is due.
+     */
+    sched_idle(slate, state_registry_get(slate->current_state_id));
 }
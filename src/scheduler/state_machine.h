@@ -1,13 +1,143 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "sched_wakeup.h"
 #include "state_ids.h"
+#include "task_ids.h"
 #include "typedefs.h"
 
 #define MAX_TASKS_PER_STATE 10
 
+/**
+ * Number of tasks in a task list initializer, as an integer constant
+ * expression.
+ */
+#define SCHED_TASK_COUNT(...)                                                  \
+    (sizeof((sched_task_t *[]){__VA_ARGS__}) / sizeof(sched_task_t *))
+
+/**
+ * Pointer to a task, which must be listed in SCHED_TASKS (task_ids.h).
+ */
+#define SCHED_TASK_REF(task) (&(task) + 0 * SCHED_TASK_ID_##task)
+
+// SCHED_TASK_REF applied to each of up to MAX_TASKS_PER_STATE tasks
+#define SCHED_TASK_REFS_1(a) SCHED_TASK_REF(a)
+#define SCHED_TASK_REFS_2(a, ...)                                              \
+    SCHED_TASK_REF(a), SCHED_TASK_REFS_1(__VA_ARGS__)
+#define SCHED_TASK_REFS_3(a, ...)                                              \
+    SCHED_TASK_REF(a), SCHED_TASK_REFS_2(__VA_ARGS__)
+#define SCHED_TASK_REFS_4(a, ...)                                              \
+    SCHED_TASK_REF(a), SCHED_TASK_REFS_3(__VA_ARGS__)
+#define SCHED_TASK_REFS_5(a, ...)                                              \
+    SCHED_TASK_REF(a), SCHED_TASK_REFS_4(__VA_ARGS__)
+#define SCHED_TASK_REFS_6(a, ...)                                              \
+    SCHED_TASK_REF(a), SCHED_TASK_REFS_5(__VA_ARGS__)
+#define SCHED_TASK_REFS_7(a, ...)                                              \
+    SCHED_TASK_REF(a), SCHED_TASK_REFS_6(__VA_ARGS__)
+#define SCHED_TASK_REFS_8(a, ...)                                              \
+    SCHED_TASK_REF(a), SCHED_TASK_REFS_7(__VA_ARGS__)
+#define SCHED_TASK_REFS_9(a, ...)                                              \
+    SCHED_TASK_REF(a), SCHED_TASK_REFS_8(__VA_ARGS__)
+#define SCHED_TASK_REFS_10(a, ...)                                             \
+    SCHED_TASK_REF(a), SCHED_TASK_REFS_9(__VA_ARGS__)
+#define SCHED_TASK_REFS_N(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, N, ...) N
+#define SCHED_TASK_REFS(...)                                                   \
+    SCHED_TASK_REFS_N(__VA_ARGS__, SCHED_TASK_REFS_10, SCHED_TASK_REFS_9,      \
+                      SCHED_TASK_REFS_8, SCHED_TASK_REFS_7, SCHED_TASK_REFS_6, \
+                      SCHED_TASK_REFS_5, SCHED_TASK_REFS_4, SCHED_TASK_REFS_3, \
+                      SCHED_TASK_REFS_2, SCHED_TASK_REFS_1)(__VA_ARGS__)
+
+/**
+ * Initialize a sched_state_t's num_tasks and task_list together, e.g.
+ *     SCHED_TASK_LIST(print_task, radio_task),
+ * The count cannot drift from the list. A list longer than
+ * MAX_TASKS_PER_STATE, or naming a task missing from SCHED_TASKS (and so
+ * from sched_task_table), fails to compile.
+ */
+#define SCHED_TASK_LIST(...)                                                   \
+    SCHED_TASK_LIST_OF_REFS(SCHED_TASK_REFS(__VA_ARGS__))
+#define SCHED_TASK_LIST_OF_REFS(...)                                           \
+    .num_tasks = SCHED_TASK_COUNT(__VA_ARGS__) +                               \
+                 0 * sizeof(struct {                                           \
+                     _Static_assert(SCHED_TASK_COUNT(__VA_ARGS__) <=           \
+                                        MAX_TASKS_PER_STATE,                   \
+                                    "Too many tasks for MAX_TASKS_PER_STATE"); \
+                     char unused;                                              \
+                 }),                                                           \
+    .task_list = {__VA_ARGS__}
+
+/**
+ * Number of log2 buckets in each task's execution time histogram. Bucket 0
+ * counts dispatches under 1us, bucket k counts [2^(k-1), 2^k) us, and the last
+ * bucket also absorbs anything longer (>= ~4.2s).
+ */
+#define SCHED_PROFILE_NUM_BUCKETS 24
+
+/**
+ * Execution time statistics for a single task, maintained by sched_dispatch.
+ */
+typedef struct sched_task_profile
+{
+    uint32_t num_dispatches;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint16_t histogram[SCHED_PROFILE_NUM_BUCKETS]; // Saturates at UINT16_MAX
+
+    // Lateness is how long after next_dispatch the task actually started
+    uint32_t last_lateness_us;
+    uint32_t max_lateness_us;
+    uint64_t total_lateness_us;
+    uint32_t max_jitter_us; // Largest change in lateness between dispatches
+    uint32_t num_skipped;   // Periods dropped by SCHED_PERIOD_FIXED_RATE_SKIP,
+                            // or while a core1 task was still running
+    uint32_t num_overruns;  // Dispatches that finished past their deadline
+                            // (core1: still running at the next release)
+    uint32_t num_over_budget; // Dispatches that ran longer than budget_ms
+} sched_task_profile_t;
+
+/**
+ * How a task's next deadline is computed each time it dispatches.
+ */
+typedef enum
+{
+    // next = now + period. Every late dispatch pushes the phase back.
+    SCHED_PERIOD_DELAY = 0,
+    // next = previous deadline + period. Missed periods are dispatched back
+    // to back until the task has caught up.
+    SCHED_PERIOD_FIXED_RATE_CATCH_UP,
+    // next = previous deadline + period. Missed periods are dropped (and
+    // counted), keeping the original phase.
+    SCHED_PERIOD_FIXED_RATE_SKIP,
+} sched_period_mode_t;
+
+/**
+ * Task priority, used to order tasks that are ready at the same time (see
+ * SCHED_POLICY in config.h). Higher runs first.
+ */
+typedef enum
+{
+    SCHED_PRIORITY_LOW = -1,   // Housekeeping: logging, diagnostics, LEDs
+    SCHED_PRIORITY_NORMAL = 0, // Default
+    SCHED_PRIORITY_HIGH,       // Command handling
+    SCHED_PRIORITY_CRITICAL,   // Radio and watchdog
+} sched_priority_t;
+
+/**
+ * Which core a task's dispatch function runs on.
+ */
+typedef enum
+{
+    // Dispatched inline by sched_dispatch on core0
+    SCHED_CORE_0 = 0,
+    // Handed to the core1 executor (see sched_core1.h), so long-running work
+    // does not hold up the rest of the state's tasks
+    SCHED_CORE_1,
+} sched_core_t;
+
 /**
  * Holds the info for a single task. A single task can belong to multiple
  * states.
@@ -20,10 +150,67 @@ typedef struct sched_task
     const char *name;
 
     /**
-     * Minimum number of milliseconds between dispatches of this task.
+     * Minimum number of milliseconds between dispatches of this task, unless
+     * the current state overrides it (see sched_state_t.period_overrides).
      */
     const uint32_t dispatch_period_ms;
 
+    /**
+     * Period in effect in the current state. Set by the scheduler on state
+     * entry.
+     */
+    uint32_t period_ms;
+
+    /**
+     * Relative deadline: the task should finish within this many milliseconds
+     * of becoming due (or of being woken). 0 means period_ms. A task
+     * with neither has no deadline and never overruns.
+     */
+    const uint32_t deadline_ms;
+
+    /**
+     * Execution budget: a core0 dispatch taking longer than this is logged
+     * and counted, and the task skips budget_skip_periods periods. After
+     * SCHED_BUDGET_MAX_STRIKES dispatches over budget in a row the task is
+     * suspended and the FSM drops into the safe state (see config.h). 0 means
+     * no budget.
+     */
+    const uint32_t budget_ms;
+    const uint16_t budget_skip_periods;
+
+    /**
+     * Consecutive dispatches over budget. The task is suspended while this is
+     * at least SCHED_BUDGET_MAX_STRIKES.
+     */
+    uint8_t budget_strikes;
+
+    /**
+     * Defaults to SCHED_PRIORITY_NORMAL.
+     */
+    sched_priority_t priority;
+
+    /**
+     * How next_dispatch advances. Defaults to SCHED_PERIOD_DELAY.
+     */
+    sched_period_mode_t period_mode;
+
+    /**
+     * Optional event which makes this task eligible for dispatch immediately,
+     * without waiting for its period. Defaults to SCHED_WAKEUP_NONE.
+     */
+    sched_wakeup_t wakeup;
+
+    /**
+     * Core the task dispatches on. Defaults to SCHED_CORE_0. task_init
+     * always runs on core0.
+     */
+    sched_core_t core;
+
+    /**
+     * Set while a SCHED_CORE_1 task is queued or running on core1.
+     */
+    volatile bool in_flight;
+
     /**
      * Earliest time this task can be dispatched.
      */
@@ -41,8 +228,23 @@ typedef struct sched_task
      */
     void (*task_dispatch)(slate_t *slate);
 
+    /**
+     * Execution time statistics, see sched_profile.h.
+     */
+    sched_task_profile_t profile;
+
 } sched_task_t;
 
+/**
+ * Runs a task at a different period while a state is active, e.g.
+ *     .period_overrides = {{&beacon_task, 30000}},
+ */
+typedef struct
+{
+    const sched_task_t *task;
+    uint32_t period_ms;
+} sched_period_override_t;
+
 /**
  * Holds the info for defining a state.
  */
@@ -55,9 +257,30 @@ typedef struct sched_state
 
     state_id_t id;
 
+    /**
+     * Optional enclosing state. Moving between two states runs on_exit up
+     * to, and on_enter down from, their closest common ancestor, and period
+     * overrides not set here are inherited from the parent. Moving between a
+     * state and its own parent only runs the child's hooks.
+     */
+    const struct sched_state *parent;
+
     size_t num_tasks;
     sched_task_t *task_list[MAX_TASKS_PER_STATE];
 
+    /**
+     * Per-state task periods, terminated by the first entry with a NULL task.
+     */
+    sched_period_override_t period_overrides[MAX_TASKS_PER_STATE];
+
+    /**
+     * Optional hooks, called by sched_dispatch on the transition into and out
+     * of this state (and by sched_init for the initial state).
+     * @param slate     Pointer to the current satellite slate
+     */
+    void (*on_enter)(slate_t *slate);
+    void (*on_exit)(slate_t *slate);
+
     /**
      * Called each time the state dispatches.
      * @param slate     Pointer to the current satellite slate
@@ -1,34 +1,44 @@
 #include "state_registry.h"
 #include <stddef.h>
 
-static sched_state_t *registry[STATE_COUNT] = {NULL};
-static sched_state_t *ordered_states[STATE_COUNT] = {NULL};
-static size_t num_registered = 0;
+sched_state_t *state_registry_get(state_id_t id)
+{
+    if (id < 0 || id >= STATE_COUNT)
+        return NULL;
+    return sched_state_table[id];
+}
 
-void state_registry_register(state_id_t id, sched_state_t *state)
+size_t state_registry_count(void)
 {
-    if (id >= 0 && id < STATE_COUNT && registry[id] == NULL)
+    size_t count = 0;
+    for (size_t id = 0; id < STATE_COUNT; id++)
     {
-        registry[id] = state;
-        ordered_states[num_registered++] = state;
+        if (sched_state_table[id] != NULL)
+            count++;
     }
+    return count;
 }
 
-sched_state_t *state_registry_get(state_id_t id)
+sched_state_t *state_registry_get_by_index(size_t i)
 {
-    if (id < 0 || id >= STATE_COUNT)
-        return NULL;
-    return registry[id];
+    for (size_t id = 0; id < STATE_COUNT; id++)
+    {
+        if (sched_state_table[id] == NULL)
+            continue;
+        if (i-- == 0)
+            return sched_state_table[id];
+    }
+    return NULL;
 }
 
-size_t state_registry_count(void)
+size_t state_registry_task_count(void)
 {
-    return num_registered;
+    return sched_task_table_len;
 }
 
-sched_state_t *state_registry_get_by_index(size_t i)
+sched_task_t *state_registry_get_task_by_index(size_t i)
 {
-    if (i < num_registered)
-        return ordered_states[i];
+    if (i < sched_task_table_len)
+        return sched_task_table[i];
     return NULL;
 }
@@ -2,8 +2,10 @@
  * @file state_registry.h
  * @brief Central registry mapping state IDs to singleton state structs.
  *
- * The registry provides O(1) lookup from state_id_t to sched_state_t *.
- * States are registered during scheduler initialization.
+ * The registry provides O(1) lookup from state_id_t to sched_state_t *, and
+ * the list of unique tasks across all states, since a single task can belong
+ * to several states. Both are static tables built at compile time in
+ * sched_tables.c, so there is nothing to register at boot.
  */
 
 #pragma once
@@ -12,9 +14,19 @@
 #include "state_machine.h"
 
 /**
- * Register a state in the registry. Called during scheduler initialization.
+ * States in this build, indexed by state_id_t. NULL for states compiled out
+ * of the current build profile (e.g. STATE_BRINGUP outside BRINGUP builds).
+ * Defined in sched_tables.c; host tests that don't link the real states
+ * define their own.
  */
-void state_registry_register(state_id_t id, sched_state_t *state);
+extern sched_state_t *const sched_state_table[STATE_COUNT];
+
+/**
+ * Every task referenced by a state in sched_state_table, each listed once.
+ * The index of a task in this table is its task index for TASK_PROFILE.
+ */
+extern sched_task_t *const sched_task_table[];
+extern const size_t sched_task_table_len;
 
 /**
  * Look up a state struct by its ID.
@@ -31,3 +43,13 @@ size_t state_registry_count(void);
  * Get state at index i (for iterating over all registered states).
  */
 sched_state_t *state_registry_get_by_index(size_t i);
+
+/**
+ * Get the number of unique tasks across all registered states.
+ */
+size_t state_registry_task_count(void);
+
+/**
+ * Get unique task at index i (for iterating over all registered tasks).
+ */
+sched_task_t *state_registry_get_task_by_index(size_t i);
@@ -0,0 +1,57 @@
+/**
+ * @file task_ids.h
+ * @brief The tasks of the current build profile, and an ID for each.
+ *
+ * SCHED_TASKS is the one list of tasks the firmware runs. sched_tables.c
+ * expands it into sched_task_table, and SCHED_TASK_LIST only accepts tasks
+ * with an ID here, so a state task missing from the table fails to compile
+ * (with "SCHED_TASK_ID_<task> undeclared") instead of never being
+ * initialized. Listing a task twice fails too, as a duplicate enumerator.
+ *
+ * Like state_ids.h, this header has no dependencies: it only names tasks.
+ */
+
+#pragma once
+
+// Ordered by first appearance, walking the states in state ID order
+#ifdef BRINGUP
+#define SCHED_TASKS(X)                                                         \
+    X(print_task)                                                              \
+    X(watchdog_task)                                                           \
+    X(diagnostics_task)                                                        \
+    X(hardware_test_task)                                                      \
+    X(burn_wire_task)
+#elif defined(PICOHAT)
+#define SCHED_TASKS(X)                                                         \
+    X(print_task)                                                              \
+    X(blink_task)                                                              \
+    X(beacon_task)                                                             \
+    X(radio_task)                                                              \
+    X(command_task)                                                            \
+    X(watchdog_task)                                                           \
+    X(burn_wire_task)
+#elif defined(PICO)
+#define SCHED_TASKS(X)                                                         \
+    X(print_task)                                                              \
+    X(blink_task)                                                              \
+    X(hardware_test_task)                                                      \
+    X(burn_wire_task)
+#else
+#define SCHED_TASKS(X)                                                         \
+    X(print_task)                                                              \
+    X(watchdog_task)                                                           \
+    X(beacon_task)                                                             \
+    X(telemetry_task)                                                          \
+    X(adcs_task)                                                               \
+    X(radio_task)                                                              \
+    X(command_task)                                                            \
+    X(ftp_task)                                                                \
+    X(burn_wire_task)
+#endif
+
+#define SCHED_TASK_ID_ENUM(task) SCHED_TASK_ID_##task,
+
+typedef enum
+{
+    SCHED_TASKS(SCHED_TASK_ID_ENUM) SCHED_NUM_TASKS // Must be last
+} sched_task_id_t;
@@ -48,62 +48,23 @@ extern bool mock_panel_B_deployed;
 // HELPERS
 // =============================================================================
 
-/**
- * Register all states relevant to the current build profile.
- * Mirrors the registration in scheduler.c sched_init().
- */
-static void register_all_states(void)
-{
-    state_registry_register(STATE_INIT, &init_state);
-    state_registry_register(STATE_RUNNING, &running_state);
-    state_registry_register(STATE_BURN_WIRE, &burn_wire_state);
-    state_registry_register(STATE_BURN_WIRE_RESET, &burn_wire_reset_state);
-#ifdef BRINGUP
-    state_registry_register(STATE_BRINGUP, &bringup_state);
-#endif
-}
-
 /**
  * Initialize all unique tasks across all registered states.
+ * Mirrors sched_init().
  */
 static void init_all_tasks(slate_t *slate)
 {
-    // Track which tasks we've already initialized (by pointer)
-    sched_task_t *initialized[STATE_COUNT * MAX_TASKS_PER_STATE];
-    size_t n_initialized = 0;
-
-    size_t num_states = state_registry_count();
-    for (size_t i = 0; i < num_states; i++)
+    size_t num_tasks = state_registry_task_count();
+    for (size_t i = 0; i < num_tasks; i++)
     {
-        sched_state_t *state = state_registry_get_by_index(i);
-        for (size_t j = 0; j < state->num_tasks; j++)
-        {
-            sched_task_t *task = state->task_list[j];
-
-            // Check if already initialized
-            bool already = false;
-            for (size_t k = 0; k < n_initialized; k++)
-            {
-                if (initialized[k] == task)
-                {
-                    already = true;
-                    break;
-                }
-            }
-
-            if (!already)
-            {
-                task->task_init(slate);
-                task->next_dispatch =
-                    make_timeout_time_ms(task->dispatch_period_ms);
-                log_viz_event("task_init", task->name, "initialized");
-                initialized[n_initialized++] = task;
-            }
-        }
+        sched_task_t *task = state_registry_get_task_by_index(i);
+        task->task_init(slate);
+        task->next_dispatch = make_timeout_time_ms(task->dispatch_period_ms);
+        log_viz_event("task_init", task->name, "initialized");
     }
 
-    LOG_DEBUG("Initialized %zu unique tasks across %zu states", n_initialized,
-              num_states);
+    LOG_DEBUG("Initialized %zu unique tasks across %zu states", num_tasks,
+              state_registry_count());
 }
 
 static const char *get_profile_name(void)
@@ -159,6 +120,45 @@ void test_state_registration(void)
     LOG_DEBUG("  Test 1 passed");
 }
 
+/**
+ * Test 1b: The static task table lists every state's tasks exactly once, and
+ * the state table is indexed by state ID
+ */
+void test_task_table(void)
+{
+    LOG_DEBUG("=== Test 1b: Task table ===");
+
+    size_t num_tasks = state_registry_task_count();
+    for (size_t i = 0; i < num_tasks; i++)
+    {
+        for (size_t j = i + 1; j < num_tasks; j++)
+            ASSERT(state_registry_get_task_by_index(i) !=
+                   state_registry_get_task_by_index(j));
+    }
+
+    size_t num_states = state_registry_count();
+    for (size_t i = 0; i < num_states; i++)
+    {
+        sched_state_t *state = state_registry_get_by_index(i);
+        ASSERT(state_registry_get(state->id) == state);
+
+        for (size_t j = 0; j < state->num_tasks; j++)
+        {
+            bool found = false;
+            for (size_t k = 0; k < num_tasks; k++)
+                found |= state_registry_get_task_by_index(k) ==
+                         state->task_list[j];
+            if (!found)
+                LOG_ERROR("  Task %s of state %s missing from SCHED_TASKS",
+                          state->task_list[j]->name, state->name);
+            ASSERT(found);
+        }
+    }
+
+    LOG_DEBUG("  %zu unique tasks across %zu states", num_tasks, num_states);
+    LOG_DEBUG("  Test 1b passed");
+}
+
 /**
  * Test 2: Run full FSM simulation from init until stable
  */
@@ -391,11 +391,11 @@ int main(void)
     test_slate.time_in_current_state_ms = 0;
 
     // Register all states and initialize tasks
-    register_all_states();
     init_all_tasks(&test_slate);
 
     // Run tests
     test_state_registration();
+    test_task_table();
     test_fsm_transitions();
     test_stable_state_execution();
 #ifdef FLIGHT
@@ -0,0 +1,228 @@
+/**
+ * @file test_sched_budget.c
+ * @brief Execution budget test - exercises the real sched_dispatch and
+ * watchdog task on the real running and safe states
+ *
+ * The telemetry task's dispatch is wrapped so the test can make it take as
+ * long as it likes in mock time.
+ */
+
+#include "error.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include "scheduler.h"
+#include "telemetry_task.h"
+#include "watchdog_task.h"
+
+slate_t test_slate;
+
+static void (*real_telemetry_dispatch)(slate_t *slate);
+static uint32_t telemetry_cost_ms;
+
+static void slow_telemetry_dispatch(slate_t *slate)
+{
+    real_telemetry_dispatch(slate);
+    sleep_ms(telemetry_cost_ms);
+}
+
+/**
+ * Make telemetry due and dispatch once, with the given execution time.
+ * Returns the time it was released at.
+ */
+static absolute_time_t dispatch_telemetry(uint32_t cost_ms)
+{
+    absolute_time_t release = mock_time_us;
+    telemetry_task.next_dispatch = release;
+    mock_time_us++;
+    telemetry_cost_ms = cost_ms;
+    sched_dispatch(&test_slate);
+    telemetry_cost_ms = 0;
+    return release;
+}
+
+/**
+ * Test 1: A dispatch within budget counts nothing
+ */
+void test_within_budget(void)
+{
+    LOG_DEBUG("=== Test 1: Within budget ===");
+
+    ASSERT(telemetry_task.budget_ms > 0);
+    uint32_t over = telemetry_task.profile.num_over_budget;
+
+    dispatch_telemetry(telemetry_task.budget_ms / 2);
+
+    ASSERT(telemetry_task.profile.num_over_budget == over);
+    ASSERT(telemetry_task.budget_strikes == 0);
+
+    LOG_DEBUG("  Test 1 passed");
+}
+
+/**
+ * Test 2: Going over budget is counted and skips budget_skip_periods periods
+ */
+void test_over_budget_skips(void)
+{
+    LOG_DEBUG("=== Test 2: Over budget skips periods ===");
+
+    uint32_t over = telemetry_task.profile.num_over_budget;
+    uint32_t skipped = telemetry_task.profile.num_skipped;
+
+    absolute_time_t release = dispatch_telemetry(telemetry_task.budget_ms + 1);
+
+    ASSERT(telemetry_task.profile.num_over_budget == over + 1);
+    ASSERT(telemetry_task.budget_strikes == 1);
+    ASSERT(telemetry_task.profile.num_skipped ==
+           skipped + telemetry_task.budget_skip_periods);
+    ASSERT(telemetry_task.next_dispatch ==
+           release + (1 + telemetry_task.budget_skip_periods) *
+                         telemetry_task.dispatch_period_ms * 1000ULL);
+    ASSERT(test_slate.current_state_id == STATE_RUNNING);
+
+    // Back within budget clears the strike
+    dispatch_telemetry(0);
+    ASSERT(telemetry_task.budget_strikes == 0);
+
+    LOG_DEBUG("  Test 2 passed");
+}
+
+/**
+ * Test 3: A repeat offender is suspended and the FSM enters the safe state,
+ * then returns to running once the dwell time is over
+ */
+void test_repeat_offender(void)
+{
+    LOG_DEBUG("=== Test 3: Repeat offender ===");
+
+    uint32_t faults = test_slate.sched_budget_faults;
+
+    for (int i = 0; i < SCHED_BUDGET_MAX_STRIKES; i++)
+        dispatch_telemetry(telemetry_task.budget_ms + 1);
+
+    ASSERT(test_slate.sched_budget_faults == faults + 1);
+    ASSERT(test_slate.current_state_id == STATE_SAFE);
+    ASSERT(test_slate.sched_fault_resume_state_id == STATE_RUNNING);
+    ASSERT(telemetry_task.next_dispatch >=
+           mock_time_us + (SCHED_BUDGET_SUSPEND_MS -
+                           SCHED_SAFE_STATE_DWELL_MS) * 1000ULL);
+
+    absolute_time_t entered = test_slate.entered_current_state_time;
+    while (test_slate.current_state_id == STATE_SAFE)
+        sched_dispatch(&test_slate);
+
+    ASSERT(test_slate.current_state_id == STATE_RUNNING);
+    ASSERT(mock_time_us - entered >= SCHED_SAFE_STATE_DWELL_MS * 1000ULL);
+
+    // Still suspended: the dwell is shorter than the suspension
+    ASSERT(telemetry_task.next_dispatch > mock_time_us);
+
+    LOG_DEBUG("  Test 3 passed");
+}
+
+/**
+ * Test 4: The watchdog task reports a long gap between feeds
+ */
+void test_watchdog_stall(void)
+{
+    LOG_DEBUG("=== Test 4: Watchdog stall ===");
+
+    telemetry_task.budget_strikes = 0;
+    uint32_t stalls = test_slate.watchdog_stalls;
+
+    dispatch_telemetry(WATCHDOG_STALL_MS + 100);
+
+    // Whichever watchdog dispatch comes next sees the gap
+    watchdog_task.next_dispatch = mock_time_us;
+    mock_time_us++;
+    sched_dispatch(&test_slate);
+
+    ASSERT(test_slate.watchdog_stalls == stalls + 1);
+    ASSERT(test_slate.sched_slowest_task == NULL);
+
+    LOG_DEBUG("  Test 4 passed");
+}
+
+/**
+ * Test 5: Time spent in a state without the watchdog task is not a stall
+ */
+void test_watchdog_state_entry(void)
+{
+    LOG_DEBUG("=== Test 5: Watchdog after a state without it ===");
+
+    uint32_t stalls = test_slate.watchdog_stalls;
+
+    // burn_wire_reset runs no tasks, and goes back to running
+    test_slate.manual_override_state_id = STATE_BURN_WIRE_RESET;
+    sched_dispatch(&test_slate);
+    ASSERT(test_slate.current_state_id == STATE_BURN_WIRE_RESET);
+    mock_time_us += (WATCHDOG_STALL_MS + 100) * 1000ULL;
+    sched_dispatch(&test_slate);
+    ASSERT(test_slate.current_state_id == STATE_RUNNING);
+
+    watchdog_task.next_dispatch = mock_time_us;
+    mock_time_us++;
+    sched_dispatch(&test_slate);
+
+    ASSERT(test_slate.watchdog_stalls == stalls);
+
+    LOG_DEBUG("  Test 5 passed");
+}
+
+/**
+ * Test 6: An override pending when a fault forces the safe state is applied
+ * once the safe state ends
+ */
+void test_override_kept_over_fault(void)
+{
+    LOG_DEBUG("=== Test 6: Override kept over a fault ===");
+
+    telemetry_task.budget_strikes = SCHED_BUDGET_MAX_STRIKES - 1;
+    test_slate.manual_override_state_id = STATE_BURN_WIRE_RESET;
+    dispatch_telemetry(telemetry_task.budget_ms + 1);
+
+    ASSERT(test_slate.current_state_id == STATE_SAFE);
+    ASSERT(test_slate.sched_fault_saved_override_state_id ==
+           STATE_BURN_WIRE_RESET);
+
+    while (test_slate.current_state_id == STATE_SAFE)
+        sched_dispatch(&test_slate);
+
+    ASSERT(test_slate.current_state_id == STATE_RUNNING);
+    ASSERT(test_slate.manual_override_state_id == STATE_BURN_WIRE_RESET);
+    ASSERT(test_slate.sched_fault_saved_override_state_id == STATE_NONE);
+
+    sched_dispatch(&test_slate);
+    ASSERT(test_slate.current_state_id == STATE_BURN_WIRE_RESET);
+    sched_dispatch(&test_slate);
+    ASSERT(test_slate.current_state_id == STATE_RUNNING);
+
+    LOG_DEBUG("  Test 6 passed");
+}
+
+int main(void)
+{
+    LOG_DEBUG("=== Scheduler Budget Test ===");
+
+    mock_time_us = 0;
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    sched_init(&test_slate);
+
+    test_slate.manual_override_state_id = STATE_RUNNING;
+    sched_dispatch(&test_slate);
+    ASSERT(test_slate.current_state_id == STATE_RUNNING);
+
+    real_telemetry_dispatch = telemetry_task.task_dispatch;
+    telemetry_task.task_dispatch = slow_telemetry_dispatch;
+
+    test_within_budget();
+    test_over_budget_skips();
+    test_repeat_offender();
+    test_watchdog_stall();
+    test_watchdog_state_entry();
+    test_override_kept_over_fault();
+
+    free_slate(&test_slate);
+
+    LOG_DEBUG("=== All Scheduler Budget Tests Passed ===");
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file test_sched_core1.c
+ * @brief Core1 affinity test - exercises the real sched_dispatch against the
+ * host mock of the core1 executor
+ *
+ * The ADCS task is pinned to core1, so sched_dispatch must only queue it, and
+ * it runs when the test drains the queue (standing in for core1). Core0 tasks
+ * must keep dispatching while it is in flight.
+ */
+
+#include "adcs_task.h"
+#include "error.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include "sched_core1.h"
+#include "scheduler.h"
+#include "telemetry_task.h"
+
+slate_t test_slate;
+
+/**
+ * Make a task due on the next sched_dispatch.
+ */
+static void make_due(sched_task_t *task)
+{
+    task->next_dispatch = mock_time_us;
+    mock_time_us++;
+}
+
+/**
+ * Test 1: A core1 task is queued instead of running inline
+ */
+void test_core1_task_is_offloaded(void)
+{
+    LOG_DEBUG("=== Test 1: Core1 task is offloaded ===");
+
+    ASSERT(adcs_task.core == SCHED_CORE_1);
+    uint32_t dispatches = adcs_task.profile.num_dispatches;
+
+    make_due(&adcs_task);
+    sched_dispatch(&test_slate);
+
+    ASSERT(adcs_task.in_flight);
+    ASSERT(adcs_task.profile.num_dispatches == dispatches);
+
+    ASSERT(sched_core1_run_pending() == 1);
+    ASSERT(!adcs_task.in_flight);
+    ASSERT(adcs_task.profile.num_dispatches == dispatches + 1);
+
+    LOG_DEBUG("  Test 1 passed");
+}
+
+/**
+ * Test 2: Periods that come due while the task is still in flight are
+ * dropped, not queued behind it
+ */
+void test_in_flight_drops_periods(void)
+{
+    LOG_DEBUG("=== Test 2: In-flight task drops periods ===");
+
+    make_due(&adcs_task);
+    sched_dispatch(&test_slate);
+    ASSERT(adcs_task.in_flight);
+
+    uint32_t skipped = adcs_task.profile.num_skipped;
+    make_due(&adcs_task);
+    absolute_time_t deadline = adcs_task.next_dispatch;
+    sched_dispatch(&test_slate);
+
+    ASSERT(adcs_task.profile.num_skipped == skipped + 1);
+    ASSERT(adcs_task.next_dispatch > deadline);
+    ASSERT(sched_core1_submit(&adcs_task) == false);
+    ASSERT(sched_core1_run_pending() == 1);
+
+    LOG_DEBUG("  Test 2 passed");
+}
+
+/**
+ * Test 3: Core0 tasks keep running while a core1 task is in flight
+ */
+void test_core0_not_blocked(void)
+{
+    LOG_DEBUG("=== Test 3: Core0 tasks not blocked ===");
+
+    ASSERT(telemetry_task.core == SCHED_CORE_0);
+
+    make_due(&adcs_task);
+    sched_dispatch(&test_slate);
+    ASSERT(adcs_task.in_flight);
+
+    uint32_t dispatches = telemetry_task.profile.num_dispatches;
+    for (int i = 0; i < 3; i++)
+    {
+        make_due(&telemetry_task);
+        sched_dispatch(&test_slate);
+    }
+
+    ASSERT(telemetry_task.profile.num_dispatches == dispatches + 3);
+    ASSERT(adcs_task.in_flight);
+    ASSERT(sched_core1_run_pending() == 1);
+
+    LOG_DEBUG("  Test 3 passed");
+}
+
+int main(void)
+{
+    LOG_DEBUG("=== Scheduler Core1 Test ===");
+
+    mock_time_us = 0;
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    sched_init(&test_slate);
+
+    // The ADCS task only runs in the running state
+    test_slate.manual_override_state_id = STATE_RUNNING;
+    sched_dispatch(&test_slate);
+    ASSERT(test_slate.current_state_id == STATE_RUNNING);
+    sched_core1_run_pending();
+
+    test_core1_task_is_offloaded();
+    test_in_flight_drops_periods();
+    test_core0_not_blocked();
+
+    free_slate(&test_slate);
+
+    LOG_DEBUG("=== All Scheduler Core1 Tests Passed ===");
+    return 0;
+}
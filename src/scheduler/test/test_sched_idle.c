@@ -0,0 +1,123 @@
+/**
+ * @file test_sched_idle.c
+ * @brief Tickless idle test - exercises the real sched_init/sched_dispatch
+ *
+ * Under TEST, best_effort_wfe_or_timeout jumps mock time straight to the
+ * timeout, so every sched_dispatch call should leave the clock at (or past,
+ * if a task itself slept) the point where the next task of the current state
+ * becomes due. A pending wakeup must cut that sleep short.
+ */
+
+#include "command_task.h"
+#include "error.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include "sched_wakeup.h"
+#include "scheduler.h"
+
+slate_t test_slate;
+
+/**
+ * Earliest next_dispatch among the current state's tasks.
+ */
+static absolute_time_t earliest_dispatch(slate_t *slate)
+{
+    sched_state_t *state = state_registry_get(slate->current_state_id);
+    ASSERT(state->num_tasks > 0);
+
+    absolute_time_t earliest = state->task_list[0]->next_dispatch;
+    for (size_t i = 1; i < state->num_tasks; i++)
+    {
+        if (state->task_list[i]->next_dispatch < earliest)
+            earliest = state->task_list[i]->next_dispatch;
+    }
+    return earliest;
+}
+
+/**
+ * Test 1: Each dispatch sleeps until the next task is due
+ */
+void test_idle_until_next_task(void)
+{
+    LOG_DEBUG("=== Test 1: Idle until next task ===");
+
+    for (int i = 0; i < 100; i++)
+    {
+        sched_dispatch(&test_slate);
+        ASSERT(mock_time_us > earliest_dispatch(&test_slate));
+    }
+
+    LOG_DEBUG("  Test 1 passed");
+}
+
+/**
+ * Test 2: Idle percentage is published once a window has elapsed
+ */
+void test_idle_percent(void)
+{
+    LOG_DEBUG("=== Test 2: Idle percentage ===");
+
+    absolute_time_t start = get_absolute_time();
+    while (absolute_time_diff_us(start, get_absolute_time()) <
+           2 * SCHED_IDLE_WINDOW_MS * 1000ULL)
+    {
+        sched_dispatch(&test_slate);
+    }
+
+    LOG_DEBUG("  Idle: %u%%", test_slate.sched_idle_percent);
+    ASSERT(test_slate.sched_idle_percent > 0);
+    ASSERT(test_slate.sched_idle_percent <= 100);
+
+    LOG_DEBUG("  Test 2 passed");
+}
+
+/**
+ * Test 3: A wakeup dispatches its task immediately, without waiting for its
+ * period or touching its deadline
+ */
+void test_wakeup_dispatches_early(void)
+{
+    LOG_DEBUG("=== Test 3: Wakeup dispatches early ===");
+
+    ASSERT(command_task.wakeup == SCHED_WAKEUP_RADIO_RX);
+
+    // Push the command task's deadline well out of reach, since other tasks
+    // (e.g. ADCS) advance mock time while they dispatch
+    absolute_time_t saved_deadline = command_task.next_dispatch;
+    absolute_time_t deadline = make_timeout_time_ms(60 * 1000);
+    command_task.next_dispatch = deadline;
+    uint32_t dispatches = command_task.profile.num_dispatches;
+
+    sched_wakeup_signal(SCHED_WAKEUP_RADIO_RX);
+    sched_dispatch(&test_slate);
+
+    ASSERT(command_task.profile.num_dispatches == dispatches + 1);
+    ASSERT(command_task.next_dispatch == deadline);
+    ASSERT(!sched_wakeup_is_pending(SCHED_WAKEUP_RADIO_RX));
+
+    // Without a wakeup the task stays asleep
+    sched_dispatch(&test_slate);
+    ASSERT(command_task.profile.num_dispatches == dispatches + 1);
+
+    command_task.next_dispatch = saved_deadline;
+
+    LOG_DEBUG("  Test 3 passed");
+}
+
+int main(void)
+{
+    LOG_DEBUG("=== Scheduler Idle Test ===");
+
+    mock_time_us = 0;
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    sched_init(&test_slate);
+
+    test_idle_until_next_task();
+    test_idle_percent();
+    test_wakeup_dispatches_early();
+
+    free_slate(&test_slate);
+
+    LOG_DEBUG("=== All Scheduler Idle Tests Passed ===");
+    return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file test_sched_period.c
+ * @brief Fixed-rate scheduling test - exercises the real sched_dispatch
+ *
+ * The telemetry task runs with SCHED_PERIOD_FIXED_RATE_SKIP, so its deadlines
+ * must stay on the grid set up by sched_init no matter how late the loop gets.
+ */
+
+#include "error.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include "scheduler.h"
+#include "telemetry_task.h"
+
+slate_t test_slate;
+
+// First deadline of the telemetry task, set by sched_init
+static absolute_time_t telemetry_phase;
+
+static bool on_grid(sched_task_t *task, absolute_time_t phase)
+{
+    uint64_t period_us = task->dispatch_period_ms * 1000ULL;
+    return (task->next_dispatch - phase) % period_us == 0;
+}
+
+/**
+ * Test 1: Fixed-rate deadlines stay on the grid during normal operation
+ */
+void test_fixed_rate_no_drift(void)
+{
+    LOG_DEBUG("=== Test 1: Fixed rate does not drift ===");
+
+    absolute_time_t start = get_absolute_time();
+    while (absolute_time_diff_us(start, get_absolute_time()) < 60 * 1000000ULL)
+    {
+        sched_dispatch(&test_slate);
+        ASSERT(on_grid(&telemetry_task, telemetry_phase));
+    }
+
+    ASSERT(telemetry_task.profile.num_dispatches >= 59);
+    ASSERT(telemetry_task.profile.num_skipped == 0);
+
+    LOG_DEBUG("  Test 1 passed");
+}
+
+/**
+ * Test 2: After a stall, the skip policy drops the missed periods
+ */
+void test_fixed_rate_skip(void)
+{
+    LOG_DEBUG("=== Test 2: Skip missed periods ===");
+
+    uint32_t dispatches = telemetry_task.profile.num_dispatches;
+
+    // Stall the loop for 3.5 periods past the next deadline
+    mock_time_us = telemetry_task.next_dispatch + 3500 * 1000ULL;
+    sched_dispatch(&test_slate);
+
+    ASSERT(telemetry_task.profile.num_dispatches == dispatches + 1);
+    ASSERT(telemetry_task.profile.num_skipped == 3);
+    ASSERT(telemetry_task.profile.max_lateness_us >= 3500 * 1000U);
+    ASSERT(on_grid(&telemetry_task, telemetry_phase));
+
+    LOG_DEBUG("  Test 2 passed");
+}
+
+/**
+ * Test 3: After a stall, the catch-up policy runs the missed periods back to
+ * back
+ */
+void test_fixed_rate_catch_up(void)
+{
+    LOG_DEBUG("=== Test 3: Catch up missed periods ===");
+
+    telemetry_task.period_mode = SCHED_PERIOD_FIXED_RATE_CATCH_UP;
+    uint32_t dispatches = telemetry_task.profile.num_dispatches;
+    uint32_t skipped = telemetry_task.profile.num_skipped;
+
+    // Stall the loop for 3.5 periods past the next deadline
+    mock_time_us = telemetry_task.next_dispatch + 3500 * 1000ULL;
+    absolute_time_t stalled_until = mock_time_us;
+    while (telemetry_task.next_dispatch < stalled_until)
+    {
+        sched_dispatch(&test_slate);
+    }
+
+    ASSERT(telemetry_task.profile.num_dispatches == dispatches + 4);
+    ASSERT(telemetry_task.profile.num_skipped == skipped);
+    ASSERT(on_grid(&telemetry_task, telemetry_phase));
+
+    telemetry_task.period_mode = SCHED_PERIOD_FIXED_RATE_SKIP;
+    LOG_DEBUG("  Test 3 passed");
+}
+
+int main(void)
+{
+    LOG_DEBUG("=== Scheduler Period Test ===");
+
+    mock_time_us = 0;
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    sched_init(&test_slate);
+    telemetry_phase = telemetry_task.next_dispatch;
+
+    test_fixed_rate_no_drift();
+    test_fixed_rate_skip();
+    test_fixed_rate_catch_up();
+
+    free_slate(&test_slate);
+
+    LOG_DEBUG("=== All Scheduler Period Tests Passed ===");
+    return 0;
+}
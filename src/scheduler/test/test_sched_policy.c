@@ -0,0 +1,192 @@
+/**
+ * @file test_sched_policy.c
+ * @brief Dispatch order and overrun test - exercises the real sched_dispatch
+ * on the real running state
+ *
+ * Each running-state task's dispatch function is wrapped so the test can see
+ * the order tasks ran in within a single sched_dispatch.
+ */
+
+#include "error.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include "print_task.h"
+#include "radio_task.h"
+#include "running_state.h"
+#include "scheduler.h"
+#include "watchdog_task.h"
+
+slate_t test_slate;
+
+static void (*real_dispatch[MAX_TASKS_PER_STATE])(slate_t *slate);
+static sched_task_t *order[MAX_TASKS_PER_STATE];
+static size_t num_ran;
+
+static void record(size_t i, slate_t *slate)
+{
+    sched_task_t *task = running_state.task_list[i];
+    order[num_ran++] = task;
+    real_dispatch[i](slate);
+}
+
+#define RECORDER(i)                                                            \
+    static void record_##i(slate_t *slate)                                     \
+    {                                                                          \
+        record(i, slate);                                                      \
+    }
+RECORDER(0)
+RECORDER(1)
+RECORDER(2)
+RECORDER(3)
+RECORDER(4)
+RECORDER(5)
+RECORDER(6)
+RECORDER(7)
+RECORDER(8)
+RECORDER(9)
+
+static void (*const recorders[MAX_TASKS_PER_STATE])(slate_t *slate) = {
+    record_0, record_1, record_2, record_3, record_4,
+    record_5, record_6, record_7, record_8, record_9,
+};
+
+/**
+ * Position of a task in the recorded order, or -1 if it did not run.
+ */
+static int position(sched_task_t *task)
+{
+    for (size_t i = 0; i < num_ran; i++)
+    {
+        if (order[i] == task)
+            return (int)i;
+    }
+    return -1;
+}
+
+/**
+ * Make every running-state task due at the same instant, then dispatch once.
+ */
+static void dispatch_all_due(void)
+{
+    absolute_time_t release = mock_time_us;
+    for (size_t i = 0; i < running_state.num_tasks; i++)
+        running_state.task_list[i]->next_dispatch = release;
+
+    mock_time_us = release + 1;
+    num_ran = 0;
+    sched_dispatch(&test_slate);
+}
+
+/**
+ * Test 1: Radio and watchdog run before print when all are due together
+ */
+void test_critical_tasks_first(void)
+{
+    LOG_DEBUG("=== Test 1: Critical tasks first ===");
+
+    dispatch_all_due();
+
+    int radio = position(&radio_task);
+    int watchdog = position(&watchdog_task);
+    int print = position(&print_task);
+    LOG_DEBUG("  radio=%d watchdog=%d print=%d", radio, watchdog, print);
+
+    ASSERT(radio >= 0 && watchdog >= 0 && print >= 0);
+    ASSERT(radio < print);
+    ASSERT(watchdog < print);
+
+    // Every ready task still runs exactly once
+    for (size_t i = 0; i < running_state.num_tasks; i++)
+    {
+        sched_task_t *task = running_state.task_list[i];
+        if (task->core == SCHED_CORE_0)
+            ASSERT(position(task) >= 0);
+    }
+
+    LOG_DEBUG("  Test 1 passed");
+}
+
+/**
+ * Test 2: A print task that is about to miss its deadline is ordered by the
+ * policy: still last under fixed priority, first under EDF
+ */
+void test_late_low_priority_task(void)
+{
+    LOG_DEBUG("=== Test 2: Late low priority task ===");
+
+    // Print was released 950 ms before everything else
+    print_task.next_dispatch = mock_time_us;
+    mock_time_us += 950 * 1000ULL;
+    for (size_t i = 0; i < running_state.num_tasks; i++)
+    {
+        if (running_state.task_list[i] != &print_task)
+            running_state.task_list[i]->next_dispatch = mock_time_us - 1;
+    }
+
+    num_ran = 0;
+    sched_dispatch(&test_slate);
+
+    int radio = position(&radio_task);
+    int print = position(&print_task);
+    ASSERT(radio >= 0 && print >= 0);
+#if SCHED_POLICY == SCHED_POLICY_EDF
+    ASSERT(print < radio);
+#else
+    ASSERT(radio < print);
+#endif
+
+    LOG_DEBUG("  Test 2 passed");
+}
+
+/**
+ * Test 3: Finishing after the relative deadline counts an overrun
+ */
+void test_overrun_counted(void)
+{
+    LOG_DEBUG("=== Test 3: Overruns ===");
+
+    uint32_t overruns = print_task.profile.num_overruns;
+
+    // On time: no overrun
+    dispatch_all_due();
+    ASSERT(print_task.profile.num_overruns == overruns);
+
+    // Released two periods ago: past its deadline before it even starts
+    print_task.next_dispatch = mock_time_us;
+    mock_time_us += 2 * print_task.dispatch_period_ms * 1000ULL;
+    num_ran = 0;
+    sched_dispatch(&test_slate);
+
+    ASSERT(position(&print_task) >= 0);
+    ASSERT(print_task.profile.num_overruns == overruns + 1);
+
+    LOG_DEBUG("  Test 3 passed");
+}
+
+int main(void)
+{
+    LOG_DEBUG("=== Scheduler Policy Test ===");
+
+    mock_time_us = 0;
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    sched_init(&test_slate);
+
+    test_slate.manual_override_state_id = STATE_RUNNING;
+    sched_dispatch(&test_slate);
+    ASSERT(test_slate.current_state_id == STATE_RUNNING);
+
+    for (size_t i = 0; i < running_state.num_tasks; i++)
+    {
+        real_dispatch[i] = running_state.task_list[i]->task_dispatch;
+        running_state.task_list[i]->task_dispatch = recorders[i];
+    }
+
+    test_critical_tasks_first();
+    test_late_low_priority_task();
+    test_overrun_counted();
+
+    free_slate(&test_slate);
+
+    LOG_DEBUG("=== All Scheduler Policy Tests Passed ===");
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file test_sched_profile.c
+ * @brief Unit tests for per-task execution time profiling
+ */
+
+#include "sched_profile.h"
+#include "test_harness.h"
+#include <string.h>
+
+static void noop(slate_t *slate)
+{
+}
+
+static sched_task_t test_task = {
+    .name = "test_task",
+    .dispatch_period_ms = 100,
+    .task_init = noop,
+    .task_dispatch = noop,
+};
+
+int test_bucket_boundaries(slate_t *slate)
+{
+    TEST_ASSERT(sched_profile_bucket(0) == 0, "0us should be bucket 0");
+    TEST_ASSERT(sched_profile_bucket(1) == 1, "1us should be bucket 1");
+    TEST_ASSERT(sched_profile_bucket(2) == 2, "2us should be bucket 2");
+    TEST_ASSERT(sched_profile_bucket(3) == 2, "3us should be bucket 2");
+    TEST_ASSERT(sched_profile_bucket(1024) == 11, "1024us should be bucket 11");
+    TEST_ASSERT(sched_profile_bucket(UINT64_MAX) ==
+                    SCHED_PROFILE_NUM_BUCKETS - 1,
+                "Long dispatches should land in the last bucket");
+    return 0;
+}
+
+int test_record_min_max_mean(slate_t *slate)
+{
+    sched_profile_reset(&test_task);
+    sched_profile_record(&test_task, 100);
+    sched_profile_record(&test_task, 10);
+    sched_profile_record(&test_task, 1000);
+
+    const sched_task_profile_t *p = &test_task.profile;
+    TEST_ASSERT(p->num_dispatches == 3, "Expected 3 dispatches, got %u",
+                p->num_dispatches);
+    TEST_ASSERT(p->min_us == 10, "Expected min 10, got %u", p->min_us);
+    TEST_ASSERT(p->max_us == 1000, "Expected max 1000, got %u", p->max_us);
+    TEST_ASSERT(p->total_us == 1110, "Expected total 1110");
+    TEST_ASSERT(p->histogram[sched_profile_bucket(10)] == 1,
+                "10us not counted");
+    TEST_ASSERT(p->histogram[sched_profile_bucket(100)] == 1,
+                "100us not counted");
+    TEST_ASSERT(p->histogram[sched_profile_bucket(1000)] == 1,
+                "1000us not counted");
+    return 0;
+}
+
+int test_histogram_saturates(slate_t *slate)
+{
+    sched_profile_reset(&test_task);
+    for (uint32_t i = 0; i < UINT16_MAX + 10; i++)
+        sched_profile_record(&test_task, 5);
+
+    TEST_ASSERT(test_task.profile.histogram[sched_profile_bucket(5)] ==
+                    UINT16_MAX,
+                "Histogram bucket should saturate");
+    TEST_ASSERT(test_task.profile.num_dispatches == UINT16_MAX + 10,
+                "Dispatch count should not saturate");
+    return 0;
+}
+
+int test_record_lateness(slate_t *slate)
+{
+    sched_profile_reset(&test_task);
+    uint64_t lateness[] = {10, 50, 20};
+    for (size_t i = 0; i < 3; i++)
+    {
+        sched_profile_record_lateness(&test_task, lateness[i]);
+        sched_profile_record(&test_task, 1);
+    }
+
+    const sched_task_profile_t *p = &test_task.profile;
+    TEST_ASSERT(p->max_lateness_us == 50, "Expected max lateness 50, got %u",
+                p->max_lateness_us);
+    TEST_ASSERT(p->total_lateness_us == 80, "Expected total lateness 80");
+    TEST_ASSERT(p->max_jitter_us == 40, "Expected max jitter 40, got %u",
+                p->max_jitter_us);
+    TEST_ASSERT(p->last_lateness_us == 20, "Expected last lateness 20");
+    return 0;
+}
+
+int test_serialize(slate_t *slate)
+{
+    sched_profile_reset(&test_task);
+    sched_profile_record_lateness(&test_task, 100);
+    sched_profile_record(&test_task, 20);
+    sched_profile_record_lateness(&test_task, 300);
+    sched_profile_record(&test_task, 40);
+    test_task.profile.num_skipped = 5;
+    test_task.profile.num_overruns = 2;
+    test_task.profile.num_over_budget = 3;
+
+    sched_profile_packet_t pkt;
+    sched_profile_serialize(&test_task, 3, 7, &pkt);
+
+    TEST_ASSERT(pkt.task_index == 3, "Wrong task index");
+    TEST_ASSERT(pkt.num_tasks == 7, "Wrong task count");
+    TEST_ASSERT(strncmp(pkt.name, "test_task", SCHED_PROFILE_NAME_LEN) == 0,
+                "Wrong task name");
+    TEST_ASSERT(pkt.num_dispatches == 2, "Wrong dispatch count");
+    TEST_ASSERT(pkt.min_us == 20 && pkt.max_us == 40, "Wrong min/max");
+    TEST_ASSERT(pkt.mean_us == 30, "Expected mean 30, got %u", pkt.mean_us);
+    TEST_ASSERT(pkt.mean_lateness_us == 200, "Expected mean lateness 200");
+    TEST_ASSERT(pkt.max_lateness_us == 300, "Expected max lateness 300");
+    TEST_ASSERT(pkt.max_jitter_us == 200, "Expected max jitter 200");
+    TEST_ASSERT(pkt.num_skipped == 5, "Expected 5 skipped periods");
+    TEST_ASSERT(pkt.num_overruns == 2, "Expected 2 overruns");
+    TEST_ASSERT(pkt.num_over_budget == 3, "Expected 3 over budget");
+    TEST_ASSERT(pkt.histogram[sched_profile_bucket(20)] == 1 &&
+                    pkt.histogram[sched_profile_bucket(40)] == 1,
+                "Histogram not copied");
+
+    // Out of range index: only the task count is reported
+    sched_profile_serialize(NULL, 9, 7, &pkt);
+    TEST_ASSERT(pkt.task_index == 9 && pkt.num_tasks == 7,
+                "Header not filled for missing task");
+    TEST_ASSERT(pkt.num_dispatches == 0 && pkt.name[0] == '\0',
+                "Body should be empty for missing task");
+    return 0;
+}
+
+const test_harness_case_t sched_profile_tests[] = {
+    {0, test_bucket_boundaries, "Bucket boundaries"},
+    {1, test_record_min_max_mean, "Record min/max/mean"},
+    {2, test_histogram_saturates, "Histogram saturates"},
+    {3, test_record_lateness, "Record lateness and jitter"},
+    {4, test_serialize, "Serialize downlink packet"},
+};
+
+int main()
+{
+    return test_harness_run(
+        "Scheduler Profile", sched_profile_tests,
+        sizeof(sched_profile_tests) / sizeof(sched_profile_tests[0]), NULL);
+}
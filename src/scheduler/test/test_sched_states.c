@@ -0,0 +1,192 @@
+/**
+ * @file test_sched_states.c
+ * @brief State entry/exit hooks, per-state task periods and state nesting -
+ * exercises the real sched_dispatch on the real running and safe states
+ */
+
+#include "beacon_task.h"
+#include "error.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include "radio_task.h"
+#include "running_state.h"
+#include "safe_state.h"
+#include "scheduler.h"
+#include <string.h>
+
+slate_t test_slate;
+
+#define MAX_EVENTS 8
+static const char *events[MAX_EVENTS];
+static size_t num_events;
+
+static void record(const char *event)
+{
+    ASSERT(num_events < MAX_EVENTS);
+    events[num_events++] = event;
+}
+
+static void running_enter(slate_t *slate)
+{
+    record("running_enter");
+}
+
+static void running_exit(slate_t *slate)
+{
+    record("running_exit");
+}
+
+static void safe_enter(slate_t *slate)
+{
+    record("safe_enter");
+}
+
+static void safe_exit(slate_t *slate)
+{
+    record("safe_exit");
+}
+
+/**
+ * Move to a state with the manual override and a single sched_dispatch,
+ * recording the hooks that ran.
+ */
+static void go_to(state_id_t id)
+{
+    num_events = 0;
+    test_slate.manual_override_state_id = id;
+    sched_dispatch(&test_slate);
+    ASSERT(test_slate.current_state_id == id);
+}
+
+/**
+ * Test 1: Hooks run on exit from the old state, then on entry to the new one
+ */
+void test_hooks_order(void)
+{
+    LOG_DEBUG("=== Test 1: Hook order ===");
+
+    go_to(STATE_SAFE);
+    ASSERT(num_events == 2);
+    ASSERT(strcmp(events[0], "running_exit") == 0);
+    ASSERT(strcmp(events[1], "safe_enter") == 0);
+
+    go_to(STATE_RUNNING);
+    ASSERT(num_events == 2);
+    ASSERT(strcmp(events[0], "safe_exit") == 0);
+    ASSERT(strcmp(events[1], "running_enter") == 0);
+
+    // Staying put runs nothing
+    go_to(STATE_RUNNING);
+    ASSERT(num_events == 0);
+
+    LOG_DEBUG("  Test 1 passed");
+}
+
+/**
+ * Test 2: The safe state slows the beacon down, and running restores it
+ * without waiting out the long period
+ */
+void test_period_override(void)
+{
+    LOG_DEBUG("=== Test 2: Period override ===");
+
+    ASSERT(beacon_task.period_ms == beacon_task.dispatch_period_ms);
+
+    go_to(STATE_SAFE);
+    ASSERT(beacon_task.period_ms > beacon_task.dispatch_period_ms);
+    ASSERT(radio_task.period_ms == radio_task.dispatch_period_ms);
+
+    // Run the beacon once so its next deadline is a full slow period away
+    beacon_task.next_dispatch = mock_time_us;
+    mock_time_us++;
+    sched_dispatch(&test_slate);
+    ASSERT(beacon_task.next_dispatch >
+           mock_time_us + beacon_task.dispatch_period_ms * 1000ULL);
+
+    go_to(STATE_RUNNING);
+    ASSERT(beacon_task.period_ms == beacon_task.dispatch_period_ms);
+    ASSERT(beacon_task.next_dispatch <=
+           mock_time_us + beacon_task.dispatch_period_ms * 1000ULL);
+
+    LOG_DEBUG("  Test 2 passed");
+}
+
+/**
+ * Test 3: A state nested in another only runs its own hooks when moving to
+ * or from its parent, and inherits the parent's period overrides
+ */
+void test_nested_state(void)
+{
+    LOG_DEBUG("=== Test 3: Nested state ===");
+
+    safe_state.parent = &running_state;
+    running_state.period_overrides[0] =
+        (sched_period_override_t){&radio_task, 500};
+
+    go_to(STATE_SAFE);
+    ASSERT(num_events == 1);
+    ASSERT(strcmp(events[0], "safe_enter") == 0);
+    ASSERT(radio_task.period_ms == 500);
+
+    go_to(STATE_RUNNING);
+    ASSERT(num_events == 1);
+    ASSERT(strcmp(events[0], "safe_exit") == 0);
+
+    running_state.period_overrides[0] = (sched_period_override_t){0};
+    safe_state.parent = NULL;
+
+    LOG_DEBUG("  Test 3 passed");
+}
+
+/**
+ * Test 4: A task suspended for its budget is not pulled in by a shorter
+ * period on state entry
+ */
+void test_period_keeps_suspension(void)
+{
+    LOG_DEBUG("=== Test 4: Period change keeps a budget suspension ===");
+
+    go_to(STATE_SAFE);
+
+    // As sched_enforce_budget leaves a suspended task
+    beacon_task.budget_strikes = SCHED_BUDGET_MAX_STRIKES;
+    absolute_time_t suspended_until =
+        mock_time_us + SCHED_BUDGET_SUSPEND_MS * 1000ULL;
+    beacon_task.next_dispatch = suspended_until;
+
+    go_to(STATE_RUNNING);
+    ASSERT(beacon_task.period_ms == beacon_task.dispatch_period_ms);
+    ASSERT(beacon_task.next_dispatch == suspended_until);
+
+    beacon_task.budget_strikes = 0;
+
+    LOG_DEBUG("  Test 4 passed");
+}
+
+int main(void)
+{
+    LOG_DEBUG("=== Scheduler States Test ===");
+
+    running_state.on_enter = running_enter;
+    running_state.on_exit = running_exit;
+    safe_state.on_enter = safe_enter;
+    safe_state.on_exit = safe_exit;
+
+    mock_time_us = 0;
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    sched_init(&test_slate);
+
+    go_to(STATE_RUNNING);
+    ASSERT(num_events == 1);
+    ASSERT(strcmp(events[0], "running_enter") == 0);
+
+    test_hooks_order();
+    test_period_override();
+    test_nested_state();
+    test_period_keeps_suspension();
+
+    free_slate(&test_slate);
+
+    LOG_DEBUG("=== All Scheduler States Tests Passed ===");
+    return 0;
+}
@@ -25,8 +25,11 @@ void free_slate(slate_t *slate)
     if (slate != NULL)
     {
         queue_free(&slate->payload_command_data);
-        queue_free(&slate->tx_queue);
+        queue_free(&slate->ftp_command_data);
+        for (int c = 0; c < TX_CLASS_COUNT; c++)
+            queue_free(&slate->tx_sched.queues[c]);
         queue_free(&slate->rx_queue);
+        queue_free(&slate->packet_pool.free_list);
         queue_free(&slate->rpi_uart_queue);
     }
 
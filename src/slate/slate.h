@@ -21,10 +21,13 @@
 
 #include "adcs_packet.h"
 #include "config.h"
+#include "link_stats.h"
 #include "logger.h"
 #include "onboard_led.h"
+#include "packet_pool.h"
 #include "rfm9x.h"
 #include "state_ids.h"
+#include "tx_sched.h"
 #include "typedefs.h"
 #include "watchdog.h"
 
@@ -52,6 +55,21 @@ typedef struct samwise_slate
     // Manually set next state to transition to
     state_id_t manual_override_state_id;
 
+    // Tickless idle accounting, maintained by sched_dispatch
+    absolute_time_t sched_idle_window_start;
+    uint64_t sched_idle_us;     // Time spent idle in the current window
+    uint8_t sched_idle_percent; // Idle % over the last completed window
+
+    // Execution budget enforcement, maintained by sched_dispatch
+    uint32_t sched_budget_faults; // Times a task was suspended for its budget
+    state_id_t sched_fault_resume_state_id; // State the safe state returns to
+    // Override pending when a fault forced the safe state, restored after it
+    state_id_t sched_fault_saved_override_state_id;
+
+    // Slowest core0 dispatch since watchdog_task last ran
+    const char *sched_slowest_task;
+    uint32_t sched_slowest_us;
+
     /*
      * Power Telemetry
      */
@@ -87,6 +105,8 @@ typedef struct samwise_slate
      * Watchdog
      */
     watchdog_t watchdog;
+    absolute_time_t watchdog_last_dispatch;
+    uint32_t watchdog_stalls; // Gaps over WATCHDOG_STALL_MS between feeds
 
     /*
      * LED
@@ -111,14 +131,36 @@ typedef struct samwise_slate
      */
     rfm9x_t radio;
     uint8_t radio_node;
-    queue_t tx_queue; // Initialized in radio_task.c
-    queue_t rx_queue; // Initialized in radio_task.c
+    packet_pool_t packet_pool; // Initialized in radio_task.c
+    tx_sched_t tx_sched;       // Downlink by class, initialized in radio_task.c
+    queue_t rx_queue;          // packet_handle_t, initialized in radio_task.c
     uint32_t rx_bytes;
     uint32_t rx_packets;
     uint32_t rx_backpressure_drops;
     uint32_t rx_bad_packet_drops;
+    uint32_t auth_results[PACKET_AUTH_RESULT_COUNT]; // Uplink, by outcome
     uint32_t tx_bytes;
     uint32_t tx_packets;
+    uint32_t tx_bursts;
+    uint32_t tx_burst_cutoffs; // Bursts ended by a limit with frames queued
+    uint32_t tx_timeouts;      // Bursts abandoned for want of a TxDone
+    uint64_t tx_airtime_us;
+    uint32_t tx_fec_frames; // Sent with Reed-Solomon parity
+    uint64_t tx_fec_us;     // Spent computing it
+
+    /*
+     * Link adaptation, see link_adapt.h
+     */
+    uint8_t link_profile;         // Index into link_profiles
+    uint8_t link_pending_profile; // Switched to once the ACK is on air
+    int16_t link_snr_avg_q4;      // Uplink SNR, quarter dB at 125 kHz
+    int16_t link_last_rssi;
+    uint32_t link_samples; // Uplink packets since the last switch
+    absolute_time_t link_last_rx;
+    absolute_time_t link_last_propose;
+    uint32_t link_switches;
+    uint32_t link_fallbacks; // Switches back for want of uplink
+    link_stats_t link_stats; // Every uplink frame, initialized in radio_task.c
 
     /*
      * RPi UART Communication
@@ -148,6 +190,46 @@ typedef struct samwise_slate
     FILESYS_BUFFERED_FNAME_STR_T filesys_buffered_fname_str;
     FILESYS_BUFFERED_FILE_LEN_T filesys_buffered_file_len;
     FILESYS_BUFFERED_FILE_CRC_T filesys_buffered_file_crc;
+    FILESYS_BUFFERED_FILE_LEN_T filesys_bytes_written; // Committed to MRAM
+    uint32_t filesys_crc_state; // Running CRC32 of those bytes, not finalized
+    bool filesys_crc_state_valid; // False once MRAM may not match it
+    bool filesys_verify_on_complete; // Read the file back to check its CRC
+
+    /*
+     * FTP uplink, see ftp_task.h. The file being written is the filesys one.
+     */
+    queue_t ftp_command_data; // FTP_COMMAND_DATA, initialized in command_task.c
+    bool ftp_filesys_mounted;
+    FTP_PACKET_SEQUENCE_T ftp_packet_start; // Current cycle, inclusive
+    FTP_PACKET_SEQUENCE_T ftp_packet_end;
+    uint8_t ftp_received_bitfield[FTP_BITFIELD_SIZE]; // Bit i: packet_start + i
+    uint16_t ftp_cycle_received;
+    absolute_time_t ftp_last_packet_time; // Last start or data packet
+    absolute_time_t ftp_last_report_time;
+    bool ftp_out_of_range_reported; // Since the last packet in range
+    uint32_t ftp_packets_accepted;
+    uint32_t ftp_packets_duplicate;
+    uint32_t ftp_packets_out_of_range;
+    uint32_t ftp_queue_drops; // Commands lost to a full ftp_command_data
+    uint32_t ftp_reply_drops; // Replies lost to a full downlink
+
+    // FTP downlink. The open file itself is private to ftp_task.c.
+    bool ftp_is_reading_file;
+    FILESYS_BUFFERED_FNAME_T ftp_read_fname;
+    FILESYS_BUFFERED_FILE_LEN_T ftp_read_file_len;
+    FILESYS_BUFFERED_FILE_CRC_T ftp_read_file_crc; // Checked on open
+    bool ftp_read_fec;
+    uint32_t ftp_read_base; // First packet the ground does not have
+    uint8_t ftp_read_acked_bitfield[FTP_BITFIELD_SIZE]; // Bit i: base + i
+    uint32_t ftp_read_next;     // Next packet of the round
+    uint32_t ftp_read_sent_end; // Past the furthest packet sent
+    uint32_t ftp_read_pos;      // Of the open file
+    bool ftp_read_waiting;      // Round over, for an acknowledgement
+    absolute_time_t ftp_read_wait_time; // Since the downlink queue ran dry
+    absolute_time_t ftp_read_last_ack_time; // Last start or acknowledgement
+    uint32_t ftp_read_packets_sent;
+    uint32_t ftp_read_packets_resent;
+    uint32_t ftp_read_polls; // Sent again for want of an acknowledgement
 
     /*
     Payload Heartbeat time: the time at which the Picubed last sent a request to
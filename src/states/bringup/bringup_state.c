@@ -14,8 +14,7 @@ state_id_t bringup_get_next_state(slate_t *slate)
 sched_state_t bringup_state = {
     .name = "bringup",
     .id = STATE_BRINGUP,
-    .num_tasks = 3,
-    .task_list = {&diagnostics_task, &hardware_test_task, &watchdog_task},
+    SCHED_TASK_LIST(diagnostics_task, hardware_test_task, watchdog_task),
     .get_next_state = &bringup_get_next_state};
 
 #endif
@@ -53,6 +53,5 @@ state_id_t burn_wire_get_next_state(slate_t *slate)
 
 sched_state_t burn_wire_state = {.name = "burn_wire",
                                  .id = STATE_BURN_WIRE,
-                                 .num_tasks = 1,
-                                 .task_list = {&burn_wire_task},
+                                 SCHED_TASK_LIST(burn_wire_task),
                                  .get_next_state = &burn_wire_get_next_state};
@@ -8,6 +8,7 @@
 #include "blink_task.h"
 #include "command_task.h"
 #include "diagnostics_task.h"
+#include "ftp_task.h"
 #include "hardware_test_task.h"
 #include "payload_task.h"
 #include "print_task.h"
@@ -183,8 +183,8 @@ void test_scheduler_execution()
     test_slate.manual_override_state_id = STATE_NONE;
     test_slate.entered_current_state_time = get_absolute_time();
 
-    // Register the running state in the state registry so scheduler can find it
-    state_registry_register(STATE_RUNNING, &running_state);
+    // The running state is in the static registry tables (sched_tables.c)
+    ASSERT(state_registry_get(STATE_RUNNING) == &running_state);
     LOG_DEBUG("Found running state: %s",
               state_registry_get(test_slate.current_state_id)->name);
 
@@ -0,0 +1,71 @@
+/**
+ * @file safe_state.c
+ *
+ * Safe state, entered by the scheduler when a task keeps blowing its
+ * execution budget (see sched_task_t.budget_ms). Only the tasks needed to
+ * stay alive and reachable run here; the offending task is suspended
+ * regardless of state, and the beacon slows down to save power. After
+ * SCHED_SAFE_STATE_DWELL_MS we go back to the state we came from.
+ */
+
+#include "safe_state.h"
+#include "logger.h"
+
+// Beacon period while in the safe state
+#define SAFE_BEACON_PERIOD_MS 30000
+
+static void safe_on_enter(slate_t *slate)
+{
+    LOG_ERROR("safe: Entered after %u budget faults, will resume state %d",
+              slate->sched_budget_faults, slate->sched_fault_resume_state_id);
+}
+
+static void safe_on_exit(slate_t *slate)
+{
+    LOG_INFO("safe: Leaving after %u ms",
+             (uint32_t)slate->time_in_current_state_ms);
+
+    // Hand back the override the fault displaced; it applies on the next
+    // dispatch, from the state we resume
+    slate->manual_override_state_id =
+        slate->sched_fault_saved_override_state_id;
+    slate->sched_fault_saved_override_state_id = STATE_NONE;
+}
+
+state_id_t safe_get_next_state(slate_t *slate)
+{
+    if (slate->time_in_current_state_ms < SCHED_SAFE_STATE_DWELL_MS)
+        return STATE_SAFE;
+
+    state_id_t resume = slate->sched_fault_resume_state_id;
+    if (resume == STATE_NONE || resume == STATE_SAFE)
+        resume = STATE_RUNNING;
+
+    LOG_INFO("safe: Dwell over, resuming state %d", resume);
+    return resume;
+}
+
+#ifdef BRINGUP
+sched_state_t safe_state = {.name = "safe",
+                            .id = STATE_SAFE,
+                            SCHED_TASK_LIST(print_task, watchdog_task),
+                            .on_enter = &safe_on_enter,
+                            .on_exit = &safe_on_exit,
+                            .get_next_state = &safe_get_next_state};
+#elif defined(PICO) && !defined(PICOHAT)
+sched_state_t safe_state = {.name = "safe",
+                            .id = STATE_SAFE,
+                            SCHED_TASK_LIST(print_task, blink_task),
+                            .on_enter = &safe_on_enter,
+                            .on_exit = &safe_on_exit,
+                            .get_next_state = &safe_get_next_state};
+#else
+sched_state_t safe_state = {
+    .name = "safe",
+    .id = STATE_SAFE,
+    SCHED_TASK_LIST(watchdog_task, beacon_task, radio_task, command_task),
+    .period_overrides = {{&beacon_task, SAFE_BEACON_PERIOD_MS}},
+    .on_enter = &safe_on_enter,
+    .on_exit = &safe_on_exit,
+    .get_next_state = &safe_get_next_state};
+#endif
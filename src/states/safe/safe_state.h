@@ -0,0 +1,17 @@
+#pragma once
+
+#include "macros.h"
+#include "slate.h"
+#include "state_machine.h"
+#include "typedefs.h"
+
+#include "beacon_task.h"
+#include "blink_task.h"
+#include "command_task.h"
+#include "print_task.h"
+#include "radio_task.h"
+#include "watchdog_task.h"
+
+state_id_t safe_get_next_state(slate_t *slate);
+
+extern sched_state_t safe_state;
@@ -8,9 +8,10 @@
 #include "adcs_task.h"
 #include "adcs_driver.h"
 #include "hardware/gpio.h"
-#include "neopixel.h"
+#include "logger.h"
 #include "pico/stdlib.h"
 #include "pins.h"
+#include "sched_core1.h"
 #include "slate.h"
 
 #include "cobs.h"
@@ -38,10 +39,9 @@ static uint32_t tx_count;
 static uint32_t rx_count;
 static uint8_t rx_buf[256];
 
+// Runs on core1, so it does not set the neopixel (see sched_core1.h)
 void adcs_task_dispatch(slate_t *slate)
 {
-    neopixel_set_color_rgb(ADCS_TASK_COLOR);
-
     // Turn on adcs_pin after init for some reason
     // TODO: figure out why this breaks the code if it happens during init
     sleep_ms(100);
@@ -79,9 +79,12 @@ void adcs_task_dispatch(slate_t *slate)
                 LOG_INFO("[ADCS] Attitude packet received");
                 slate->is_adcs_on = true;
                 // payload points into rx_buf at a byte offset, so it carries no
-                // alignment guarantee for adcs_packet_t.
+                // alignment guarantee for adcs_packet_t. The beacon reads
+                // this from core0, so copy it under the slate lock.
+                sched_slate_lock();
                 memcpy(&slate->adcs_telemetry, received.payload,
                        sizeof(adcs_packet_t));
+                sched_slate_unlock();
                 adcs_print_telemetry(&slate->adcs_telemetry);
                 break;
         } // end switch
@@ -92,12 +95,13 @@ void adcs_task_dispatch(slate_t *slate)
         tx_count += 1;
         send_ping();
     }
-
-    neopixel_set_color_rgb(0, 0, 0);
 }
 
 sched_task_t adcs_task = {.name = "adcs",
                           .dispatch_period_ms = 1000,
+                          // UART exchanges block for 200+ ms, keep them off
+                          // the radio/command core
+                          .core = SCHED_CORE_1,
                           .task_init = &adcs_task_init,
                           .task_dispatch = &adcs_task_dispatch,
 
@@ -10,8 +10,6 @@
 #include "slate.h"
 #include "state_machine.h"
 
-#define ADCS_TASK_COLOR 128, 255, 0
-
 void adcs_task_init(slate_t *slate);
 
 void adcs_task_dispatch(slate_t *slate);
@@ -7,10 +7,15 @@
 
 #include "beacon_task.h"
 #include "adcs_packet.h"
+#include "link_stats.h"
 #include "logger.h"
 #include "neopixel.h"
+#include "packet_fec.h"
+#include "pico/stdlib.h"
+#include "sched_core1.h"
 #include "state_registry.h"
 #include "str_utils.h"
+#include "tx_sched.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -45,6 +50,9 @@ typedef struct
     uint16_t panel_B_current; // in mA (to 0.001A)
 
     uint8_t device_status; // 0 for off, 1 for on
+    uint8_t idle_percent;  // Scheduler idle % over the last window
+
+    link_stats_summary_t link; // Recent uplink frames
 } __attribute__((__packed__)) beacon_stats;
 
 _Static_assert(sizeof(beacon_stats) + MAX_STR_LENGTH + 1 +
@@ -111,13 +119,19 @@ size_t serialize_slate(slate_t *slate, uint8_t *data)
                           .panel_A_current = slate->panel_A_current,
                           .panel_B_voltage = slate->panel_B_voltage,
                           .panel_B_current = slate->panel_B_current,
-                          .device_status = get_device_status(slate)};
+                          .device_status = get_device_status(slate),
+                          .idle_percent = slate->sched_idle_percent};
+    link_stats_summarize(&slate->link_stats,
+                         to_ms_since_boot(get_absolute_time()), &stats.link);
 
     memcpy(data + data_offset, &stats, sizeof(beacon_stats));
     data_offset += sizeof(beacon_stats);
 
-    // Copy adcs packet - device status will indicate if this is invalid
+    // Copy adcs packet - device status will indicate if this is invalid.
+    // The ADCS task writes it from core1.
+    sched_slate_lock();
     memcpy(data + data_offset, &slate->adcs_telemetry, sizeof(adcs_packet_t));
+    sched_slate_unlock();
     data_offset += sizeof(adcs_packet_t);
 
     // Add callsign at the end of the packet
@@ -135,26 +149,37 @@ void beacon_task_init(slate_t *slate)
 void beacon_task_dispatch(slate_t *slate)
 {
     neopixel_set_color_rgb(BEACON_TASK_COLOR);
-    // Create a new packet for radio TX
-    packet_t pkt;
-    pkt.src = 0;   // TODO Put in Samwise's node ID
-    pkt.dst = 255; // Broadcast address
-    pkt.flags = 0;
-    pkt.seq = 0;
+    // Build the packet straight into a pool slot for radio TX
+    packet_handle_t h =
+        tx_sched_alloc(&slate->tx_sched, &slate->packet_pool, TX_CLASS_BEACON);
+    if (h == PACKET_HANDLE_NONE)
+    {
+        LOG_ERROR("Beacon pkt failed, packet pool exhausted");
+        neopixel_set_color_rgb(0, 0, 0);
+        return;
+    }
+    packet_t *pkt = packet_pool_get(&slate->packet_pool, h);
+    pkt->src = 0;   // TODO Put in Samwise's node ID
+    pkt->dst = 255; // Broadcast address
+    // Beacons are what the ground hears at the edges of a pass, where a few
+    // corrupted bytes would otherwise lose the whole frame
+    pkt->flags = PACKET_FLAG_FEC;
+    pkt->seq = 0;
 
     // Commit into serialized byte array
-    pkt.len = serialize_slate(slate, pkt.data);
+    pkt->len = serialize_slate(slate, pkt->data);
 
     LOG_INFO("[beacon_task] Boot count: %d", slate->reboot_counter);
 
-    // Write into tx_queue
-    if (queue_try_add(&slate->tx_queue, &pkt))
+    // Hand to the radio
+    if (tx_sched_enqueue(&slate->tx_sched, &slate->packet_pool, TX_CLASS_BEACON,
+                         h))
     {
         LOG_INFO("Beacon pkt added to queue");
     }
     else
     {
-        LOG_ERROR("Beacon pkt failed to commit to tx_queue");
+        LOG_ERROR("Beacon pkt failed to commit to the TX queue");
     }
     neopixel_set_color_rgb(0, 0, 0);
 }
@@ -163,5 +188,7 @@ sched_task_t beacon_task = {.name = "beacon",
                             .dispatch_period_ms = 5000,
                             .task_init = &beacon_task_init,
                             .task_dispatch = &beacon_task_dispatch,
+                            /* Keep a fixed beacon cadence */
+                            .period_mode = SCHED_PERIOD_FIXED_RATE_SKIP,
                             /* Set to an actual value on init */
                             .next_dispatch = 0};
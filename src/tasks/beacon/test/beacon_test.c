@@ -32,6 +32,14 @@ sched_state_t mock_state = {
     .get_next_state = mock_get_next_state,
 };
 
+// Registry tables, in place of sched_tables.c, so state_registry_get can find
+// the mock state
+sched_state_t *const sched_state_table[STATE_COUNT] = {
+    [STATE_INIT] = &mock_state,
+};
+sched_task_t *const sched_task_table[] = {NULL};
+const size_t sched_task_table_len = 0;
+
 void mock_slate(slate_t *slate)
 {
     // Reset slate to empty first
@@ -41,9 +49,6 @@ void mock_slate(slate_t *slate)
         return;
     }
 
-    // Register mock state so state_registry_get can find it
-    state_registry_register(STATE_INIT, &mock_state);
-
     // Mock values into slate
     slate->time_in_current_state_ms = 12345;
     slate->current_state_id = STATE_INIT;
@@ -67,6 +72,11 @@ void mock_slate(slate_t *slate)
     };
     slate->reboot_counter = 42;
     slate->battery_voltage = 4000;
+    slate->sched_idle_percent = 87;
+
+    rfm9x_rx_info_t rx = {
+        .freq_error_hz = -1500, .rssi_dbm = -105, .snr_q4 = -6};
+    link_stats_record(&slate->link_stats, &rx, 0);
 }
 
 void test_beacon_serialize()
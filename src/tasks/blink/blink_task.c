@@ -18,6 +18,7 @@ void blink_task_dispatch(slate_t *slate)
 
 sched_task_t blink_task = {.name = "blink",
                            .dispatch_period_ms = 1000,
+                           .priority = SCHED_PRIORITY_LOW,
                            .task_init = &blink_task_init,
                            .task_dispatch = &blink_task_dispatch,
 
@@ -10,15 +10,38 @@
 
 #include "command_parser.h"
 #include "adcs_driver.h"
+#include "link_adapt.h"
 #include "logger.h"
 #include "macros.h"
 #include "payload_uart.h"
 #include "rfm9x.h"
+#include "sched_profile.h"
+#include "sched_wakeup.h"
 #include "state_ids.h"
+#include "state_registry.h"
+#include "tx_sched.h"
 #include "str_utils.h"
 #include <stdio.h>
 #include <string.h>
 
+_Static_assert(sizeof(sched_profile_packet_t) <= PACKET_DATA_SIZE,
+               "Task profile does not fit in a packet");
+
+/// @brief Queue a reply packet for the radio to send
+/// @return true if queued
+static bool queue_reply(slate_t *slate, uint8_t len, uint8_t *data)
+{
+    packet_handle_t h =
+        tx_sched_alloc(&slate->tx_sched, &slate->packet_pool, TX_CLASS_COMMAND);
+    if (h == PACKET_HANDLE_NONE)
+        return false;
+
+    rfm9x_format_packet(packet_pool_get(&slate->packet_pool, h), 0, 0, 0, 0,
+                        len, data);
+    return tx_sched_enqueue(&slate->tx_sched, &slate->packet_pool,
+                            TX_CLASS_COMMAND, h);
+}
+
 /// @brief Parse packet and dispatch command to appropriate queue
 void dispatch_command(slate_t *slate, packet_t *packet)
 {
@@ -56,13 +79,9 @@ void dispatch_command(slate_t *slate, packet_t *packet)
                                "Number commands executed: %d",
                                slate->number_commands_processed);
 
-            // Create the packet
-            packet_t pkt;
-            rfm9x_format_packet(&pkt, 0, 0, 0, 0, len, &data[0]);
-
             // Add to transmit buffer
             LOG_INFO("Sending to radio transmit queue...");
-            if (queue_try_add(&slate->tx_queue, &pkt))
+            if (queue_reply(slate, len, &data[0]))
             {
                 LOG_INFO("Ping info was sent...");
             }
@@ -124,6 +143,71 @@ void dispatch_command(slate_t *slate, packet_t *packet)
             break;
         }
 
+        case TASK_PROFILE:
+        {
+            // Payload: [task index][reset flag]
+            uint8_t task_index = command_payload[0];
+            bool reset = command_payload[1] != 0;
+            size_t num_tasks = state_registry_task_count();
+            sched_task_t *task = state_registry_get_task_by_index(task_index);
+
+            sched_profile_packet_t profile;
+            sched_profile_serialize(task, task_index, num_tasks, &profile);
+
+            if (queue_reply(slate, sizeof(profile), (uint8_t *)&profile))
+            {
+                LOG_INFO("Task profile for %s queued",
+                         task ? task->name : "(none)");
+                if (task != NULL && reset)
+                {
+                    sched_profile_reset(task);
+                }
+            }
+            else
+            {
+                LOG_ERROR("Task profile failed to send...");
+            }
+            break;
+        }
+
+        case LINK_SWITCH:
+        {
+            // Payload: [profile index]. The radio switches once the ACK is
+            // sent.
+            uint8_t profile = command_payload[0];
+            if (link_adapt_request(slate, profile))
+            {
+                LOG_INFO("Link switch to profile %d acknowledged", profile);
+            }
+            break;
+        }
+
+        case FTP_REFORMAT:
+        case FTP_START_FILE_WRITE:
+        case FTP_WRITE_TO_FILE:
+        case FTP_CANCEL_FILE_WRITE:
+        case FTP_START_FILE_READ:
+        case FTP_READ_ACK:
+        case FTP_CANCEL_FILE_READ:
+        case FTP_LIST_FILES:
+        {
+            FTP_COMMAND_DATA ftp_command;
+            ftp_command.command_type = command_id;
+            ftp_command.len =
+                packet->len > COMMAND_MNEMONIC_SIZE
+                    ? packet->len - COMMAND_MNEMONIC_SIZE
+                    : 0;
+            memcpy(ftp_command.data, command_payload, ftp_command.len);
+
+            // A lost data packet shows up in the next status report, and the
+            // ground sends it again
+            if (queue_try_add(&slate->ftp_command_data, &ftp_command))
+                sched_wakeup_signal(SCHED_WAKEUP_FTP_COMMAND);
+            else
+                slate->ftp_queue_drops++;
+            break;
+        }
+
         default:
             LOG_ERROR("Unknown command ID: %i", command_id);
             break;
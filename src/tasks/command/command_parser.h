@@ -23,7 +23,17 @@ typedef enum
     PAYLOAD_TURN_OFF,
     MANUAL_STATE_OVERRIDE,
     ADCS_EXEC,
-    ADCS_PACKET
+    ADCS_PACKET,
+    TASK_PROFILE,
+    LINK_SWITCH,
+    FTP_REFORMAT,
+    FTP_START_FILE_WRITE,
+    FTP_WRITE_TO_FILE,
+    FTP_CANCEL_FILE_WRITE,
+    FTP_START_FILE_READ,
+    FTP_READ_ACK,
+    FTP_CANCEL_FILE_READ,
+    FTP_LIST_FILES,
     // add more commands here as needed
 } Command;
 
@@ -48,4 +58,13 @@ typedef struct
     Command command_type; // Command type
 } PAYLOAD_COMMAND_DATA;
 
+// FTP commands are handed to ftp_task as received; ftp_task.h describes the
+// layout of data for each
+typedef struct
+{
+    Command command_type;
+    uint8_t len; // Bytes of data used
+    uint8_t data[PACKET_DATA_SIZE - COMMAND_MNEMONIC_SIZE];
+} FTP_COMMAND_DATA;
+
 void dispatch_command(slate_t *slate, packet_t *packet);
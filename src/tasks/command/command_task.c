@@ -7,13 +7,16 @@
 
 #include "command_task.h"
 #include "command_parser.h"
+#include "flash.h"
 #include "logger.h"
 #include "macros.h"
 #include "neopixel.h"
 #include "pico/stdlib.h"
+#include "sched_wakeup.h"
 #include "slate.h"
 
 const int PAYLOAD_DATA_CAPACITY = 32;
+const int FTP_DATA_CAPACITY = 8;
 
 /// @brief Initialize the command switch task
 /// @param slate Slate
@@ -22,36 +25,77 @@ void command_task_init(slate_t *slate)
     // Initialize queues for storing processed commands
     queue_init(&slate->payload_command_data, sizeof(PAYLOAD_COMMAND_DATA),
                PAYLOAD_DATA_CAPACITY);
+    queue_init(&slate->ftp_command_data, sizeof(FTP_COMMAND_DATA),
+               FTP_DATA_CAPACITY);
 
     slate->num_uploaded_bytes = 0;
     slate->packet_buffer_index = 0;
     slate->uploading_command_id = 0;
     slate->number_commands_processed = 0;
+
+    // Key the packet HMAC once rather than per packet
+    packet_auth_init();
+
+    // Carry the replay window over a reboot that kept the boot count
+    uint32_t boot_count, reserved;
+    if (get_replay_reservation(&boot_count, &reserved))
+        packet_replay_restore(boot_count, reserved);
+
+    memset(slate->auth_results, 0, sizeof(slate->auth_results));
 }
 
 /// @brief Process incoming radio packets and dispatch commands
 void command_task_dispatch(slate_t *slate)
 {
     neopixel_set_color_rgb(COMMAND_TASK_COLOR);
-    packet_t packet = {0};
+    packet_handle_t h;
 
     // Process one packet per dispatch cycle
-    if (queue_try_remove(&slate->rx_queue, &packet))
+    if (queue_try_remove(&slate->rx_queue, &h))
     {
-        if (!is_packet_authenticated(&packet, slate->reboot_counter))
+        // Come straight back for the rest of a burst
+        if (!queue_is_empty(&slate->rx_queue))
+            sched_wakeup_signal(SCHED_WAKEUP_RADIO_RX);
+
+        packet_t *packet = packet_pool_get(&slate->packet_pool, h);
+        packet_auth_result_t result =
+            packet_authenticate(packet, slate->reboot_counter);
+        slate->auth_results[result]++;
+        if (result != PACKET_AUTH_OK)
         {
             LOG_ERROR("Packet authentication failed. Dropping packet.");
+            packet_pool_free(&slate->packet_pool, h);
             return;
         }
 
+        // The msg_id must be on record as seen before the command can run.
+        // Every PACKET_REPLAY_RESERVE msg_ids this erases a flash sector,
+        // stalling both cores with interrupts off for tens of ms.
+        uint32_t boot_count, reserved;
+        if (packet_replay_reserve(&boot_count, &reserved))
+        {
+            if (!save_replay_reservation(boot_count, reserved))
+            {
+                LOG_ERROR("Could not save replay reservation. Dropping "
+                          "packet.");
+                packet_pool_free(&slate->packet_pool, h);
+                return;
+            }
+            packet_replay_reserved(boot_count, reserved);
+        }
+
         // Parse and process the command
-        dispatch_command(slate, &packet);
+        dispatch_command(slate, packet);
+        packet_pool_free(&slate->packet_pool, h);
     }
     neopixel_set_color_rgb(0, 0, 0);
 }
 
 sched_task_t command_task = {.name = "command",
                              .dispatch_period_ms = 100,
+                             .priority = SCHED_PRIORITY_HIGH,
                              .task_init = &command_task_init,
                              .task_dispatch = &command_task_dispatch,
+                             /* Run as soon as the radio queues a packet */
+                             .wakeup = SCHED_WAKEUP_RADIO_RX,
                              .next_dispatch = 0};
@@ -130,6 +130,7 @@ void diagnostics_task_dispatch(slate_t *slate)
 
 sched_task_t diagnostics_task = {.name = "diagnostics",
                                  .dispatch_period_ms = 1000,
+                                 .priority = SCHED_PRIORITY_LOW,
                                  .task_init = &diagnostics_task_init,
                                  .task_dispatch = &diagnostics_task_dispatch,
 
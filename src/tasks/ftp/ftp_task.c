@@ -0,0 +1,986 @@
+/**
+ * @file ftp_task.c
+ *
+ * File transfer task, see ftp_task.h and README.md.
+ */
+
+#include "ftp_task.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "command_parser.h"
+#include "filesys.h"
+#include "logger.h"
+#include "neopixel.h"
+#include "packet.h"
+#include "packet_fec.h"
+#include "packet_pool.h"
+#include "pico/stdlib.h"
+#include "rfm9x.h"
+#include "tx_sched.h"
+
+_Static_assert(sizeof(FTP_WRITE_TO_FILE_DATA) <=
+                   sizeof(((FTP_COMMAND_DATA *)0)->data),
+               "FTP_WRITE_TO_FILE_DATA must fit in a command");
+_Static_assert(sizeof(FTP_STATUS_REPORT_DATA) <= PACKET_DATA_SIZE,
+               "FTP_STATUS_REPORT_DATA must fit in a packet");
+_Static_assert(sizeof(FTP_READ_DATA) <= PACKET_DATA_SIZE,
+               "FTP_READ_DATA must fit in a packet");
+_Static_assert(sizeof(FTP_FILE_LIST_DATA) <= PACKET_DATA_SIZE,
+               "FTP_FILE_LIST_DATA must fit in a packet");
+_Static_assert(FTP_READ_WINDOW <= FTP_BITFIELD_SIZE * 8,
+               "FTP_READ_WINDOW must fit in an acknowledgement");
+
+// The file being read while slate->ftp_is_reading_file. Every open file
+// shares the filesys cache, so it stays open only while nothing is written.
+static lfs_file_t ftp_read_file;
+
+static void ftp_send_reply(slate_t *slate, const void *data, size_t len)
+{
+    packet_handle_t h =
+        tx_sched_alloc(&slate->tx_sched, &slate->packet_pool, TX_CLASS_COMMAND);
+    if (h == PACKET_HANDLE_NONE)
+    {
+        slate->ftp_reply_drops++;
+        return;
+    }
+
+    rfm9x_format_packet(packet_pool_get(&slate->packet_pool, h), 0, 0, 0, 0,
+                        len, (uint8_t *)data);
+    if (!tx_sched_enqueue(&slate->tx_sched, &slate->packet_pool,
+                          TX_CLASS_COMMAND, h))
+        slate->ftp_reply_drops++;
+}
+
+static void ftp_fill_header(slate_t *slate, FTP_RESULT_HEADER *header,
+                            FTP_Result result)
+{
+    if (slate->filesys_is_writing_file)
+    {
+        memcpy(&header->fname, slate->filesys_buffered_fname_str,
+               sizeof(header->fname));
+        header->file_len = slate->filesys_buffered_file_len;
+        header->file_crc = slate->filesys_buffered_file_crc;
+    }
+    else if (slate->ftp_is_reading_file)
+    {
+        header->fname = slate->ftp_read_fname;
+        header->file_len = slate->ftp_read_file_len;
+        header->file_crc = slate->ftp_read_file_crc;
+    }
+    else
+    {
+        header->fname = FTP_NO_FILE_FNAME;
+        header->file_len = 0;
+        header->file_crc = 0;
+    }
+    header->result = result;
+}
+
+static void ftp_send_result(slate_t *slate, FTP_Result result)
+{
+    FTP_RESULT_HEADER header;
+    ftp_fill_header(slate, &header, result);
+    ftp_send_reply(slate, &header, sizeof(header));
+}
+
+static void ftp_send_filesys_error(slate_t *slate, FTP_Result result,
+                                   filesys_error_t error, lfs_ssize_t lfs_error)
+{
+    FTP_FILESYS_ERROR_DATA reply;
+    ftp_fill_header(slate, &reply.header, result);
+    reply.filesys_error = error;
+    reply.lfs_error = lfs_error;
+    ftp_send_reply(slate, &reply, sizeof(reply));
+}
+
+static void ftp_fill_cycle_status(slate_t *slate, FTP_CYCLE_STATUS_DATA *status,
+                                  FTP_Result result)
+{
+    ftp_fill_header(slate, &status->header, result);
+    status->packet_start = slate->ftp_packet_start;
+    status->packet_end = slate->ftp_packet_end;
+    memcpy(status->received_bitfield, slate->ftp_received_bitfield,
+           sizeof(status->received_bitfield));
+}
+
+static void ftp_send_cycle_status(slate_t *slate, FTP_Result result)
+{
+    FTP_CYCLE_STATUS_DATA status;
+    ftp_fill_cycle_status(slate, &status, result);
+    ftp_send_reply(slate, &status, sizeof(status));
+}
+
+static void ftp_send_status_report(slate_t *slate)
+{
+    FTP_STATUS_REPORT_DATA report;
+    ftp_fill_cycle_status(slate, &report.cycle, FTP_STATUS_REPORT);
+    report.file_crc_so_far =
+        slate->filesys_bytes_written > 0 ? ~slate->filesys_crc_state : 0;
+    report.total_bytes_written = slate->filesys_bytes_written;
+    report.filesys_buffer_malloced = slate->filesys_buffer != NULL;
+    report.filesys_is_writing_file = slate->filesys_is_writing_file;
+    ftp_send_reply(slate, &report, sizeof(report));
+
+    slate->ftp_last_report_time = get_absolute_time();
+}
+
+/*
+ * The file being written, by packet
+ */
+
+static uint32_t ftp_num_packets(slate_t *slate)
+{
+    return (slate->filesys_buffered_file_len + FTP_DATA_PAYLOAD_SIZE - 1) /
+           FTP_DATA_PAYLOAD_SIZE;
+}
+
+static uint32_t ftp_packet_len(slate_t *slate, uint32_t packet_id)
+{
+    uint32_t left = slate->filesys_buffered_file_len -
+                    packet_id * FTP_DATA_PAYLOAD_SIZE;
+    return left < FTP_DATA_PAYLOAD_SIZE ? left : FTP_DATA_PAYLOAD_SIZE;
+}
+
+static bool ftp_is_received(slate_t *slate, uint32_t bit)
+{
+    return slate->ftp_received_bitfield[bit / 8] & (1 << (bit % 8));
+}
+
+static void ftp_open_cycle(slate_t *slate, uint32_t packet_start)
+{
+    uint32_t packet_end = packet_start + FTP_NUM_PACKETS_PER_CYCLE - 1;
+    if (packet_end >= ftp_num_packets(slate))
+        packet_end = ftp_num_packets(slate) - 1;
+
+    slate->ftp_packet_start = packet_start;
+    slate->ftp_packet_end = packet_end;
+    memset(slate->ftp_received_bitfield, 0,
+           sizeof(slate->ftp_received_bitfield));
+    slate->ftp_cycle_received = 0;
+    slate->ftp_out_of_range_reported = false;
+}
+
+static bool ftp_is_current_file(slate_t *slate, FILESYS_BUFFERED_FNAME_T fname)
+{
+    return slate->filesys_is_writing_file &&
+           memcmp(&fname, slate->filesys_buffered_fname_str, sizeof(fname)) ==
+               0;
+}
+
+// LFS takes names as C strings, so neither byte may be zero
+static bool ftp_fname_to_str(FILESYS_BUFFERED_FNAME_T fname,
+                             FILESYS_BUFFERED_FNAME_STR_T fname_str)
+{
+    memcpy(fname_str, &fname, sizeof(fname));
+    fname_str[sizeof(fname)] = '\0';
+    return strlen(fname_str) == sizeof(fname);
+}
+
+static bool ftp_ensure_mounted(slate_t *slate)
+{
+    if (slate->ftp_filesys_mounted)
+        return true;
+
+    lfs_ssize_t lfs_error;
+    filesys_error_t error = filesys_initialize(slate, &lfs_error);
+    if (error != FILESYS_OK)
+    {
+        ftp_send_filesys_error(slate, FILESYS_INIT_ERROR, error, lfs_error);
+        return false;
+    }
+    slate->ftp_filesys_mounted = true;
+    return true;
+}
+
+/*
+ * The file being read, by packet. Bit i of ftp_read_acked_bitfield is
+ * packet ftp_read_base + i.
+ */
+
+static uint32_t ftp_read_num_packets(slate_t *slate)
+{
+    return (slate->ftp_read_file_len + FTP_DATA_PAYLOAD_SIZE - 1) /
+           FTP_DATA_PAYLOAD_SIZE;
+}
+
+static uint32_t ftp_read_window_end(slate_t *slate)
+{
+    uint32_t end = slate->ftp_read_base + FTP_READ_WINDOW;
+    uint32_t num_packets = ftp_read_num_packets(slate);
+    return end < num_packets ? end : num_packets;
+}
+
+static bool ftp_read_is_acked(slate_t *slate, uint32_t packet_id)
+{
+    uint32_t bit = packet_id - slate->ftp_read_base;
+    return slate->ftp_read_acked_bitfield[bit / 8] & (1 << (bit % 8));
+}
+
+// The packet that ends a round: the last of the window the ground lacks
+static uint32_t ftp_read_last_missing(slate_t *slate)
+{
+    uint32_t id = ftp_read_window_end(slate) - 1;
+    while (id > slate->ftp_read_base && ftp_read_is_acked(slate, id))
+        id--;
+    return id;
+}
+
+static void ftp_read_slide(slate_t *slate, uint32_t n)
+{
+    uint8_t old[FTP_BITFIELD_SIZE];
+    memcpy(old, slate->ftp_read_acked_bitfield, sizeof(old));
+    memset(slate->ftp_read_acked_bitfield, 0, sizeof(old));
+    for (uint32_t bit = n; bit < FTP_READ_WINDOW; bit++)
+        if (old[bit / 8] & (1 << (bit % 8)))
+            slate->ftp_read_acked_bitfield[(bit - n) / 8] |=
+                1 << ((bit - n) % 8);
+    slate->ftp_read_base += n;
+}
+
+// Mark what the ground has and slide the window past it
+static void ftp_read_merge(slate_t *slate, const FTP_READ_ACK_DATA *received)
+{
+    uint32_t num_packets = ftp_read_num_packets(slate);
+    uint32_t start = received->packet_start;
+    if (start > num_packets)
+        start = num_packets;
+    if (start > slate->ftp_read_base)
+        ftp_read_slide(slate, start - slate->ftp_read_base);
+
+    // Sliding brings packets into the window that the bitfield may cover
+    uint32_t n;
+    do
+    {
+        for (uint32_t i = 0; i < FTP_READ_WINDOW; i++)
+        {
+            uint32_t id = start + i;
+            if (id >= slate->ftp_read_base && id < ftp_read_window_end(slate) &&
+                (received->received_bitfield[i / 8] & (1 << (i % 8))))
+            {
+                uint32_t bit = id - slate->ftp_read_base;
+                slate->ftp_read_acked_bitfield[bit / 8] |= 1 << (bit % 8);
+            }
+        }
+
+        n = 0;
+        while (slate->ftp_read_base + n < ftp_read_window_end(slate) &&
+               ftp_read_is_acked(slate, slate->ftp_read_base + n))
+            n++;
+        ftp_read_slide(slate, n);
+    } while (n > 0);
+}
+
+static void ftp_send_read_status(slate_t *slate, FTP_Result result)
+{
+    FTP_CYCLE_STATUS_DATA status;
+    ftp_fill_header(slate, &status.header, result);
+    uint32_t end = ftp_read_window_end(slate);
+    status.packet_start = slate->ftp_read_base;
+    status.packet_end = end > slate->ftp_read_base ? end - 1 : end;
+    memcpy(status.received_bitfield, slate->ftp_read_acked_bitfield,
+           sizeof(status.received_bitfield));
+    ftp_send_reply(slate, &status, sizeof(status));
+}
+
+static bool ftp_is_current_read(slate_t *slate, FILESYS_BUFFERED_FNAME_T fname)
+{
+    return slate->ftp_is_reading_file && fname == slate->ftp_read_fname;
+}
+
+static void ftp_close_read(slate_t *slate)
+{
+    // Nothing was written, so there is nothing to lose if this fails
+    lfs_ssize_t lfs_error;
+    filesys_close_file_read(slate, &ftp_read_file, &lfs_error);
+    slate->ftp_is_reading_file = false;
+}
+
+// Queue one data frame. On a read error the read is abandoned.
+static bool ftp_send_read_packet(slate_t *slate, uint32_t packet_id, bool poll)
+{
+    packet_handle_t h =
+        tx_sched_alloc(&slate->tx_sched, &slate->packet_pool, TX_CLASS_BULK);
+    if (h == PACKET_HANDLE_NONE)
+        return false;
+    packet_t *p = packet_pool_get(&slate->packet_pool, h);
+    FTP_READ_DATA *frame = (FTP_READ_DATA *)p->data;
+
+    // Straight from MRAM into the frame
+    uint32_t offset = packet_id * FTP_DATA_PAYLOAD_SIZE;
+    uint32_t len = slate->ftp_read_file_len - offset;
+    if (len > FTP_DATA_PAYLOAD_SIZE)
+        len = FTP_DATA_PAYLOAD_SIZE;
+    lfs_ssize_t lfs_error = LFS_ERR_OK;
+    filesys_error_t error = FILESYS_OK;
+    FILESYS_BUFFERED_FILE_LEN_T pos = slate->ftp_read_pos;
+    if (pos != offset)
+        error = filesys_read_file_seek(slate, &ftp_read_file, offset,
+                                       LFS_SEEK_SET, &pos, &lfs_error);
+    FILESYS_BUFFERED_FILE_LEN_T bytes_read = 0;
+    if (error == FILESYS_OK)
+        error = filesys_read_data(slate, &ftp_read_file, frame->data, len,
+                                  &bytes_read, &lfs_error);
+    if (error == FILESYS_OK && bytes_read != len)
+        error = FILESYS_ERR_READ_FILE;
+    if (error != FILESYS_OK)
+    {
+        packet_pool_free(&slate->packet_pool, h);
+        ftp_send_filesys_error(slate, FTP_FILE_READ_MRAM_ERROR, error,
+                               lfs_error);
+        ftp_close_read(slate);
+        return false;
+    }
+    slate->ftp_read_pos = offset + len;
+
+    frame->fname = slate->ftp_read_fname;
+    frame->packet_id = packet_id;
+    uint8_t flags = FTP_FLAG_READ_DATA;
+    if (poll)
+        flags |= FTP_FLAG_READ_POLL;
+    if (slate->ftp_read_fec)
+        flags |= PACKET_FLAG_FEC;
+    p->dst = 0;
+    p->src = 0;
+    p->flags = flags;
+    p->seq = 0;
+    p->len = offsetof(FTP_READ_DATA, data) + len;
+    if (!tx_sched_enqueue(&slate->tx_sched, &slate->packet_pool,
+                          TX_CLASS_BULK, h))
+        return false;
+
+    slate->ftp_read_packets_sent++;
+    if (packet_id < slate->ftp_read_sent_end)
+        slate->ftp_read_packets_resent++;
+    else
+        slate->ftp_read_sent_end = packet_id + 1;
+    return true;
+}
+
+// Queue as much of the round as the downlink has room for
+static void ftp_read_round(slate_t *slate)
+{
+    uint32_t end = ftp_read_window_end(slate);
+    uint32_t last = ftp_read_last_missing(slate);
+    while (slate->ftp_is_reading_file && !slate->ftp_read_waiting &&
+           tx_sched_has_room(&slate->packet_pool, TX_CLASS_BULK))
+    {
+        uint32_t id = slate->ftp_read_next;
+        while (id < end && ftp_read_is_acked(slate, id))
+            id++;
+        bool poll = id >= last;
+        if (id < end && !ftp_send_read_packet(slate, id, poll))
+            return;
+        slate->ftp_read_next = id + 1;
+        if (poll)
+        {
+            slate->ftp_read_waiting = true;
+            slate->ftp_read_wait_time = get_absolute_time();
+        }
+    }
+}
+
+static void ftp_read_wait(slate_t *slate)
+{
+    // The timeout runs from when the last frame of the round left the queue
+    absolute_time_t now = get_absolute_time();
+    if (!tx_sched_is_empty(&slate->tx_sched))
+    {
+        slate->ftp_read_wait_time = now;
+        return;
+    }
+    if (absolute_time_diff_us(slate->ftp_read_wait_time, now) <
+        FTP_READ_ACK_TIMEOUT_MS * 1000LL)
+        return;
+
+    // The poll or its answer was lost. Sending the last packet of the round
+    // again gets an acknowledgement either way.
+    if (ftp_send_read_packet(slate, ftp_read_last_missing(slate), true))
+    {
+        slate->ftp_read_polls++;
+        slate->ftp_read_wait_time = now;
+    }
+}
+
+static void ftp_read_dispatch(slate_t *slate)
+{
+    if (absolute_time_diff_us(slate->ftp_read_last_ack_time,
+                              get_absolute_time()) >=
+        FTP_READ_TIMEOUT_MS * 1000LL)
+    {
+        LOG_INFO("[ftp] Nothing heard, giving up reading %.2s at packet %u",
+                 (const char *)&slate->ftp_read_fname, slate->ftp_read_base);
+        ftp_close_read(slate);
+        return;
+    }
+
+    if (slate->ftp_read_waiting)
+        ftp_read_wait(slate);
+    else
+        ftp_read_round(slate);
+}
+
+/*
+ * Commands
+ */
+
+static void ftp_complete_file(slate_t *slate)
+{
+    FTP_EOF_DATA reply;
+    ftp_fill_header(slate, &reply.header, FTP_EOF_SUCCESS);
+    reply.computed_crc = slate->filesys_buffered_file_crc;
+    reply.file_len_on_disk = slate->filesys_bytes_written;
+
+    lfs_ssize_t lfs_error;
+    filesys_error_t error = filesys_complete_file_write(slate, &lfs_error);
+    if (error == FILESYS_ERR_CRC_MISMATCH)
+    {
+        // The file stays open, and completing it again checks it again
+        reply.header.result = FTP_EOF_CRC_ERROR;
+        reply.computed_crc = filesys_written_crc(slate, &error, &lfs_error);
+    }
+    else if (error != FILESYS_OK)
+    {
+        ftp_send_filesys_error(slate, FTP_FILE_WRITE_MRAM_ERROR, error,
+                               lfs_error);
+        return;
+    }
+    else
+    {
+        LOG_INFO("[ftp] Received file %s, %u bytes",
+                 slate->filesys_buffered_fname_str, reply.file_len_on_disk);
+    }
+    ftp_send_reply(slate, &reply, sizeof(reply));
+}
+
+static void ftp_finish_cycle(slate_t *slate)
+{
+    uint32_t cycle_start = slate->ftp_packet_start * FTP_DATA_PAYLOAD_SIZE;
+    uint32_t cycle_bytes =
+        (slate->ftp_packet_end - slate->ftp_packet_start) *
+            FTP_DATA_PAYLOAD_SIZE +
+        ftp_packet_len(slate, slate->ftp_packet_end);
+
+    // Already on MRAM if this retries the check of the last cycle
+    if (slate->filesys_bytes_written == cycle_start)
+    {
+        lfs_ssize_t lfs_error;
+        filesys_error_t error =
+            filesys_write_buffer_to_mram(slate, cycle_bytes, &lfs_error);
+        if (error != FILESYS_OK)
+        {
+            // How much of the cycle reached MRAM is unknown, so the file
+            // cannot be continued
+            FTP_FILESYS_ERROR_DATA reply;
+            ftp_fill_header(slate, &reply.header, FTP_FILE_WRITE_MRAM_ERROR);
+            reply.filesys_error = error;
+            reply.lfs_error = lfs_error;
+            if (slate->filesys_is_writing_file)
+                filesys_cancel_file_write(slate, &lfs_error);
+            ftp_send_reply(slate, &reply, sizeof(reply));
+            return;
+        }
+    }
+
+    if ((uint32_t)slate->ftp_packet_end + 1 < ftp_num_packets(slate))
+    {
+        ftp_open_cycle(slate, slate->ftp_packet_end + 1);
+        ftp_send_cycle_status(slate, FTP_FILE_WRITE_SUCCESS);
+    }
+    else
+    {
+        ftp_complete_file(slate);
+    }
+}
+
+static void ftp_start_file_write(slate_t *slate, const FTP_COMMAND_DATA *cmd)
+{
+    FTP_START_FILE_WRITE_DATA start;
+    FILESYS_BUFFERED_FNAME_STR_T fname_str;
+    if (cmd->len < sizeof(start))
+    {
+        ftp_send_result(slate, FTP_ERROR);
+        return;
+    }
+    memcpy(&start, cmd->data, sizeof(start));
+
+    if (slate->filesys_is_writing_file)
+    {
+        ftp_send_result(slate, FTP_ERROR_ALREADY_WRITING_FILE);
+        return;
+    }
+    if (slate->ftp_is_reading_file)
+    {
+        ftp_send_result(slate, FTP_ERROR_ALREADY_READING_FILE);
+        return;
+    }
+    if (!ftp_fname_to_str(start.fname, fname_str))
+    {
+        ftp_send_result(slate, FTP_ERROR);
+        return;
+    }
+
+    FTP_START_ERROR_DATA reply = {
+        .error.header = {.fname = start.fname,
+                         .file_len = start.file_len,
+                         .file_crc = start.file_crc,
+                         .result = FTP_ERROR_START_FILE_WRITE},
+        .error.filesys_error = FILESYS_ERR_NOT_ENOUGH_SPACE,
+        .error.lfs_error = LFS_ERR_OK,
+        .blocks_left = -1,
+    };
+    if (start.file_len > FTP_MAX_FILE_LEN)
+    {
+        ftp_send_reply(slate, &reply, sizeof(reply));
+        return;
+    }
+
+    lfs_ssize_t lfs_error;
+    lfs_ssize_t blocks_left = -1;
+    filesys_error_t error =
+        filesys_start_file_write(slate, fname_str, start.file_len,
+                                 start.file_crc, &lfs_error, &blocks_left);
+    if (error != FILESYS_OK)
+    {
+        reply.error.filesys_error = error;
+        reply.error.lfs_error = lfs_error;
+        reply.blocks_left = blocks_left;
+        ftp_send_reply(slate, &reply, sizeof(reply));
+        return;
+    }
+
+    slate->ftp_last_packet_time = get_absolute_time();
+    slate->ftp_last_report_time = slate->ftp_last_packet_time;
+
+    if (start.file_len == 0)
+    {
+        ftp_complete_file(slate);
+        return;
+    }
+    ftp_open_cycle(slate, 0);
+    ftp_send_cycle_status(slate, FTP_READY_RECEIVE);
+}
+
+static void ftp_write_to_file(slate_t *slate, const FTP_COMMAND_DATA *cmd)
+{
+    const size_t header_len = offsetof(FTP_WRITE_TO_FILE_DATA, data);
+    FTP_WRITE_TO_FILE_DATA write;
+    if (cmd->len < header_len || cmd->len > sizeof(write))
+    {
+        ftp_send_result(slate, FTP_ERROR);
+        return;
+    }
+    memcpy(&write, cmd->data, cmd->len);
+    uint32_t data_len = cmd->len - header_len;
+
+    if (!ftp_is_current_file(slate, write.fname))
+    {
+        ftp_send_result(slate, FTP_ERROR_NOT_WRITING_FILE);
+        return;
+    }
+    slate->ftp_last_packet_time = get_absolute_time();
+
+    uint32_t packet_id = write.packet_id;
+    if (packet_id < slate->ftp_packet_start ||
+        packet_id > slate->ftp_packet_end)
+    {
+        // Once is enough for the ground to move on to the current cycle
+        slate->ftp_packets_out_of_range++;
+        if (!slate->ftp_out_of_range_reported)
+            ftp_send_cycle_status(slate, FTP_ERROR_PACKET_OUT_OF_RANGE);
+        slate->ftp_out_of_range_reported = true;
+        return;
+    }
+    slate->ftp_out_of_range_reported = false;
+
+    uint32_t bit = packet_id - slate->ftp_packet_start;
+    if (ftp_is_received(slate, bit))
+    {
+        LOG_INFO("[ftp] Ignoring duplicate packet %u", packet_id);
+        slate->ftp_packets_duplicate++;
+    }
+    else
+    {
+        // A short packet would leave a hole in the file
+        lfs_ssize_t lfs_error = LFS_ERR_OK;
+        filesys_error_t error = FILESYS_ERR_EXCEED_BUFFER;
+        if (data_len == ftp_packet_len(slate, packet_id))
+            error = filesys_write_data_to_buffer(
+                slate, write.data, data_len, bit * FTP_DATA_PAYLOAD_SIZE,
+                &lfs_error);
+        if (error != FILESYS_OK)
+        {
+            ftp_send_filesys_error(slate, FTP_FILE_WRITE_BUFFER_ERROR, error,
+                                   lfs_error);
+            return;
+        }
+
+        slate->ftp_received_bitfield[bit / 8] |= 1 << (bit % 8);
+        slate->ftp_cycle_received++;
+        slate->ftp_packets_accepted++;
+    }
+
+    uint32_t cycle_len = slate->ftp_packet_end - slate->ftp_packet_start + 1;
+    if (slate->ftp_cycle_received == cycle_len)
+    {
+        ftp_finish_cycle(slate);
+        return;
+    }
+
+    // The ground sends what is missing in order, so with nothing missing past
+    // this packet it is done with the round and waiting to hear what is left
+    for (uint32_t i = bit + 1; i < cycle_len; i++)
+        if (!ftp_is_received(slate, i))
+            return;
+    ftp_send_status_report(slate);
+}
+
+static void ftp_cancel_file_write(slate_t *slate, const FTP_COMMAND_DATA *cmd)
+{
+    FTP_CANCEL_FILE_WRITE_DATA cancel;
+    if (cmd->len < sizeof(cancel))
+    {
+        ftp_send_result(slate, FTP_ERROR);
+        return;
+    }
+    memcpy(&cancel, cmd->data, sizeof(cancel));
+
+    if (slate->filesys_is_writing_file &&
+        !ftp_is_current_file(slate, cancel.fname))
+    {
+        ftp_send_result(slate, FTP_ERROR_NOT_WRITING_FILE);
+        return;
+    }
+
+    // Reply with the name of the file that was cancelled
+    FTP_FILESYS_ERROR_DATA reply;
+    ftp_fill_header(slate, &reply.header, FTP_CANCEL_SUCCESS);
+    lfs_ssize_t lfs_error;
+    filesys_error_t error = filesys_cancel_file_write(slate, &lfs_error);
+    if (error == FILESYS_OK)
+    {
+        ftp_send_reply(slate, &reply.header, sizeof(reply.header));
+        return;
+    }
+    reply.header.result = FTP_CANCEL_ERROR;
+    reply.filesys_error = error;
+    reply.lfs_error = lfs_error;
+    ftp_send_reply(slate, &reply, sizeof(reply));
+}
+
+static void ftp_start_file_read(slate_t *slate, const FTP_COMMAND_DATA *cmd)
+{
+    FTP_START_FILE_READ_DATA start;
+    FILESYS_BUFFERED_FNAME_STR_T fname_str;
+    if (cmd->len < sizeof(start))
+    {
+        ftp_send_result(slate, FTP_ERROR);
+        return;
+    }
+    memcpy(&start, cmd->data, sizeof(start));
+
+    if (slate->filesys_is_writing_file)
+    {
+        ftp_send_result(slate, FTP_ERROR_ALREADY_WRITING_FILE);
+        return;
+    }
+    if (!ftp_fname_to_str(start.received.fname, fname_str))
+    {
+        ftp_send_result(slate, FTP_ERROR);
+        return;
+    }
+
+    // Starting again replaces the read in progress, e.g. when the ground
+    // resumes on a new pass before it timed out
+    if (slate->ftp_is_reading_file)
+        ftp_close_read(slate);
+
+    // The whole file is checked against its CRC here, once
+    filesys_file_info_t info = {0};
+    lfs_ssize_t lfs_error;
+    filesys_error_t error = filesys_open_file_read(
+        slate, &ftp_read_file, fname_str, &info, &lfs_error);
+    if (error == FILESYS_OK && info.file_size > FTP_MAX_FILE_LEN)
+    {
+        // Packet numbers would run out
+        filesys_close_file_read(slate, &ftp_read_file, &lfs_error);
+        error = FILESYS_ERR_FILE_SIZE;
+        lfs_error = LFS_ERR_OK;
+    }
+    if (error != FILESYS_OK)
+    {
+        FTP_FILESYS_ERROR_DATA reply = {
+            .header = {.fname = start.received.fname,
+                       .file_len = info.file_size,
+                       .file_crc = info.computed_crc,
+                       .result = FTP_ERROR_START_FILE_READ},
+            .filesys_error = error,
+            .lfs_error = lfs_error,
+        };
+        ftp_send_reply(slate, &reply, sizeof(reply));
+        return;
+    }
+
+    slate->ftp_is_reading_file = true;
+    slate->ftp_read_fname = start.received.fname;
+    slate->ftp_read_file_len = info.file_size;
+    slate->ftp_read_file_crc = info.computed_crc;
+    slate->ftp_read_fec = (start.flags & FTP_READ_FEC) != 0;
+    slate->ftp_read_base = 0;
+    memset(slate->ftp_read_acked_bitfield, 0,
+           sizeof(slate->ftp_read_acked_bitfield));
+    slate->ftp_read_pos = 0;
+    slate->ftp_read_waiting = false;
+    slate->ftp_read_last_ack_time = get_absolute_time();
+
+    // Resume past what the ground already has
+    ftp_read_merge(slate, &start.received);
+    slate->ftp_read_next = slate->ftp_read_base;
+    slate->ftp_read_sent_end = slate->ftp_read_base;
+    ftp_send_read_status(slate, FTP_READY_SEND);
+
+    if (slate->ftp_read_base == ftp_read_num_packets(slate))
+    {
+        ftp_send_result(slate, FTP_FILE_READ_SUCCESS);
+        ftp_close_read(slate);
+    }
+}
+
+static void ftp_read_ack(slate_t *slate, const FTP_COMMAND_DATA *cmd)
+{
+    FTP_READ_ACK_DATA ack;
+    if (cmd->len < sizeof(ack))
+    {
+        ftp_send_result(slate, FTP_ERROR);
+        return;
+    }
+    memcpy(&ack, cmd->data, sizeof(ack));
+
+    if (!ftp_is_current_read(slate, ack.fname))
+    {
+        ftp_send_result(slate, FTP_ERROR_NOT_READING_FILE);
+        return;
+    }
+    slate->ftp_read_last_ack_time = get_absolute_time();
+
+    ftp_read_merge(slate, &ack);
+    if (slate->ftp_read_base == ftp_read_num_packets(slate))
+    {
+        LOG_INFO("[ftp] Sent file %.2s, %u bytes", (const char *)&ack.fname,
+                 slate->ftp_read_file_len);
+        ftp_send_result(slate, FTP_FILE_READ_SUCCESS);
+        ftp_close_read(slate);
+        return;
+    }
+
+    // The next round sends the gaps, then what the window newly took in. An
+    // acknowledgement in the middle of a round leaves it be.
+    if (slate->ftp_read_waiting)
+    {
+        slate->ftp_read_waiting = false;
+        slate->ftp_read_next = slate->ftp_read_base;
+    }
+    else if (slate->ftp_read_next < slate->ftp_read_base)
+    {
+        slate->ftp_read_next = slate->ftp_read_base;
+    }
+}
+
+static void ftp_cancel_file_read(slate_t *slate, const FTP_COMMAND_DATA *cmd)
+{
+    FTP_CANCEL_FILE_READ_DATA cancel;
+    if (cmd->len < sizeof(cancel))
+    {
+        ftp_send_result(slate, FTP_ERROR);
+        return;
+    }
+    memcpy(&cancel, cmd->data, sizeof(cancel));
+
+    if (!ftp_is_current_read(slate, cancel.fname))
+    {
+        ftp_send_result(slate, FTP_ERROR_NOT_READING_FILE);
+        return;
+    }
+    // Frames already queued still go out
+    ftp_send_result(slate, FTP_CANCEL_SUCCESS);
+    ftp_close_read(slate);
+}
+
+static void ftp_list_files(slate_t *slate, const FTP_COMMAND_DATA *cmd)
+{
+    FTP_LIST_FILES_DATA list;
+    if (cmd->len < sizeof(list))
+    {
+        ftp_send_result(slate, FTP_ERROR);
+        return;
+    }
+    memcpy(&list, cmd->data, sizeof(list));
+
+    // Listing opens each file, which would take the filesys cache from under
+    // the read
+    if (slate->ftp_is_reading_file)
+    {
+        ftp_send_result(slate, FTP_ERROR_ALREADY_READING_FILE);
+        return;
+    }
+
+    // 0 is the empty name, before every other
+    FILESYS_BUFFERED_FNAME_STR_T after;
+    memcpy(after, &list.after, sizeof(list.after));
+    after[sizeof(list.after)] = '\0';
+
+    filesys_file_info_t infos[FTP_LIST_PAGE_FILES];
+    uint16_t num_files;
+    bool more;
+    lfs_ssize_t lfs_error;
+    filesys_error_t error = filesys_list_files_page(
+        slate, after, infos, FTP_LIST_PAGE_FILES,
+        (list.flags & FTP_LIST_DEEP_VERIFY) != 0, &num_files, &more,
+        &lfs_error);
+    if (error != FILESYS_OK)
+    {
+        ftp_send_filesys_error(slate, FTP_ERROR_LIST_FILES, error, lfs_error);
+        return;
+    }
+
+    FTP_FILE_LIST_DATA reply;
+    ftp_fill_header(slate, &reply.header, FTP_FILE_LIST);
+    reply.num_files = num_files;
+    reply.more = more;
+    for (uint16_t i = 0; i < num_files; i++)
+    {
+        FTP_FILE_LIST_ENTRY *entry = &reply.files[i];
+        memcpy(&entry->fname, infos[i].fname, sizeof(entry->fname));
+        entry->file_len = infos[i].file_size;
+        entry->computed_crc = infos[i].computed_crc;
+        entry->expected_crc = infos[i].expected_crc;
+        entry->flags = infos[i].flags;
+    }
+    ftp_send_reply(slate, &reply,
+                   offsetof(FTP_FILE_LIST_DATA, files) +
+                       num_files * sizeof(reply.files[0]));
+}
+
+static void ftp_reformat(slate_t *slate)
+{
+    // The file would be gone from under the read
+    if (slate->ftp_is_reading_file)
+        ftp_close_read(slate);
+
+    lfs_ssize_t lfs_error;
+    filesys_error_t error = filesys_reformat_initialize(slate, &lfs_error);
+    slate->ftp_filesys_mounted = error == FILESYS_OK;
+    if (error != FILESYS_OK)
+    {
+        ftp_send_filesys_error(slate, FILESYS_REFORMAT_ERROR, error,
+                               lfs_error);
+        return;
+    }
+    ftp_send_result(slate, FILESYS_REFORMAT_SUCCESS);
+}
+
+static void ftp_handle_command(slate_t *slate, const FTP_COMMAND_DATA *cmd)
+{
+    // Reformatting is how the ground recovers from a filesystem that will
+    // not mount
+    if (cmd->command_type == FTP_REFORMAT)
+    {
+        ftp_reformat(slate);
+        return;
+    }
+    if (!ftp_ensure_mounted(slate))
+        return;
+
+    switch (cmd->command_type)
+    {
+        case FTP_START_FILE_WRITE:
+            ftp_start_file_write(slate, cmd);
+            break;
+        case FTP_WRITE_TO_FILE:
+            ftp_write_to_file(slate, cmd);
+            break;
+        case FTP_CANCEL_FILE_WRITE:
+            ftp_cancel_file_write(slate, cmd);
+            break;
+        case FTP_START_FILE_READ:
+            ftp_start_file_read(slate, cmd);
+            break;
+        case FTP_READ_ACK:
+            ftp_read_ack(slate, cmd);
+            break;
+        case FTP_CANCEL_FILE_READ:
+            ftp_cancel_file_read(slate, cmd);
+            break;
+        case FTP_LIST_FILES:
+            ftp_list_files(slate, cmd);
+            break;
+        default:
+            LOG_ERROR("[ftp] Unknown command %i", cmd->command_type);
+            break;
+    }
+}
+
+void ftp_task_init(slate_t *slate)
+{
+    slate->ftp_filesys_mounted = false;
+    slate->ftp_packets_accepted = 0;
+    slate->ftp_packets_duplicate = 0;
+    slate->ftp_packets_out_of_range = 0;
+    slate->ftp_queue_drops = 0;
+    slate->ftp_reply_drops = 0;
+    slate->ftp_is_reading_file = false;
+    slate->ftp_read_packets_sent = 0;
+    slate->ftp_read_packets_resent = 0;
+    slate->ftp_read_polls = 0;
+
+    // Runs before core1 is launched, which the MRAM and flash drivers handle
+    // (see xip_safe_execute). A failure is retried and reported in reply to
+    // the first command, when the ground is listening.
+    lfs_ssize_t lfs_error;
+    filesys_error_t error = filesys_initialize(slate, &lfs_error);
+    if (error == FILESYS_OK)
+        slate->ftp_filesys_mounted = true;
+    else
+        LOG_ERROR("[ftp] Filesystem did not mount: %d (lfs %d)", error,
+                  lfs_error);
+}
+
+void ftp_task_dispatch(slate_t *slate)
+{
+    neopixel_set_color_rgb(FTP_TASK_COLOR);
+
+    FTP_COMMAND_DATA cmd;
+    while (queue_try_remove(&slate->ftp_command_data, &cmd))
+        ftp_handle_command(slate, &cmd);
+
+    // Remind the ground where the file stands while the uplink is quiet
+    if (slate->ftp_filesys_mounted && slate->filesys_is_writing_file)
+    {
+        absolute_time_t now = get_absolute_time();
+        absolute_time_t last = slate->ftp_last_packet_time;
+        if (absolute_time_diff_us(last, slate->ftp_last_report_time) > 0)
+            last = slate->ftp_last_report_time;
+
+        if (absolute_time_diff_us(slate->ftp_last_packet_time, now) <
+                FTP_STATUS_REPORT_TIMEOUT_MS * 1000LL &&
+            absolute_time_diff_us(last, now) >=
+                FTP_STATUS_REPORT_INTERVAL_MS * 1000LL)
+            ftp_send_status_report(slate);
+    }
+
+    // Stream the file being read
+    if (slate->ftp_is_reading_file)
+        ftp_read_dispatch(slate);
+
+    neopixel_set_color_rgb(0, 0, 0);
+}
+
+sched_task_t ftp_task = {.name = "ftp",
+                         .dispatch_period_ms = 100,
+                         .priority = SCHED_PRIORITY_NORMAL,
+                         .task_init = &ftp_task_init,
+                         .task_dispatch = &ftp_task_dispatch,
+                         /* Run as soon as a command is queued */
+                         .wakeup = SCHED_WAKEUP_FTP_COMMAND,
+                         .next_dispatch = 0};
@@ -0,0 +1,259 @@
+/**
+ * @file ftp_task.h
+ *
+ * File transfer over the radio, as described in README.md.
+ *
+ * The ground starts a file write, then sends the file as numbered packets of
+ * FTP_DATA_PAYLOAD_SIZE bytes. Packets are accepted in any order within the
+ * current cycle of FTP_NUM_PACKETS_PER_CYCLE, and land directly in
+ * slate->filesys_buffer. When every packet of a cycle is in, the buffer is
+ * flushed to MRAM and the next cycle opens. After the last cycle the file is
+ * checked against the CRC32 given at the start, which filesys keeps up as
+ * each cycle is flushed rather than reading the file back.
+ *
+ * Data packets are not acknowledged one by one. Instead a status report
+ * carries a bitfield of the packets received so far in the cycle, so the
+ * ground can send the gaps again. It goes out as soon as the ground reaches
+ * the end of what was missing, or after the uplink has been quiet for
+ * FTP_STATUS_REPORT_INTERVAL_MS.
+ *
+ * Reads go the other way with selective repeat. The file is sent as the same
+ * numbered packets, as bulk traffic, in rounds over a window of
+ * FTP_READ_WINDOW packets the ground does not have yet. The last frame of a
+ * round asks for an acknowledgement, whose bitfield slides the window on; the
+ * next round sends the gaps and whatever the window has newly taken in. Only
+ * one file is open at a time, for reading or for writing. Starting a read
+ * again with what the ground already holds resumes it, e.g. on a later pass.
+ *
+ * The files on MRAM are listed a packet's worth at a time, in name order, each
+ * page starting after the last name of the one before. Their CRCs are the
+ * ones verified when they were written, unless the ground asks for a deep
+ * verify, so that a listing does not read the files through.
+ *
+ * All multi-byte fields are little endian.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "slate.h"
+#include "state_machine.h"
+#include "typedefs.h"
+
+// LED Color for ftp task - Turquoise
+#define FTP_TASK_COLOR 64, 224, 208
+
+// Uplink silence after which a status report is sent while writing a file
+#define FTP_STATUS_REPORT_INTERVAL_MS 5000
+
+// Reports stop this long after the last data packet, e.g. once the pass is
+// over, and resume with the next one
+#define FTP_STATUS_REPORT_TIMEOUT_MS 60000
+
+// Sent as the file name, length and CRC when no file is being written
+#define FTP_NO_FILE_FNAME (('X' << 8) | 'X')
+
+// Packet flags of the data frames of a read. FTP_FLAG_READ_POLL marks the
+// last frame of a round, which the ground answers with FTP_READ_ACK.
+#define FTP_FLAG_READ_DATA 0x04
+#define FTP_FLAG_READ_POLL 0x08
+
+// Packets a read sends before waiting to hear which arrived
+#define FTP_READ_WINDOW FTP_NUM_PACKETS_PER_CYCLE
+
+// Wait for an acknowledgement, from when the downlink queue runs dry, before
+// polling again. It covers the last frame on air and the reply.
+#define FTP_READ_ACK_TIMEOUT_MS 2500
+
+// A read is given up this long after the last acknowledgement, e.g. once the
+// pass is over. The ground resumes it with the next one.
+#define FTP_READ_TIMEOUT_MS 60000
+
+// FTP_START_FILE_READ_DATA.flags: send the data frames with FEC parity
+#define FTP_READ_FEC 0x01
+
+// FTP_LIST_FILES_DATA.flags: read every file of the page through to check its
+// CRC, rather than taking the one verified when it was written
+#define FTP_LIST_DEEP_VERIFY 0x01
+
+typedef enum
+{
+    FILESYS_REFORMAT_SUCCESS = 1,
+    FTP_READY_RECEIVE = 10,
+    FTP_FILE_WRITE_SUCCESS = 11,
+    FTP_EOF_SUCCESS = 20,
+    FTP_CANCEL_SUCCESS = 30,
+    FTP_STATUS_REPORT = 40,
+    FTP_READY_SEND = 60,
+    FTP_FILE_READ_SUCCESS = 61,
+    FTP_FILE_LIST = 70,
+
+    FILESYS_REFORMAT_ERROR = -1,
+    FILESYS_INIT_ERROR = -2,
+    FTP_FILE_WRITE_BUFFER_ERROR = -11,
+    FTP_FILE_WRITE_MRAM_ERROR = -12,
+    FTP_ERROR_PACKET_OUT_OF_RANGE = -13,
+    FTP_EOF_CRC_ERROR = -20,
+    FTP_CANCEL_ERROR = -30,
+    FTP_ERROR_START_FILE_WRITE = -50,
+    FTP_ERROR_ALREADY_WRITING_FILE = -51,
+    FTP_ERROR_NOT_WRITING_FILE = -52,
+    FTP_ERROR_START_FILE_READ = -60,
+    FTP_FILE_READ_MRAM_ERROR = -61,
+    FTP_ERROR_NOT_READING_FILE = -62,
+    FTP_ERROR_ALREADY_READING_FILE = -63,
+    FTP_ERROR_LIST_FILES = -70,
+    FTP_ERROR = -99,
+} FTP_Result;
+
+/*
+ * Ground -> SAMWISE, the data of each FTP command after the command ID
+ */
+
+typedef struct __attribute__((packed))
+{
+    FILESYS_BUFFERED_FNAME_T fname;
+    FILESYS_BUFFERED_FILE_LEN_T file_len;
+    FILESYS_BUFFERED_FILE_CRC_T file_crc;
+} FTP_START_FILE_WRITE_DATA;
+
+// Every packet but the last carries exactly FTP_DATA_PAYLOAD_SIZE bytes
+typedef struct __attribute__((packed))
+{
+    FILESYS_BUFFERED_FNAME_T fname;
+    FTP_PACKET_SEQUENCE_T packet_id;
+    uint8_t data[FTP_DATA_PAYLOAD_SIZE];
+} FTP_WRITE_TO_FILE_DATA;
+
+typedef struct __attribute__((packed))
+{
+    FILESYS_BUFFERED_FNAME_T fname;
+} FTP_CANCEL_FILE_WRITE_DATA;
+
+// Also what the ground holds when it starts or resumes a read
+typedef struct __attribute__((packed))
+{
+    FILESYS_BUFFERED_FNAME_T fname;
+    FTP_PACKET_SEQUENCE_T packet_start; // Every packet before it is received
+    uint8_t received_bitfield[FTP_BITFIELD_SIZE]; // Bit i: packet_start + i
+} FTP_READ_ACK_DATA;
+
+typedef struct __attribute__((packed))
+{
+    FTP_READ_ACK_DATA received; // All zero for a new read
+    uint8_t flags;              // FTP_READ_*
+} FTP_START_FILE_READ_DATA;
+
+typedef struct __attribute__((packed))
+{
+    FILESYS_BUFFERED_FNAME_T fname;
+} FTP_CANCEL_FILE_READ_DATA;
+
+typedef struct __attribute__((packed))
+{
+    FILESYS_BUFFERED_FNAME_T after; // Last name of the page before, 0 for none
+    uint8_t flags;                  // FTP_LIST_*
+} FTP_LIST_FILES_DATA;
+
+/*
+ * SAMWISE -> Ground. Every reply starts with FTP_RESULT_HEADER, which alone
+ * makes up FILESYS_REFORMAT_SUCCESS, FTP_CANCEL_SUCCESS,
+ * FTP_FILE_READ_SUCCESS, FTP_ERROR_ALREADY_WRITING_FILE,
+ * FTP_ERROR_NOT_WRITING_FILE, FTP_ERROR_NOT_READING_FILE,
+ * FTP_ERROR_ALREADY_READING_FILE and FTP_ERROR. The file named is the one
+ * being written or read.
+ */
+
+typedef struct __attribute__((packed))
+{
+    // A write's length and CRC are as given on start, a read's as on MRAM
+    FILESYS_BUFFERED_FNAME_T fname;       // FTP_NO_FILE_FNAME when idle
+    FILESYS_BUFFERED_FILE_LEN_T file_len; // 0 when idle
+    FILESYS_BUFFERED_FILE_CRC_T file_crc; // 0 when idle
+    int32_t result;                       // FTP_Result
+} FTP_RESULT_HEADER;
+
+// FTP_READY_RECEIVE, FTP_FILE_WRITE_SUCCESS, FTP_ERROR_PACKET_OUT_OF_RANGE,
+// and FTP_READY_SEND with the first window of a read
+typedef struct __attribute__((packed))
+{
+    FTP_RESULT_HEADER header;
+    FTP_PACKET_SEQUENCE_T packet_start; // Inclusive
+    FTP_PACKET_SEQUENCE_T packet_end;   // Inclusive
+    uint8_t received_bitfield[FTP_BITFIELD_SIZE]; // Bit i: packet_start + i
+} FTP_CYCLE_STATUS_DATA;
+
+typedef struct __attribute__((packed))
+{
+    FTP_CYCLE_STATUS_DATA cycle;
+    uint32_t file_crc_so_far;    // Of the bytes on MRAM, 0 if there are none
+    uint32_t total_bytes_written; // To MRAM
+    uint8_t filesys_buffer_malloced;
+    uint8_t filesys_is_writing_file;
+} FTP_STATUS_REPORT_DATA;
+
+// FTP_EOF_SUCCESS, FTP_EOF_CRC_ERROR
+typedef struct __attribute__((packed))
+{
+    FTP_RESULT_HEADER header;
+    uint32_t computed_crc;
+    uint32_t file_len_on_disk;
+} FTP_EOF_DATA;
+
+// FILESYS_INIT_ERROR, FILESYS_REFORMAT_ERROR, FTP_FILE_WRITE_BUFFER_ERROR,
+// FTP_FILE_WRITE_MRAM_ERROR, FTP_CANCEL_ERROR, FTP_ERROR_START_FILE_READ,
+// FTP_FILE_READ_MRAM_ERROR, FTP_ERROR_LIST_FILES
+typedef struct __attribute__((packed))
+{
+    FTP_RESULT_HEADER header;
+    int32_t filesys_error;
+    int32_t lfs_error; // LFS_ERR_OK if the error was filesys' own
+} FTP_FILESYS_ERROR_DATA;
+
+// FTP_ERROR_START_FILE_WRITE
+typedef struct __attribute__((packed))
+{
+    FTP_FILESYS_ERROR_DATA error;
+    int32_t blocks_left; // -1 if it was never computed
+} FTP_START_ERROR_DATA;
+
+// A data frame of a read, flagged FTP_FLAG_READ_DATA. Every packet but the
+// last carries exactly FTP_DATA_PAYLOAD_SIZE bytes.
+typedef struct __attribute__((packed))
+{
+    FILESYS_BUFFERED_FNAME_T fname;
+    FTP_PACKET_SEQUENCE_T packet_id;
+    uint8_t data[FTP_DATA_PAYLOAD_SIZE];
+} FTP_READ_DATA;
+
+// A file of FTP_FILE_LIST, as filesys_list_files gives it
+typedef struct __attribute__((packed))
+{
+    FILESYS_BUFFERED_FNAME_T fname;
+    FILESYS_BUFFERED_FILE_LEN_T file_len;     // On MRAM
+    FILESYS_BUFFERED_FILE_CRC_T computed_crc; // Of the file on MRAM
+    FILESYS_BUFFERED_FILE_CRC_T expected_crc; // As given on upload
+    uint8_t flags;                            // FILESYS_FILE_INFO_*
+} FTP_FILE_LIST_ENTRY;
+
+// Files that fit in one FTP_FILE_LIST
+#define FTP_LIST_PAGE_FILES                                                    \
+    ((PACKET_DATA_SIZE - sizeof(FTP_RESULT_HEADER) - 2 * sizeof(uint8_t)) /    \
+     sizeof(FTP_FILE_LIST_ENTRY))
+
+// FTP_FILE_LIST, cut short after num_files entries
+typedef struct __attribute__((packed))
+{
+    FTP_RESULT_HEADER header;
+    uint8_t num_files;
+    uint8_t more; // Files remain after the last one; list again after it
+    FTP_FILE_LIST_ENTRY files[FTP_LIST_PAGE_FILES];
+} FTP_FILE_LIST_DATA;
+
+void ftp_task_init(slate_t *slate);
+void ftp_task_dispatch(slate_t *slate);
+
+extern sched_task_t ftp_task;
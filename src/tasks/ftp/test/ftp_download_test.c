@@ -0,0 +1,439 @@
+#include "command_parser.h"
+#include "command_task.h"
+#include "crc32.h"
+#include "error.h"
+#include "filesys.h"
+#include "ftp_task.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include "radio_task.h"
+#include "rfm9x_channel.h"
+#include "test_scheduler_helpers.h"
+#include <stdio.h>
+
+/**
+ * End-to-end download test: the radio, command and FTP tasks on an emulated
+ * channel, with a ground station stand-in that reads a file off MRAM. The
+ * ground acknowledges each round when it hears the poll, or once the downlink
+ * has gone quiet if the poll was lost. Reports goodput as a share of what the
+ * downlink could carry, for a clear and a lossy channel, and for a lossy one
+ * where the pass ends halfway and the next pass resumes. Every run is
+ * deterministic.
+ */
+
+#define FILE_LEN 30000
+#define FILE_PACKETS                                                           \
+    ((FILE_LEN + FTP_DATA_PAYLOAD_SIZE - 1) / FTP_DATA_PAYLOAD_SIZE)
+
+#define SIM_TIMEOUT_MS 900000
+
+// The ground only keys up after this long without hearing a frame
+#define GROUND_QUIET_US 5000
+
+// With data heard but no poll, the ground acknowledges after this much quiet
+#define GROUND_ACK_QUIET_MS 1000
+
+// After a start or an acknowledgement the ground waits this long to hear
+// anything before sending it again
+#define GROUND_REPLY_TIMEOUT_MS 3000
+
+// Longer than FTP_READ_TIMEOUT_MS, so the satellite gives the read up
+#define PASS_GAP_MS 90000
+
+slate_t test_slate;
+
+typedef struct
+{
+    const char *name;
+    rfm9x_channel_config_t channel;
+    bool pass_break; // Halfway through the file
+} scenario_t;
+
+typedef struct
+{
+    bool done;
+    double goodput_bps;
+    uint32_t acks;
+    uint32_t duplicates; // Frames of packets the ground already had
+    uint32_t resumed_duplicates;
+} result_t;
+
+typedef enum
+{
+    GROUND_START,   // Start, or resume, the read
+    GROUND_RECEIVE, // Data, and acknowledge it
+    GROUND_BREAK,   // Between passes
+    GROUND_DONE,
+} ground_phase_t;
+
+static uint8_t file[FILE_LEN];
+
+static struct
+{
+    rfm9x_t radio;
+    const scenario_t *sc;
+    ground_phase_t phase;
+    bool transmitting;
+    bool received[FILE_PACKETS];
+    uint32_t num_received;
+    uint8_t data[FILE_LEN];
+    bool ack_due;    // A poll was heard
+    bool heard_data; // Since the last start or acknowledgement
+    bool resumed;
+    uint64_t last_data_us;
+    uint64_t sent_us; // Last start or acknowledgement
+    uint64_t last_heard_us;
+    uint64_t break_until_us;
+    uint64_t start_us;
+    result_t *res;
+} ground;
+
+// Carries over between runs, as the satellite's replay window does
+static uint32_t ground_msg_id;
+
+#ifdef PACKET_HMAC_PSK
+static packet_hmac_key_t ground_key;
+#endif
+
+static void ground_tx_done(void)
+{
+    ground.transmitting = false;
+    rfm9x_listen(&ground.radio);
+}
+
+static void ground_finish(void)
+{
+    ground.phase = GROUND_DONE;
+    ground.res->done = true;
+    ground.res->goodput_bps =
+        FILE_LEN * 8.0 * 1e6 / (mock_time_us - ground.start_us);
+}
+
+static void ground_data(const packet_t *p)
+{
+    const FTP_READ_DATA *frame = (const FTP_READ_DATA *)p->data;
+    uint32_t id = frame->packet_id;
+    if (id >= FILE_PACKETS)
+        return;
+
+    if (ground.received[id])
+    {
+        ground.res->duplicates++;
+        if (ground.resumed)
+            ground.res->resumed_duplicates++;
+    }
+    else
+    {
+        memcpy(&ground.data[id * FTP_DATA_PAYLOAD_SIZE], frame->data,
+               p->len - offsetof(FTP_READ_DATA, data));
+        ground.received[id] = true;
+        ground.num_received++;
+    }
+    ground.phase = GROUND_RECEIVE;
+    ground.heard_data = true;
+    ground.last_data_us = mock_time_us;
+    if (p->flags & FTP_FLAG_READ_POLL)
+        ground.ack_due = true;
+
+    // The pass ends
+    if (ground.sc->pass_break && !ground.resumed &&
+        ground.num_received >= FILE_PACKETS / 2)
+    {
+        ground.phase = GROUND_BREAK;
+        ground.break_until_us = mock_time_us + PASS_GAP_MS * 1000ULL;
+        ground.start_us += PASS_GAP_MS * 1000ULL;
+        ground.resumed = true;
+    }
+}
+
+static void ground_rx_done(void)
+{
+    uint8_t buf[256];
+    uint8_t n = rfm9x_packet_from_fifo(&ground.radio, buf);
+    packet_t *p = (packet_t *)buf;
+    if (ground.phase == GROUND_BREAK || ground.phase == GROUND_DONE)
+        return;
+    ground.last_heard_us = mock_time_us;
+    if (n < PACKET_HEADER_SIZE || n < PACKET_HEADER_SIZE + p->len)
+        return;
+
+    if (p->flags & FTP_FLAG_READ_DATA)
+    {
+        ground_data(p);
+        return;
+    }
+    if (p->flags != 0 || p->len < sizeof(FTP_RESULT_HEADER))
+        return;
+
+    const FTP_RESULT_HEADER *header = (const FTP_RESULT_HEADER *)p->data;
+    switch (header->result)
+    {
+        case FTP_READY_SEND:
+            ground.phase = GROUND_RECEIVE;
+            break;
+
+        case FTP_FILE_READ_SUCCESS:
+            ground_finish();
+            break;
+
+        case FTP_ERROR_NOT_READING_FILE:
+            // The satellite closed the read, or gave it up
+            if (ground.num_received == FILE_PACKETS)
+                ground_finish();
+            else
+                ground.phase = GROUND_START;
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void ground_send(Command command, const void *data, size_t len)
+{
+    packet_t p = {.dst = test_slate.radio_node,
+                  .len = 1 + len,
+                  .boot_count = test_slate.reboot_counter,
+                  .msg_id = ++ground_msg_id};
+    p.data[0] = command;
+    memcpy(&p.data[1], data, len);
+#ifdef PACKET_HMAC_PSK
+    packet_compute_hmac(&ground_key, &p, p.hmac);
+#endif
+    uint8_t buf[PACKET_SIZE];
+    size_t n = encode_packet(&p, buf, sizeof(buf), true);
+
+    rfm9x_packet_to_fifo(&ground.radio, buf, n);
+    rfm9x_transmit(&ground.radio);
+    ground.transmitting = true;
+    ground.sent_us = mock_time_us;
+    ground.ack_due = false;
+    ground.heard_data = false;
+}
+
+// What the ground holds, from the first packet it lacks
+static void ground_fill_ack(FTP_READ_ACK_DATA *ack)
+{
+    memset(ack, 0, sizeof(*ack));
+    ack->fname = 'D' | 'L' << 8;
+    uint32_t start = 0;
+    while (start < FILE_PACKETS && ground.received[start])
+        start++;
+    ack->packet_start = start;
+    for (uint32_t i = 0; i < FTP_READ_WINDOW && start + i < FILE_PACKETS; i++)
+        if (ground.received[start + i])
+            ack->received_bitfield[i / 8] |= 1 << (i % 8);
+}
+
+// When the ground next has something to do
+static uint64_t ground_next_us(void)
+{
+    if (ground.phase == GROUND_DONE || ground.transmitting)
+        return UINT64_MAX;
+    if (ground.phase == GROUND_BREAK)
+        return ground.break_until_us;
+
+    uint64_t t = ground.sent_us + GROUND_REPLY_TIMEOUT_MS * 1000ULL;
+    if (ground.phase == GROUND_START && ground.sent_us == 0)
+        t = 0;
+    if (ground.ack_due)
+        t = 0;
+    else if (ground.heard_data)
+        t = ground.last_data_us + GROUND_ACK_QUIET_MS * 1000ULL;
+
+    uint64_t quiet_us = ground.last_heard_us + GROUND_QUIET_US;
+    return t > quiet_us ? t : quiet_us;
+}
+
+static void ground_step(void)
+{
+    if (ground.transmitting || mock_time_us < ground_next_us())
+        return;
+
+    switch (ground.phase)
+    {
+        case GROUND_BREAK:
+            ground.phase = GROUND_START;
+            ground.sent_us = 0;
+            ground.last_heard_us = mock_time_us;
+            break;
+
+        case GROUND_START:
+        {
+            FTP_START_FILE_READ_DATA start = {0};
+            ground_fill_ack(&start.received);
+            ground_send(FTP_START_FILE_READ, &start, sizeof(start));
+            break;
+        }
+
+        case GROUND_RECEIVE:
+        {
+            FTP_READ_ACK_DATA ack;
+            ground_fill_ack(&ack);
+            ground_send(FTP_READ_ACK, &ack, sizeof(ack));
+            ground.res->acks++;
+            break;
+        }
+
+        case GROUND_DONE:
+            break;
+    }
+}
+
+static uint64_t min_us(uint64_t a, uint64_t b)
+{
+    return a < b ? a : b;
+}
+
+// Put the file on MRAM the way the uplink would
+static void store_file(void)
+{
+    lfs_ssize_t lfs_error;
+    lfs_ssize_t blocks_left;
+    ASSERT(filesys_reformat_initialize(&test_slate, &lfs_error) == FILESYS_OK);
+    test_slate.ftp_filesys_mounted = true;
+    ASSERT(filesys_start_file_write(&test_slate, "DL", FILE_LEN,
+                                    crc32(file, FILE_LEN), &lfs_error,
+                                    &blocks_left) == FILESYS_OK);
+    for (uint32_t offset = 0; offset < FILE_LEN; offset += FILESYS_BUFFER_SIZE)
+    {
+        uint32_t n = FILE_LEN - offset < FILESYS_BUFFER_SIZE
+                         ? FILE_LEN - offset
+                         : FILESYS_BUFFER_SIZE;
+        ASSERT(filesys_write_data_to_buffer(&test_slate, &file[offset], n, 0,
+                                            &lfs_error) == FILESYS_OK);
+        ASSERT(filesys_write_buffer_to_mram(&test_slate, n, &lfs_error) ==
+               FILESYS_OK);
+    }
+    ASSERT(filesys_complete_file_write(&test_slate, &lfs_error) ==
+           FILESYS_OK);
+}
+
+static void run(const scenario_t *sc, result_t *res)
+{
+    memset(res, 0, sizeof(*res));
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    rfm9x_channel_init(&sc->channel);
+    rfm9x_channel_attach(&test_slate.radio, true);
+    rfm9x_channel_attach(&ground.radio, true);
+    radio_task_init(&test_slate);
+    command_task_init(&test_slate);
+    ftp_task_init(&test_slate);
+    store_file();
+
+    memset(&ground, 0, sizeof(ground));
+    ground_msg_id += PACKET_REPLAY_RESERVE;
+    ground.sc = sc;
+    ground.res = res;
+    ground.radio.modem = test_slate.radio.modem;
+    ground.phase = GROUND_START;
+    ground.last_heard_us = mock_time_us;
+    ground.start_us = mock_time_us;
+    rfm9x_set_tx_irq(&ground.radio, &ground_tx_done);
+    rfm9x_set_rx_irq(&ground.radio, &ground_rx_done);
+    rfm9x_listen(&ground.radio);
+
+    uint64_t end_us = mock_time_us + SIM_TIMEOUT_MS * 1000ULL;
+    uint64_t next_radio_us = mock_time_us;
+    uint64_t next_command_us = mock_time_us;
+    uint64_t next_ftp_us = mock_time_us;
+    while (mock_time_us < end_us && ground.phase != GROUND_DONE)
+    {
+        uint64_t t = min_us(end_us, rfm9x_channel_next_event_us());
+        t = min_us(t, min_us(next_radio_us, next_command_us));
+        t = min_us(t, min_us(next_ftp_us, ground_next_us()));
+        rfm9x_channel_run_until(t);
+
+        // Stand in for the scheduler: the command task wakes on RX and the
+        // FTP task on a queued command
+        if (mock_time_us >= next_command_us ||
+            !queue_is_empty(&test_slate.rx_queue))
+        {
+            command_task_dispatch(&test_slate);
+            next_command_us =
+                mock_time_us + command_task.dispatch_period_ms * 1000ULL;
+        }
+        if (mock_time_us >= next_ftp_us ||
+            !queue_is_empty(&test_slate.ftp_command_data))
+        {
+            ftp_task_dispatch(&test_slate);
+            next_ftp_us = mock_time_us + ftp_task.dispatch_period_ms * 1000ULL;
+        }
+        if (mock_time_us >= next_radio_us)
+        {
+            radio_task_dispatch(&test_slate);
+            next_radio_us += radio_task.dispatch_period_ms * 1000ULL;
+        }
+        ground_step();
+    }
+
+    const rfm9x_channel_stats_t *s = rfm9x_channel_stats(&ground.radio);
+    printf("%-8s %4s %9.0f %6u %6u %6u %6u %6u   %u/%u/%u/%u\n", sc->name,
+           res->done ? "yes" : "no", res->goodput_bps,
+           test_slate.ftp_read_packets_sent, test_slate.ftp_read_packets_resent,
+           res->acks, test_slate.ftp_read_polls, res->duplicates, s->lost,
+           s->corrupted, s->collisions, s->missed);
+    ASSERT(memcmp(ground.data, file, FILE_LEN) == 0);
+    ASSERT(!test_slate.ftp_is_reading_file);
+    ASSERT(test_slate.ftp_queue_drops == 0);
+    ASSERT(test_slate.ftp_reply_drops == 0);
+
+    free_slate(&test_slate);
+}
+
+int main()
+{
+    printf("Starting FTP download test\n");
+    logger_mock_echo = false;
+#ifdef PACKET_HMAC_PSK
+    packet_hmac_key_init(&ground_key, (const uint8_t *)PACKET_HMAC_PSK,
+                         PACKET_HMAC_PSK_LEN);
+#endif
+    for (size_t i = 0; i < sizeof(file); i++)
+        file[i] = i * 11 + (i >> 10);
+
+    const rfm9x_channel_config_t clear = {.latency_us = 5000,
+                                          .turnaround_us = 1000,
+                                          .rssi_dbm = -100,
+                                          .snr_q4 = 0,
+                                          .seed = 1};
+    rfm9x_channel_config_t lossy = clear;
+    lossy.loss = 0.1;
+
+    const scenario_t scenarios[] = {
+        {"clear", clear, false},
+        {"lossy", lossy, false},
+        {"resume", lossy, true},
+    };
+    result_t res[sizeof(scenarios) / sizeof(scenarios[0])];
+
+    printf("\n%-8s %4s %9s %6s %6s %6s %6s %6s   %s\n", "channel", "done",
+           "goodput", "sent", "resent", "acks", "polls", "dups",
+           "ground lost/corrupt/collided/missed");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+        run(&scenarios[i], &res[i]);
+
+    // What the downlink could carry if it did nothing but send file data
+    packet_t full = {.len = sizeof(FTP_READ_DATA)};
+    uint8_t buf[PACKET_SIZE];
+    uint32_t frame_us = rfm9x_airtime_us(
+        &test_slate.radio.modem, encode_packet(&full, buf, sizeof(buf), false));
+    double max_bps = FTP_DATA_PAYLOAD_SIZE * 8.0 * 1e6 / frame_us;
+    printf("downlink capacity %.0f bps\n", max_bps);
+
+    for (size_t i = 0; i < sizeof(res) / sizeof(res[0]); i++)
+        ASSERT(res[i].done);
+
+    // One round trip per window is all that is lost
+    ASSERT(res[0].duplicates == 0);
+    ASSERT(res[0].goodput_bps > 0.9 * max_bps);
+
+    // Lost packets cost one more frame each, and a lost poll the quiet wait
+    ASSERT(res[1].goodput_bps > 0.75 * max_bps);
+
+    // The next pass picks up from what the ground holds. Only packets sent
+    // while the pass was ending, past the bitfield, can come down twice.
+    ASSERT(res[2].resumed_duplicates <= FTP_READ_WINDOW);
+    ASSERT(res[2].goodput_bps > 0.7 * max_bps);
+    return 0;
+}
@@ -0,0 +1,572 @@
+#include "ftp_task.h"
+#include "command_parser.h"
+#include "command_task.h"
+#include "crc32.h"
+#include "error.h"
+#include "filesys.h"
+#include "logger.h"
+#include "packet_fec.h"
+#include "pico/stdlib.h"
+#include "radio_task.h"
+#include "test_scheduler_helpers.h"
+#include <stdio.h>
+
+slate_t test_slate;
+
+/**
+ * Tests for the FTP task, fed through dispatch_command. Each command gets at
+ * most one reply, which is taken off the downlink queue and checked. The data
+ * frames of a read are taken off first.
+ */
+
+#define FNAME(a, b) ((FILESYS_BUFFERED_FNAME_T)((a) | ((b) << 8)))
+
+// Three cycles, the last of them short and ending in a short packet
+#define FILE_PACKETS (2 * FTP_NUM_PACKETS_PER_CYCLE + 7)
+#define FILE_LEN ((FILE_PACKETS - 1) * FTP_DATA_PAYLOAD_SIZE + 100)
+
+static uint8_t file[FILE_LEN];
+static uint8_t reply[PACKET_DATA_SIZE];
+
+static void send(Command command, const void *data, size_t len)
+{
+    packet_t p = {.len = 1 + len};
+    p.data[0] = command;
+    memcpy(&p.data[1], data, len);
+    dispatch_command(&test_slate, &p);
+    ftp_task_dispatch(&test_slate);
+}
+
+static void send_start(FILESYS_BUFFERED_FNAME_T fname, uint32_t len,
+                       uint32_t crc)
+{
+    FTP_START_FILE_WRITE_DATA start = {fname, len, crc};
+    send(FTP_START_FILE_WRITE, &start, sizeof(start));
+}
+
+static void send_data(FILESYS_BUFFERED_FNAME_T fname, uint16_t packet_id,
+                      const uint8_t *data, size_t len)
+{
+    FTP_WRITE_TO_FILE_DATA write = {.fname = fname, .packet_id = packet_id};
+    memcpy(write.data, data, len);
+    send(FTP_WRITE_TO_FILE, &write,
+         offsetof(FTP_WRITE_TO_FILE_DATA, data) + len);
+}
+
+static void send_packet(uint16_t packet_id)
+{
+    size_t offset = packet_id * FTP_DATA_PAYLOAD_SIZE;
+    size_t len = FILE_LEN - offset < FTP_DATA_PAYLOAD_SIZE
+                     ? FILE_LEN - offset
+                     : FTP_DATA_PAYLOAD_SIZE;
+    send_data(FNAME('A', 'B'), packet_id, &file[offset], len);
+}
+
+static void send_cancel(FILESYS_BUFFERED_FNAME_T fname)
+{
+    FTP_CANCEL_FILE_WRITE_DATA cancel = {fname};
+    send(FTP_CANCEL_FILE_WRITE, &cancel, sizeof(cancel));
+}
+
+static void set_bits(uint8_t bitfield[FTP_BITFIELD_SIZE], uint32_t bits)
+{
+    for (int i = 0; i < FTP_BITFIELD_SIZE; i++)
+        bitfield[i] = bits >> (8 * i);
+}
+
+static void send_read_start(uint16_t packet_start, uint32_t received,
+                            uint8_t flags)
+{
+    FTP_START_FILE_READ_DATA start = {
+        .received = {.fname = FNAME('A', 'B'), .packet_start = packet_start},
+        .flags = flags};
+    set_bits(start.received.received_bitfield, received);
+    send(FTP_START_FILE_READ, &start, sizeof(start));
+}
+
+static void send_ack(uint16_t packet_start, uint32_t received)
+{
+    FTP_READ_ACK_DATA ack = {.fname = FNAME('A', 'B'),
+                             .packet_start = packet_start};
+    set_bits(ack.received_bitfield, received);
+    send(FTP_READ_ACK, &ack, sizeof(ack));
+}
+
+// Data frames taken by take_data, by packet
+static int frames[FILE_PACKETS];
+static int polls;
+static int poll_id;
+static uint8_t frame_flags;
+
+// Takes every data frame off the downlink, letting the task top the queue up
+// as it goes, and checks each against the file. Returns how many there were.
+static int take_data(void)
+{
+    memset(frames, 0, sizeof(frames));
+    polls = 0;
+    poll_id = -1;
+    frame_flags = 0;
+
+    int n = 0;
+    packet_handle_t h;
+    while (queue_try_remove(&test_slate.tx_sched.queues[TX_CLASS_BULK], &h))
+    {
+        packet_t *p = packet_pool_get(&test_slate.packet_pool, h);
+        FTP_READ_DATA *data = (FTP_READ_DATA *)p->data;
+        ASSERT(p->flags & FTP_FLAG_READ_DATA);
+        ASSERT(data->fname == FNAME('A', 'B'));
+        ASSERT(data->packet_id < FILE_PACKETS);
+        size_t offset = data->packet_id * FTP_DATA_PAYLOAD_SIZE;
+        size_t len = FILE_LEN - offset < FTP_DATA_PAYLOAD_SIZE
+                         ? FILE_LEN - offset
+                         : FTP_DATA_PAYLOAD_SIZE;
+        ASSERT(p->len == offsetof(FTP_READ_DATA, data) + len);
+        ASSERT(memcmp(data->data, &file[offset], len) == 0);
+
+        frames[data->packet_id]++;
+        if (p->flags & FTP_FLAG_READ_POLL)
+        {
+            polls++;
+            poll_id = data->packet_id;
+        }
+        frame_flags |= p->flags;
+        packet_pool_free(&test_slate.packet_pool, h);
+        n++;
+
+        if (queue_is_empty(&test_slate.tx_sched.queues[TX_CLASS_BULK]))
+            ftp_task_dispatch(&test_slate);
+    }
+    return n;
+}
+
+// Whether take_data saw each of packets [start, end) exactly once, and none
+// of the others
+static bool took(int start, int end)
+{
+    for (int i = 0; i < FILE_PACKETS; i++)
+        if (frames[i] != (i >= start && i < end))
+            return false;
+    return true;
+}
+
+// Takes the one reply off the downlink, or returns 0 if there is none
+static size_t take_reply(void)
+{
+    packet_handle_t h;
+    if (!queue_try_remove(&test_slate.tx_sched.queues[TX_CLASS_COMMAND], &h))
+        return 0;
+    packet_t *p = packet_pool_get(&test_slate.packet_pool, h);
+    size_t len = p->len;
+    memcpy(reply, p->data, len);
+    packet_pool_free(&test_slate.packet_pool, h);
+    ASSERT(tx_sched_is_empty(&test_slate.tx_sched));
+    return len;
+}
+
+static FTP_RESULT_HEADER *expect_reply(FTP_Result result, size_t len)
+{
+    ASSERT(take_reply() == len);
+    FTP_RESULT_HEADER *header = (FTP_RESULT_HEADER *)reply;
+    ASSERT(header->result == result);
+    return header;
+}
+
+static FTP_CYCLE_STATUS_DATA *expect_cycle(FTP_Result result,
+                                           uint16_t packet_start,
+                                           uint16_t packet_end)
+{
+    FTP_CYCLE_STATUS_DATA *status = (FTP_CYCLE_STATUS_DATA *)expect_reply(
+        result, sizeof(FTP_CYCLE_STATUS_DATA));
+    ASSERT(status->header.fname == FNAME('A', 'B'));
+    ASSERT(status->header.file_len == FILE_LEN);
+    ASSERT(status->packet_start == packet_start);
+    ASSERT(status->packet_end == packet_end);
+    return status;
+}
+
+void test_mount()
+{
+    printf("Starting mount test\n");
+
+    // The mock flash starts out unformatted
+    ASSERT(!test_slate.ftp_filesys_mounted);
+    send_start(FNAME('A', 'B'), FILE_LEN, crc32(file, FILE_LEN));
+    FTP_FILESYS_ERROR_DATA *error = (FTP_FILESYS_ERROR_DATA *)expect_reply(
+        FILESYS_INIT_ERROR, sizeof(FTP_FILESYS_ERROR_DATA));
+    ASSERT(error->header.fname == FTP_NO_FILE_FNAME);
+    ASSERT(error->filesys_error == FILESYS_ERR_MOUNT);
+    ASSERT(error->lfs_error < 0);
+
+    send(FTP_REFORMAT, NULL, 0);
+    expect_reply(FILESYS_REFORMAT_SUCCESS, sizeof(FTP_RESULT_HEADER));
+    ASSERT(test_slate.ftp_filesys_mounted);
+}
+
+void test_start()
+{
+    printf("Starting start test\n");
+
+    // Truncated, and names LFS cannot store
+    send(FTP_START_FILE_WRITE, "AB", 2);
+    expect_reply(FTP_ERROR, sizeof(FTP_RESULT_HEADER));
+    send_start(FNAME('A', 0), FILE_LEN, 0);
+    expect_reply(FTP_ERROR, sizeof(FTP_RESULT_HEADER));
+
+    send_start(FNAME('A', 'B'), FTP_MAX_FILE_LEN + 1, 0);
+    FTP_START_ERROR_DATA *error = (FTP_START_ERROR_DATA *)expect_reply(
+        FTP_ERROR_START_FILE_WRITE, sizeof(FTP_START_ERROR_DATA));
+    ASSERT(error->error.header.file_len == FTP_MAX_FILE_LEN + 1);
+    ASSERT(error->error.filesys_error == FILESYS_ERR_NOT_ENOUGH_SPACE);
+    ASSERT(error->blocks_left == -1);
+
+    send_start(FNAME('A', 'B'), FILE_LEN, crc32(file, FILE_LEN));
+    FTP_CYCLE_STATUS_DATA *status =
+        expect_cycle(FTP_READY_RECEIVE, 0, FTP_NUM_PACKETS_PER_CYCLE - 1);
+    for (int i = 0; i < FTP_BITFIELD_SIZE; i++)
+        ASSERT(status->received_bitfield[i] == 0);
+
+    send_start(FNAME('C', 'D'), 10, 0);
+    FTP_RESULT_HEADER *header =
+        expect_reply(FTP_ERROR_ALREADY_WRITING_FILE, sizeof(*header));
+    ASSERT(header->fname == FNAME('A', 'B'));
+}
+
+void test_first_cycle()
+{
+    printf("Starting first cycle test\n");
+    const uint32_t last = FTP_NUM_PACKETS_PER_CYCLE - 1;
+
+    // Nothing to say while later packets are still missing
+    for (uint32_t i = 0; i < last - 1; i++)
+        send_packet(i);
+    ASSERT(take_reply() == 0);
+    ASSERT(test_slate.ftp_packets_accepted == last - 1);
+
+    send_packet(5);
+    ASSERT(take_reply() == 0);
+    ASSERT(test_slate.ftp_packets_duplicate == 1);
+
+    // The next cycle is not open yet. One reply is enough.
+    send_packet(last + 1);
+    expect_cycle(FTP_ERROR_PACKET_OUT_OF_RANGE, 0, last);
+    send_packet(last + 2);
+    ASSERT(take_reply() == 0);
+    ASSERT(test_slate.ftp_packets_out_of_range == 2);
+
+    // Another file, and a short packet that would leave a gap
+    send_data(FNAME('C', 'D'), last, file, FTP_DATA_PAYLOAD_SIZE);
+    expect_reply(FTP_ERROR_NOT_WRITING_FILE, sizeof(FTP_RESULT_HEADER));
+    send_data(FNAME('A', 'B'), last, file, 100);
+    FTP_FILESYS_ERROR_DATA *error = (FTP_FILESYS_ERROR_DATA *)expect_reply(
+        FTP_FILE_WRITE_BUFFER_ERROR, sizeof(FTP_FILESYS_ERROR_DATA));
+    ASSERT(error->filesys_error == FILESYS_ERR_EXCEED_BUFFER);
+    ASSERT(error->lfs_error == LFS_ERR_OK);
+
+    // The ground got to the end of the cycle with one gap left
+    send_packet(last);
+    FTP_STATUS_REPORT_DATA *report = (FTP_STATUS_REPORT_DATA *)expect_reply(
+        FTP_STATUS_REPORT, sizeof(FTP_STATUS_REPORT_DATA));
+    ASSERT(report->cycle.received_bitfield[(last - 1) / 8] ==
+           (uint8_t)~(1 << ((last - 1) % 8)));
+    ASSERT(report->total_bytes_written == 0);
+    ASSERT(report->file_crc_so_far == 0);
+    ASSERT(report->filesys_is_writing_file);
+
+    send_packet(last - 1);
+    expect_cycle(FTP_FILE_WRITE_SUCCESS, last + 1, 2 * last + 1);
+    ASSERT(test_slate.filesys_bytes_written == FILESYS_BUFFER_SIZE);
+
+    // A packet from the old cycle gets the new range
+    send_packet(3);
+    expect_cycle(FTP_ERROR_PACKET_OUT_OF_RANGE, last + 1, 2 * last + 1);
+}
+
+void test_status_reports()
+{
+    printf("Starting status report test\n");
+
+    // Reports while the uplink is quiet, then not once the pass is over
+    mock_time_us += FTP_STATUS_REPORT_INTERVAL_MS * 1000ULL;
+    ftp_task_dispatch(&test_slate);
+    FTP_STATUS_REPORT_DATA *report = (FTP_STATUS_REPORT_DATA *)expect_reply(
+        FTP_STATUS_REPORT, sizeof(FTP_STATUS_REPORT_DATA));
+    ASSERT(report->total_bytes_written == FILESYS_BUFFER_SIZE);
+    ASSERT(report->file_crc_so_far == crc32(file, FILESYS_BUFFER_SIZE));
+
+    mock_time_us += FTP_STATUS_REPORT_INTERVAL_MS * 1000ULL - 1000;
+    ftp_task_dispatch(&test_slate);
+    ASSERT(take_reply() == 0);
+    mock_time_us += 1000;
+    ftp_task_dispatch(&test_slate);
+    expect_reply(FTP_STATUS_REPORT, sizeof(FTP_STATUS_REPORT_DATA));
+
+    mock_time_us += FTP_STATUS_REPORT_TIMEOUT_MS * 1000ULL;
+    ftp_task_dispatch(&test_slate);
+    ASSERT(take_reply() == 0);
+}
+
+void test_complete()
+{
+    printf("Starting complete test\n");
+
+    for (int i = FTP_NUM_PACKETS_PER_CYCLE; i < 2 * FTP_NUM_PACKETS_PER_CYCLE;
+         i++)
+        send_packet(i);
+    expect_cycle(FTP_FILE_WRITE_SUCCESS, 2 * FTP_NUM_PACKETS_PER_CYCLE,
+                 FILE_PACKETS - 1);
+
+    // The short packet at the end of the file first
+    send_packet(FILE_PACKETS - 1);
+    expect_reply(FTP_STATUS_REPORT, sizeof(FTP_STATUS_REPORT_DATA));
+    for (int i = 2 * FTP_NUM_PACKETS_PER_CYCLE; i < FILE_PACKETS - 1; i++)
+        send_packet(i);
+    FTP_EOF_DATA *eof = (FTP_EOF_DATA *)expect_reply(FTP_EOF_SUCCESS,
+                                                      sizeof(FTP_EOF_DATA));
+    ASSERT(eof->header.fname == FNAME('A', 'B'));
+    ASSERT(eof->computed_crc == crc32(file, FILE_LEN));
+    ASSERT(eof->file_len_on_disk == FILE_LEN);
+    ASSERT(!test_slate.filesys_is_writing_file);
+
+    send_packet(0);
+    FTP_RESULT_HEADER *header =
+        expect_reply(FTP_ERROR_NOT_WRITING_FILE, sizeof(*header));
+    ASSERT(header->fname == FTP_NO_FILE_FNAME);
+
+    // Empty files are done as soon as they start
+    send_start(FNAME('E', 'F'), 0, 0);
+    eof = (FTP_EOF_DATA *)expect_reply(FTP_EOF_SUCCESS, sizeof(FTP_EOF_DATA));
+    ASSERT(eof->header.fname == FNAME('E', 'F'));
+    ASSERT(eof->file_len_on_disk == 0);
+}
+
+void test_crc_error_and_cancel()
+{
+    printf("Starting CRC error and cancel test\n");
+
+    send_start(FNAME('C', 'D'), 10, 0x12345678);
+    expect_reply(FTP_READY_RECEIVE, sizeof(FTP_CYCLE_STATUS_DATA));
+    send_data(FNAME('C', 'D'), 0, file, 10);
+    FTP_EOF_DATA *eof = (FTP_EOF_DATA *)expect_reply(FTP_EOF_CRC_ERROR,
+                                                      sizeof(FTP_EOF_DATA));
+    ASSERT(eof->computed_crc == crc32(file, 10));
+    ASSERT(eof->header.file_crc == 0x12345678);
+
+    // The file stays open until cancelled; asking again checks again
+    send_data(FNAME('C', 'D'), 0, file, 10);
+    expect_reply(FTP_EOF_CRC_ERROR, sizeof(FTP_EOF_DATA));
+
+    send_cancel(FNAME('A', 'B'));
+    expect_reply(FTP_ERROR_NOT_WRITING_FILE, sizeof(FTP_RESULT_HEADER));
+    send_cancel(FNAME('C', 'D'));
+    FTP_RESULT_HEADER *header =
+        expect_reply(FTP_CANCEL_SUCCESS, sizeof(*header));
+    ASSERT(header->fname == FNAME('C', 'D'));
+    ASSERT(!test_slate.filesys_is_writing_file);
+
+    send_cancel(FNAME('C', 'D'));
+    FTP_FILESYS_ERROR_DATA *error = (FTP_FILESYS_ERROR_DATA *)expect_reply(
+        FTP_CANCEL_ERROR, sizeof(FTP_FILESYS_ERROR_DATA));
+    ASSERT(error->filesys_error == FILESYS_ERR_NO_FILE_WRITING);
+}
+
+void test_queue_full()
+{
+    printf("Starting queue full test\n");
+
+    // Commands beyond the queue are dropped until the task catches up
+    packet_t p = {.len = 1, .data = {FTP_REFORMAT}};
+    uint32_t drops = test_slate.ftp_queue_drops;
+    while (!queue_is_full(&test_slate.ftp_command_data))
+        dispatch_command(&test_slate, &p);
+    int queued = queue_get_level(&test_slate.ftp_command_data);
+    dispatch_command(&test_slate, &p);
+    ASSERT(test_slate.ftp_queue_drops == drops + 1);
+
+    // One dispatch works through the whole queue
+    ftp_task_dispatch(&test_slate);
+    ASSERT(queue_is_empty(&test_slate.ftp_command_data));
+    packet_handle_t h;
+    int replies = 0;
+    while (queue_try_remove(&test_slate.tx_sched.queues[TX_CLASS_COMMAND], &h))
+    {
+        packet_pool_free(&test_slate.packet_pool, h);
+        replies++;
+    }
+    ASSERT(replies == queued);
+}
+
+void test_read()
+{
+    printf("Starting read test\n");
+
+    FTP_START_FILE_READ_DATA missing = {.received.fname = FNAME('Z', 'Z')};
+    send(FTP_START_FILE_READ, &missing, sizeof(missing));
+    FTP_FILESYS_ERROR_DATA *error = (FTP_FILESYS_ERROR_DATA *)expect_reply(
+        FTP_ERROR_START_FILE_READ, sizeof(FTP_FILESYS_ERROR_DATA));
+    ASSERT(error->header.fname == FNAME('Z', 'Z'));
+    ASSERT(error->filesys_error == FILESYS_ERR_OPEN_FILE);
+    ASSERT(!test_slate.ftp_is_reading_file);
+
+    // The first round is the whole window, polling on its last packet
+    send_read_start(0, 0, 0);
+    ASSERT(take_data() == FTP_READ_WINDOW);
+    ASSERT(took(0, FTP_READ_WINDOW));
+    ASSERT(polls == 1 && poll_id == FTP_READ_WINDOW - 1);
+    ASSERT(!(frame_flags & PACKET_FLAG_FEC));
+    FTP_CYCLE_STATUS_DATA *status =
+        expect_cycle(FTP_READY_SEND, 0, FTP_READ_WINDOW - 1);
+    ASSERT(status->header.file_crc == crc32(file, FILE_LEN));
+
+    // Nothing more goes out until the ground answers
+    ftp_task_dispatch(&test_slate);
+    ASSERT(take_data() == 0);
+
+    // Only the gaps are sent again, then what slid into the window
+    send_ack(0, ~((1u << 3) | (1u << 17)));
+    ASSERT(take_data() == 5);
+    ASSERT(frames[3] == 1 && frames[17] == 1);
+    ASSERT(frames[FTP_READ_WINDOW] == 1 && frames[FTP_READ_WINDOW + 2] == 1);
+    ASSERT(poll_id == FTP_READ_WINDOW + 2);
+    ASSERT(test_slate.ftp_read_base == 3);
+    ASSERT(test_slate.ftp_read_packets_resent == 2);
+
+    // Without an answer the poll goes out again
+    mock_time_us += FTP_READ_ACK_TIMEOUT_MS * 1000ULL;
+    ftp_task_dispatch(&test_slate);
+    ASSERT(take_data() == 1);
+    ASSERT(polls == 1 && poll_id == FTP_READ_WINDOW + 2);
+    ASSERT(test_slate.ftp_read_polls == 1);
+
+    // Only one file is open at a time
+    send_start(FNAME('C', 'D'), 10, 0);
+    expect_reply(FTP_ERROR_ALREADY_READING_FILE, sizeof(FTP_RESULT_HEADER));
+
+    // Resuming skips what the ground has, and runs to the end of the file
+    send_read_start(40, 0x6, FTP_READ_FEC);
+    ASSERT(take_data() == FILE_PACKETS - 40 - 2);
+    ASSERT(frames[40] == 1 && frames[41] == 0 && frames[42] == 0);
+    for (int i = 43; i < FILE_PACKETS; i++)
+        ASSERT(frames[i] == 1);
+    ASSERT(poll_id == FILE_PACKETS - 1);
+    ASSERT(frame_flags & PACKET_FLAG_FEC);
+    status = expect_cycle(FTP_READY_SEND, 40, FILE_PACKETS - 1);
+    ASSERT(status->received_bitfield[0] == 0x6);
+    ASSERT(test_slate.ftp_read_base == 40);
+
+    send_ack(40, 0xFFFFFFFF);
+    ASSERT(take_data() == 0);
+    FTP_RESULT_HEADER *header =
+        expect_reply(FTP_FILE_READ_SUCCESS, sizeof(*header));
+    ASSERT(header->fname == FNAME('A', 'B'));
+    ASSERT(!test_slate.ftp_is_reading_file);
+    send_ack(40, 0xFFFFFFFF);
+    header = expect_reply(FTP_ERROR_NOT_READING_FILE, sizeof(*header));
+    ASSERT(header->fname == FTP_NO_FILE_FNAME);
+}
+
+void test_read_cancel_and_timeout()
+{
+    printf("Starting read cancel and timeout test\n");
+
+    FTP_CANCEL_FILE_READ_DATA cancel = {FNAME('A', 'B')};
+    send_read_start(0, 0, 0);
+    take_data();
+    expect_cycle(FTP_READY_SEND, 0, FTP_READ_WINDOW - 1);
+    send(FTP_CANCEL_FILE_READ, &cancel, sizeof(cancel));
+    expect_reply(FTP_CANCEL_SUCCESS, sizeof(FTP_RESULT_HEADER));
+    ASSERT(!test_slate.ftp_is_reading_file);
+    send(FTP_CANCEL_FILE_READ, &cancel, sizeof(cancel));
+    expect_reply(FTP_ERROR_NOT_READING_FILE, sizeof(FTP_RESULT_HEADER));
+
+    // A read nobody answers is given up without a word
+    send_read_start(0, 0, 0);
+    take_data();
+    expect_cycle(FTP_READY_SEND, 0, FTP_READ_WINDOW - 1);
+    mock_time_us += FTP_READ_TIMEOUT_MS * 1000ULL;
+    ftp_task_dispatch(&test_slate);
+    ASSERT(!test_slate.ftp_is_reading_file);
+    ASSERT(take_reply() == 0);
+}
+
+static FTP_FILE_LIST_DATA *expect_list(FILESYS_BUFFERED_FNAME_T after,
+                                       uint8_t flags, uint8_t num_files)
+{
+    FTP_LIST_FILES_DATA list = {after, flags};
+    send(FTP_LIST_FILES, &list, sizeof(list));
+    FTP_FILE_LIST_DATA *page = (FTP_FILE_LIST_DATA *)expect_reply(
+        FTP_FILE_LIST, offsetof(FTP_FILE_LIST_DATA, files) +
+                           num_files * sizeof(FTP_FILE_LIST_ENTRY));
+    ASSERT(page->num_files == num_files);
+    ASSERT(!page->more);
+    return page;
+}
+
+void test_list()
+{
+    printf("Starting list test\n");
+
+    // What the tests before left: the file and the empty one
+    FTP_FILE_LIST_DATA *page = expect_list(0, 0, 2);
+    FTP_FILE_LIST_ENTRY *entry = &page->files[0];
+    ASSERT(entry->fname == FNAME('A', 'B'));
+    ASSERT(entry->file_len == FILE_LEN);
+    ASSERT(entry->computed_crc == crc32(file, FILE_LEN));
+    ASSERT(entry->expected_crc == crc32(file, FILE_LEN));
+    ASSERT(entry->flags & FILESYS_FILE_INFO_CRC_MATCH);
+    ASSERT(entry->flags & FILESYS_FILE_INFO_CRC_CACHED);
+    entry = &page->files[1];
+    ASSERT(entry->fname == FNAME('E', 'F'));
+    ASSERT(entry->file_len == 0);
+    ASSERT(entry->flags & FILESYS_FILE_INFO_CRC_MATCH);
+
+    // The next page starts after the last name of this one
+    page = expect_list(FNAME('A', 'B'), 0, 1);
+    ASSERT(page->files[0].fname == FNAME('E', 'F'));
+    expect_list(FNAME('E', 'F'), 0, 0);
+
+    // A deep verify reads the file through
+    page = expect_list(0, FTP_LIST_DEEP_VERIFY, 2);
+    ASSERT(page->files[0].computed_crc == crc32(file, FILE_LEN));
+    ASSERT(page->files[0].flags & FILESYS_FILE_INFO_CRC_MATCH);
+    ASSERT(!(page->files[0].flags & FILESYS_FILE_INFO_CRC_CACHED));
+
+    send(FTP_LIST_FILES, "A", 1);
+    expect_reply(FTP_ERROR, sizeof(FTP_RESULT_HEADER));
+
+    // Not while a read holds the filesys cache
+    FTP_LIST_FILES_DATA list = {0, 0};
+    send_read_start(0, 0, 0);
+    take_data();
+    expect_cycle(FTP_READY_SEND, 0, FTP_READ_WINDOW - 1);
+    send(FTP_LIST_FILES, &list, sizeof(list));
+    expect_reply(FTP_ERROR_ALREADY_READING_FILE, sizeof(FTP_RESULT_HEADER));
+    FTP_CANCEL_FILE_READ_DATA cancel = {FNAME('A', 'B')};
+    send(FTP_CANCEL_FILE_READ, &cancel, sizeof(cancel));
+    expect_reply(FTP_CANCEL_SUCCESS, sizeof(FTP_RESULT_HEADER));
+}
+
+int main()
+{
+    printf("Starting FTP task test\n");
+    logger_mock_echo = false;
+    for (size_t i = 0; i < sizeof(file); i++)
+        file[i] = i * 7 + (i >> 8);
+
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    radio_task_init(&test_slate);
+    command_task_init(&test_slate);
+    ftp_task_init(&test_slate);
+
+    test_mount();
+    test_start();
+    test_first_cycle();
+    test_status_reports();
+    test_complete();
+    test_crc_error_and_cancel();
+    test_read();
+    test_read_cancel_and_timeout();
+    test_list();
+    test_queue_full();
+    free_slate(&test_slate);
+    return 0;
+}
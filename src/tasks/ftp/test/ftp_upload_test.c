@@ -0,0 +1,399 @@
+#include "command_parser.h"
+#include "command_task.h"
+#include "crc32.h"
+#include "error.h"
+#include "ftp_task.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include "radio_task.h"
+#include "rfm9x_channel.h"
+#include "test_scheduler_helpers.h"
+#include <stdio.h>
+
+/**
+ * End-to-end upload test: the radio, command and FTP tasks on an emulated
+ * channel, with a ground station stand-in that uploads a file. The ground
+ * sends the missing packets of the current cycle in order, then waits for a
+ * report and sends whatever is still missing. Reports goodput as a share of
+ * what the uplink could carry, for a clear and a lossy channel. Every run is
+ * deterministic.
+ */
+
+#define FILE_LEN 20000
+#define FILE_PACKETS                                                           \
+    ((FILE_LEN + FTP_DATA_PAYLOAD_SIZE - 1) / FTP_DATA_PAYLOAD_SIZE)
+
+#define SIM_TIMEOUT_MS 600000
+
+// The ground only keys up after this long without hearing a frame
+#define GROUND_QUIET_US 5000
+
+// After a round the ground waits this long for a report before asking again
+#define GROUND_REPLY_TIMEOUT_MS 1500
+
+slate_t test_slate;
+
+typedef struct
+{
+    const char *name;
+    rfm9x_channel_config_t channel;
+    FILESYS_BUFFERED_FNAME_T fname;
+} scenario_t;
+
+typedef struct
+{
+    bool done;
+    int32_t result;
+    uint32_t computed_crc;
+    double goodput_bps;
+    uint32_t packets_sent;
+    uint32_t rounds;
+    uint32_t timeouts;
+} result_t;
+
+typedef enum
+{
+    GROUND_START, // Start the file write
+    GROUND_ROUND, // Send what is missing of the cycle
+    GROUND_WAIT,  // For a reply
+    GROUND_DONE,
+} ground_phase_t;
+
+static uint8_t file[FILE_LEN];
+
+static struct
+{
+    rfm9x_t radio;
+    const scenario_t *sc;
+    ground_phase_t phase;
+    bool reformat;
+    bool transmitting;
+    uint16_t packet_start;
+    uint16_t packet_end;
+    bool received[FILE_PACKETS];
+    uint32_t next_id;   // Where the round goes on from
+    uint32_t round_end; // Last packet sent in the round
+    uint64_t wait_until_us;
+    uint64_t last_heard_us;
+    uint64_t start_us;
+    result_t *res;
+} ground;
+
+// Carries over between runs, as the satellite's replay window does
+static uint32_t ground_msg_id;
+
+#ifdef PACKET_HMAC_PSK
+static packet_hmac_key_t ground_key;
+#endif
+
+static void ground_tx_done(void)
+{
+    ground.transmitting = false;
+    rfm9x_listen(&ground.radio);
+}
+
+static void ground_cycle_status(const FTP_CYCLE_STATUS_DATA *status)
+{
+    ground.packet_start = status->packet_start;
+    ground.packet_end = status->packet_end;
+    for (uint32_t id = 0; id < FILE_PACKETS; id++)
+    {
+        uint32_t bit = id - ground.packet_start;
+        if (id < ground.packet_start)
+            ground.received[id] = true;
+        else if (id <= ground.packet_end)
+            ground.received[id] =
+                status->received_bitfield[bit / 8] & (1 << (bit % 8));
+    }
+}
+
+static void ground_rx_done(void)
+{
+    uint8_t buf[256];
+    uint8_t n = rfm9x_packet_from_fifo(&ground.radio, buf);
+    ground.last_heard_us = mock_time_us;
+    packet_t *p = (packet_t *)buf;
+    if (n < PACKET_HEADER_SIZE || n < PACKET_HEADER_SIZE + p->len ||
+        p->flags != 0 || p->len < sizeof(FTP_RESULT_HEADER))
+        return;
+
+    const FTP_RESULT_HEADER *header = (const FTP_RESULT_HEADER *)p->data;
+    switch (header->result)
+    {
+        case FILESYS_INIT_ERROR:
+            ground.reformat = true;
+            ground.phase = GROUND_START;
+            break;
+
+        case FILESYS_REFORMAT_SUCCESS:
+            ground.reformat = false;
+            ground.phase = GROUND_START;
+            break;
+
+        case FTP_READY_RECEIVE:
+        case FTP_FILE_WRITE_SUCCESS:
+        case FTP_ERROR_PACKET_OUT_OF_RANGE:
+        case FTP_STATUS_REPORT:
+            ground_cycle_status((const FTP_CYCLE_STATUS_DATA *)p->data);
+            // A periodic report mid-round changes nothing
+            if (ground.phase != GROUND_ROUND ||
+                header->result != FTP_STATUS_REPORT)
+            {
+                ground.phase = GROUND_ROUND;
+                ground.next_id = ground.packet_start;
+                ground.res->rounds++;
+            }
+            break;
+
+        case FTP_EOF_SUCCESS:
+        case FTP_EOF_CRC_ERROR:
+        {
+            const FTP_EOF_DATA *eof = (const FTP_EOF_DATA *)p->data;
+            ground.phase = GROUND_DONE;
+            ground.res->done = true;
+            ground.res->result = header->result;
+            ground.res->computed_crc = eof->computed_crc;
+            ground.res->goodput_bps =
+                FILE_LEN * 8.0 * 1e6 / (mock_time_us - ground.start_us);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+static void ground_send(Command command, const void *data, size_t len)
+{
+    packet_t p = {.dst = test_slate.radio_node,
+                  .len = 1 + len,
+                  .boot_count = test_slate.reboot_counter,
+                  .msg_id = ++ground_msg_id};
+    p.data[0] = command;
+    memcpy(&p.data[1], data, len);
+#ifdef PACKET_HMAC_PSK
+    packet_compute_hmac(&ground_key, &p, p.hmac);
+#endif
+    uint8_t buf[PACKET_SIZE];
+    size_t n = encode_packet(&p, buf, sizeof(buf), true);
+
+    rfm9x_packet_to_fifo(&ground.radio, buf, n);
+    rfm9x_transmit(&ground.radio);
+    ground.transmitting = true;
+}
+
+static void ground_send_packet(uint32_t id)
+{
+    FTP_WRITE_TO_FILE_DATA write = {.fname = ground.sc->fname,
+                                    .packet_id = id};
+    size_t offset = id * FTP_DATA_PAYLOAD_SIZE;
+    size_t len = FILE_LEN - offset < FTP_DATA_PAYLOAD_SIZE
+                     ? FILE_LEN - offset
+                     : FTP_DATA_PAYLOAD_SIZE;
+    memcpy(write.data, &file[offset], len);
+    ground_send(FTP_WRITE_TO_FILE, &write,
+                offsetof(FTP_WRITE_TO_FILE_DATA, data) + len);
+    ground.res->packets_sent++;
+}
+
+static void ground_wait(void)
+{
+    ground.phase = GROUND_WAIT;
+    ground.wait_until_us = mock_time_us + GROUND_REPLY_TIMEOUT_MS * 1000ULL;
+}
+
+// When the ground next has something to do
+static uint64_t ground_next_us(void)
+{
+    if (ground.phase == GROUND_DONE || ground.transmitting)
+        return UINT64_MAX;
+    uint64_t quiet_us = ground.last_heard_us + GROUND_QUIET_US;
+    if (ground.phase == GROUND_WAIT && ground.wait_until_us > quiet_us)
+        return ground.wait_until_us;
+    return quiet_us;
+}
+
+static void ground_step(void)
+{
+    if (ground.transmitting || mock_time_us < ground_next_us())
+        return;
+
+    switch (ground.phase)
+    {
+        case GROUND_START:
+            if (ground.reformat)
+            {
+                ground_send(FTP_REFORMAT, NULL, 0);
+            }
+            else
+            {
+                FTP_START_FILE_WRITE_DATA start = {ground.sc->fname, FILE_LEN,
+                                                   crc32(file, FILE_LEN)};
+                ground_send(FTP_START_FILE_WRITE, &start, sizeof(start));
+                ground.packet_start = 0;
+                ground.packet_end = FTP_NUM_PACKETS_PER_CYCLE - 1;
+            }
+            ground_wait();
+            break;
+
+        case GROUND_ROUND:
+            while (ground.next_id <= ground.packet_end &&
+                   ground.received[ground.next_id])
+                ground.next_id++;
+            if (ground.next_id > ground.packet_end)
+            {
+                ground_wait();
+                break;
+            }
+            ground.round_end = ground.next_id;
+            ground_send_packet(ground.next_id++);
+            break;
+
+        case GROUND_WAIT:
+            ground.res->timeouts++;
+            // The last packet of the round, or the reply to it, was lost.
+            // Sending it again gets a report either way.
+            if (ground.reformat || ground.res->packets_sent == 0)
+            {
+                // Nothing heard back from the start: the first cycle is open
+                // if it got through, and asking for it costs a packet
+                ground.phase = ground.reformat ? GROUND_START : GROUND_ROUND;
+                ground.next_id = 0;
+                break;
+            }
+            ground_send_packet(ground.round_end);
+            ground_wait();
+            break;
+
+        case GROUND_DONE:
+            break;
+    }
+}
+
+static uint64_t min_us(uint64_t a, uint64_t b)
+{
+    return a < b ? a : b;
+}
+
+static void run(const scenario_t *sc, result_t *res)
+{
+    memset(res, 0, sizeof(*res));
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    rfm9x_channel_init(&sc->channel);
+    rfm9x_channel_attach(&test_slate.radio, true);
+    rfm9x_channel_attach(&ground.radio, true);
+    radio_task_init(&test_slate);
+    command_task_init(&test_slate);
+    ftp_task_init(&test_slate);
+
+    memset(&ground, 0, sizeof(ground));
+    ground_msg_id += PACKET_REPLAY_RESERVE;
+    ground.sc = sc;
+    ground.res = res;
+    ground.radio.modem = test_slate.radio.modem;
+    ground.phase = GROUND_START;
+    ground.last_heard_us = mock_time_us;
+    ground.start_us = mock_time_us;
+    rfm9x_set_tx_irq(&ground.radio, &ground_tx_done);
+    rfm9x_set_rx_irq(&ground.radio, &ground_rx_done);
+    rfm9x_listen(&ground.radio);
+
+    uint64_t end_us = mock_time_us + SIM_TIMEOUT_MS * 1000ULL;
+    uint64_t next_radio_us = mock_time_us;
+    uint64_t next_command_us = mock_time_us;
+    uint64_t next_ftp_us = mock_time_us;
+    while (mock_time_us < end_us && ground.phase != GROUND_DONE)
+    {
+        uint64_t t = min_us(end_us, rfm9x_channel_next_event_us());
+        t = min_us(t, min_us(next_radio_us, next_command_us));
+        t = min_us(t, min_us(next_ftp_us, ground_next_us()));
+        rfm9x_channel_run_until(t);
+
+        // Stand in for the scheduler: the command task wakes on RX and the
+        // FTP task on a queued command
+        if (mock_time_us >= next_command_us ||
+            !queue_is_empty(&test_slate.rx_queue))
+        {
+            command_task_dispatch(&test_slate);
+            next_command_us =
+                mock_time_us + command_task.dispatch_period_ms * 1000ULL;
+        }
+        if (mock_time_us >= next_ftp_us ||
+            !queue_is_empty(&test_slate.ftp_command_data))
+        {
+            ftp_task_dispatch(&test_slate);
+            next_ftp_us = mock_time_us + ftp_task.dispatch_period_ms * 1000ULL;
+        }
+        if (mock_time_us >= next_radio_us)
+        {
+            radio_task_dispatch(&test_slate);
+            next_radio_us += radio_task.dispatch_period_ms * 1000ULL;
+        }
+        ground_step();
+    }
+
+    const rfm9x_channel_stats_t *s = rfm9x_channel_stats(&test_slate.radio);
+    printf("%-8s %4s %9.0f %6u %6u %6u %6u   %u/%u/%u/%u\n", sc->name,
+           res->done ? "yes" : "no", res->goodput_bps, res->packets_sent,
+           res->rounds, res->timeouts, test_slate.ftp_packets_duplicate,
+           s->lost, s->corrupted, s->collisions, s->missed);
+    ASSERT(test_slate.ftp_queue_drops == 0);
+
+    free_slate(&test_slate);
+}
+
+int main()
+{
+    printf("Starting FTP upload test\n");
+    logger_mock_echo = false;
+#ifdef PACKET_HMAC_PSK
+    packet_hmac_key_init(&ground_key, (const uint8_t *)PACKET_HMAC_PSK,
+                         PACKET_HMAC_PSK_LEN);
+#endif
+    for (size_t i = 0; i < sizeof(file); i++)
+        file[i] = i * 13 + (i >> 9);
+
+    const rfm9x_channel_config_t clear = {.latency_us = 5000,
+                                          .turnaround_us = 1000,
+                                          .rssi_dbm = -100,
+                                          .snr_q4 = 0,
+                                          .seed = 1};
+    rfm9x_channel_config_t lossy = clear;
+    lossy.loss = 0.1;
+
+    const scenario_t scenarios[] = {
+        {"clear", clear, 'A' | 'A' << 8},
+        {"lossy", lossy, 'B' | 'B' << 8},
+    };
+    result_t res[sizeof(scenarios) / sizeof(scenarios[0])];
+
+    printf("\n%-8s %4s %9s %6s %6s %6s %6s   %s\n", "channel", "done",
+           "goodput", "sent", "rounds", "tmout", "dups",
+           "satellite lost/corrupt/collided/missed");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+        run(&scenarios[i], &res[i]);
+
+    // What the uplink could carry if it did nothing but send file data
+    packet_t full = {.len = PACKET_DATA_SIZE};
+    uint8_t buf[PACKET_SIZE];
+    uint32_t frame_us = rfm9x_airtime_us(
+        &test_slate.radio.modem, encode_packet(&full, buf, sizeof(buf), true));
+    double max_bps = FTP_DATA_PAYLOAD_SIZE * 8.0 * 1e6 / frame_us;
+    printf("uplink capacity %.0f bps\n", max_bps);
+
+    for (size_t i = 0; i < sizeof(res) / sizeof(res[0]); i++)
+    {
+        ASSERT(res[i].done);
+        ASSERT(res[i].result == FTP_EOF_SUCCESS);
+        ASSERT(res[i].computed_crc == crc32(file, FILE_LEN));
+    }
+
+    // The round trip at the end of each cycle is all that is lost
+    ASSERT(res[0].packets_sent == FILE_PACKETS);
+    ASSERT(res[0].goodput_bps > 0.9 * max_bps);
+
+    // Lost packets cost one more frame each, and rounds end in a timeout
+    // when the last packet of the round is lost
+    ASSERT(res[1].goodput_bps > 0.7 * max_bps);
+    return 0;
+}
@@ -39,6 +39,7 @@ void hardware_test_task_dispatch(slate_t *slate)
 sched_task_t hardware_test_task = {
     .name = "hardware_test",
     .dispatch_period_ms = 10000,
+    .priority = SCHED_PRIORITY_LOW,
     .task_init = &hardware_test_task_init,
     .task_dispatch = &hardware_test_task_dispatch,
     .next_dispatch = 0,
@@ -25,6 +25,7 @@ void print_task_dispatch(slate_t *slate)
 
 sched_task_t print_task = {.name = "print",
                            .dispatch_period_ms = 1000,
+                           .priority = SCHED_PRIORITY_LOW,
                            .task_init = &print_task_init,
                            .task_dispatch = &print_task_dispatch,
 
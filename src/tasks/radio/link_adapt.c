@@ -0,0 +1,169 @@
+/**
+ * @file link_adapt.c
+ *
+ * LoRa link adaptation: uplink SNR tracking and the profile switch handshake.
+ */
+
+#include "link_adapt.h"
+#include "logger.h"
+#include "packet_pool.h"
+#include "tx_sched.h"
+#include "pico/stdlib.h"
+
+#define SNR_Q4_PER_DOUBLING 12 // 3 dB
+
+/*
+ * Ordered from most robust to fastest. Floors are the SX1276 demodulator
+ * limits (RFM9X.pdf 4.1.1.1 p26); the default profile is in the middle so
+ * there is room both ways. 4/5 coding throughout.
+ */
+const link_profile_t link_profiles[LINK_PROFILE_COUNT] = {
+    {{.sf = 10, .cr = 5, .bw = 125000}, -60},
+    {{.sf = 9, .cr = 5, .bw = 125000}, -50},
+    {{.sf = 8, .cr = 5, .bw = 125000}, -40},
+    {{.sf = 7, .cr = 5, .bw = 125000}, -30},
+    {{.sf = 7, .cr = 5, .bw = 250000}, -30 + SNR_Q4_PER_DOUBLING},
+    {{.sf = 7, .cr = 5, .bw = 500000}, -30 + 2 * SNR_Q4_PER_DOUBLING},
+};
+
+_Static_assert(LINK_PROFILE_DEFAULT < LINK_PROFILE_COUNT,
+               "Default link profile out of range");
+_Static_assert(sizeof(link_report_t) <= PACKET_DATA_SIZE,
+               "Link report does not fit in a packet");
+
+static void set_profile(slate_t *slate, uint8_t profile)
+{
+    rfm9x_set_modem(&slate->radio, &link_profiles[profile].modem);
+    slate->link_profile = profile;
+    slate->link_samples = 0;
+    slate->link_last_rx = get_absolute_time();
+}
+
+/*
+ * Queue a link frame on the current settings.
+ */
+static bool send_report(slate_t *slate, uint8_t flags, uint8_t next)
+{
+    link_report_t report = {.current = slate->link_profile,
+                            .next = next,
+                            .snr_avg_q4 = slate->link_snr_avg_q4,
+                            .rssi_dbm = slate->link_last_rssi};
+
+    packet_handle_t h =
+        tx_sched_alloc(&slate->tx_sched, &slate->packet_pool, TX_CLASS_COMMAND);
+    if (h == PACKET_HANDLE_NONE)
+        return false;
+
+    rfm9x_format_packet(packet_pool_get(&slate->packet_pool, h), 0, 0, flags,
+                        0, sizeof(report), (uint8_t *)&report);
+    return tx_sched_enqueue(&slate->tx_sched, &slate->packet_pool,
+                            TX_CLASS_COMMAND, h);
+}
+
+void link_adapt_init(slate_t *slate)
+{
+    slate->link_pending_profile = LINK_PROFILE_NONE;
+    slate->link_snr_avg_q4 = 0;
+    slate->link_last_rssi = 0;
+    slate->link_switches = 0;
+    slate->link_fallbacks = 0;
+    slate->link_last_propose = get_absolute_time();
+    set_profile(slate, LINK_PROFILE_DEFAULT);
+}
+
+void link_adapt_record(slate_t *slate, const rfm9x_rx_info_t *rx)
+{
+    int16_t snr = rx->snr_q4;
+    for (uint32_t bw = slate->radio.modem.bw; bw > 125000; bw /= 2)
+        snr += SNR_Q4_PER_DOUBLING;
+
+    // Start the average afresh on a new profile
+    if (slate->link_samples == 0)
+        slate->link_snr_avg_q4 = snr;
+    else
+        slate->link_snr_avg_q4 +=
+            (snr - slate->link_snr_avg_q4) / LINK_SNR_AVG_WEIGHT;
+
+    slate->link_last_rssi = rx->rssi_dbm;
+    slate->link_samples++;
+    slate->link_last_rx = get_absolute_time();
+}
+
+uint8_t link_adapt_recommend(const slate_t *slate)
+{
+    uint8_t p = slate->link_profile;
+    if (slate->link_samples < LINK_MIN_SAMPLES)
+        return p;
+
+    int16_t avg = slate->link_snr_avg_q4;
+    if (p > 0 && avg - link_profiles[p].snr_floor_q4 < LINK_MARGIN_DOWN_DB * 4)
+        return p - 1;
+    if (p + 1 < LINK_PROFILE_COUNT &&
+        avg - link_profiles[p + 1].snr_floor_q4 >= LINK_MARGIN_UP_DB * 4 &&
+        link_stats_recent_crc_errors(&slate->link_stats, LINK_MIN_SAMPLES) == 0)
+        return p + 1;
+    return p;
+}
+
+void link_adapt_dispatch(slate_t *slate)
+{
+    // Waiting for the ACK to go out
+    if (slate->link_pending_profile != LINK_PROFILE_NONE)
+        return;
+
+    absolute_time_t now = get_absolute_time();
+    if (slate->link_profile != LINK_PROFILE_DEFAULT &&
+        absolute_time_diff_us(slate->link_last_rx, now) >
+            LINK_FALLBACK_MS * 1000LL)
+    {
+        LOG_INFO("Link: No uplink, falling back to profile %d",
+                 LINK_PROFILE_DEFAULT);
+        slate->link_fallbacks++;
+        set_profile(slate, LINK_PROFILE_DEFAULT);
+        return;
+    }
+
+    uint8_t next = link_adapt_recommend(slate);
+    if (next == slate->link_profile)
+        return;
+
+    if (absolute_time_diff_us(slate->link_last_propose, now) <=
+        LINK_PROPOSE_INTERVAL_MS * 1000LL)
+        return;
+
+    LOG_INFO("Link: Proposing profile %d -> %d (SNR %d/4 dB)",
+             slate->link_profile, next, slate->link_snr_avg_q4);
+    slate->link_last_propose = now;
+    send_report(slate, LINK_FLAG_PROPOSE, next);
+}
+
+bool link_adapt_request(slate_t *slate, uint8_t profile)
+{
+    if (profile >= LINK_PROFILE_COUNT)
+    {
+        LOG_ERROR("Link: Unknown profile %d", profile);
+        return false;
+    }
+    if (!send_report(slate, LINK_FLAG_ACK, profile))
+    {
+        LOG_ERROR("Link: Failed to queue ACK");
+        return false;
+    }
+
+    slate->link_pending_profile = profile;
+    return true;
+}
+
+void link_adapt_apply_pending(slate_t *slate)
+{
+    uint8_t profile = slate->link_pending_profile;
+    if (profile == LINK_PROFILE_NONE)
+        return;
+
+    LOG_INFO("Link: Switching to profile %d (SF%d, %u Hz)", profile,
+             link_profiles[profile].modem.sf,
+             (unsigned int)link_profiles[profile].modem.bw);
+    slate->link_pending_profile = LINK_PROFILE_NONE;
+    slate->link_switches++;
+    set_profile(slate, profile);
+}
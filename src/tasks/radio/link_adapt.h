@@ -0,0 +1,105 @@
+/**
+ * @file link_adapt.h
+ *
+ * LoRa link adaptation.
+ *
+ * The radio records the SNR and RSSI of every uplink packet addressed to us.
+ * When the smoothed SNR leaves enough margin over what the next faster
+ * profile needs, or too little for the current one, we propose a switch to
+ * the ground in a LINK_FLAG_PROPOSE frame. Both ends only change modem
+ * settings through a handshake:
+ *
+ *   1. The ground sends an authenticated LINK_SWITCH command naming a profile
+ *      (usually the one proposed).
+ *   2. We reply with a LINK_FLAG_ACK frame on the old settings and switch as
+ *      soon as it is on air. The ground switches when it hears the ACK.
+ *
+ * If the ACK is lost, or the pass ends, nothing is heard for LINK_FALLBACK_MS
+ * and both ends independently fall back to the default profile.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rfm9x.h"
+#include "slate.h"
+
+// Set in the packet flags of link frames, which carry a link_report_t
+#define LINK_FLAG_PROPOSE 0x01
+#define LINK_FLAG_ACK 0x02
+
+#define LINK_PROFILE_COUNT 6
+#define LINK_PROFILE_DEFAULT 3 // SF7, 125 kHz, as before link adaptation
+#define LINK_PROFILE_NONE 0xFF
+
+// Smoothing of the uplink SNR: each sample moves the average 1/4 of the way
+#define LINK_SNR_AVG_WEIGHT 4
+
+// Samples needed on a profile before proposing to leave it
+#define LINK_MIN_SAMPLES 4
+
+// Step up when the faster profile would still have this much margin, step
+// down when the current one has less, in dB
+#define LINK_MARGIN_UP_DB 8
+#define LINK_MARGIN_DOWN_DB 3
+
+#define LINK_PROPOSE_INTERVAL_MS 10000
+
+// Uplink silence after which we go back to the default profile. The ground
+// must use the same value.
+#define LINK_FALLBACK_MS 60000
+
+typedef struct
+{
+    rfm9x_modem_t modem;
+    // Demodulation floor in quarter dB, as measured at 125 kHz: each doubling
+    // of the bandwidth lets in 3 dB more noise
+    int16_t snr_floor_q4;
+} link_profile_t;
+
+/*
+ * Payload of link frames, in both directions of the handshake.
+ */
+typedef struct __attribute__((packed))
+{
+    uint8_t current;    // Profile in use
+    uint8_t next;       // Proposed, or switched to after this frame
+    int16_t snr_avg_q4; // Uplink SNR average, normalized to 125 kHz
+    int16_t rssi_dbm;   // RSSI of the last uplink packet
+} link_report_t;
+
+extern const link_profile_t link_profiles[LINK_PROFILE_COUNT];
+
+void link_adapt_init(slate_t *slate);
+
+/*
+ * Account for the signal quality of an uplink packet. Called from the RX
+ * interrupt.
+ */
+void link_adapt_record(slate_t *slate, const rfm9x_rx_info_t *rx);
+
+/*
+ * The profile the link should be on given what has been received so far.
+ * Never a faster one while recent uplink frames are failing their CRC.
+ */
+uint8_t link_adapt_recommend(const slate_t *slate);
+
+/*
+ * Fall back after uplink silence and send proposals. Called by the radio task
+ * while it is not transmitting.
+ */
+void link_adapt_dispatch(slate_t *slate);
+
+/*
+ * Handle a LINK_SWITCH command: queue the ACK and arm the switch. Returns
+ * false if the profile is unknown or the ACK could not be queued.
+ */
+bool link_adapt_request(slate_t *slate, uint8_t profile);
+
+/*
+ * Switch to the armed profile, if any. Called by the radio task once the ACK
+ * has been sent.
+ */
+void link_adapt_apply_pending(slate_t *slate);
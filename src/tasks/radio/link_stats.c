@@ -0,0 +1,90 @@
+/**
+ * @file link_stats.c
+ *
+ * Uplink statistics ring.
+ */
+
+#include "link_stats.h"
+#include "hardware/sync.h"
+#include <string.h>
+
+_Static_assert(LINK_STATS_RING_SIZE <= UINT8_MAX,
+               "Ring indices and summary counts are bytes");
+
+void link_stats_init(link_stats_t *ls)
+{
+    memset(ls, 0, sizeof(*ls));
+}
+
+void link_stats_record(link_stats_t *ls, const rfm9x_rx_info_t *rx,
+                       uint32_t time_ms)
+{
+    ls->ring[ls->head] = (link_rx_sample_t){.time_ms = time_ms, .rx = *rx};
+    ls->head = (ls->head + 1) % LINK_STATS_RING_SIZE;
+    if (ls->count < LINK_STATS_RING_SIZE)
+        ls->count++;
+
+    ls->frames++;
+    if (rx->crc_error)
+        ls->crc_errors++;
+}
+
+void link_stats_summarize(const link_stats_t *ls, uint32_t now_ms,
+                          link_stats_summary_t *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    uint32_t ints = save_and_disable_interrupts();
+    unsigned int n = ls->count;
+    if (n == 0)
+    {
+        restore_interrupts(ints);
+        return;
+    }
+
+    int32_t rssi_sum = 0;
+    int32_t snr_sum = 0;
+    int64_t freq_sum = 0;
+    out->rssi_min_dbm = INT16_MAX;
+    out->snr_min_q4 = INT8_MAX;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        const rfm9x_rx_info_t *rx = &ls->ring[i].rx;
+        rssi_sum += rx->rssi_dbm;
+        snr_sum += rx->snr_q4;
+        freq_sum += rx->freq_error_hz;
+        if (rx->rssi_dbm < out->rssi_min_dbm)
+            out->rssi_min_dbm = rx->rssi_dbm;
+        if (rx->snr_q4 < out->snr_min_q4)
+            out->snr_min_q4 = rx->snr_q4;
+        out->crc_errors += rx->crc_error;
+    }
+    unsigned int newest = (ls->head + LINK_STATS_RING_SIZE - 1) %
+                          LINK_STATS_RING_SIZE;
+    uint32_t age_s = (now_ms - ls->ring[newest].time_ms) / 1000;
+    restore_interrupts(ints);
+
+    out->samples = n;
+    out->rssi_avg_dbm = rssi_sum / (int32_t)n;
+    out->snr_avg_q4 = snr_sum / (int32_t)n;
+    out->freq_error_avg_hz = freq_sum / (int64_t)n;
+    out->age_s = age_s > UINT16_MAX ? UINT16_MAX : age_s;
+}
+
+unsigned int link_stats_recent_crc_errors(const link_stats_t *ls,
+                                          unsigned int n)
+{
+    uint32_t ints = save_and_disable_interrupts();
+    if (n > ls->count)
+        n = ls->count;
+
+    unsigned int errors = 0;
+    for (unsigned int i = 1; i <= n; i++)
+    {
+        unsigned int slot = (ls->head + LINK_STATS_RING_SIZE - i) %
+                            LINK_STATS_RING_SIZE;
+        errors += ls->ring[slot].rx.crc_error;
+    }
+    restore_interrupts(ints);
+    return errors;
+}
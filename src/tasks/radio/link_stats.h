@@ -0,0 +1,69 @@
+/**
+ * @file link_stats.h
+ *
+ * Uplink statistics: the signal quality of the last LINK_STATS_RING_SIZE
+ * frames received, whether or not they passed their CRC or were addressed to
+ * us. The beacon carries a summary for pass planning, and link adaptation
+ * looks at recent CRC failures.
+ *
+ * Frames are recorded from the RX interrupt; readers on core0 mask
+ * interrupts while they look at the ring.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rfm9x.h"
+
+#define LINK_STATS_RING_SIZE 32
+
+typedef struct
+{
+    uint32_t time_ms; // Since boot
+    rfm9x_rx_info_t rx;
+} link_rx_sample_t;
+
+typedef struct
+{
+    link_rx_sample_t ring[LINK_STATS_RING_SIZE];
+    uint8_t head;  // Next slot written
+    uint8_t count; // Valid samples, up to LINK_STATS_RING_SIZE
+
+    uint32_t frames;     // Since boot
+    uint32_t crc_errors; // Since boot
+} link_stats_t;
+
+/*
+ * Summary of the ring, as sent in the beacon. All zero if nothing has been
+ * received.
+ */
+typedef struct __attribute__((packed))
+{
+    uint8_t samples;       // Frames summarized
+    uint8_t crc_errors;    // Among them
+    int16_t rssi_avg_dbm;
+    int16_t rssi_min_dbm;
+    int8_t snr_avg_q4;
+    int8_t snr_min_q4;
+    int32_t freq_error_avg_hz;
+    uint16_t age_s; // Since the newest frame, saturating
+} link_stats_summary_t;
+
+void link_stats_init(link_stats_t *ls);
+
+/*
+ * Add a received frame, replacing the oldest once the ring is full.
+ */
+void link_stats_record(link_stats_t *ls, const rfm9x_rx_info_t *rx,
+                       uint32_t time_ms);
+
+void link_stats_summarize(const link_stats_t *ls, uint32_t now_ms,
+                          link_stats_summary_t *out);
+
+/*
+ * How many of the newest n frames failed their CRC.
+ */
+unsigned int link_stats_recent_crc_errors(const link_stats_t *ls,
+                                          unsigned int n);
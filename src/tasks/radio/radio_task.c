@@ -7,16 +7,21 @@
  */
 
 #include "radio_task.h"
+#include "link_adapt.h"
+#include "link_stats.h"
 #include "logger.h"
 #include "neopixel.h"
+#include "packet_fec.h"
+#include "sched_wakeup.h"
 
 static slate_t *s;
 
 // --- PACKET ENCODER/DECODER ---
 // p.len is always the length of p.data (payload), not including header fields.
 
-// Serializes a packet_t into a buffer. Returns the total number of bytes
-// written, or 0 on error.
+// Serializes a packet_t into a buffer. With PACKET_FLAG_FEC set, Reed-Solomon
+// parity over everything before it ends the frame. Returns the total number
+// of bytes written, or 0 on error.
 size_t encode_packet(const packet_t *p, uint8_t *buf, size_t bufsize,
                      bool enable_hmac)
 {
@@ -31,6 +36,7 @@ size_t encode_packet(const packet_t *p, uint8_t *buf, size_t bufsize,
         return 0;
     }
 
+    bool enable_fec = (p->flags & PACKET_FLAG_FEC) != 0;
     size_t total_size;
     if (__builtin_add_overflow(PACKET_HEADER_SIZE, p->len, &total_size) ||
         (enable_hmac &&
@@ -40,6 +46,16 @@ size_t encode_packet(const packet_t *p, uint8_t *buf, size_t bufsize,
         return 0; // Integer overflow would occur
     }
 
+    if (enable_fec)
+    {
+        if (total_size > PACKET_FEC_MAX_FRAME)
+        {
+            LOG_ERROR("encode_packet: Packet too long for FEC");
+            return 0;
+        }
+        total_size += PACKET_FEC_PARITY_SIZE;
+    }
+
     if (bufsize < total_size)
     {
         LOG_ERROR("encode_packet: Buffer size too small for packet");
@@ -68,13 +84,18 @@ size_t encode_packet(const packet_t *p, uint8_t *buf, size_t bufsize,
         offset += PACKET_HMAC_SIZE;
     }
 
+    if (enable_fec)
+        offset = packet_fec_encode(buf, offset);
+
     return offset;
 }
 
-// Parses a buffer into a packet_t. Returns true on success, false on error.
-static bool parse_packet(const uint8_t *buf, size_t n, packet_t *p)
+// Parses a packet received straight into a packet_t's bytes, in place. The
+// header and data are already where they belong; only the footer has to move
+// up from the end of the data. Returns true on success, false on error.
+static bool parse_packet_in_place(packet_t *p, size_t n)
 {
-    if (!buf || !p)
+    if (!p)
     {
         LOG_ERROR("parse_packet: NULL pointer provided");
         return false;
@@ -87,15 +108,6 @@ static bool parse_packet(const uint8_t *buf, size_t n, packet_t *p)
         return false;
     }
 
-    size_t offset = 0;
-
-    // Parse header fields
-    p->dst = buf[offset++];
-    p->src = buf[offset++];
-    p->flags = buf[offset++];
-    p->seq = buf[offset++];
-    p->len = buf[offset++];
-
     LOG_INFO("parse_packet [RECEIVED PACKER]: dst=%d, src=%d, flags=0x%02x, "
              "seq=%d, len=%d",
              p->dst, p->src, p->flags, p->seq, p->len);
@@ -125,68 +137,271 @@ static bool parse_packet(const uint8_t *buf, size_t n, packet_t *p)
         return false;
     }
 
-    memcpy(p->data, buf + offset, p->len);
-    offset += p->len;
-    memcpy(&p->boot_count, buf + offset, sizeof(p->boot_count));
-    offset += sizeof(p->boot_count);
-    memcpy(&p->msg_id, buf + offset, sizeof(p->msg_id));
-    offset += sizeof(p->msg_id);
-    memcpy(p->hmac, buf + offset, PACKET_HMAC_SIZE);
-    offset += PACKET_HMAC_SIZE;
+    // boot_count, msg_id and hmac follow the data on the wire
+    memmove((uint8_t *)p + offsetof(packet_t, boot_count), p->data + p->len,
+            PACKET_FOOTER_SIZE);
+
+    // Commands treat the data as a string; keep the rest of it zeroed
+    memset(p->data + p->len, 0, PACKET_DATA_SIZE - p->len);
 
     return true;
 }
 
 // --- TX ---
-static void tx_done()
+// Frames go out in bursts. Once radio_task_dispatch starts one, each TxDone
+// interrupt loads the next frame straight away, in the order tx_sched picks
+// across the traffic classes (see tx_sched.h), until the queues are empty or
+// the burst reaches RADIO_TX_BURST_MAX_PACKETS or RADIO_TX_BURST_AIRTIME_MS.
+// Only then does the radio go back to listening.
+//
+// The FIFO can only be written in standby, so the next frame cannot be loaded
+// while the current one is on air. It is dequeued and checked against the
+// burst limits instead (tx_next), so TxDone only has to DMA it into the FIFO
+// and key the transmitter.
+//
+// A link ACK (see link_adapt.h) ends its burst, and the modem switches to the
+// acknowledged profile before anything else goes out.
+//
+// Frames flagged PACKET_FLAG_FEC get their Reed-Solomon parity when staged.
+// That delays keying the transmitter by the encode time (slate tx_fec_us
+// keeps the total), which is small next to a frame's airtime.
+
+// Slot being written to the FIFO. The downlink is not authenticated, so the
+// header and data of a packet_t (then FEC parity in place of the footer) are
+// already its wire format and the DMA reads them straight out of the pool.
+static packet_handle_t tx_handle = PACKET_HANDLE_NONE;
+
+// Next frame of the burst, staged while the current one is on air
+static packet_handle_t tx_next = PACKET_HANDLE_NONE;
+
+static volatile bool tx_bursting;
+static uint32_t tx_burst_packets;
+static uint32_t tx_burst_airtime_us;
+static absolute_time_t tx_frame_start;
+static uint32_t tx_frame_timeout_us;
+static bool tx_link_switch;
+
+static size_t tx_frame_size(packet_handle_t h)
 {
-    packet_t p = {0};
-    if (queue_try_remove(&s->tx_queue, &p))
+    return packet_fec_frame_size(packet_pool_get(&s->packet_pool, h));
+}
+
+// Append the Reed-Solomon parity to a frame that asks for it
+static void tx_encode_fec(packet_handle_t h)
+{
+    packet_t *p = packet_pool_get(&s->packet_pool, h);
+    if (!(p->flags & PACKET_FLAG_FEC) || p->len > PACKET_DATA_SIZE)
+        return;
+
+    absolute_time_t start = get_absolute_time();
+    packet_fec_encode((uint8_t *)p, PACKET_HEADER_SIZE + p->len);
+    s->tx_fec_us += absolute_time_diff_us(start, get_absolute_time());
+    s->tx_fec_frames++;
+}
+
+// Stage the next frame in tx_next, if the burst may go on. A frame that would
+// overrun the airtime budget stays queued for the next burst. The first frame
+// of a burst always goes.
+static void tx_stage_next()
+{
+    packet_handle_t h;
+    tx_class_t cls;
+    if (tx_next != PACKET_HANDLE_NONE || tx_link_switch ||
+        tx_burst_packets >= RADIO_TX_BURST_MAX_PACKETS ||
+        !tx_sched_peek(&s->tx_sched, &h, &cls))
+        return;
+
+    uint32_t airtime_us = rfm9x_airtime_us(&s->radio.modem, tx_frame_size(h));
+    if (tx_burst_packets > 0 &&
+        tx_burst_airtime_us + airtime_us > RADIO_TX_BURST_AIRTIME_MS * 1000)
+        return;
+
+    // The radio is the only consumer, so this removes the peeked handle
+    tx_sched_commit(&s->tx_sched, cls, airtime_us);
+    tx_encode_fec(h);
+    tx_next = h;
+}
+
+static void tx_fifo_done(uint8_t n)
+{
+    // The frame is in the FIFO; its slot can go back to the pool
+    packet_pool_free(&s->packet_pool, tx_handle);
+    tx_handle = PACKET_HANDLE_NONE;
+
+    tx_stage_next();
+    rfm9x_transmit(&s->radio);
+}
+
+// Load a frame into the FIFO; transmission starts once the DMA is done.
+// Returns false (and frees the frame) if it cannot be sent.
+static bool tx_send(packet_handle_t h)
+{
+    packet_t *p = packet_pool_get(&s->packet_pool, h);
+    LOG_INFO("TX: Sending packet to %d, len %d", p->dst, p->len);
+    if (p->len > PACKET_DATA_SIZE)
     {
-        LOG_INFO("TX: Sending packet to %d, len %d", p.dst, p.len);
-        uint8_t p_buf[PACKET_SIZE];
-        size_t pkt_size = encode_packet(&p, p_buf, sizeof(p_buf), false);
-        if (pkt_size == 0)
-        {
-            LOG_ERROR("Failed to encode packet for TX");
-            rfm9x_clear_interrupts(&s->radio);
+        LOG_ERROR("Failed to encode packet for TX");
+        packet_pool_free(&s->packet_pool, h);
+        return false;
+    }
+    size_t pkt_size = packet_fec_frame_size(p);
+    uint32_t airtime_us = rfm9x_airtime_us(&s->radio.modem, pkt_size);
+
+    tx_burst_packets++;
+    tx_burst_airtime_us += airtime_us;
+    tx_frame_start = get_absolute_time();
+    tx_frame_timeout_us = airtime_us + RADIO_TX_FRAME_TIMEOUT_MS * 1000;
+    tx_link_switch = (p->flags & LINK_FLAG_ACK) != 0;
+    s->tx_packets++;
+    s->tx_bytes += pkt_size;
+    s->tx_airtime_us += airtime_us;
+
+    tx_handle = h;
+    rfm9x_packet_to_fifo_async(&s->radio, (uint8_t *)p, pkt_size,
+                               &tx_fifo_done);
+    return true;
+}
+
+static void tx_end_burst()
+{
+    // Whatever is left goes out in the next burst
+    if (!tx_sched_is_empty(&s->tx_sched))
+        s->tx_burst_cutoffs++;
+
+    if (tx_link_switch)
+    {
+        tx_link_switch = false;
+        link_adapt_apply_pending(s);
+    }
+
+    tx_bursting = false;
+    rfm9x_listen(&s->radio);
+}
+
+// Send the next frame of the burst, or end it
+static void tx_continue_burst()
+{
+    while (true)
+    {
+        tx_stage_next();
+        packet_handle_t h = tx_next;
+        tx_next = PACKET_HANDLE_NONE;
+        if (h == PACKET_HANDLE_NONE)
+            break;
+        if (tx_send(h))
             return;
-        }
-        rfm9x_packet_to_fifo(&s->radio, p_buf, pkt_size);
-        rfm9x_clear_interrupts(&s->radio);
-        s->tx_packets++;
-        s->tx_bytes += pkt_size;
+    }
+    tx_end_burst();
+}
+
+static void tx_start_burst()
+{
+    tx_bursting = true;
+    tx_burst_packets = 0;
+    tx_burst_airtime_us = 0;
+    s->tx_bursts++;
+    tx_continue_burst();
+}
+
+static void tx_done()
+{
+    // Also waits out a FIFO write still in flight, so tx_handle is free again
+    rfm9x_clear_interrupts(&s->radio);
+
+    if (tx_bursting)
+    {
+        tx_continue_burst();
     }
     else
     {
-        // No more TX packets, switch to receive mode
-        rfm9x_clear_interrupts(&s->radio);
+        // Not ours (e.g. the empty frame sent on init), back to receive mode
         rfm9x_listen(&s->radio);
     }
 }
 
 // --- RX ---
-static void rx_done()
+// Slot the FIFO is being read into. It is filled by DMA after rx_done
+// returns; the radio stays in standby, so nothing else is received, until
+// the read is done.
+static packet_handle_t rx_handle = PACKET_HANDLE_NONE;
+
+static void rx_fifo_done(uint8_t n)
 {
-    uint8_t p_buf[PACKET_SIZE] = {0};
-    packet_t p = {0};
-    uint8_t n = rfm9x_packet_from_fifo(&s->radio, p_buf);
+    packet_handle_t h = rx_handle;
+    packet_t *p = packet_pool_get(&s->packet_pool, h);
+    rx_handle = PACKET_HANDLE_NONE;
+
+    // Every frame heard says something about the link, even one that failed
+    // its CRC or is not for us
+    if (n > 0 || s->radio.last_rx.crc_error)
+        link_stats_record(&s->link_stats, &s->radio.last_rx,
+                          to_ms_since_boot(get_absolute_time()));
+
+    // Counted in link_stats.crc_errors, and there is nothing to parse
+    if (s->radio.last_rx.crc_error)
+    {
+        packet_pool_free(&s->packet_pool, h);
+        rfm9x_clear_interrupts(&s->radio);
+        return;
+    }
+
     s->rx_bytes += n;
-    if (!parse_packet(p_buf, n, &p))
+    if (!parse_packet_in_place(p, n))
     {
         s->rx_bad_packet_drops++;
+        packet_pool_free(&s->packet_pool, h);
         rfm9x_clear_interrupts(&s->radio);
         return;
     }
-    if ((p.dst == _RH_BROADCAST_ADDRESS || p.dst == s->radio_node))
+    if ((p->dst == _RH_BROADCAST_ADDRESS || p->dst == s->radio_node))
     {
         s->rx_packets++;
-        if (!queue_try_add(&s->rx_queue, &p))
+
+        // A replay could never authenticate; drop it before it costs a
+        // queue slot and an HMAC in the command task
+        packet_auth_result_t replay = packet_check_replay(p, s->reboot_counter);
+        if (replay != PACKET_AUTH_OK)
+        {
+            s->auth_results[replay]++;
+            packet_pool_free(&s->packet_pool, h);
+            rfm9x_clear_interrupts(&s->radio);
+            return;
+        }
+
+        link_adapt_record(s, &s->radio.last_rx);
+        // The command task owns the slot from here on
+        if (packet_pool_enqueue(&s->packet_pool, &s->rx_queue, h))
+            sched_wakeup_signal(SCHED_WAKEUP_RADIO_RX);
+        else
             s->rx_backpressure_drops++;
     }
+    else
+    {
+        packet_pool_free(&s->packet_pool, h);
+    }
     rfm9x_clear_interrupts(&s->radio);
 }
 
+static void rx_done()
+{
+    // Leave some slots for the tasks building TX packets, so a flood of
+    // uplink cannot starve the downlink
+    if (packet_pool_available(&s->packet_pool) > RADIO_TX_POOL_RESERVE)
+        rx_handle = packet_pool_alloc(&s->packet_pool);
+
+    if (rx_handle == PACKET_HANDLE_NONE)
+    {
+        // The packet stays in the FIFO until the next one overwrites it
+        s->rx_backpressure_drops++;
+        rfm9x_clear_interrupts(&s->radio);
+        return;
+    }
+
+    rfm9x_packet_from_fifo_async(
+        &s->radio, (uint8_t *)packet_pool_get(&s->packet_pool, rx_handle),
+        &rx_fifo_done);
+}
+
 void radio_task_init(slate_t *slate)
 {
     s = slate;
@@ -195,15 +410,34 @@ void radio_task_init(slate_t *slate)
     slate->rx_packets = 0;
     slate->rx_backpressure_drops = 0;
     slate->rx_bad_packet_drops = 0;
+    link_stats_init(&slate->link_stats);
 
     slate->tx_bytes = 0;
     slate->tx_packets = 0;
+    slate->tx_bursts = 0;
+    slate->tx_burst_cutoffs = 0;
+    slate->tx_timeouts = 0;
+    slate->tx_airtime_us = 0;
+    slate->tx_fec_frames = 0;
+    slate->tx_fec_us = 0;
+
+    tx_bursting = false;
+    tx_link_switch = false;
+    tx_handle = PACKET_HANDLE_NONE;
+    tx_next = PACKET_HANDLE_NONE;
+    rx_handle = PACKET_HANDLE_NONE;
 
-    // transmit queue
-    queue_init(&slate->tx_queue, sizeof(packet_t), TX_QUEUE_SIZE);
+    // Packets live in the pool; the queues pass handles to them
+    packet_pool_init(&slate->packet_pool);
+
+    // transmit queues, one per traffic class
+    tx_sched_init(&slate->tx_sched);
 
     // receive queue
-    queue_init(&slate->rx_queue, sizeof(packet_t), RX_QUEUE_SIZE);
+    queue_init(&slate->rx_queue, sizeof(packet_handle_t), RX_QUEUE_SIZE);
+
+    // Starts on the default modem settings
+    link_adapt_init(slate);
 
     // Install interrupt handlers
     rfm9x_set_tx_irq(&slate->radio, &tx_done);
@@ -220,35 +454,50 @@ void radio_task_init(slate_t *slate)
     LOG_INFO("  Node: %d", &slate->radio_node);
 }
 
-// When it sees something in the transmit queue, switches into transmit mode and
-// send a packet. Otherwise, be in recieve mode. When it recieves a packet, it
-// inturrupts the CPU to immediately recieve.
+// When it sees something in the transmit queues, switches into transmit mode
+// and sends a burst of packets. Otherwise, be in recieve mode. When it
+// recieves a packet, it inturrupts the CPU to immediately recieve.
 void radio_task_dispatch(slate_t *slate)
 {
     neopixel_set_color_rgb(RADIO_TASK_COLOR);
-    // Switch to transmit mode if queue is not empty
-    if (!queue_is_empty(&slate->tx_queue))
+    if (tx_bursting)
     {
-        rfm9x_transmit(&slate->radio);
-        LOG_INFO("Transmitting...");
-        // Since the interrupt only fires when done transmitting the last
-        // packet, we need to get it started manually to clear the tx_queue.
-        // Furthermore, at this point, if there were previously outstanding
-        // packets to be transmitted, they should have been cleared by tx_done
-        // triggering the next interrupt in a chain.
-        // So we should NEVER end up calling tx_done when the radio is still
-        // transmitting.
-        tx_done();
+        // The TX interrupt chain runs the burst. It only needs rescuing if a
+        // TxDone went missing.
+        if (absolute_time_diff_us(tx_frame_start, get_absolute_time()) >
+            tx_frame_timeout_us)
+        {
+            LOG_ERROR("TX: No TxDone, abandoning burst");
+            slate->tx_timeouts++;
+            if (tx_next != PACKET_HANDLE_NONE)
+            {
+                packet_pool_free(&slate->packet_pool, tx_next);
+                tx_next = PACKET_HANDLE_NONE;
+            }
+            tx_end_burst();
+        }
     }
     else
     {
-        rfm9x_listen(&slate->radio);
+        // May queue a proposal for this burst
+        link_adapt_dispatch(slate);
+
+        if (!tx_sched_is_empty(&slate->tx_sched))
+        {
+            LOG_INFO("Transmitting...");
+            tx_start_burst();
+        }
+        else
+        {
+            rfm9x_listen(&slate->radio);
+        }
     }
     neopixel_set_color_rgb(0, 0, 0);
 }
 
 sched_task_t radio_task = {.name = "radio",
                            .dispatch_period_ms = 100,
+                           .priority = SCHED_PRIORITY_CRITICAL,
                            .task_init = &radio_task_init,
                            .task_dispatch = &radio_task_dispatch,
 
@@ -19,13 +19,26 @@
 #include "typedefs.h"
 
 #include "packet.h"
+#include "packet_pool.h"
 #include "rfm9x.h"
+#include "tx_sched.h"
 
 // LED Color for radio task - Magenta
 #define RADIO_TASK_COLOR 255, 0, 255
 
-#define TX_QUEUE_SIZE 16
-#define RX_QUEUE_SIZE 16
+// The queue holds packet_handle_t, so it can be as deep as the whole pool
+#define RX_QUEUE_SIZE PACKET_POOL_SIZE
+
+// Pool slots the RX interrupt leaves free for TX packets
+#define RADIO_TX_POOL_RESERVE 4
+
+// Limits on one TX burst, after which the radio listens again until the next
+// dispatch. The airtime budget bounds how long the ground cannot uplink.
+#define RADIO_TX_BURST_MAX_PACKETS 16
+#define RADIO_TX_BURST_AIRTIME_MS 3000
+
+// A burst with no TxDone this long after the frame's airtime is abandoned
+#define RADIO_TX_FRAME_TIMEOUT_MS 1000
 
 size_t encode_packet(const packet_t *p, uint8_t *buf, size_t bufsize,
                      bool enable_hmac);
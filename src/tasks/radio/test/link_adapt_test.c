@@ -0,0 +1,162 @@
+#include "link_adapt.h"
+#include "error.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include "radio_task.h"
+#include <stdio.h>
+
+slate_t test_slate;
+
+/**
+ * Tests for the link adaptation and its handshake through the radio task.
+ */
+
+static void record_n(int n, int8_t snr_q4)
+{
+    rfm9x_rx_info_t rx = {.rssi_dbm = -90, .snr_q4 = snr_q4};
+    for (int i = 0; i < n; i++)
+        link_adapt_record(&test_slate, &rx);
+}
+
+static packet_t *peek_tx(void)
+{
+    packet_handle_t h;
+    ASSERT(queue_try_peek(&test_slate.tx_sched.queues[TX_CLASS_COMMAND], &h));
+    return packet_pool_get(&test_slate.packet_pool, h);
+}
+
+void test_recommend()
+{
+    printf("Starting recommend test\n");
+    ASSERT(test_slate.link_profile == LINK_PROFILE_DEFAULT);
+
+    // Too few samples to judge
+    record_n(LINK_MIN_SAMPLES - 1, 10 * 4);
+    ASSERT(link_adapt_recommend(&test_slate) == LINK_PROFILE_DEFAULT);
+
+    // Plenty of margin over the next profile up
+    record_n(1, 10 * 4);
+    ASSERT(link_adapt_recommend(&test_slate) == LINK_PROFILE_DEFAULT + 1);
+
+    // Not while recent uplink frames are failing their CRC
+    rfm9x_rx_info_t bad = {.crc_error = true};
+    rfm9x_rx_info_t good = {0};
+    link_stats_record(&test_slate.link_stats, &bad, 0);
+    ASSERT(link_adapt_recommend(&test_slate) == LINK_PROFILE_DEFAULT);
+    for (int i = 0; i < LINK_MIN_SAMPLES; i++)
+        link_stats_record(&test_slate.link_stats, &good, 0);
+    ASSERT(link_adapt_recommend(&test_slate) == LINK_PROFILE_DEFAULT + 1);
+
+    // Somewhere in between: stay
+    test_slate.link_samples = 0;
+    record_n(LINK_MIN_SAMPLES, -2 * 4);
+    ASSERT(link_adapt_recommend(&test_slate) == LINK_PROFILE_DEFAULT);
+
+    // Too close to the floor
+    test_slate.link_samples = 0;
+    record_n(LINK_MIN_SAMPLES, -6 * 4);
+    ASSERT(link_adapt_recommend(&test_slate) == LINK_PROFILE_DEFAULT - 1);
+
+    test_slate.link_samples = 0;
+}
+
+void test_handshake()
+{
+    printf("Starting handshake test\n");
+    uint32_t sent = test_slate.tx_packets;
+
+    // No proposal before the interval is up
+    record_n(LINK_MIN_SAMPLES, 10 * 4);
+    radio_task_dispatch(&test_slate);
+    ASSERT(test_slate.tx_packets == sent);
+
+    mock_time_us += (LINK_PROPOSE_INTERVAL_MS + 1) * 1000ULL;
+    link_adapt_dispatch(&test_slate);
+    packet_t *p = peek_tx();
+    link_report_t *report = (link_report_t *)p->data;
+    ASSERT(p->flags == LINK_FLAG_PROPOSE);
+    ASSERT(p->len == sizeof(link_report_t));
+    ASSERT(report->current == LINK_PROFILE_DEFAULT);
+    ASSERT(report->next == LINK_PROFILE_DEFAULT + 1);
+    ASSERT(report->snr_avg_q4 == 10 * 4);
+    ASSERT(report->rssi_dbm == -90);
+
+    radio_task_dispatch(&test_slate);
+    ASSERT(test_slate.tx_packets == sent + 1);
+    ASSERT(test_slate.link_profile == LINK_PROFILE_DEFAULT);
+
+    // The ground accepts. The ACK goes out on the old settings and ends the
+    // burst; the frame queued behind it waits for the new ones.
+    ASSERT(link_adapt_request(&test_slate, LINK_PROFILE_DEFAULT + 1));
+    p = peek_tx();
+    ASSERT(p->flags == LINK_FLAG_ACK);
+    ASSERT(((link_report_t *)p->data)->next == LINK_PROFILE_DEFAULT + 1);
+
+    packet_handle_t h = packet_pool_alloc(&test_slate.packet_pool);
+    packet_pool_get(&test_slate.packet_pool, h)->len = 10;
+    tx_sched_enqueue(&test_slate.tx_sched, &test_slate.packet_pool,
+                     TX_CLASS_BULK, h);
+
+    radio_task_dispatch(&test_slate);
+    ASSERT(test_slate.tx_packets == sent + 2);
+    ASSERT(tx_sched_level(&test_slate.tx_sched) == 1);
+    ASSERT(test_slate.link_profile == LINK_PROFILE_DEFAULT + 1);
+    ASSERT(test_slate.link_pending_profile == LINK_PROFILE_NONE);
+    ASSERT(test_slate.link_switches == 1);
+    ASSERT(test_slate.radio.modem.bw == 250000);
+
+    radio_task_dispatch(&test_slate);
+    ASSERT(test_slate.tx_packets == sent + 3);
+    ASSERT(packet_pool_available(&test_slate.packet_pool) == PACKET_POOL_SIZE);
+}
+
+void test_snr_normalized()
+{
+    printf("Starting SNR normalization test\n");
+
+    // At 250 kHz the same signal reads 3 dB lower than at 125 kHz
+    ASSERT(test_slate.radio.modem.bw == 250000);
+    record_n(1, 7 * 4);
+    ASSERT(test_slate.link_snr_avg_q4 == 10 * 4);
+    test_slate.link_samples = 0;
+}
+
+void test_fallback()
+{
+    printf("Starting fallback test\n");
+    ASSERT(test_slate.link_profile != LINK_PROFILE_DEFAULT);
+
+    mock_time_us += LINK_FALLBACK_MS * 1000ULL;
+    radio_task_dispatch(&test_slate);
+    ASSERT(test_slate.link_profile != LINK_PROFILE_DEFAULT);
+
+    mock_time_us += 1000;
+    radio_task_dispatch(&test_slate);
+    ASSERT(test_slate.link_profile == LINK_PROFILE_DEFAULT);
+    ASSERT(test_slate.link_fallbacks == 1);
+    ASSERT(test_slate.radio.modem.bw == RFM9X_BANDWIDTH);
+    ASSERT(test_slate.radio.modem.sf == RFM9X_SPREADING_FACTOR);
+}
+
+void test_bad_request()
+{
+    printf("Starting bad request test\n");
+    ASSERT(!link_adapt_request(&test_slate, LINK_PROFILE_COUNT));
+    ASSERT(test_slate.link_pending_profile == LINK_PROFILE_NONE);
+    ASSERT(tx_sched_is_empty(&test_slate.tx_sched));
+}
+
+int main()
+{
+    printf("Starting link adaptation test\n");
+
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    radio_task_init(&test_slate);
+    test_recommend();
+    test_handshake();
+    test_snr_normalized();
+    test_fallback();
+    test_bad_request();
+    free_slate(&test_slate);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "link_stats.h"
+#include "error.h"
+#include "logger.h"
+#include <stdio.h>
+
+/**
+ * Tests for the uplink statistics ring and its beacon summary.
+ */
+
+static link_stats_t ls;
+
+static void record(int16_t rssi_dbm, int8_t snr_q4, int32_t freq_error_hz,
+                   bool crc_error, uint32_t time_ms)
+{
+    rfm9x_rx_info_t rx = {.freq_error_hz = freq_error_hz,
+                          .rssi_dbm = rssi_dbm,
+                          .snr_q4 = snr_q4,
+                          .crc_error = crc_error};
+    link_stats_record(&ls, &rx, time_ms);
+}
+
+void test_empty()
+{
+    printf("Starting empty summary test\n");
+    link_stats_init(&ls);
+
+    link_stats_summary_t sum;
+    link_stats_summarize(&ls, 1000, &sum);
+    ASSERT(sum.samples == 0);
+    ASSERT(sum.rssi_min_dbm == 0);
+    ASSERT(sum.age_s == 0);
+    ASSERT(link_stats_recent_crc_errors(&ls, 4) == 0);
+}
+
+void test_summary()
+{
+    printf("Starting summary test\n");
+    link_stats_init(&ls);
+
+    record(-100, 8, 1000, false, 1000);
+    record(-110, -4, 3000, true, 2000);
+    record(-90, 20, -1000, false, 3000);
+
+    link_stats_summary_t sum;
+    link_stats_summarize(&ls, 63500, &sum);
+    ASSERT(sum.samples == 3);
+    ASSERT(sum.crc_errors == 1);
+    ASSERT(sum.rssi_avg_dbm == -100);
+    ASSERT(sum.rssi_min_dbm == -110);
+    ASSERT(sum.snr_avg_q4 == 8);
+    ASSERT(sum.snr_min_q4 == -4);
+    ASSERT(sum.freq_error_avg_hz == 1000);
+    ASSERT(sum.age_s == 60);
+
+    ASSERT(link_stats_recent_crc_errors(&ls, 1) == 0);
+    ASSERT(link_stats_recent_crc_errors(&ls, 2) == 1);
+    ASSERT(link_stats_recent_crc_errors(&ls, 100) == 1);
+}
+
+void test_wrap()
+{
+    printf("Starting ring wrap test\n");
+    link_stats_init(&ls);
+
+    // Old frames with CRC errors fall out of the ring, but not the totals
+    for (int i = 0; i < LINK_STATS_RING_SIZE; i++)
+        record(-130, -40, 0, true, i);
+    for (int i = 0; i < LINK_STATS_RING_SIZE; i++)
+        record(-80, 40, 0, false, 100 + i);
+
+    link_stats_summary_t sum;
+    link_stats_summarize(&ls, 200, &sum);
+    ASSERT(sum.samples == LINK_STATS_RING_SIZE);
+    ASSERT(sum.crc_errors == 0);
+    ASSERT(sum.rssi_min_dbm == -80);
+    ASSERT(ls.frames == 2 * LINK_STATS_RING_SIZE);
+    ASSERT(ls.crc_errors == LINK_STATS_RING_SIZE);
+
+    record(-130, -40, 0, true, 300);
+    ASSERT(link_stats_recent_crc_errors(&ls, LINK_STATS_RING_SIZE) == 1);
+
+    // An age too large for the beacon saturates
+    link_stats_summarize(&ls, 300 + 100000000, &sum);
+    ASSERT(sum.age_s == UINT16_MAX);
+}
+
+int main()
+{
+    printf("Starting link statistics test\n");
+    test_empty();
+    test_summary();
+    test_wrap();
+    return 0;
+}
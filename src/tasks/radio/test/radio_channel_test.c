@@ -0,0 +1,318 @@
+/**
+ * @file radio_channel_test.c
+ * @brief End-to-end link test: the radio and command tasks on an emulated
+ * channel with a ground station stand-in. Keeps the downlink busy with bulk
+ * frames while the ground pings, and reports goodput and command latency for
+ * a few channels. Every run is deterministic.
+ */
+
+#include "command_parser.h"
+#include "command_task.h"
+#include "error.h"
+#include "logger.h"
+#include "packet_fec.h"
+#include "pico/stdlib.h"
+#include "radio_task.h"
+#include "rfm9x_channel.h"
+#include "test_scheduler_helpers.h"
+
+#define SIM_DURATION_MS 120000
+#define PING_INTERVAL_MS 5000
+#define PING_TIMEOUT_MS 4000
+
+// The ground only keys up after this long without hearing a frame
+#define GROUND_QUIET_US 5000
+
+#define BULK_FILL 0xB5
+#define BULK_QUEUE_DEPTH 16
+
+slate_t test_slate;
+
+typedef struct
+{
+    const char *name;
+    rfm9x_channel_config_t channel;
+    bool bulk;
+    // One bulk frame per interval, or 0 to keep the bulk queue full
+    uint32_t bulk_interval_ms;
+    // Bulk frames carry Reed-Solomon parity, which the ground checks in
+    // place of the CRC
+    bool fec;
+} scenario_t;
+
+typedef struct
+{
+    double goodput_bps;
+    uint32_t bulk_frames;
+    uint32_t pings;
+    uint32_t replies;
+    uint64_t latency_total_us;
+    uint64_t latency_max_us;
+} result_t;
+
+static struct
+{
+    rfm9x_t radio;
+    bool fec;
+    bool ping_pending;
+    uint64_t ping_sent_us;
+    uint64_t next_ping_us;
+    uint64_t last_heard_us;
+    result_t *res;
+} ground;
+
+// Carries over between runs, as the satellite's replay window does
+static uint32_t ground_msg_id;
+
+#ifdef PACKET_HMAC_PSK
+static packet_hmac_key_t ground_key;
+#endif
+
+static void ground_tx_done(void)
+{
+    rfm9x_listen(&ground.radio);
+}
+
+static void ground_rx_done(void)
+{
+    uint8_t buf[256];
+    uint8_t n = rfm9x_packet_from_fifo(&ground.radio, buf);
+    ground.last_heard_us = mock_time_us;
+    if (n < PACKET_HEADER_SIZE)
+        return;
+
+    packet_t *p = (packet_t *)buf;
+    if (ground.fec && (p->flags & PACKET_FLAG_FEC) &&
+        packet_fec_decode(buf, n) < 0)
+        return;
+    if (n < PACKET_HEADER_SIZE + p->len)
+        return;
+
+    const char reply[] = "Number commands executed";
+    if (p->len >= sizeof(reply) - 1 &&
+        memcmp(p->data, reply, sizeof(reply) - 1) == 0)
+    {
+        if (ground.ping_pending)
+        {
+            uint64_t latency_us = mock_time_us - ground.ping_sent_us;
+            ground.ping_pending = false;
+            ground.res->replies++;
+            ground.res->latency_total_us += latency_us;
+            if (latency_us > ground.res->latency_max_us)
+                ground.res->latency_max_us = latency_us;
+        }
+        return;
+    }
+
+    // Only count bulk data that arrived intact
+    for (int i = 0; i < p->len; i++)
+        if (p->data[i] != BULK_FILL)
+            return;
+    ground.res->bulk_frames++;
+}
+
+static void ground_send_ping(void)
+{
+    packet_t p = {.dst = test_slate.radio_node,
+                  .len = 1,
+                  .data = {PING},
+                  .boot_count = test_slate.reboot_counter,
+                  .msg_id = ++ground_msg_id};
+#ifdef PACKET_HMAC_PSK
+    packet_compute_hmac(&ground_key, &p, p.hmac);
+#endif
+    uint8_t buf[PACKET_SIZE];
+    size_t n = encode_packet(&p, buf, sizeof(buf), true);
+
+    rfm9x_packet_to_fifo(&ground.radio, buf, n);
+    rfm9x_transmit(&ground.radio);
+    ground.ping_pending = true;
+    ground.ping_sent_us = mock_time_us;
+    ground.next_ping_us = mock_time_us + PING_INTERVAL_MS * 1000ULL;
+    ground.res->pings++;
+}
+
+// When the ground next has something to do
+static uint64_t ground_next_us(void)
+{
+    if (ground.ping_pending)
+        return ground.ping_sent_us + PING_TIMEOUT_MS * 1000ULL;
+    uint64_t quiet_us = ground.last_heard_us + GROUND_QUIET_US;
+    return ground.next_ping_us > quiet_us ? ground.next_ping_us : quiet_us;
+}
+
+static void ground_step(void)
+{
+    if (ground.ping_pending &&
+        mock_time_us >= ground.ping_sent_us + PING_TIMEOUT_MS * 1000ULL)
+        ground.ping_pending = false;
+
+    if (!ground.ping_pending && mock_time_us >= ground_next_us())
+        ground_send_ping();
+}
+
+static bool queue_bulk(bool fec)
+{
+    tx_sched_t *tx = &test_slate.tx_sched;
+    if (queue_get_level(&tx->queues[TX_CLASS_BULK]) >= BULK_QUEUE_DEPTH ||
+        !tx_sched_has_room(&test_slate.packet_pool, TX_CLASS_BULK))
+        return false;
+
+    packet_handle_t h =
+        tx_sched_alloc(tx, &test_slate.packet_pool, TX_CLASS_BULK);
+    packet_t *p = packet_pool_get(&test_slate.packet_pool, h);
+    memset(p, 0, sizeof(*p));
+    p->dst = _RH_BROADCAST_ADDRESS;
+    p->flags = fec ? PACKET_FLAG_FEC : 0;
+    p->len = PACKET_DATA_SIZE;
+    memset(p->data, BULK_FILL, p->len);
+    ASSERT(tx_sched_enqueue(tx, &test_slate.packet_pool, TX_CLASS_BULK, h));
+    return true;
+}
+
+static uint64_t min_us(uint64_t a, uint64_t b)
+{
+    return a < b ? a : b;
+}
+
+static void run(const scenario_t *sc, result_t *res)
+{
+    memset(res, 0, sizeof(*res));
+    // The tasks log every frame; only the results are worth reading
+    logger_mock_echo = false;
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    rfm9x_channel_init(&sc->channel);
+    rfm9x_channel_attach(&test_slate.radio, true);
+    rfm9x_channel_attach(&ground.radio, !sc->fec);
+    radio_task_init(&test_slate);
+    command_task_init(&test_slate);
+
+    memset(&ground, 0, sizeof(ground));
+    // Each run is a reboot with the same boot count, so the satellite's
+    // replay window starts past every msg_id it reserved
+    ground_msg_id += PACKET_REPLAY_RESERVE;
+    ground.fec = sc->fec;
+    ground.res = res;
+    ground.radio.modem = test_slate.radio.modem;
+    ground.next_ping_us = mock_time_us + PING_INTERVAL_MS * 1000ULL;
+    ground.last_heard_us = mock_time_us;
+    rfm9x_set_tx_irq(&ground.radio, &ground_tx_done);
+    rfm9x_set_rx_irq(&ground.radio, &ground_rx_done);
+    rfm9x_listen(&ground.radio);
+
+    uint64_t start_us = mock_time_us;
+    uint64_t end_us = start_us + SIM_DURATION_MS * 1000ULL;
+    uint64_t next_radio_us = start_us;
+    uint64_t next_command_us = start_us;
+    uint64_t next_bulk_us =
+        sc->bulk && sc->bulk_interval_ms > 0 ? start_us : UINT64_MAX;
+    while (mock_time_us < end_us)
+    {
+        uint64_t t = min_us(end_us, rfm9x_channel_next_event_us());
+        t = min_us(t, min_us(next_radio_us, next_command_us));
+        t = min_us(t, min_us(next_bulk_us, ground_next_us()));
+        rfm9x_channel_run_until(t);
+
+        // Stand in for the scheduler: the command task wakes on RX
+        if (mock_time_us >= next_command_us ||
+            !queue_is_empty(&test_slate.rx_queue))
+        {
+            command_task_dispatch(&test_slate);
+            next_command_us =
+                mock_time_us + command_task.dispatch_period_ms * 1000ULL;
+        }
+        if (mock_time_us >= next_bulk_us)
+        {
+            queue_bulk(sc->fec);
+            next_bulk_us += sc->bulk_interval_ms * 1000ULL;
+        }
+        if (mock_time_us >= next_radio_us)
+        {
+            while (sc->bulk && sc->bulk_interval_ms == 0 && queue_bulk(sc->fec))
+                ;
+            radio_task_dispatch(&test_slate);
+            next_radio_us += radio_task.dispatch_period_ms * 1000ULL;
+        }
+        ground_step();
+    }
+
+    // A ping still in flight at the end had no chance to be answered
+    if (ground.ping_pending)
+        res->pings--;
+
+    res->goodput_bps =
+        res->bulk_frames * PACKET_DATA_SIZE * 8.0 * 1e6 / (end_us - start_us);
+    const rfm9x_channel_stats_t *g = rfm9x_channel_stats(&ground.radio);
+    logger_mock_echo = true;
+    LOG_INFO("%-10s %9.0f %6u/%-6u %8llu %8llu   %u/%u/%u/%u", sc->name,
+             res->goodput_bps, res->replies, res->pings,
+             res->replies ? (unsigned long long)(res->latency_total_us /
+                                                 res->replies / 1000)
+                          : 0ULL,
+             (unsigned long long)(res->latency_max_us / 1000), g->lost,
+             g->corrupted, g->collisions, g->missed);
+
+    free_slate(&test_slate);
+}
+
+int main()
+{
+    LOG_INFO("Starting radio channel test");
+#ifdef PACKET_HMAC_PSK
+    packet_hmac_key_init(&ground_key, (const uint8_t *)PACKET_HMAC_PSK,
+                         PACKET_HMAC_PSK_LEN);
+#endif
+
+    const rfm9x_channel_config_t clear = {.latency_us = 5000,
+                                          .turnaround_us = 1000,
+                                          .rssi_dbm = -100,
+                                          .snr_q4 = 0,
+                                          .seed = 1};
+    rfm9x_channel_config_t lossy = clear;
+    lossy.loss = 0.1;
+    rfm9x_channel_config_t noisy = clear;
+    noisy.ber = 3e-4;
+
+    const scenario_t scenarios[] = {
+        {"idle", clear, false, 0, false},
+        {"half", clear, true, 700, false},
+        {"bulk", clear, true, 0, false},
+        {"lossy", lossy, true, 0, false},
+        {"noisy", noisy, true, 0, false},
+        {"noisy+fec", noisy, true, 0, true},
+    };
+    result_t res[sizeof(scenarios) / sizeof(scenarios[0])];
+
+    LOG_INFO("%-10s %9s %13s %8s %8s   %s", "channel", "goodput", "pings",
+             "avg_ms", "max_ms", "ground lost/corrupt/collided/missed");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+        run(&scenarios[i], &res[i]);
+
+    const result_t *idle = &res[0], *half = &res[1], *bulk = &res[2],
+                   *lossy_res = &res[3], *noisy_res = &res[4],
+                   *fec_res = &res[5];
+
+    // An idle link answers every ping within a couple of frame times
+    ASSERT(idle->replies == idle->pings);
+    ASSERT(idle->latency_max_us < 500000);
+
+    // With room between frames, commands that get through are as quick as on
+    // an idle link. Many collide with downlink, which goes out unannounced.
+    ASSERT(half->replies > 0);
+    ASSERT(half->latency_max_us < 500000);
+
+    // A saturated link is mostly payload. Bursts leave no room for the
+    // uplink, so this measures goodput only.
+    uint32_t frame_us = rfm9x_airtime_us(&test_slate.radio.modem,
+                                         PACKET_HEADER_SIZE + PACKET_DATA_SIZE);
+    double max_bps = PACKET_DATA_SIZE * 8.0 * 1e6 / frame_us;
+    ASSERT(bulk->goodput_bps > 0.8 * max_bps);
+    ASSERT(half->goodput_bps < bulk->goodput_bps);
+
+    ASSERT(lossy_res->goodput_bps < bulk->goodput_bps);
+    ASSERT(lossy_res->goodput_bps > 0.8 * bulk->goodput_bps);
+
+    // Parity pays for itself once bit errors are common
+    ASSERT(fec_res->goodput_bps > noisy_res->goodput_bps);
+    return 0;
+}
@@ -1,8 +1,12 @@
 #include "error.h"
 #include "logger.h"
+#include "packet_fec.h"
+#include "pico/stdlib.h"
 #include "radio_task.h"
 #include <stdio.h>
 
+slate_t test_slate;
+
 /**
  * Test for radio task.
  */
@@ -45,9 +49,174 @@ void test_encode_packet_basic()
     printf("\n");
 }
 
+void test_encode_packet_fec()
+{
+    printf("Starting FEC encode_packet test\n");
+    packet_t p = {
+        .dst = 1, .flags = PACKET_FLAG_FEC, .len = 3, .data = {0xAA, 0xBB}};
+    uint8_t buf[PACKET_SIZE] = {0};
+
+    size_t n = encode_packet(&p, buf, sizeof(buf), false);
+    ASSERT(n == PACKET_HEADER_SIZE + 3 + PACKET_FEC_PARITY_SIZE);
+    buf[PACKET_HEADER_SIZE + 1] ^= 0xFF;
+    ASSERT(packet_fec_decode(buf, n) == 1);
+    ASSERT(buf[PACKET_HEADER_SIZE + 1] == 0xBB);
+
+    // With the footer too, a full packet no longer fits one codeword
+    p.len = PACKET_DATA_SIZE;
+    ASSERT(encode_packet(&p, buf, sizeof(buf), true) == 0);
+}
+
+/**
+ * Queue n downlink packets with len bytes of data each.
+ */
+static void queue_packets(int n, uint8_t len)
+{
+    for (int i = 0; i < n; i++)
+    {
+        packet_handle_t h = packet_pool_alloc(&test_slate.packet_pool);
+        ASSERT(h != PACKET_HANDLE_NONE);
+        packet_t *p = packet_pool_get(&test_slate.packet_pool, h);
+        p->dst = _RH_BROADCAST_ADDRESS;
+        p->len = len;
+        ASSERT(tx_sched_enqueue(&test_slate.tx_sched, &test_slate.packet_pool,
+                                TX_CLASS_BULK, h));
+    }
+}
+
+void test_burst_packet_limit()
+{
+    printf("Starting burst packet limit test\n");
+    uint32_t sent = test_slate.tx_packets;
+
+    queue_packets(RADIO_TX_BURST_MAX_PACKETS + 4, 10);
+    radio_task_dispatch(&test_slate);
+
+    // One burst, cut off at the packet limit; the rest wait for the next one
+    ASSERT(test_slate.tx_packets == sent + RADIO_TX_BURST_MAX_PACKETS);
+    ASSERT(test_slate.tx_bursts == 1);
+    ASSERT(test_slate.tx_burst_cutoffs == 1);
+    ASSERT(tx_sched_level(&test_slate.tx_sched) == 4);
+
+    radio_task_dispatch(&test_slate);
+    ASSERT(test_slate.tx_packets == sent + RADIO_TX_BURST_MAX_PACKETS + 4);
+    ASSERT(test_slate.tx_bursts == 2);
+    ASSERT(test_slate.tx_burst_cutoffs == 1);
+
+    // Every slot is back in the pool
+    ASSERT(packet_pool_available(&test_slate.packet_pool) == PACKET_POOL_SIZE);
+}
+
+void test_burst_airtime_budget()
+{
+    printf("Starting burst airtime budget test\n");
+    uint32_t sent = test_slate.tx_packets;
+    uint64_t airtime_us = test_slate.tx_airtime_us;
+
+    uint32_t frame_us = rfm9x_airtime_us(&test_slate.radio.modem,
+                                         PACKET_HEADER_SIZE + PACKET_DATA_SIZE);
+    uint32_t fit = RADIO_TX_BURST_AIRTIME_MS * 1000 / frame_us;
+    ASSERT(fit > 0 && fit < RADIO_TX_BURST_MAX_PACKETS);
+
+    queue_packets(fit + 2, PACKET_DATA_SIZE);
+    radio_task_dispatch(&test_slate);
+
+    ASSERT(test_slate.tx_packets == sent + fit);
+    ASSERT(test_slate.tx_airtime_us == airtime_us + (uint64_t)fit * frame_us);
+    ASSERT(tx_sched_level(&test_slate.tx_sched) == 2);
+
+    radio_task_dispatch(&test_slate);
+    ASSERT(tx_sched_is_empty(&test_slate.tx_sched));
+}
+
+void test_fec_frame()
+{
+    printf("Starting FEC frame test\n");
+    uint32_t bytes = test_slate.tx_bytes;
+
+    queue_packets(2, 10);
+    packet_handle_t h;
+    ASSERT(queue_try_peek(&test_slate.tx_sched.queues[TX_CLASS_BULK], &h));
+    packet_t *p = packet_pool_get(&test_slate.packet_pool, h);
+    p->flags = PACKET_FLAG_FEC;
+
+    radio_task_dispatch(&test_slate);
+    ASSERT(tx_sched_is_empty(&test_slate.tx_sched));
+    ASSERT(test_slate.tx_fec_frames == 1);
+    ASSERT(test_slate.tx_bytes ==
+           bytes + 2 * (PACKET_HEADER_SIZE + 10) + PACKET_FEC_PARITY_SIZE);
+
+    // The parity went out in place of the footer
+    ASSERT(packet_fec_decode((uint8_t *)p,
+                             PACKET_HEADER_SIZE + 10 +
+                                 PACKET_FEC_PARITY_SIZE) == 0);
+}
+
+void test_burst_timeout()
+{
+    printf("Starting burst timeout test\n");
+
+    // No TxDone will come
+    rfm9x_set_tx_irq(&test_slate.radio, NULL);
+    queue_packets(2, 10);
+    radio_task_dispatch(&test_slate);
+    ASSERT(tx_sched_level(&test_slate.tx_sched) == 0);
+
+    // Still waiting: nothing happens
+    radio_task_dispatch(&test_slate);
+    ASSERT(test_slate.tx_timeouts == 0);
+
+    mock_time_us += rfm9x_airtime_us(&test_slate.radio.modem,
+                                     PACKET_HEADER_SIZE + 10) +
+                    (RADIO_TX_FRAME_TIMEOUT_MS + 1) * 1000ULL;
+    radio_task_dispatch(&test_slate);
+    ASSERT(test_slate.tx_timeouts == 1);
+
+    // The staged second frame went back to the pool
+    ASSERT(packet_pool_available(&test_slate.packet_pool) == PACKET_POOL_SIZE);
+}
+
+void test_rx_link_stats()
+{
+    printf("Starting RX link statistics test\n");
+    uint32_t bad = test_slate.rx_bad_packet_drops;
+
+    // A frame for another node still counts for the link
+    uint8_t frame[PACKET_MIN_SIZE + 3] = {7, 0, 0, 0, 3};
+    rfm9x_rx_info_t rx = {.freq_error_hz = -1200, .rssi_dbm = -110,
+                          .snr_q4 = -20};
+    rfm9x_mock_receive(&test_slate.radio, frame, sizeof(frame), &rx);
+
+    // So does one that failed its CRC, though it goes no further
+    rx.crc_error = true;
+    rx.rssi_dbm = -120;
+    rfm9x_mock_receive(&test_slate.radio, frame, sizeof(frame), &rx);
+
+    link_stats_t *ls = &test_slate.link_stats;
+    ASSERT(ls->frames == 2);
+    ASSERT(ls->crc_errors == 1);
+    ASSERT(ls->ring[0].rx.rssi_dbm == -110);
+    ASSERT(ls->ring[0].rx.freq_error_hz == -1200);
+    ASSERT(!ls->ring[0].rx.crc_error);
+    ASSERT(ls->ring[1].rx.crc_error);
+    ASSERT(test_slate.rx_bad_packet_drops == bad);
+    ASSERT(test_slate.rx_packets == 0);
+    ASSERT(packet_pool_available(&test_slate.packet_pool) == PACKET_POOL_SIZE);
+}
+
 int main()
 {
     printf("Starting radio test\n");
     test_encode_packet_basic();
+    test_encode_packet_fec();
+
+    ASSERT(clear_and_init_slate(&test_slate) == 0);
+    radio_task_init(&test_slate);
+    test_burst_packet_limit();
+    test_burst_airtime_budget();
+    test_fec_frame();
+    test_burst_timeout();
+    test_rx_link_stats();
+    free_slate(&test_slate);
     return 0;
 }
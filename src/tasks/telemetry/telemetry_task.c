@@ -163,5 +163,11 @@ sched_task_t telemetry_task = {.name = "telemetry",
                                .dispatch_period_ms = 1000,
                                .task_init = &telemetry_task_init,
                                .task_dispatch = &telemetry_task_dispatch,
+                               /* Keep a fixed sampling cadence */
+                               .period_mode = SCHED_PERIOD_FIXED_RATE_SKIP,
+                               /* A dead I2C bus costs I2C_TIMEOUT_MS per
+                                  read; back off instead of stalling */
+                               .budget_ms = 3 * I2C_TIMEOUT_MS,
+                               .budget_skip_periods = 4,
                                /* Set to an actual value on init */
                                .next_dispatch = 0};
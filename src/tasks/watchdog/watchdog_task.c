@@ -6,21 +6,58 @@
  */
 
 #include "watchdog_task.h"
+#include "logger.h"
 #include "neopixel.h"
 
 void watchdog_task_init(slate_t *slate)
 {
+    slate->watchdog_last_dispatch = get_absolute_time();
+    slate->watchdog_stalls = 0;
+}
+
+/**
+ * Report a long gap since the last feed, naming the slowest task that ran in
+ * it, so a stall is visible in the logs before it is long enough for the
+ * hardware watchdog to reset us.
+ *
+ * Not every state runs this task (e.g. burn_wire), so a gap is measured from
+ * entering the current state if that came after the last feed.
+ */
+static void watchdog_check_stall(slate_t *slate)
+{
+    absolute_time_t now = get_absolute_time();
+    absolute_time_t since = slate->watchdog_last_dispatch;
+    if (absolute_time_diff_us(since, slate->entered_current_state_time) > 0)
+        since = slate->entered_current_state_time;
+
+    uint64_t gap_us = absolute_time_diff_us(since, now);
+    slate->watchdog_last_dispatch = now;
+
+    if (gap_us > WATCHDOG_STALL_MS * 1000ULL)
+    {
+        slate->watchdog_stalls++;
+        LOG_ERROR("watchdog: Loop stalled for %u ms, slowest task %s (%u us)",
+                  (uint32_t)(gap_us / 1000),
+                  slate->sched_slowest_task ? slate->sched_slowest_task
+                                            : "unknown",
+                  slate->sched_slowest_us);
+    }
+
+    slate->sched_slowest_task = NULL;
+    slate->sched_slowest_us = 0;
 }
 
 void watchdog_task_dispatch(slate_t *slate)
 {
     neopixel_set_color_rgb(WATCHDOG_TASK_COLOR);
     watchdog_feed(&slate->watchdog);
+    watchdog_check_stall(slate);
     neopixel_set_color_rgb(0, 0, 0);
 }
 
 sched_task_t watchdog_task = {.name = "watchdog",
                               .dispatch_period_ms = 100,
+                              .priority = SCHED_PRIORITY_CRITICAL,
                               .task_init = &watchdog_task_init,
                               .task_dispatch = &watchdog_task_dispatch,
 
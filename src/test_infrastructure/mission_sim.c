@@ -0,0 +1,191 @@
+/**
+ * @file mission_sim.c
+ *
+ * Faster-than-real-time mission simulator.
+ *
+ * Runs the real sched_init/sched_dispatch over every state and task, linked
+ * against the host driver mocks. Whenever the scheduler idles, the mock
+ * best_effort_wfe_or_timeout jumps mock_time_us straight to the next
+ * deadline, so a simulated day takes a fraction of a second.
+ *
+ * At the end it prints per-task dispatch counts, time spent in each state,
+ * queue high-water marks and an estimate of energy use.
+ *
+ * Usage: mission_sim [days]
+ */
+
+#include "error.h"
+#include "logger.h"
+#include "pico/stdlib.h"
+#include "sched_core1.h"
+#include "test_scheduler_helpers.h"
+#include <stdlib.h>
+
+#define US_PER_DAY (24ULL * 60 * 60 * 1000 * 1000)
+
+/*
+ * Power model, in mW. Rough datasheet figures at 3.3 V; adjust to match
+ * bench measurements.
+ */
+#define SIM_MCU_ACTIVE_MW 80.0 // RP2350 running from flash at 150 MHz
+#define SIM_MCU_IDLE_MW 15.0   // RP2350 in WFE, clocks running
+#define SIM_RADIO_TX_MW 400.0  // RFM98 at +20 dBm
+#define SIM_RADIO_RX_MW 40.0   // RFM98 listening
+
+/*
+ * Host mocks take no simulated time, so each dispatch is also charged a
+ * nominal amount of CPU time when estimating energy.
+ */
+#define SIM_DISPATCH_COST_US 1000
+
+slate_t sim_slate;
+
+static void print_tasks(void)
+{
+    printf("\n%-12s %10s %8s %8s %8s %10s %10s\n", "task", "dispatches",
+           "skipped", "overruns", "budget", "max_late", "cpu_ms");
+    for (size_t i = 0; i < state_registry_task_count(); i++)
+    {
+        sched_task_t *task = state_registry_get_task_by_index(i);
+        const sched_task_profile_t *p = &task->profile;
+        printf("%-12s %10u %8u %8u %8u %8u us %10llu\n", task->name,
+               p->num_dispatches, p->num_skipped, p->num_overruns,
+               p->num_over_budget, p->max_lateness_us,
+               (unsigned long long)(p->total_us / 1000));
+    }
+}
+
+static void print_states(const uint64_t *time_in_state_us, uint64_t sim_us)
+{
+    printf("\n%-16s %12s %7s\n", "state", "time_s", "share");
+    for (size_t i = 0; i < state_registry_count(); i++)
+    {
+        sched_state_t *state = state_registry_get_by_index(i);
+        uint64_t us = time_in_state_us[state->id];
+        printf("%-16s %12llu %6.2f%%\n", state->name,
+               (unsigned long long)(us / 1000000), 100.0 * us / sim_us);
+    }
+}
+
+static void print_queue(const char *name, const queue_t *q)
+{
+    // Queues belonging to tasks that never ran stay zeroed
+    if (q->element_count == 0)
+    {
+        printf("%-16s %18s\n", name, "(not initialized)");
+        return;
+    }
+    printf("%-16s %5u %9u %8u\n", name, q->level, q->max_level,
+           q->element_count);
+}
+
+static void print_queues(const slate_t *slate)
+{
+    printf("\n%-16s %5s %9s %8s\n", "queue", "level", "max_level", "capacity");
+    print_queue("tx_command", &slate->tx_sched.queues[TX_CLASS_COMMAND]);
+    print_queue("tx_beacon", &slate->tx_sched.queues[TX_CLASS_BEACON]);
+    print_queue("tx_bulk", &slate->tx_sched.queues[TX_CLASS_BULK]);
+    print_queue("rx_queue", &slate->rx_queue);
+    print_queue("payload_command", &slate->payload_command_data);
+    print_queue("rpi_uart", &slate->rpi_uart_queue);
+}
+
+static void print_energy(uint64_t sim_us, uint64_t tx_airtime_us)
+{
+    // mW * us = nJ
+    const double nj_per_j = 1e9;
+    uint64_t active_us = 0;
+    double total_j = 0;
+
+    printf("\n%-12s %12s\n", "consumer", "energy_J");
+    for (size_t i = 0; i < state_registry_task_count(); i++)
+    {
+        sched_task_t *task = state_registry_get_task_by_index(i);
+        uint64_t us = task->profile.total_us +
+                      (uint64_t)task->profile.num_dispatches *
+                          SIM_DISPATCH_COST_US;
+        double j = us * SIM_MCU_ACTIVE_MW / nj_per_j;
+        printf("%-12s %12.2f\n", task->name, j);
+        active_us += us;
+        total_j += j;
+    }
+
+    uint64_t idle_us = sim_us > active_us ? sim_us - active_us : 0;
+    double idle_j = idle_us * SIM_MCU_IDLE_MW / nj_per_j;
+    double tx_j = tx_airtime_us * SIM_RADIO_TX_MW / nj_per_j;
+    double rx_j = (sim_us - tx_airtime_us) * SIM_RADIO_RX_MW / nj_per_j;
+    printf("%-12s %12.2f\n", "mcu_idle", idle_j);
+    printf("%-12s %12.2f\n", "radio_tx", tx_j);
+    printf("%-12s %12.2f\n", "radio_rx", rx_j);
+    total_j += idle_j + tx_j + rx_j;
+
+    printf("%-12s %12.2f (average %.1f mW, %.2f Wh/day)\n", "total", total_j,
+           total_j * 1e9 / sim_us, total_j / 3600.0 * US_PER_DAY / sim_us);
+}
+
+int main(int argc, char **argv)
+{
+    double days = argc > 1 ? atof(argv[1]) : 1.0;
+    if (days <= 0)
+    {
+        fprintf(stderr, "usage: %s [days]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t sim_us = (uint64_t)(days * US_PER_DAY);
+    uint64_t time_in_state_us[STATE_COUNT] = {0};
+    uint64_t num_loops = 0;
+
+    logger_mock_echo = false;
+    mock_time_us = 0;
+    ASSERT(clear_and_init_slate(&sim_slate) == 0);
+    sched_init(&sim_slate);
+
+    while (mock_time_us < sim_us)
+    {
+        state_id_t state = sim_slate.current_state_id;
+        uint64_t start_us = mock_time_us;
+
+        sched_dispatch(&sim_slate);
+
+        // Stand in for core1. Its tasks run in parallel with core0, so the
+        // simulated time they take (kept in their profiles) must not delay
+        // the next core0 deadline.
+        uint64_t core0_now_us = mock_time_us;
+        sched_core1_run_pending();
+        mock_time_us = core0_now_us;
+
+        time_in_state_us[state] += mock_time_us - start_us;
+        num_loops++;
+    }
+
+    // The last dispatch can idle past the end
+    sim_us = mock_time_us;
+
+    printf("Simulated %.2f days in %llu scheduler loops\n",
+           (double)sim_us / US_PER_DAY, (unsigned long long)num_loops);
+    printf("Radio: %u packets, %u bytes sent, %llu ms on air\n",
+           sim_slate.tx_packets, sim_slate.tx_bytes,
+           (unsigned long long)(sim_slate.tx_airtime_us / 1000));
+    printf("TX bursts: %u, cut off by a limit: %u, timed out: %u\n",
+           sim_slate.tx_bursts, sim_slate.tx_burst_cutoffs,
+           sim_slate.tx_timeouts);
+    printf("TX by class (sent/dropped): command %u/%u, beacon %u/%u, "
+           "bulk %u/%u\n",
+           sim_slate.tx_sched.sent[TX_CLASS_COMMAND],
+           sim_slate.tx_sched.drops[TX_CLASS_COMMAND],
+           sim_slate.tx_sched.sent[TX_CLASS_BEACON],
+           sim_slate.tx_sched.drops[TX_CLASS_BEACON],
+           sim_slate.tx_sched.sent[TX_CLASS_BULK],
+           sim_slate.tx_sched.drops[TX_CLASS_BULK]);
+    printf("Budget faults: %u, watchdog stalls: %u\n",
+           sim_slate.sched_budget_faults, sim_slate.watchdog_stalls);
+
+    print_tasks();
+    print_states(time_in_state_us, sim_us);
+    print_queues(&sim_slate);
+    print_energy(sim_us, sim_slate.tx_airtime_us);
+
+    free_slate(&sim_slate);
+    return 0;
+}
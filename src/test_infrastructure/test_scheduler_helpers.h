@@ -70,6 +70,12 @@ extern FILE *viz_log;
  */
 extern const char *current_executing_task;
 
+/**
+ * Echo DEBUG/INFO logs to stdout, default true (defined in
+ * drivers/logger/logger_mock.c)
+ */
+extern bool logger_mock_echo;
+
 /**
  * Open visualization log file for writing at exact path
  * @param filename Path to the log file
@@ -1,6 +1,23 @@
 #pragma once
 
+#include <stdint.h>
+
 // Mock hardware sync functions for flash operations
 static inline void __compiler_memory_barrier(void)
 {
 }
+
+// Mock send-event - nothing is ever waiting in WFE on the host
+static inline void __sev(void)
+{
+}
+
+// Mock interrupt masking - the host has no interrupts to mask
+static inline uint32_t save_and_disable_interrupts(void)
+{
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t status)
+{
+}
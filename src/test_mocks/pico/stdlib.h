@@ -13,6 +13,10 @@ static inline absolute_time_t get_absolute_time(void)
 {
     return mock_time_us;
 }
+static inline uint64_t time_us_64(void)
+{
+    return mock_time_us;
+}
 static inline uint64_t absolute_time_diff_us(absolute_time_t from,
                                              absolute_time_t to)
 {
@@ -55,3 +59,14 @@ static inline void sleep_us(uint64_t us)
 {
     mock_time_us += us;
 }
+
+// Mock low-power wait - there are no interrupts in tests, so this always sleeps
+// until the timeout and reports that it timed out
+static inline bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp)
+{
+    if (mock_time_us < timeout_timestamp)
+    {
+        mock_time_us = timeout_timestamp;
+    }
+    return true;
+}
@@ -18,6 +18,7 @@ static inline void queue_init(queue_t *q, unsigned int element_size,
     q->head = 0;
     q->tail = 0;
     q->level = 0;
+    q->max_level = 0;
     ASSERT(element_size > 0 && element_count > 0 &&
            element_size * element_count < UINT32_MAX);
     q->data = malloc(element_size * element_count);
@@ -33,6 +34,8 @@ static inline bool queue_try_add(queue_t *q, void *data)
     memcpy(q->data + q->tail * q->element_size, data, q->element_size);
     q->tail = (q->tail + 1) % q->element_count;
     q->level++;
+    if (q->level > q->max_level)
+        q->max_level = q->level;
     return true;
 }
 
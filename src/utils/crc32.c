@@ -0,0 +1,163 @@
+/**
+ * @file crc32.c
+ *
+ * CRC-32 implementations behind crc32_continue, chosen with CRC32_IMPL. The
+ * tables come from crc32_tables.h, generated at build time by
+ * gen_crc32_tables.py, and only the rows in use are compiled in.
+ */
+
+#include "crc32.h"
+
+#include <string.h>
+
+#include "crc32_tables.h"
+
+#ifdef CRC32_ALL_IMPLS
+#define CRC32_HAS(impl) 1
+#else
+#define CRC32_HAS(impl) (CRC32_IMPL == (impl))
+#endif
+
+#if CRC32_HAS(CRC32_IMPL_SLICE8)
+#define CRC32_TABLE_ROWS 8
+#elif CRC32_HAS(CRC32_IMPL_SLICE4)
+#define CRC32_TABLE_ROWS 4
+#elif CRC32_HAS(CRC32_IMPL_TABLE)
+#define CRC32_TABLE_ROWS 1
+#else
+#define CRC32_TABLE_ROWS 0
+#endif
+
+_Static_assert(CRC32_TABLE_ROWS <= CRC32_TABLE_MAX_ROWS,
+               "crc32_tables.h has too few rows");
+
+#if CRC32_TABLE_ROWS >= 4 && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Slicing-by-N loads words little endian"
+#endif
+
+// The .time_critical sections are copied to SRAM at boot, for the table and
+// the code that reads it
+#if CRC32_TABLE_IN_RAM && !defined(TEST)
+#include "pico/platform.h"
+#define CRC32_FUNC(name) __not_in_flash_func(name)
+#define CRC32_TABLE_SECTION __not_in_flash("crc32_table")
+#else
+#define CRC32_FUNC(name) name
+#define CRC32_TABLE_SECTION
+#endif
+
+#if CRC32_HAS(CRC32_IMPL_BITWISE)
+// From https://gist.github.com/xobs/91a84d29152161e973d717b9be84c4d0, the
+// variant without a table
+unsigned int CRC32_FUNC(crc32_continue_bitwise)(const uint8_t *message,
+                                                size_t len, unsigned int crc)
+{
+    size_t i;
+    unsigned int byte, mask;
+
+    i = 0;
+    while (i < len)
+    {
+        byte = message[i]; // Get next byte.
+        crc = crc ^ byte;
+        for (int j = 0; j < 8; j++)
+        { // Do eight times.
+            mask = -(crc & 1);
+            crc = (crc >> 1) ^ (0xEDB88320 & mask);
+        }
+        i = i + 1;
+    }
+
+    return crc; // Don't invert here - must be done by the user!
+}
+#endif
+
+#if CRC32_TABLE_ROWS > 0
+static const uint32_t CRC32_TABLE_SECTION
+    crc32_table[CRC32_TABLE_ROWS][256] = {
+    CRC32_TABLE_ROW_0,
+#if CRC32_TABLE_ROWS >= 4
+    CRC32_TABLE_ROW_1,
+    CRC32_TABLE_ROW_2,
+    CRC32_TABLE_ROW_3,
+#endif
+#if CRC32_TABLE_ROWS >= 8
+    CRC32_TABLE_ROW_4,
+    CRC32_TABLE_ROW_5,
+    CRC32_TABLE_ROW_6,
+    CRC32_TABLE_ROW_7,
+#endif
+};
+
+// A byte at a time, for the table and for the tail of the sliced variants
+static inline uint32_t crc32_bytes(const uint8_t *message, size_t len,
+                                   uint32_t crc)
+{
+    while (len--)
+        crc = (crc >> 8) ^ crc32_table[0][(crc ^ *message++) & 0xFF];
+    return crc;
+}
+
+static inline uint32_t crc32_load_word(const uint8_t *p)
+{
+    uint32_t word;
+    memcpy(&word, p, sizeof(word)); // A single unaligned load on the M33
+    return word;
+}
+#endif
+
+#if CRC32_HAS(CRC32_IMPL_TABLE)
+unsigned int CRC32_FUNC(crc32_continue_table)(const uint8_t *message,
+                                              size_t len, unsigned int crc)
+{
+    return crc32_bytes(message, len, crc);
+}
+#endif
+
+#if CRC32_HAS(CRC32_IMPL_SLICE4)
+unsigned int CRC32_FUNC(crc32_continue_slice4)(const uint8_t *message,
+                                               size_t len, unsigned int crc)
+{
+    for (; len >= 4; len -= 4, message += 4)
+    {
+        uint32_t word = crc32_load_word(message) ^ crc;
+        crc = crc32_table[3][word & 0xFF] ^
+              crc32_table[2][(word >> 8) & 0xFF] ^
+              crc32_table[1][(word >> 16) & 0xFF] ^ crc32_table[0][word >> 24];
+    }
+    return crc32_bytes(message, len, crc);
+}
+#endif
+
+#if CRC32_HAS(CRC32_IMPL_SLICE8)
+unsigned int CRC32_FUNC(crc32_continue_slice8)(const uint8_t *message,
+                                               size_t len, unsigned int crc)
+{
+    for (; len >= 8; len -= 8, message += 8)
+    {
+        uint32_t lo = crc32_load_word(message) ^ crc;
+        uint32_t hi = crc32_load_word(message + 4);
+        crc = crc32_table[7][lo & 0xFF] ^ crc32_table[6][(lo >> 8) & 0xFF] ^
+              crc32_table[5][(lo >> 16) & 0xFF] ^ crc32_table[4][lo >> 24] ^
+              crc32_table[3][hi & 0xFF] ^ crc32_table[2][(hi >> 8) & 0xFF] ^
+              crc32_table[1][(hi >> 16) & 0xFF] ^ crc32_table[0][hi >> 24];
+    }
+    return crc32_bytes(message, len, crc);
+}
+#endif
+
+unsigned int crc32_continue(const uint8_t *message, size_t len,
+                            unsigned int crc)
+{
+#if CRC32_IMPL == CRC32_IMPL_SLICE8
+    return crc32_continue_slice8(message, len, crc);
+#elif CRC32_IMPL == CRC32_IMPL_SLICE4
+    return crc32_continue_slice4(message, len, crc);
+#elif CRC32_IMPL == CRC32_IMPL_TABLE
+    return crc32_continue_table(message, len, crc);
+#elif CRC32_IMPL == CRC32_IMPL_BITWISE
+    return crc32_continue_bitwise(message, len, crc);
+#else
+#error "Unknown CRC32_IMPL"
+#endif
+}
@@ -1,39 +1,36 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
-// From https://gist.github.com/xobs/91a84d29152161e973d717b9be84c4d0
-// (not using fast version because we want small binary size)
-// Adapted such that original CRC can be passed in to continue calculation
-// WARNING: Note this does NOT invert after calculation, this must be done by
-// the user! To use, initialize crc to 0xFFFFFFFF, then call crc32_continue as
-// needed, then invert the final result (use the ~ operator).
-// This is equivalent to zlib's implementation, and should always be the same as
-// running in Python: import zlib zlib.crc32(data) Where data is a byte-string
-// (use bytes()) with the same data as message.
-inline static unsigned int crc32_continue(const uint8_t *message, size_t len,
-                                          unsigned int crc)
-{
-    size_t i;
-    unsigned int byte, mask;
-
-    i = 0;
-    while (i < len)
-    {
-        byte = message[i]; // Get next byte.
-        crc = crc ^ byte;
-        for (int j = 0; j < 8; j++)
-        { // Do eight times.
-            mask = -(crc & 1);
-            crc = (crc >> 1) ^ (0xEDB88320 & mask);
-        }
-        i = i + 1;
-    }
+#include "config.h"
 
-    return crc; // Don't invert here - must be done by the user!
-}
+// CRC-32 as in zlib: the same as running in Python
+// import zlib; zlib.crc32(data)
+// where data is a byte-string (use bytes()) with the same data as message.
+//
+// The implementation is chosen with CRC32_IMPL in config.h, trading flash for
+// throughput. All of them give the same result.
+//
+// WARNING: crc32_continue does NOT invert after calculation, this must be done
+// by the user! To use, initialize crc to 0xFFFFFFFF, then call crc32_continue
+// as needed, then invert the final result (use the ~ operator).
+unsigned int crc32_continue(const uint8_t *message, size_t len,
+                            unsigned int crc);
 
 inline static unsigned int crc32(const uint8_t *message, size_t len)
 {
     return ~crc32_continue(message, len, 0xFFFFFFFF);
 }
+
+#ifdef CRC32_ALL_IMPLS
+// Every implementation side by side, for comparing them in tests and benchmarks
+unsigned int crc32_continue_bitwise(const uint8_t *message, size_t len,
+                                    unsigned int crc);
+unsigned int crc32_continue_table(const uint8_t *message, size_t len,
+                                  unsigned int crc);
+unsigned int crc32_continue_slice4(const uint8_t *message, size_t len,
+                                   unsigned int crc);
+unsigned int crc32_continue_slice8(const uint8_t *message, size_t len,
+                                   unsigned int crc);
+#endif
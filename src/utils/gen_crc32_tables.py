@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""Generate crc32_tables.h, the lookup tables of src/utils/crc32.c.
+
+Usage:
+    gen_crc32_tables.py > crc32_tables.h
+
+Row 0 is the classic byte-at-a-time table of the reflected CRC-32 (zlib)
+polynomial. Row k gives the CRC of a byte followed by k zero bytes, which is
+what slicing-by-N looks up for the byte k places before the end of a word.
+Each row is emitted as an initializer macro, CRC32_TABLE_ROW_<k>, so crc32.c
+only compiles in the rows its implementation uses.
+"""
+
+POLY = 0xEDB88320
+ROWS = 8
+
+
+def byte_table():
+    table = []
+    for i in range(256):
+        crc = i
+        for _ in range(8):
+            crc = (crc >> 1) ^ (POLY if crc & 1 else 0)
+        table.append(crc)
+    return table
+
+
+def main():
+    rows = [byte_table()]
+    for _ in range(1, ROWS):
+        prev = rows[-1]
+        rows.append([(c >> 8) ^ rows[0][c & 0xFF] for c in prev])
+
+    lines = [
+        "// Generated by src/utils/gen_crc32_tables.py, do not edit",
+        "#pragma once",
+        "",
+        f"#define CRC32_TABLE_MAX_ROWS {ROWS}",
+    ]
+    for k, row in enumerate(rows):
+        lines += ["", f"#define CRC32_TABLE_ROW_{k} \\", "    { \\"]
+        for i in range(0, 256, 4):
+            words = ", ".join(f"0x{c:08x}u" for c in row[i:i + 4])
+            lines.append(f"        {words}, \\")
+        lines.append("    }")
+
+    print("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
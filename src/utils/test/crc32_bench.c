@@ -0,0 +1,69 @@
+/**
+ * @file crc32_bench.c
+ *
+ * Host micro-benchmark of the CRC32 implementations, to weigh their flash
+ * against their throughput when choosing CRC32_IMPL for a build profile.
+ *
+ * Sizes are a payload UART packet and a filesys buffer. The host figures only
+ * hint at the RP2350, where table lookups also go through the XIP cache
+ * unless CRC32_TABLE_IN_RAM is set.
+ *
+ * Usage: crc32_bench [megabytes]
+ */
+
+#include "crc32.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Keep the compiler from discarding the results
+static volatile unsigned int sink;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void run(const char *name, size_t table_bytes,
+                unsigned int (*fn)(const uint8_t *, size_t, unsigned int),
+                const uint8_t *data, size_t n, double megabytes)
+{
+    int iterations = (int)(megabytes * 1e6 / n) + 1;
+
+    unsigned int crc = 0xFFFFFFFF;
+    uint64_t start_ns = now_ns();
+    for (int i = 0; i < iterations; i++)
+        crc = fn(data, n, crc);
+    uint64_t ns = now_ns() - start_ns;
+    sink ^= crc;
+
+    printf("%-8s %6zu B %6zu B %10.1f MB/s\n", name, table_bytes, n,
+           (double)n * iterations * 1e3 / (double)ns);
+}
+
+int main(int argc, char **argv)
+{
+    double megabytes = argc > 1 ? atof(argv[1]) : 64;
+    if (megabytes <= 0)
+    {
+        fprintf(stderr, "usage: %s [megabytes]\n", argv[0]);
+        return 1;
+    }
+
+    static const size_t sizes[] = {64, FILESYS_BUFFER_SIZE};
+    static uint8_t data[FILESYS_BUFFER_SIZE];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)rand();
+
+    printf("%-8s %8s %8s %15s\n", "impl", "table", "size", "throughput");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        run("bitwise", 0, crc32_continue_bitwise, data, sizes[s], megabytes);
+        run("table", 1024, crc32_continue_table, data, sizes[s], megabytes);
+        run("slice4", 4096, crc32_continue_slice4, data, sizes[s], megabytes);
+        run("slice8", 8192, crc32_continue_slice8, data, sizes[s], megabytes);
+    }
+    return 0;
+}
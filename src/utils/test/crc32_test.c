@@ -0,0 +1,107 @@
+/**
+ * @file crc32_test.c
+ * @brief Every CRC32 implementation gives zlib's CRC-32, at any length,
+ * alignment and split across crc32_continue calls
+ */
+
+#include "crc32.h"
+#include "error.h"
+#include "logger.h"
+
+typedef unsigned int (*crc32_fn_t)(const uint8_t *, size_t, unsigned int);
+
+static const struct
+{
+    const char *name;
+    crc32_fn_t fn;
+} impls[] = {
+    {"bitwise", crc32_continue_bitwise},
+    {"table", crc32_continue_table},
+    {"slice4", crc32_continue_slice4},
+    {"slice8", crc32_continue_slice8},
+};
+
+#define NUM_IMPLS (sizeof(impls) / sizeof(impls[0]))
+
+static uint8_t data[1024 + 8];
+
+/**
+ * Test 1: Known values, as given by Python's zlib.crc32
+ */
+void test_known_values(void)
+{
+    LOG_DEBUG("=== Test 1: Known values ===");
+
+    const uint8_t check[] = "123456789";
+    for (size_t i = 0; i < NUM_IMPLS; i++)
+    {
+        LOG_DEBUG("  %s", impls[i].name);
+        ASSERT(~impls[i].fn(check, 9, 0xFFFFFFFF) == 0xCBF43926);
+        ASSERT(~impls[i].fn(check, 0, 0xFFFFFFFF) == 0);
+    }
+    ASSERT(crc32(check, 9) == 0xCBF43926);
+
+    LOG_DEBUG("  Test 1 passed");
+}
+
+/**
+ * Test 2: The same as bitwise at every length up to 64 bytes and every
+ * alignment, so that the tails of the sliced loops are covered
+ */
+void test_lengths_and_alignments(void)
+{
+    LOG_DEBUG("=== Test 2: Lengths and alignments ===");
+
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)(i * 131 + 7);
+
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        for (size_t len = 0; len <= 64; len++)
+        {
+            unsigned int expected =
+                crc32_continue_bitwise(data + offset, len, 0xFFFFFFFF);
+            for (size_t i = 0; i < NUM_IMPLS; i++)
+                ASSERT(impls[i].fn(data + offset, len, 0xFFFFFFFF) ==
+                       expected);
+        }
+    }
+
+    LOG_DEBUG("  Test 2 passed");
+}
+
+/**
+ * Test 3: Continuing over pieces gives the CRC of the whole, as when filesys
+ * keeps a file's CRC up buffer by buffer
+ */
+void test_continue(void)
+{
+    LOG_DEBUG("=== Test 3: Continue ===");
+
+    unsigned int whole = crc32_continue(data, 1024, 0xFFFFFFFF);
+    for (size_t i = 0; i < NUM_IMPLS; i++)
+    {
+        unsigned int crc = 0xFFFFFFFF;
+        for (size_t at = 0, piece = 1; at < 1024; piece = piece * 3 % 97 + 1)
+        {
+            size_t n = at + piece > 1024 ? 1024 - at : piece;
+            crc = impls[i].fn(data + at, n, crc);
+            at += n;
+        }
+        ASSERT(crc == whole);
+    }
+
+    LOG_DEBUG("  Test 3 passed");
+}
+
+int main(void)
+{
+    LOG_DEBUG("=== CRC32 Test ===");
+
+    test_known_values();
+    test_lengths_and_alignments();
+    test_continue();
+
+    LOG_DEBUG("=== All CRC32 Tests Passed ===");
+    return 0;
+}